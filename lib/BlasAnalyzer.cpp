@@ -0,0 +1,398 @@
+#include "BlasAnalyzer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+/**
+ * BlasAnalyzer: LD_PRELOAD interposer of the level-3 BLAS entry points.
+ *
+ * Each call is forwarded to the next library providing the symbol and its
+ * dimensions, flags, wall time and call site are recorded. At exit the summary
+ * is written to stderr or to the file given by BLASANALYZER_OUTPUT:
+ *
+ *   LD_PRELOAD=libblasanalyzer.so ./application
+ */
+
+#define BLASBOOSTER_EXPORT __attribute__((visibility("default")))
+
+using namespace BlasBooster;
+
+namespace {
+
+AnalyzerSettings const& getSettings()
+{
+    static const AnalyzerSettings settings = AnalyzerSettings::fromEnvironment();
+    return settings;
+}
+
+void writeReport();
+
+/// Never destroyed, because BLAS calls can occur in the destructors of other static objects
+BlasAnalyzer& getAnalyzer()
+{
+    static BlasAnalyzer* analyzer = [] {
+        auto analyzer = new BlasAnalyzer;
+        std::atexit(writeReport);
+        return analyzer;
+    }();
+    return *analyzer;
+}
+
+void writeReport()
+{
+    auto const& settings = getSettings();
+    if (settings.output.empty()) {
+        getAnalyzer().report(std::cerr, settings.nbCallSites);
+        return;
+    }
+    std::ofstream file(settings.output);
+    if (!file) {
+        std::fprintf(stderr, "BlasAnalyzer: can not write %s\n", settings.output.c_str());
+        return;
+    }
+    getAnalyzer().report(file, settings.nbCallSites);
+}
+
+/// Calls within a recorded call, e.g. cblas_dgemm calling dgemm_, are not recorded again
+thread_local size_t depth = 0;
+
+/// Symbol of the library following the interposer in the lookup order
+template <class F>
+F getNext(const char* name)
+{
+    void* symbol = dlsym(RTLD_NEXT, name);
+    if (!symbol) {
+        std::fprintf(stderr, "BlasAnalyzer: symbol %s not found in the following libraries\n", name);
+        std::abort();
+    }
+    return reinterpret_cast<F>(symbol);
+}
+
+/// Forward the call and record the measurement, estimate(time) returns the estimated boosted time
+template <class Call, class Estimate>
+void analyze(BlasCallRecord record, Call const& call, Estimate const& estimate)
+{
+    if (depth++) {
+        call();
+        --depth;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    call();
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    try {
+        record.time = duration.count();
+        record.boostedTime = estimate(record.time);
+        getAnalyzer().record(record);
+    } catch (std::exception const& e) {
+        std::fprintf(stderr, "BlasAnalyzer: error in %s: %s\n", record.routine.c_str(), e.what());
+    }
+    --depth;
+}
+
+template <class Call>
+void analyze(BlasCallRecord const& record, Call const& call)
+{
+    analyze(record, call, [](double time){ return time; });
+}
+
+bool isLeft(char side) { return side == 'L' or side == 'l'; }
+
+/// Record of a column major xgemm call with the estimation of the booster path
+template <class T, class Call>
+void analyzeGemm(const char* routine, std::string const& flags, GemmCall<T> const& gemmCall,
+    bool isValid, void const* callSite, Call const& call)
+{
+    BlasCallRecord record{routine, flags, gemmCall.m, gemmCall.n, gemmCall.k, gemmCall.getFlops(), 0.0, 0.0, callSite};
+    analyze(record, call, [&](double time) {
+        return isValid ? estimateBoostedTime(gemmCall, time, getSettings()) : time;
+    });
+}
+
+/// Fortran xsymm, xtrmm and xtrsm: the triangular or symmetric matrix is m x m for side L and n x n for side R
+BlasCallRecord makeSideRecord(const char* routine, std::string const& flags, char side, blas_int m, blas_int n,
+    double flopsPerElement, void const* callSite)
+{
+    m = std::max(m, 0);
+    n = std::max(n, 0);
+    size_t k = isLeft(side) ? m : n;
+    return {routine, flags, size_t(m), size_t(n), k, flopsPerElement * m * n * k, 0.0, 0.0, callSite};
+}
+
+/// Fortran and CBLAS xsyrk and xsyr2k: C is n x n
+BlasCallRecord makeRankRecord(const char* routine, std::string const& flags, blas_int n, blas_int k,
+    double flopsPerElement, void const* callSite)
+{
+    n = std::max(n, 0);
+    k = std::max(k, 0);
+    return {routine, flags, size_t(n), size_t(n), size_t(k), flopsPerElement * n * n * k, 0.0, 0.0, callSite};
+}
+
+char toChar(int cblasEnum)
+{
+    switch (cblasEnum) {
+        case 101: return 'R';  // CblasRowMajor
+        case 102: return 'C';  // CblasColMajor
+        case 111: return 'N';  // CblasNoTrans
+        case 112: return 'T';  // CblasTrans
+        case 113: return 'C';  // CblasConjTrans
+        case 121: return 'U';  // CblasUpper
+        case 122: return 'L';  // CblasLower
+        case 131: return 'N';  // CblasNonUnit
+        case 132: return 'U';  // CblasUnit
+        case 141: return 'L';  // CblasLeft
+        case 142: return 'R';  // CblasRight
+        default: return '?';
+    }
+}
+
+template <class... Enums>
+std::string toFlags(Enums... enums) { return std::string{toChar(enums)...}; }
+
+template <class T>
+void fortranGemm(const char* routine, char const* transA, char const* transB, blas_int const* m, blas_int const* n,
+    blas_int const* k, T const* alpha, T const* A, blas_int const* lda, T const* B, blas_int const* ldb,
+    T const* beta, T* C, blas_int const* ldc, void const* callSite)
+{
+    static const auto next = getNext<SystemBlas::GemmType<T>>(routine);
+    bool isValid = isValidGemm(*transA, *transB, *m, *n, *k, *lda, *ldb, *ldc);
+    GemmCall<T> gemmCall{*transA, *transB, size_t(std::max(*m, 0)), size_t(std::max(*n, 0)), size_t(std::max(*k, 0)),
+        *alpha, A, size_t(*lda), B, size_t(*ldb), *beta, C, size_t(*ldc)};
+    analyzeGemm(routine, std::string{*transA, *transB}, gemmCall, isValid, callSite,
+        [&]{ next(transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+template <class T>
+void cblasGemm(const char* routine, int layout, int transA, int transB, blas_int m, blas_int n, blas_int k,
+    T alpha, T const* A, blas_int lda, T const* B, blas_int ldb, T beta, T* C, blas_int ldc, void const* callSite)
+{
+    typedef void (*cblas_gemm_type)(int, int, int, blas_int, blas_int, blas_int, T, T const*, blas_int,
+        T const*, blas_int, T, T*, blas_int);
+    static const auto next = getNext<cblas_gemm_type>(routine);
+
+    auto isValidTranspose = [](int trans) {
+        return trans >= static_cast<int>(CblasTranspose::NoTrans) and trans <= static_cast<int>(CblasTranspose::ConjTrans);
+    };
+    bool isValid = (layout == static_cast<int>(CblasLayout::RowMajor) or layout == static_cast<int>(CblasLayout::ColMajor))
+        and isValidTranspose(transA) and isValidTranspose(transB);
+
+    GemmCall<T> gemmCall{'N', 'N', size_t(std::max(m, 0)), size_t(std::max(n, 0)), size_t(std::max(k, 0)),
+        alpha, A, size_t(std::max(lda, 0)), B, size_t(std::max(ldb, 0)), beta, C, size_t(std::max(ldc, 0))};
+    if (isValid) {
+        gemmCall = makeGemmCall(static_cast<CblasLayout>(layout), static_cast<CblasTranspose>(transA),
+            static_cast<CblasTranspose>(transB), m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+        isValid = isValidGemm(gemmCall.transA, gemmCall.transB, blas_int(gemmCall.m), blas_int(gemmCall.n),
+            blas_int(gemmCall.k), blas_int(gemmCall.lda), blas_int(gemmCall.ldb), blas_int(gemmCall.ldc));
+    }
+    analyzeGemm(routine, toFlags(layout, transA, transB), gemmCall, isValid, callSite,
+        [&]{ next(layout, transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+} // namespace
+
+extern "C" {
+
+// Fortran interface
+
+BLASBOOSTER_EXPORT void dgemm_(char const* transA, char const* transB, blas_int const* m, blas_int const* n,
+    blas_int const* k, double const* alpha, double const* A, blas_int const* lda, double const* B,
+    blas_int const* ldb, double const* beta, double* C, blas_int const* ldc)
+{
+    fortranGemm("dgemm_", transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, __builtin_return_address(0));
+}
+
+BLASBOOSTER_EXPORT void sgemm_(char const* transA, char const* transB, blas_int const* m, blas_int const* n,
+    blas_int const* k, float const* alpha, float const* A, blas_int const* lda, float const* B,
+    blas_int const* ldb, float const* beta, float* C, blas_int const* ldc)
+{
+    fortranGemm("sgemm_", transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, __builtin_return_address(0));
+}
+
+BLASBOOSTER_EXPORT void dsymm_(char const* side, char const* uplo, blas_int const* m, blas_int const* n,
+    double const* alpha, double const* A, blas_int const* lda, double const* B, blas_int const* ldb,
+    double const* beta, double* C, blas_int const* ldc)
+{
+    static const auto next = getNext<decltype(&dsymm_)>("dsymm_");
+    analyze(makeSideRecord("dsymm_", {*side, *uplo}, *side, *m, *n, 2.0, __builtin_return_address(0)),
+        [&]{ next(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void ssymm_(char const* side, char const* uplo, blas_int const* m, blas_int const* n,
+    float const* alpha, float const* A, blas_int const* lda, float const* B, blas_int const* ldb,
+    float const* beta, float* C, blas_int const* ldc)
+{
+    static const auto next = getNext<decltype(&ssymm_)>("ssymm_");
+    analyze(makeSideRecord("ssymm_", {*side, *uplo}, *side, *m, *n, 2.0, __builtin_return_address(0)),
+        [&]{ next(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void dsyrk_(char const* uplo, char const* trans, blas_int const* n, blas_int const* k,
+    double const* alpha, double const* A, blas_int const* lda, double const* beta, double* C, blas_int const* ldc)
+{
+    static const auto next = getNext<decltype(&dsyrk_)>("dsyrk_");
+    analyze(makeRankRecord("dsyrk_", {*uplo, *trans}, *n, *k, 1.0, __builtin_return_address(0)),
+        [&]{ next(uplo, trans, n, k, alpha, A, lda, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void ssyrk_(char const* uplo, char const* trans, blas_int const* n, blas_int const* k,
+    float const* alpha, float const* A, blas_int const* lda, float const* beta, float* C, blas_int const* ldc)
+{
+    static const auto next = getNext<decltype(&ssyrk_)>("ssyrk_");
+    analyze(makeRankRecord("ssyrk_", {*uplo, *trans}, *n, *k, 1.0, __builtin_return_address(0)),
+        [&]{ next(uplo, trans, n, k, alpha, A, lda, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void dsyr2k_(char const* uplo, char const* trans, blas_int const* n, blas_int const* k,
+    double const* alpha, double const* A, blas_int const* lda, double const* B, blas_int const* ldb,
+    double const* beta, double* C, blas_int const* ldc)
+{
+    static const auto next = getNext<decltype(&dsyr2k_)>("dsyr2k_");
+    analyze(makeRankRecord("dsyr2k_", {*uplo, *trans}, *n, *k, 2.0, __builtin_return_address(0)),
+        [&]{ next(uplo, trans, n, k, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void ssyr2k_(char const* uplo, char const* trans, blas_int const* n, blas_int const* k,
+    float const* alpha, float const* A, blas_int const* lda, float const* B, blas_int const* ldb,
+    float const* beta, float* C, blas_int const* ldc)
+{
+    static const auto next = getNext<decltype(&ssyr2k_)>("ssyr2k_");
+    analyze(makeRankRecord("ssyr2k_", {*uplo, *trans}, *n, *k, 2.0, __builtin_return_address(0)),
+        [&]{ next(uplo, trans, n, k, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void dtrmm_(char const* side, char const* uplo, char const* transA, char const* diag,
+    blas_int const* m, blas_int const* n, double const* alpha, double const* A, blas_int const* lda,
+    double* B, blas_int const* ldb)
+{
+    static const auto next = getNext<decltype(&dtrmm_)>("dtrmm_");
+    analyze(makeSideRecord("dtrmm_", {*side, *uplo, *transA, *diag}, *side, *m, *n, 1.0, __builtin_return_address(0)),
+        [&]{ next(side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+BLASBOOSTER_EXPORT void strmm_(char const* side, char const* uplo, char const* transA, char const* diag,
+    blas_int const* m, blas_int const* n, float const* alpha, float const* A, blas_int const* lda,
+    float* B, blas_int const* ldb)
+{
+    static const auto next = getNext<decltype(&strmm_)>("strmm_");
+    analyze(makeSideRecord("strmm_", {*side, *uplo, *transA, *diag}, *side, *m, *n, 1.0, __builtin_return_address(0)),
+        [&]{ next(side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+BLASBOOSTER_EXPORT void dtrsm_(char const* side, char const* uplo, char const* transA, char const* diag,
+    blas_int const* m, blas_int const* n, double const* alpha, double const* A, blas_int const* lda,
+    double* B, blas_int const* ldb)
+{
+    static const auto next = getNext<decltype(&dtrsm_)>("dtrsm_");
+    analyze(makeSideRecord("dtrsm_", {*side, *uplo, *transA, *diag}, *side, *m, *n, 1.0, __builtin_return_address(0)),
+        [&]{ next(side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+BLASBOOSTER_EXPORT void strsm_(char const* side, char const* uplo, char const* transA, char const* diag,
+    blas_int const* m, blas_int const* n, float const* alpha, float const* A, blas_int const* lda,
+    float* B, blas_int const* ldb)
+{
+    static const auto next = getNext<decltype(&strsm_)>("strsm_");
+    analyze(makeSideRecord("strsm_", {*side, *uplo, *transA, *diag}, *side, *m, *n, 1.0, __builtin_return_address(0)),
+        [&]{ next(side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+// CBLAS interface
+
+BLASBOOSTER_EXPORT void cblas_dgemm(int layout, int transA, int transB, blas_int m, blas_int n, blas_int k,
+    double alpha, double const* A, blas_int lda, double const* B, blas_int ldb, double beta, double* C, blas_int ldc)
+{
+    cblasGemm("cblas_dgemm", layout, transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, __builtin_return_address(0));
+}
+
+BLASBOOSTER_EXPORT void cblas_sgemm(int layout, int transA, int transB, blas_int m, blas_int n, blas_int k,
+    float alpha, float const* A, blas_int lda, float const* B, blas_int ldb, float beta, float* C, blas_int ldc)
+{
+    cblasGemm("cblas_sgemm", layout, transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, __builtin_return_address(0));
+}
+
+BLASBOOSTER_EXPORT void cblas_dsymm(int layout, int side, int uplo, blas_int m, blas_int n, double alpha,
+    double const* A, blas_int lda, double const* B, blas_int ldb, double beta, double* C, blas_int ldc)
+{
+    static const auto next = getNext<decltype(&cblas_dsymm)>("cblas_dsymm");
+    analyze(makeSideRecord("cblas_dsymm", toFlags(layout, side, uplo), toChar(side), m, n, 2.0, __builtin_return_address(0)),
+        [&]{ next(layout, side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void cblas_ssymm(int layout, int side, int uplo, blas_int m, blas_int n, float alpha,
+    float const* A, blas_int lda, float const* B, blas_int ldb, float beta, float* C, blas_int ldc)
+{
+    static const auto next = getNext<decltype(&cblas_ssymm)>("cblas_ssymm");
+    analyze(makeSideRecord("cblas_ssymm", toFlags(layout, side, uplo), toChar(side), m, n, 2.0, __builtin_return_address(0)),
+        [&]{ next(layout, side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void cblas_dsyrk(int layout, int uplo, int trans, blas_int n, blas_int k, double alpha,
+    double const* A, blas_int lda, double beta, double* C, blas_int ldc)
+{
+    static const auto next = getNext<decltype(&cblas_dsyrk)>("cblas_dsyrk");
+    analyze(makeRankRecord("cblas_dsyrk", toFlags(layout, uplo, trans), n, k, 1.0, __builtin_return_address(0)),
+        [&]{ next(layout, uplo, trans, n, k, alpha, A, lda, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void cblas_ssyrk(int layout, int uplo, int trans, blas_int n, blas_int k, float alpha,
+    float const* A, blas_int lda, float beta, float* C, blas_int ldc)
+{
+    static const auto next = getNext<decltype(&cblas_ssyrk)>("cblas_ssyrk");
+    analyze(makeRankRecord("cblas_ssyrk", toFlags(layout, uplo, trans), n, k, 1.0, __builtin_return_address(0)),
+        [&]{ next(layout, uplo, trans, n, k, alpha, A, lda, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void cblas_dsyr2k(int layout, int uplo, int trans, blas_int n, blas_int k, double alpha,
+    double const* A, blas_int lda, double const* B, blas_int ldb, double beta, double* C, blas_int ldc)
+{
+    static const auto next = getNext<decltype(&cblas_dsyr2k)>("cblas_dsyr2k");
+    analyze(makeRankRecord("cblas_dsyr2k", toFlags(layout, uplo, trans), n, k, 2.0, __builtin_return_address(0)),
+        [&]{ next(layout, uplo, trans, n, k, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void cblas_ssyr2k(int layout, int uplo, int trans, blas_int n, blas_int k, float alpha,
+    float const* A, blas_int lda, float const* B, blas_int ldb, float beta, float* C, blas_int ldc)
+{
+    static const auto next = getNext<decltype(&cblas_ssyr2k)>("cblas_ssyr2k");
+    analyze(makeRankRecord("cblas_ssyr2k", toFlags(layout, uplo, trans), n, k, 2.0, __builtin_return_address(0)),
+        [&]{ next(layout, uplo, trans, n, k, alpha, A, lda, B, ldb, beta, C, ldc); });
+}
+
+BLASBOOSTER_EXPORT void cblas_dtrmm(int layout, int side, int uplo, int transA, int diag, blas_int m, blas_int n,
+    double alpha, double const* A, blas_int lda, double* B, blas_int ldb)
+{
+    static const auto next = getNext<decltype(&cblas_dtrmm)>("cblas_dtrmm");
+    analyze(makeSideRecord("cblas_dtrmm", toFlags(layout, side, uplo, transA, diag), toChar(side), m, n, 1.0,
+        __builtin_return_address(0)), [&]{ next(layout, side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+BLASBOOSTER_EXPORT void cblas_strmm(int layout, int side, int uplo, int transA, int diag, blas_int m, blas_int n,
+    float alpha, float const* A, blas_int lda, float* B, blas_int ldb)
+{
+    static const auto next = getNext<decltype(&cblas_strmm)>("cblas_strmm");
+    analyze(makeSideRecord("cblas_strmm", toFlags(layout, side, uplo, transA, diag), toChar(side), m, n, 1.0,
+        __builtin_return_address(0)), [&]{ next(layout, side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+BLASBOOSTER_EXPORT void cblas_dtrsm(int layout, int side, int uplo, int transA, int diag, blas_int m, blas_int n,
+    double alpha, double const* A, blas_int lda, double* B, blas_int ldb)
+{
+    static const auto next = getNext<decltype(&cblas_dtrsm)>("cblas_dtrsm");
+    analyze(makeSideRecord("cblas_dtrsm", toFlags(layout, side, uplo, transA, diag), toChar(side), m, n, 1.0,
+        __builtin_return_address(0)), [&]{ next(layout, side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+BLASBOOSTER_EXPORT void cblas_strsm(int layout, int side, int uplo, int transA, int diag, blas_int m, blas_int n,
+    float alpha, float const* A, blas_int lda, float* B, blas_int ldb)
+{
+    static const auto next = getNext<decltype(&cblas_strsm)>("cblas_strsm");
+    analyze(makeSideRecord("cblas_strsm", toFlags(layout, side, uplo, transA, diag), toChar(side), m, n, 1.0,
+        __builtin_return_address(0)), [&]{ next(layout, side, uplo, transA, diag, m, n, alpha, A, lda, B, ldb); });
+}
+
+} // extern "C"
@@ -0,0 +1,109 @@
+#include "BlasInterface.h"
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+/**
+ * Drop-in BLAS library: exports the Fortran and CBLAS entry points of xgemm.
+ *
+ * Large calls with a sparse looking operand are computed by the blocked
+ * BlasBooster path, all other calls are passed to the system BLAS.
+ */
+
+#define BLASBOOSTER_EXPORT __attribute__((visibility("default")))
+
+using namespace BlasBooster;
+
+namespace {
+
+BoosterSettings const& getSettings()
+{
+    static const BoosterSettings settings = BoosterSettings::fromEnvironment();
+    return settings;
+}
+
+/// Errors can not be propagated through the BLAS interface
+[[noreturn]] void abortOnError(const char* function, std::exception const& e)
+{
+    std::fprintf(stderr, "BlasBooster: error in %s: %s\n", function, e.what());
+    std::abort();
+}
+
+template <class T>
+void fortranGemm(const char* function, char const* transA, char const* transB, blas_int const* m, blas_int const* n,
+    blas_int const* k, T const* alpha, T const* A, blas_int const* lda, T const* B, blas_int const* ldb,
+    T const* beta, T* C, blas_int const* ldc)
+{
+    try {
+        if (!isValidGemm(*transA, *transB, *m, *n, *k, *lda, *ldb, *ldc)) {
+            SystemBlas::instance().gemm<T>()(transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+            return;
+        }
+        gemm(GemmCall<T>{*transA, *transB, size_t(*m), size_t(*n), size_t(*k), *alpha, A, size_t(*lda),
+            B, size_t(*ldb), *beta, C, size_t(*ldc)}, getSettings());
+    } catch (std::exception const& e) {
+        abortOnError(function, e);
+    }
+}
+
+template <class T>
+void cblasGemm(const char* function, int layout, int transA, int transB, blas_int m, blas_int n, blas_int k,
+    T alpha, T const* A, blas_int lda, T const* B, blas_int ldb, T beta, T* C, blas_int ldc)
+{
+    auto isValidTranspose = [](int trans) {
+        return trans >= static_cast<int>(CblasTranspose::NoTrans) and trans <= static_cast<int>(CblasTranspose::ConjTrans);
+    };
+
+    // Parameter numbers of the reference CBLAS, the other arguments are checked by the Fortran interface
+    blas_int info = 0;
+    if (layout != static_cast<int>(CblasLayout::RowMajor) and layout != static_cast<int>(CblasLayout::ColMajor)) info = 1;
+    else if (!isValidTranspose(transA)) info = 2;
+    else if (!isValidTranspose(transB)) info = 3;
+    if (info) {
+        try {
+            SystemBlas::instance().xerbla(function, info);
+        } catch (std::exception const& e) {
+            abortOnError(function, e);
+        }
+        return;
+    }
+
+    GemmCall<T> call = makeGemmCall(static_cast<CblasLayout>(layout), static_cast<CblasTranspose>(transA),
+        static_cast<CblasTranspose>(transB), m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+
+    blas_int cm = call.m, cn = call.n, ck = call.k, clda = call.lda, cldb = call.ldb, cldc = call.ldc;
+    fortranGemm(function, &call.transA, &call.transB, &cm, &cn, &ck, &call.alpha, call.A, &clda,
+        call.B, &cldb, &call.beta, call.C, &cldc);
+}
+
+} // namespace
+
+extern "C" {
+
+BLASBOOSTER_EXPORT void dgemm_(char const* transA, char const* transB, blas_int const* m, blas_int const* n,
+    blas_int const* k, double const* alpha, double const* A, blas_int const* lda, double const* B,
+    blas_int const* ldb, double const* beta, double* C, blas_int const* ldc)
+{
+    fortranGemm("dgemm_", transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+BLASBOOSTER_EXPORT void sgemm_(char const* transA, char const* transB, blas_int const* m, blas_int const* n,
+    blas_int const* k, float const* alpha, float const* A, blas_int const* lda, float const* B,
+    blas_int const* ldb, float const* beta, float* C, blas_int const* ldc)
+{
+    fortranGemm("sgemm_", transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+BLASBOOSTER_EXPORT void cblas_dgemm(int layout, int transA, int transB, blas_int m, blas_int n, blas_int k,
+    double alpha, double const* A, blas_int lda, double const* B, blas_int ldb, double beta, double* C, blas_int ldc)
+{
+    cblasGemm("cblas_dgemm", layout, transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+BLASBOOSTER_EXPORT void cblas_sgemm(int layout, int transA, int transB, blas_int m, blas_int n, blas_int k,
+    float alpha, float const* A, blas_int lda, float const* B, blas_int ldb, float beta, float* C, blas_int ldc)
+{
+    cblasGemm("cblas_sgemm", layout, transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+} // extern "C"
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace BlasBooster {
+
+/**
+ * \brief Bump allocator for short-lived scratch memory of one thread.
+ *
+ * The memory is taken from large chunks by incrementing an offset, so that
+ * temporary buffers of block products and conversions neither lock the heap
+ * nor fragment it. Single buffers are only returned if they are the last
+ * allocation, all others are released together by rewind() or reset(),
+ * e.g. after each multiplication phase. The chunks are kept for reuse and
+ * merged into one chunk by reset(). Threads which only live for one parallel
+ * run take their arena from an ArenaPool (see ArenaBinding).
+ */
+class Arena
+{
+public:
+
+    /// Position of the bump pointer
+    struct Marker
+    {
+        size_t chunk = 0;
+        size_t offset = 0;
+    };
+
+    static constexpr size_t alignment = 64;
+
+    explicit Arena(size_t chunkSize = size_t(1) << 20)
+     : chunkSize_(chunkSize)
+    {}
+
+    Arena(Arena const&) = delete;
+    Arena& operator = (Arena const&) = delete;
+
+    ~Arena()
+    {
+        for (auto& chunk : chunks_) ::operator delete(chunk.data, std::align_val_t(alignment));
+    }
+
+    /// Arena bound to the calling thread by ArenaBinding, else the thread-local arena
+    static Arena& getLocal()
+    {
+        if (Arena* bound = getBound()) return *bound;
+        static thread_local Arena arena;
+        return arena;
+    }
+
+    void* allocate(size_t bytes)
+    {
+        bytes = (bytes + alignment - 1) / alignment * alignment;
+        while (current_ < chunks_.size() and chunks_[current_].size - offset_ < bytes) {
+            ++current_;
+            offset_ = 0;
+        }
+        if (current_ == chunks_.size()) {
+            size_t size = std::max(chunkSize_, bytes);
+            chunks_.push_back(Chunk{static_cast<char*>(::operator new(size, std::align_val_t(alignment))), size});
+            offset_ = 0;
+        }
+        void* memory = chunks_[current_].data + offset_;
+        offset_ += bytes;
+        return memory;
+    }
+
+    /// Only the last allocation is returned, all others on rewind
+    void release(void* memory, size_t bytes) noexcept
+    {
+        bytes = (bytes + alignment - 1) / alignment * alignment;
+        if (current_ < chunks_.size() and offset_ >= bytes and memory == chunks_[current_].data + offset_ - bytes) offset_ -= bytes;
+    }
+
+    Marker getMarker() const { return Marker{current_, offset_}; }
+
+    /// Release all allocations after the marker
+    void rewind(Marker const& marker) noexcept
+    {
+        current_ = marker.chunk;
+        offset_ = marker.offset;
+    }
+
+    /// Release all allocations and merge the chunks, so that the next phase needs no new chunk
+    void reset()
+    {
+        if (chunks_.size() > 1) {
+            size_t size = getReservedBytes();
+            for (auto& chunk : chunks_) ::operator delete(chunk.data, std::align_val_t(alignment));
+            chunks_.clear();
+            chunks_.push_back(Chunk{static_cast<char*>(::operator new(size, std::align_val_t(alignment))), size});
+        }
+        current_ = 0;
+        offset_ = 0;
+    }
+
+    size_t getUsedBytes() const
+    {
+        size_t bytes = offset_;
+        for (size_t i = 0; i < current_ and i < chunks_.size(); ++i) bytes += chunks_[i].size;
+        return bytes;
+    }
+
+    size_t getReservedBytes() const
+    {
+        size_t bytes = 0;
+        for (auto const& chunk : chunks_) bytes += chunk.size;
+        return bytes;
+    }
+
+private:
+
+    friend class ArenaBinding;
+
+    static Arena*& getBound()
+    {
+        static thread_local Arena* arena = nullptr;
+        return arena;
+    }
+
+    struct Chunk
+    {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks_;
+
+    size_t current_ = 0;
+
+    size_t offset_ = 0;
+
+    size_t chunkSize_;
+
+};
+
+/**
+ * \brief Arenas, which outlive the threads using them.
+ *
+ * The workers of the WorkStealingScheduler are started for each run, so that
+ * their thread-local arenas and chunks would be released with the threads.
+ * Instead they take an idle arena from the pool and return it at the end of
+ * the run, so that the next run finds the chunks of the previous one.
+ */
+class ArenaPool
+{
+public:
+
+    ArenaPool() = default;
+
+    ArenaPool(ArenaPool const&) = delete;
+    ArenaPool& operator = (ArenaPool const&) = delete;
+
+    /// Pool of the workers of all schedulers
+    static ArenaPool& getGlobal()
+    {
+        static ArenaPool pool;
+        return pool;
+    }
+
+    std::unique_ptr<Arena> acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.empty()) return std::make_unique<Arena>();
+        std::unique_ptr<Arena> arena = std::move(idle_.back());
+        idle_.pop_back();
+        return arena;
+    }
+
+    /// All allocations of the arena are released
+    void release(std::unique_ptr<Arena> arena)
+    {
+        arena->rewind(Arena::Marker());
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(std::move(arena));
+    }
+
+    /// Merge the chunks of all idle arenas, e.g. at the end of a multiplication phase
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& arena : idle_) arena->reset();
+    }
+
+    size_t getNbIdle() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_.size();
+    }
+
+private:
+
+    mutable std::mutex mutex_;
+
+    std::vector<std::unique_ptr<Arena>> idle_;
+
+};
+
+/// Bind an arena of the pool to the calling thread for the lifetime of the scope
+class ArenaBinding
+{
+public:
+
+    explicit ArenaBinding(ArenaPool& pool = ArenaPool::getGlobal())
+     : pool_(pool), arena_(pool.acquire()), previous_(Arena::getBound())
+    {
+        Arena::getBound() = arena_.get();
+    }
+
+    ArenaBinding(ArenaBinding const&) = delete;
+    ArenaBinding& operator = (ArenaBinding const&) = delete;
+
+    ~ArenaBinding()
+    {
+        Arena::getBound() = previous_;
+        pool_.release(std::move(arena_));
+    }
+
+private:
+
+    ArenaPool& pool_;
+
+    std::unique_ptr<Arena> arena_;
+
+    Arena* previous_;
+
+};
+
+/// Rewind the arena of the calling thread at the end of the scope
+class ArenaScope
+{
+public:
+
+    ArenaScope()
+     : arena_(Arena::getLocal()), marker_(arena_.getMarker())
+    {}
+
+    ArenaScope(ArenaScope const&) = delete;
+    ArenaScope& operator = (ArenaScope const&) = delete;
+
+    ~ArenaScope() { arena_.rewind(marker_); }
+
+private:
+
+    Arena& arena_;
+
+    Arena::Marker marker_;
+
+};
+
+/**
+ * \brief Scratch memory from the arena of the calling thread.
+ *
+ * The storage must not outlive the next rewind or reset of the arena, e.g. the
+ * enclosing ArenaScope, and must not be moved to another thread. The elements
+ * are not initialized.
+ */
+struct ArenaAllocator
+{
+    template <typename T>
+    static T* allocate(size_t size)
+    {
+        if (size == 0) return nullptr;
+        T* memory = static_cast<T*>(Arena::getLocal().allocate(size * sizeof(T)));
+        if constexpr (!std::is_trivially_default_constructible<T>::value) std::uninitialized_default_construct_n(memory, size);
+        return memory;
+    }
+
+    template <typename T>
+    static void deallocate(T* memory, size_t size) noexcept
+    {
+        if (!memory) return;
+        std::destroy_n(memory, size);
+        Arena::getLocal().release(memory, size * sizeof(T));
+    }
+};
+
+} // namespace BlasBooster
@@ -0,0 +1,308 @@
+#pragma once
+
+#include "BlasInterface.h"
+#include "CostModel.h"
+#include "DynamicMatrixTypeList.h"
+#include "TypeList.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Measurement of a single level-3 BLAS call
+struct BlasCallRecord
+{
+    /// Name of the entry point, e.g. dgemm_ or cblas_sgemm
+    std::string routine;
+
+    /// Character arguments in the order of the interface, e.g. "NT" for xgemm or "LUNN" for xtrmm
+    std::string flags;
+
+    size_t m = 0, n = 0, k = 0;
+
+    /// Floating point operations of the call
+    double flops = 0.0;
+
+    /// Measured wall time in seconds
+    double time = 0.0;
+
+    /// Estimated wall time of the BlasBooster path, equal to time if the call would not be boosted
+    double boostedTime = 0.0;
+
+    /// Return address of the BLAS call
+    void const* callSite = nullptr;
+};
+
+/// Criteria of the analysis
+struct AnalyzerSettings
+{
+    /// Criteria of the booster path, which are used for the estimation of the speedup
+    BoosterSettings booster;
+
+    /// Ratio of the flop rate of the sparse to the dense block kernel, if no cost model is available
+    double sparseEfficiency = 0.1;
+
+    /// Number of call sites listed in the summary
+    size_t nbCallSites = 10;
+
+    /// File of the summary, empty for stderr
+    std::string output;
+
+    /// Default settings overwritten by the variables of BoosterSettings::fromEnvironment,
+    /// BLASANALYZER_SPARSE_EFFICIENCY, BLASANALYZER_CALL_SITES and BLASANALYZER_OUTPUT
+    static AnalyzerSettings fromEnvironment()
+    {
+        AnalyzerSettings settings;
+        settings.booster = BoosterSettings::fromEnvironment();
+        if (const char* value = std::getenv("BLASANALYZER_SPARSE_EFFICIENCY")) settings.sparseEfficiency = std::stod(value);
+        if (const char* value = std::getenv("BLASANALYZER_CALL_SITES")) settings.nbCallSites = std::stoul(value);
+        if (const char* value = std::getenv("BLASANALYZER_OUTPUT")) settings.output = value;
+        return settings;
+    }
+
+    /// Ratio of the flop rate of the sparse to the dense kernel, measured by the cost model if available
+    double getSparseEfficiency() const
+    {
+        auto const& costModel = booster.converter.costModel;
+        if (!costModel) return sparseEfficiency;
+
+        static const size_t sparseType = GetIndex<Matrix<Sparse,double>, DynamicMatrixTypeList>::value;
+        static const size_t denseType = GetIndex<Matrix<Dense,double>, DynamicMatrixTypeList>::value;
+        auto const& sparse = costModel->getCoefficients(sparseType, denseType);
+        auto const& dense = costModel->getCoefficients(denseType, denseType);
+        if (!sparse.valid or !dense.valid or sparse.c[1] <= 0.0) return sparseEfficiency;
+        return dense.c[1] / sparse.c[1];
+    }
+};
+
+/**
+ * \brief Estimated time of a xgemm call computed by the BlasBooster path.
+ *
+ * The selection of the booster path is the same as in gemm(). The dense
+ * operations keep the measured flop rate of the system BLAS, while the work
+ * of a sparse looking operand is reduced by its sampled occupation and done
+ * with the lower flop rate of the sparse kernel. The conversion is not taken
+ * into account, so that the estimate is an upper bound of the speedup.
+ */
+template <class T>
+double estimateBoostedTime(GemmCall<T> const& call, double time, AnalyzerSettings const& settings)
+{
+    auto const& booster = settings.booster;
+    if (std::min({call.m, call.n, call.k}) < booster.minDimension or call.alpha == T(0)) return time;
+
+    double occupationA = sampleOccupation(call.A, call.getRowStrideA(), call.getColumnStrideA(),
+        call.m, call.k, booster.nbSamples, booster.converter.threshold);
+    double occupationB = sampleOccupation(call.B, call.getRowStrideB(), call.getColumnStrideB(),
+        call.k, call.n, booster.nbSamples, booster.converter.threshold);
+
+    const bool isSparseA = occupationA < booster.maxOccupation;
+    const bool isSparseB = occupationB < booster.maxOccupation;
+    if (!isSparseA and !isSparseB) return time;
+
+    double workFraction = (isSparseA ? occupationA : 1.0) * (isSparseB ? occupationB : 1.0);
+    return time * workFraction / settings.getSparseEfficiency();
+}
+
+/**
+ * \brief Collection of the BLAS calls of an application and their summary.
+ *
+ * The calls are aggregated on the fly, so that the memory does not grow with
+ * the number of calls. All member functions are thread-safe.
+ */
+class BlasAnalyzer
+{
+public:
+
+    /// Number of bins of the size histograms, bin b contains the sizes in [2^(b-1), 2^b)
+    static const size_t nbBins = 65;
+
+    struct Statistics
+    {
+        size_t nbCalls = 0;
+        double time = 0.0;
+        double flops = 0.0;
+        double boostedTime = 0.0;
+
+        void add(BlasCallRecord const& record)
+        {
+            ++nbCalls;
+            time += record.time;
+            flops += record.flops;
+            boostedTime += record.boostedTime;
+        }
+
+        double getGflops() const { return time > 0.0 ? flops / time * 1e-9 : 0.0; }
+        double getSpeedup() const { return boostedTime > 0.0 ? time / boostedTime : 1.0; }
+    };
+
+    struct HistogramBin
+    {
+        std::array<size_t, 3> nbCalls{};
+        std::array<double, 3> time{};
+    };
+
+    /// Histogram bin of a matrix dimension
+    static size_t getBin(size_t size) { return std::bit_width(size); }
+
+    void record(BlasCallRecord const& record)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        total_.add(record);
+        routines_[record.routine].add(record);
+        flags_[std::make_pair(record.routine, record.flags)].add(record);
+        callSites_[std::make_pair(record.callSite, record.routine)].add(record);
+
+        size_t dimensions[] = {record.m, record.n, record.k};
+        for (size_t d = 0; d != 3; ++d) {
+            auto& bin = histogram_[getBin(dimensions[d])];
+            ++bin.nbCalls[d];
+            bin.time[d] += record.time;
+        }
+    }
+
+    Statistics getTotal() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_;
+    }
+
+    Statistics getRoutine(std::string const& routine) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = routines_.find(routine);
+        return iter == routines_.end() ? Statistics() : iter->second;
+    }
+
+    HistogramBin getHistogramBin(size_t bin) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return histogram_.at(bin);
+    }
+
+    /// Call sites with routine sorted by descending time
+    std::vector<std::pair<std::pair<void const*, std::string>, Statistics>> getCallSites() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::pair<std::pair<void const*, std::string>, Statistics>> callSites(callSites_.begin(), callSites_.end());
+        std::stable_sort(callSites.begin(), callSites.end(),
+            [](auto const& a, auto const& b){ return a.second.time > b.second.time; });
+        return callSites;
+    }
+
+    /// Symbol and shared object of an address, in the form symbol+offset (object)
+    static std::string getCallSiteName(void const* address);
+
+    /// Write the summary of all recorded calls
+    void report(std::ostream& os, size_t nbCallSites = 10) const;
+
+private:
+
+    mutable std::mutex mutex_;
+
+    Statistics total_;
+
+    std::map<std::string, Statistics> routines_;
+
+    std::map<std::pair<std::string, std::string>, Statistics> flags_;
+
+    std::map<std::pair<void const*, std::string>, Statistics> callSites_;
+
+    std::array<HistogramBin, nbBins> histogram_{};
+
+};
+
+inline std::string BlasAnalyzer::getCallSiteName(void const* address)
+{
+    std::ostringstream ss;
+    ss << std::hex;
+    Dl_info info;
+    if (!address or !dladdr(address, &info)) {
+        ss << address;
+        return ss.str();
+    }
+
+    auto offset = [](void const* address, void const* base) {
+        return reinterpret_cast<std::uintptr_t>(address) - reinterpret_cast<std::uintptr_t>(base);
+    };
+
+    // Without symbol the offset within the object can be resolved by addr2line
+    if (info.dli_sname) ss << info.dli_sname << "+0x" << offset(address, info.dli_saddr);
+    else ss << "0x" << offset(address, info.dli_fbase);
+    if (info.dli_fname) ss << " (" << info.dli_fname << ")";
+    return ss.str();
+}
+
+inline void BlasAnalyzer::report(std::ostream& os, size_t nbCallSites) const
+{
+    auto callSites = getCallSites();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto writeStatistics = [&](Statistics const& s) {
+        os << std::setw(10) << s.nbCalls << std::setw(14) << s.time << std::setw(10) << s.getGflops()
+           << std::setw(14) << s.boostedTime << std::setw(9) << s.getSpeedup() << "x";
+    };
+    auto writeHeader = [&](std::string const& name, size_t width) {
+        os << std::left << std::setw(width) << name << std::right << std::setw(10) << "calls" << std::setw(14) << "time [s]"
+           << std::setw(10) << "GFLOP/s" << std::setw(14) << "boosted [s]" << std::setw(10) << "speedup" << "\n";
+    };
+
+    os << std::fixed << std::setprecision(3);
+    os << "BlasAnalyzer summary\n\n";
+    writeHeader("Total", 24);
+    os << std::setw(24) << "";
+    writeStatistics(total_);
+    os << "\n\n";
+
+    writeHeader("Routine", 24);
+    for (auto const& [routine, s] : routines_) {
+        os << std::left << std::setw(24) << routine << std::right;
+        writeStatistics(s);
+        os << "\n";
+    }
+    os << "\n";
+
+    writeHeader("Routine flags", 24);
+    for (auto const& [key, s] : flags_) {
+        os << std::left << std::setw(24) << key.first + " " + key.second << std::right;
+        writeStatistics(s);
+        os << "\n";
+    }
+    os << "\n";
+
+    os << "Top call sites by time\n";
+    for (size_t i = 0; i != std::min(nbCallSites, callSites.size()); ++i) {
+        auto const& [key, s] = callSites[i];
+        os << std::setw(4) << i + 1 << ". " << getCallSiteName(key.first) << " " << key.second << "\n      ";
+        writeStatistics(s);
+        os << std::setw(8) << (total_.time > 0.0 ? 100.0 * s.time / total_.time : 0.0) << " %\n";
+    }
+    os << "\n";
+
+    os << "Size histogram" << std::setw(12) << "m calls" << std::setw(14) << "m time [s]" << std::setw(12) << "n calls"
+       << std::setw(14) << "n time [s]" << std::setw(12) << "k calls" << std::setw(14) << "k time [s]" << "\n";
+    for (size_t b = 0; b != nbBins; ++b) {
+        auto const& bin = histogram_[b];
+        if (bin.nbCalls[0] + bin.nbCalls[1] + bin.nbCalls[2] == 0) continue;
+
+        std::ostringstream range;
+        if (b == 0) range << "0";
+        else range << (size_t(1) << (b - 1)) << "-" << (b == 64 ? SIZE_MAX : (size_t(1) << b) - 1);
+        os << std::setw(14) << range.str();
+        for (size_t d = 0; d != 3; ++d) os << std::setw(12) << bin.nbCalls[d] << std::setw(14) << bin.time[d];
+        os << "\n";
+    }
+}
+
+} // namespace BlasBooster
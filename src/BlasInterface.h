@@ -0,0 +1,195 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "DynamicMatrix.h"
+#include "DynamicMultiplication.h"
+#include "MatrixConverter.h"
+#include "SparsityEstimator.h"
+#include "SystemBlas.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Values of the CBLAS enumerations
+enum class CblasLayout { RowMajor = 101, ColMajor = 102 };
+enum class CblasTranspose { NoTrans = 111, Trans = 112, ConjTrans = 113 };
+
+/**
+ * \brief Arguments of a column major xgemm call C = alpha * op(A) * op(B) + beta * C.
+ *
+ * op(A) is m x k, op(B) is k x n and C is m x n.
+ */
+template <class T>
+struct GemmCall
+{
+    char transA;
+    char transB;
+    size_t m, n, k;
+    T alpha;
+    T const* A;
+    size_t lda;
+    T const* B;
+    size_t ldb;
+    T beta;
+    T* C;
+    size_t ldc;
+
+    static bool isTransposed(char trans) { return trans == 'T' or trans == 't' or trans == 'C' or trans == 'c'; }
+
+    static bool isValidTrans(char trans) { return isTransposed(trans) or trans == 'N' or trans == 'n'; }
+
+    bool isTransposedA() const { return isTransposed(transA); }
+    bool isTransposedB() const { return isTransposed(transB); }
+
+    /// Strides of op(A) and op(B), a transposed operand is read as row major view
+    size_t getRowStrideA() const { return isTransposedA() ? lda : 1; }
+    size_t getColumnStrideA() const { return isTransposedA() ? 1 : lda; }
+    size_t getRowStrideB() const { return isTransposedB() ? ldb : 1; }
+    size_t getColumnStrideB() const { return isTransposedB() ? 1 : ldb; }
+
+    double getFlops() const { return 2.0 * m * n * k; }
+};
+
+/// Argument check of the reference BLAS, invalid calls are passed to the system BLAS for the error report
+inline bool isValidGemm(char transA, char transB, blas_int m, blas_int n, blas_int k, blas_int lda, blas_int ldb, blas_int ldc)
+{
+    if (!GemmCall<double>::isValidTrans(transA) or !GemmCall<double>::isValidTrans(transB)) return false;
+    if (m < 0 or n < 0 or k < 0) return false;
+    blas_int nbRowsA = GemmCall<double>::isTransposed(transA) ? k : m;
+    blas_int nbRowsB = GemmCall<double>::isTransposed(transB) ? n : k;
+    return lda >= std::max(1, nbRowsA) and ldb >= std::max(1, nbRowsB) and ldc >= std::max(1, m);
+}
+
+/// Column major call equivalent to a CBLAS call, row major is computed as C^T = op(B)^T op(A)^T
+template <class T>
+GemmCall<T> makeGemmCall(CblasLayout layout, CblasTranspose transA, CblasTranspose transB,
+    blas_int m, blas_int n, blas_int k, T alpha, T const* A, blas_int lda,
+    T const* B, blas_int ldb, T beta, T* C, blas_int ldc)
+{
+    auto toChar = [](CblasTranspose trans) {
+        return trans == CblasTranspose::NoTrans ? 'N' : trans == CblasTranspose::Trans ? 'T' : 'C';
+    };
+
+    if (layout == CblasLayout::RowMajor)
+        return {toChar(transB), toChar(transA), size_t(n), size_t(m), size_t(k), alpha, B, size_t(ldb), A, size_t(lda), beta, C, size_t(ldc)};
+    return {toChar(transA), toChar(transB), size_t(m), size_t(n), size_t(k), alpha, A, size_t(lda), B, size_t(ldb), beta, C, size_t(ldc)};
+}
+
+/// Criteria for the booster path of the BLAS interface
+struct BoosterSettings
+{
+    /// Minimal m, n and k for the booster path, smaller calls are passed to the system BLAS
+    size_t minDimension = 1024;
+
+    /// At least one operand must have a lower estimated occupation
+    double maxOccupation = 0.3;
+
+    /// Number of elements sampled per operand for the estimation of the occupation
+    size_t nbSamples = 4096;
+
+    ConverterSettings converter;
+
+    /// Default settings overwritten by BLASBOOSTER_MIN_DIMENSION, BLASBOOSTER_MAX_OCCUPATION,
+    /// BLASBOOSTER_BLOCK_SIZE and BLASBOOSTER_THRESHOLD
+    static BoosterSettings fromEnvironment()
+    {
+        BoosterSettings settings;
+        if (const char* value = std::getenv("BLASBOOSTER_MIN_DIMENSION")) settings.minDimension = std::stoul(value);
+        if (const char* value = std::getenv("BLASBOOSTER_MAX_OCCUPATION")) settings.maxOccupation = std::stod(value);
+        if (const char* value = std::getenv("BLASBOOSTER_BLOCK_SIZE")) settings.converter.blockSize = std::stoul(value);
+        if (const char* value = std::getenv("BLASBOOSTER_THRESHOLD")) settings.converter.threshold = std::stod(value);
+        return settings;
+    }
+};
+
+/**
+ * Occupation of a m x n matrix estimated by the SparsityEstimator with at most nbSamples elements,
+ * which are distributed over all blocks. Single-threaded, because the sampling is cheap compared
+ * to the call.
+ */
+template <class T>
+double sampleOccupation(T const* data, size_t rs, size_t cs, size_t m, size_t n, size_t nbSamples, double threshold)
+{
+    EstimatorSettings settings;
+    settings.maxSamples = nbSamples;
+    settings.nbTilesPerBlock = std::numeric_limits<size_t>::max();
+    settings.threshold = threshold;
+    return SparsityEstimator(settings, WorkStealingScheduler(1)).estimate(data, rs, cs, m, n).occupation.value;
+}
+
+/// True if the call is large enough and at least one operand looks sparse
+template <class T>
+bool isBoostable(GemmCall<T> const& call, BoosterSettings const& settings)
+{
+    if (std::min({call.m, call.n, call.k}) < settings.minDimension) return false;
+    if (call.alpha == T(0)) return false;
+
+    double occupationA = sampleOccupation(call.A, call.getRowStrideA(), call.getColumnStrideA(),
+        call.m, call.k, settings.nbSamples, settings.converter.threshold);
+    if (occupationA < settings.maxOccupation) return true;
+
+    double occupationB = sampleOccupation(call.B, call.getRowStrideB(), call.getColumnStrideB(),
+        call.k, call.n, settings.nbSamples, settings.converter.threshold);
+    return occupationB < settings.maxOccupation;
+}
+
+/**
+ * \brief xgemm by the blocked BlasBooster path.
+ *
+ * The operands are converted into blocked matrices, multiplied by the dispatch
+ * table and the tiles are added to C in parallel. For beta equal to zero C is not read.
+ */
+template <class T>
+void boostedGemm(GemmCall<T> const& call, BoosterSettings const& settings,
+    WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+{
+    typedef Matrix<Dense, DynamicMatrix, Parameter<size_t, ColumnMajor, VariableSize, NoLeadingDimension, UnblockedDimension>> BlockedMatrix;
+
+    MatrixConverter converter(settings.converter, scheduler);
+    BlockedMatrix A, B, C;
+    converter.convert(call.A, call.getRowStrideA(), call.getColumnStrideA(), call.m, call.k, A);
+    converter.convert(call.B, call.getRowStrideB(), call.getColumnStrideB(), call.k, call.n, B);
+
+    multiplyBlocked(A, B, C, scheduler);
+
+    std::vector<size_t> rowOffsets(C.getNbRows() + 1, 0), columnOffsets(C.getNbColumns() + 1, 0);
+    for (size_t bi = 0; bi != C.getNbRows(); ++bi) rowOffsets[bi + 1] = rowOffsets[bi] + C(bi, 0).getNbRows();
+    for (size_t bj = 0; bj != C.getNbColumns(); ++bj) columnOffsets[bj + 1] = columnOffsets[bj] + C(0, bj).getNbColumns();
+
+    scheduler.run(C.getNbRows() * C.getNbColumns(), [&](size_t index)
+    {
+        size_t bi = index % C.getNbRows(), bj = index / C.getNbRows();
+        auto const& tile = C(bi, bj).template get<Matrix<Dense,double>>();
+        T* c = call.C + rowOffsets[bi] + columnOffsets[bj] * call.ldc;
+        const double alpha = call.alpha, beta = call.beta;
+        for (size_t j = 0; j != tile.getNbColumns(); ++j) {
+            for (size_t i = 0; i != tile.getNbRows(); ++i) {
+                double value = alpha * tile(i, j);
+                if (beta != 0.0) value += beta * c[i + j * call.ldc];
+                c[i + j * call.ldc] = static_cast<T>(value);
+            }
+        }
+    });
+}
+
+/// Dispatch of a xgemm call to the booster path or to the system BLAS
+template <class T>
+void gemm(GemmCall<T> const& call, BoosterSettings const& settings)
+{
+    if (isBoostable(call, settings)) {
+        boostedGemm(call, settings);
+        return;
+    }
+
+    blas_int m = call.m, n = call.n, k = call.k, lda = call.lda, ldb = call.ldb, ldc = call.ldc;
+    SystemBlas::instance().gemm<T>()(&call.transA, &call.transB, &m, &n, &k, &call.alpha,
+        call.A, &lda, call.B, &ldb, &call.beta, call.C, &ldc);
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <xsimd/xsimd.hpp>
+
+namespace BlasBooster {
+
+/**
+ * \brief Small dense products of the tiles of a block-sparse matrix.
+ *
+ * C += alpha * A * B with A (m x k), B (k x n) and C (m x n) of arbitrary row
+ * and column strides, where the inner dimension k is the tile size. One of the
+ * operands is a tile, the other one a tile or a panel of a dense matrix.
+ *
+ * If the columns of A and C are contiguous (ColumnMajor tiles and dense
+ * matrices), the columns of A are held in SIMD registers and each element of B
+ * adds a scaled column of A to a column of C. If the rows of B and C are
+ * contiguous (RowMajor), each element of A adds a scaled row of B to a row of
+ * C. All other stride combinations use the scalar path. With k equal to the
+ * compile-time tile size the loops over k are unrolled.
+ *
+ * T: compute type, vectorized paths are only used if all value types are T.
+ */
+template <class T>
+struct BlockSparseKernel
+{
+    typedef xsimd::batch<T> batch;
+
+    static constexpr size_t simdSize = batch::size;
+
+    template <size_t TileSize, class TA, class TB, class TC>
+    static void multiply(size_t m, size_t n, size_t k, TC alpha,
+        TA const* a, size_t rsA, size_t csA,
+        TB const* b, size_t rsB, size_t csB,
+        TC* c, size_t rsC, size_t csC)
+    {
+        if (TileSize and k == TileSize) tileMultiply<TileSize>(m, n, alpha, a, rsA, csA, b, rsB, csB, c, rsC, csC, k);
+        else tileMultiply<0>(m, n, alpha, a, rsA, csA, b, rsB, csB, c, rsC, csC, k);
+    }
+
+private:
+
+    /// K: inner dimension known at compile time, 0 for the runtime value k
+    template <size_t K, class TA, class TB, class TC>
+    static void tileMultiply(size_t m, size_t n, TC alpha,
+        TA const* a, size_t rsA, size_t csA,
+        TB const* b, size_t rsB, size_t csB,
+        TC* c, size_t rsC, size_t csC, size_t k);
+
+    template <class TA, class TB, class TC>
+    static constexpr bool isVectorizable()
+    {
+        return std::is_same<TA,T>::value and std::is_same<TB,T>::value and std::is_same<TC,T>::value;
+    }
+
+};
+
+template <class T>
+template <size_t K, class TA, class TB, class TC>
+void BlockSparseKernel<T>::tileMultiply(size_t m, size_t n, TC alpha,
+    TA const* a, size_t rsA, size_t csA,
+    TB const* b, size_t rsB, size_t csB,
+    TC* c, size_t rsC, size_t csC, size_t k)
+{
+    const size_t kk = K ? K : k;
+    size_t i0 = 0, j0 = 0;
+
+    if constexpr (isVectorizable<TA,TB,TC>()) {
+        if (rsA == 1 and rsC == 1) {
+            // C(:,j) += A(:,l) * alpha * B(l,j), SIMD over the rows
+            for (; i0 + simdSize <= m; i0 += simdSize) {
+                if constexpr (K != 0) {
+                    batch va[K];
+                    for (size_t l = 0; l != K; ++l) va[l] = batch::load_unaligned(a + i0 + l * csA);
+                    for (size_t j = 0; j != n; ++j) {
+                        T* cj = c + i0 + j * csC;
+                        batch sum = batch::load_unaligned(cj);
+                        for (size_t l = 0; l != K; ++l) sum = xsimd::fma(va[l], batch(alpha * b[l * rsB + j * csB]), sum);
+                        sum.store_unaligned(cj);
+                    }
+                } else {
+                    for (size_t j = 0; j != n; ++j) {
+                        T* cj = c + i0 + j * csC;
+                        batch sum = batch::load_unaligned(cj);
+                        for (size_t l = 0; l != kk; ++l)
+                            sum = xsimd::fma(batch::load_unaligned(a + i0 + l * csA), batch(alpha * b[l * rsB + j * csB]), sum);
+                        sum.store_unaligned(cj);
+                    }
+                }
+            }
+        } else if (csB == 1 and csC == 1) {
+            // C(i,:) += alpha * A(i,l) * B(l,:), SIMD over the columns
+            for (; j0 + simdSize <= n; j0 += simdSize) {
+                for (size_t i = 0; i != m; ++i) {
+                    T* ci = c + i * rsC + j0;
+                    batch sum = batch::load_unaligned(ci);
+                    for (size_t l = 0; l != kk; ++l)
+                        sum = xsimd::fma(batch(alpha * a[i * rsA + l * csA]), batch::load_unaligned(b + l * rsB + j0), sum);
+                    sum.store_unaligned(ci);
+                }
+            }
+        }
+    }
+
+    // Scalar path for the remaining rows i >= i0 or columns j >= j0, only one of both was vectorized
+    for (size_t j = j0; j != n; ++j) {
+        for (size_t i = i0; i != m; ++i) {
+            T sum(0);
+            for (size_t l = 0; l != kk; ++l) sum += static_cast<T>(a[i * rsA + l * csA]) * static_cast<T>(b[l * rsB + j * csB]);
+            c[i * rsC + j * csC] += alpha * static_cast<TC>(sum);
+        }
+    }
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,390 @@
+#pragma once
+
+#include "DynamicMatrix.h"
+#include "DynamicMatrixTypeList.h"
+#include "Matrix.h"
+#include "MatrixBase.h"
+#include "NormPolicy.h"
+#include "Storage.h"
+#include "TypeName.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/**
+ * \brief Block-compressed sparse matrix of dense square tiles (BSR and BSC).
+ *
+ * The matrix is divided into tiles of tileSize x tileSize elements and only
+ * the tiles with a significant element are stored. The key and offset arrays
+ * are those of Matrix<Sparse>, but with one key per tile instead of one per
+ * element: for RowMajor (BSR) the outer index is the tile row and the key the
+ * tile column, for ColumnMajor (BSC) vice versa. The elements of a tile are
+ * stored contiguously in the orientation of the matrix, tile e starts at
+ * begin() + e * tileSize * tileSize. The tiles of the last tile row and column
+ * may exceed the matrix, their excess elements are zero.
+ *
+ * TileSize: edge length fixed at compile time, 0 for a tile size given at runtime.
+ */
+template <size_t TileSize, class T, class P>
+class Matrix<BlockSparse<TileSize>,T,P>
+ : public MatrixBase,
+   public P::dimension,
+   public NormPolicy<Matrix<BlockSparse<TileSize>,T,P>, typename P::NormType>
+{
+public: // typedefs
+
+    typedef Matrix<BlockSparse<TileSize>,T,P> self;
+    typedef BlockSparse<TileSize> matrix_type;
+    typedef T value_type;
+    typedef P parameter;
+    typedef typename P::dimension dimension;
+    typedef typename P::orientation orientation;
+    typedef typename P::IndexType IndexType;
+    typedef NormPolicy<self, typename P::NormType> norm_policy;
+    typedef Storage<T,false,false,0,false,typename P::AllocatorType> value_storage;
+    typedef Storage<IndexType,false,false,0,false,typename P::AllocatorType> index_storage;
+    typedef typename value_storage::iterator iterator;
+    typedef typename value_storage::const_iterator const_iterator;
+    typedef typename index_storage::iterator index_iterator;
+    typedef typename index_storage::const_iterator const_index_iterator;
+
+    static_assert(!P::isFixed, "BlockSparseMatrix: only variable sized matrices are supported.");
+
+    static constexpr bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+
+public:
+
+    /// Default constructor
+    Matrix();
+
+    /// Parameter constructor
+    /// Storage for nbTiles tiles is allocated, the offsets are zero. The tile size must be given for TileSize = 0.
+    Matrix(IndexType nbRows, IndexType nbColumns, IndexType nbTiles = 0, size_t tileSize = TileSize);
+
+    /// Parameter constructor taking over the value, key and offset arrays without copying
+    Matrix(IndexType nbRows, IndexType nbColumns, value_storage&& values, index_storage&& keys,
+        index_storage&& offsets, size_t tileSize = TileSize);
+
+    /// Conversion from a nbRows x nbColumns matrix in external memory with arbitrary strides
+    /// Tiles with an element passing checker are stored, the other elements of the tile are zero.
+    template <class T2>
+    Matrix(T2 const* data, size_t rs, size_t cs, IndexType nbRows, IndexType nbColumns,
+        auto const& checker, size_t tileSize = TileSize);
+
+    /// Conversion from DenseMatrix, see above
+    template <class T2, class P2>
+    Matrix(Matrix<Dense,T2,P2> const& other, auto const& checker, size_t tileSize = TileSize);
+
+    /// Conversion from SparseMatrix, tiles with a stored element are stored
+    template <class T2, class P2>
+    Matrix(Matrix<Sparse,T2,P2> const& other, size_t tileSize = TileSize);
+
+    Matrix(Matrix const& other) = default;
+
+    Matrix(Matrix&& other) = default;
+
+    ~Matrix() = default;
+
+    Matrix& operator = (Matrix const& other) = default;
+
+    Matrix& operator = (Matrix&& other) = default;
+
+    /// Storage for nbTiles tiles is allocated, the offsets are zero.
+    void resize(IndexType nbRows, IndexType nbColumns, IndexType nbTiles = 0);
+
+    bool operator == (Matrix const& rhs) const {
+        return dimension::operator==(rhs) and getTileSize() == rhs.getTileSize()
+            and std::equal(beginOffset(), endOffset(), rhs.beginOffset(), rhs.endOffset())
+            and std::equal(beginKey(), endKey(), rhs.beginKey(), rhs.endKey())
+            and std::equal(begin(), end(), rhs.begin(), rhs.end());
+    }
+
+    /// Element (i, j), zero outside of the stored tiles
+    T operator () (IndexType i, IndexType j) const;
+
+    size_t getTileSize() const { return TileSize ? TileSize : tileSize_; }
+
+    size_t getNbTileRows() const { return getNbTiles(this->getNbRows()); }
+    size_t getNbTileColumns() const { return getNbTiles(this->getNbColumns()); }
+
+    /// Number of tile rows (RowMajor) or tile columns (ColumnMajor)
+    size_t getNbOuterTiles() const { return columnMajor ? getNbTileColumns() : getNbTileRows(); }
+
+    /// Number of stored tiles
+    size_t getNbTiles() const { return key_.size(); }
+
+    /// Number of stored elements including the zeros within the tiles
+    size_t nnz() const { return value_.size(); }
+
+    /// Number of rows and columns of the tiles within the matrix, smaller than the tile size at the border
+    size_t getTileRows(size_t tileRow) const { return std::min(getTileSize(), this->getNbRows() - tileRow * getTileSize()); }
+    size_t getTileColumns(size_t tileColumn) const { return std::min(getTileSize(), this->getNbColumns() - tileColumn * getTileSize()); }
+
+    /// Strides of the elements within a tile
+    size_t getTileRowStride() const { return columnMajor ? 1 : getTileSize(); }
+    size_t getTileColumnStride() const { return columnMajor ? getTileSize() : 1; }
+
+    T* getTile(size_t e) { return value_.getDataPointer() + e * getTileSize() * getTileSize(); }
+    T const* getTile(size_t e) const { return value_.getDataPointer() + e * getTileSize() * getTileSize(); }
+
+    /// Call f(tileRow, tileColumn, e) for all stored tiles e in storage order
+    template <class F>
+    void forEachTile(F const& f) const;
+
+    /// Call f(i, j, value) for all stored elements within the matrix, the elements of each row and column in ascending order
+    template <class F>
+    void forEachElement(F const& f) const;
+
+    iterator begin() { return value_.begin(); }
+    const_iterator begin() const { return value_.begin(); }
+    iterator end() { return value_.end(); }
+    const_iterator end() const { return value_.end(); }
+
+    index_iterator beginKey() { return key_.begin(); }
+    const_index_iterator beginKey() const { return key_.begin(); }
+    index_iterator endKey() { return key_.end(); }
+    const_index_iterator endKey() const { return key_.end(); }
+
+    index_iterator beginOffset() { return offset_.begin(); }
+    const_index_iterator beginOffset() const { return offset_.begin(); }
+    index_iterator endOffset() { return offset_.end(); }
+    const_index_iterator endOffset() const { return offset_.end(); }
+
+    const std::type_info& getTypeInfo() const { return typeid(*this); }
+
+    size_t getTypeIndex() const { return typeIndex_; }
+
+    double getNorm() const { return this->norm(); }
+
+    static constexpr size_t typeIndex_ = GetIndex<self, DynamicMatrixTypeList>::value;
+
+    static const std::string name() {
+        return "Matrix<BlockSparse<" + std::to_string(TileSize) + ">," + TypeName<T>::value() + ">";
+    }
+
+private:
+
+    static size_t checkTileSize(size_t tileSize)
+    {
+        if (tileSize == 0) throw std::runtime_error("BlockSparseMatrix: tile size must be positive.");
+        if (TileSize and tileSize != TileSize)
+            throw std::runtime_error("BlockSparseMatrix: tile size differs from the compile-time tile size.");
+        return tileSize;
+    }
+
+    size_t getNbTiles(size_t n) const { return getTileSize() ? (n + getTileSize() - 1) / getTileSize() : 0; }
+
+    size_t tileSize_;
+
+    value_storage value_;
+    index_storage key_;
+    index_storage offset_;
+
+};
+
+template <size_t TileSize, class T, class P>
+Matrix<BlockSparse<TileSize>,T,P>::Matrix()
+ : dimension(), tileSize_(TileSize), offset_(1)
+{
+    offset_.getDataPointer()[0] = 0;
+}
+
+template <size_t TileSize, class T, class P>
+Matrix<BlockSparse<TileSize>,T,P>::Matrix(IndexType nbRows, IndexType nbColumns, IndexType nbTiles, size_t tileSize)
+ : dimension(nbRows, nbColumns),
+   tileSize_(checkTileSize(tileSize)),
+   value_(nbTiles * tileSize_ * tileSize_),
+   key_(nbTiles),
+   offset_(getNbOuterTiles() + 1)
+{
+    std::fill(beginOffset(), endOffset(), IndexType(0));
+}
+
+template <size_t TileSize, class T, class P>
+Matrix<BlockSparse<TileSize>,T,P>::Matrix(IndexType nbRows, IndexType nbColumns, value_storage&& values,
+    index_storage&& keys, index_storage&& offsets, size_t tileSize)
+ : dimension(nbRows, nbColumns),
+   tileSize_(checkTileSize(tileSize)),
+   value_(std::move(values)),
+   key_(std::move(keys)),
+   offset_(std::move(offsets))
+{
+    if (offset_.size() != getNbOuterTiles() + 1)
+        throw std::runtime_error("BlockSparseMatrix: wrong number of offsets.");
+    if (value_.size() != key_.size() * tileSize_ * tileSize_)
+        throw std::runtime_error("BlockSparseMatrix: number of tiles and values differ.");
+}
+
+// Conversion from strided memory
+template <size_t TileSize, class T, class P>
+template <class T2, class ValueChecker>
+Matrix<BlockSparse<TileSize>,T,P>::Matrix(T2 const* data, size_t rs, size_t cs, IndexType nbRows, IndexType nbColumns,
+    ValueChecker const& valueChecker, size_t tileSize)
+ : dimension(nbRows, nbColumns),
+   tileSize_(checkTileSize(tileSize)),
+   offset_(getNbOuterTiles() + 1)
+{
+    const size_t b = tileSize_;
+    const size_t nbOuter = getNbOuterTiles();
+    const size_t nbInner = columnMajor ? getNbTileRows() : getNbTileColumns();
+    const size_t strideOuter = columnMajor ? cs : rs;
+    const size_t strideInner = columnMajor ? rs : cs;
+    auto element = [&](size_t outer, size_t inner) { return data[outer * strideOuter + inner * strideInner]; };
+
+    // Keys of the tiles with a significant element
+    std::vector<IndexType> keys;
+    IndexType* offset = offset_.getDataPointer();
+    offset[0] = 0;
+    for (size_t outer = 0; outer != nbOuter; ++outer) {
+        const size_t outerEnd = std::min(this->getMinorDimension(), (outer + 1) * b);
+        for (size_t inner = 0; inner != nbInner; ++inner) {
+            const size_t innerEnd = std::min(this->getMajorDimension(), (inner + 1) * b);
+            bool significant = false;
+            for (size_t o = outer * b; o != outerEnd and !significant; ++o)
+                for (size_t i = inner * b; i != innerEnd and !significant; ++i) significant = valueChecker(element(o, i));
+            if (significant) keys.push_back(inner);
+        }
+        offset[outer + 1] = keys.size();
+    }
+
+    key_ = index_storage(keys.size());
+    std::copy(keys.begin(), keys.end(), beginKey());
+    value_ = value_storage(keys.size() * b * b);
+    value_.fill(T(0));
+
+    for (size_t outer = 0; outer != nbOuter; ++outer) {
+        const size_t outerEnd = std::min(this->getMinorDimension(), (outer + 1) * b);
+        for (size_t e = offset[outer]; e != offset[outer + 1]; ++e) {
+            const size_t inner = keys[e];
+            const size_t innerEnd = std::min(this->getMajorDimension(), (inner + 1) * b);
+            T* tile = getTile(e);
+            for (size_t o = outer * b; o != outerEnd; ++o)
+                for (size_t i = inner * b; i != innerEnd; ++i) {
+                    T2 const& value = element(o, i);
+                    if (valueChecker(value)) tile[(o - outer * b) * b + i - inner * b] = static_cast<T>(value);
+                }
+        }
+    }
+}
+
+// Conversion from DenseMatrix
+template <size_t TileSize, class T, class P>
+template <class T2, class P2, class ValueChecker>
+Matrix<BlockSparse<TileSize>,T,P>::Matrix(Matrix<Dense,T2,P2> const& other, ValueChecker const& valueChecker, size_t tileSize)
+ : Matrix(other.getDataPointer(), getRowStride(other), getColumnStride(other), other.getNbRows(), other.getNbColumns(),
+     valueChecker, tileSize)
+{}
+
+// Conversion from SparseMatrix
+template <size_t TileSize, class T, class P>
+template <class T2, class P2>
+Matrix<BlockSparse<TileSize>,T,P>::Matrix(Matrix<Sparse,T2,P2> const& other, size_t tileSize)
+ : dimension(other.getNbRows(), other.getNbColumns()),
+   tileSize_(checkTileSize(tileSize)),
+   offset_(getNbOuterTiles() + 1)
+{
+    const bool sparseColumnMajor = std::is_same<typename P2::orientation, ColumnMajor>::value;
+    const size_t b = tileSize_;
+    const size_t nbOuter = getNbOuterTiles();
+
+    // Call f(outer tile, inner tile, position in the tile, value) for all elements of other
+    auto forEachSparse = [&](auto const& f) {
+        auto value = other.begin();
+        auto key = other.beginKey();
+        auto offset = other.beginOffset();
+        for (size_t line = 0; line != other.getMinorDimension(); ++line) {
+            for (auto e = offset[line]; e != offset[line + 1]; ++e) {
+                const size_t i = sparseColumnMajor ? key[e] : line;
+                const size_t j = sparseColumnMajor ? line : key[e];
+                const size_t outer = columnMajor ? j : i, inner = columnMajor ? i : j;
+                f(outer / b, inner / b, (outer % b) * b + inner % b, value[e]);
+            }
+        }
+    };
+
+    std::vector<std::vector<IndexType>> lines(nbOuter);
+    forEachSparse([&](size_t outer, size_t inner, size_t, T2 const&) {
+        if (lines[outer].empty() or lines[outer].back() != inner) lines[outer].push_back(inner);
+    });
+
+    IndexType* offset = offset_.getDataPointer();
+    offset[0] = 0;
+    for (size_t outer = 0; outer != nbOuter; ++outer) {
+        std::sort(lines[outer].begin(), lines[outer].end());
+        lines[outer].erase(std::unique(lines[outer].begin(), lines[outer].end()), lines[outer].end());
+        offset[outer + 1] = offset[outer] + lines[outer].size();
+    }
+
+    key_ = index_storage(offset[nbOuter]);
+    for (size_t outer = 0; outer != nbOuter; ++outer) std::copy(lines[outer].begin(), lines[outer].end(), key_.begin() + offset[outer]);
+    value_ = value_storage(offset[nbOuter] * b * b);
+    value_.fill(T(0));
+
+    forEachSparse([&](size_t outer, size_t inner, size_t position, T2 const& value) {
+        auto first = beginKey() + offset[outer], last = beginKey() + offset[outer + 1];
+        getTile(std::lower_bound(first, last, inner) - beginKey())[position] = static_cast<T>(value);
+    });
+}
+
+template <size_t TileSize, class T, class P>
+void Matrix<BlockSparse<TileSize>,T,P>::resize(IndexType nbRows, IndexType nbColumns, IndexType nbTiles)
+{
+    dimension::resize(nbRows, nbColumns);
+    value_.resize(nbTiles * getTileSize() * getTileSize());
+    key_.resize(nbTiles);
+    offset_.resize(getNbOuterTiles() + 1);
+    std::fill(beginOffset(), endOffset(), IndexType(0));
+    this->invalidateNorm();
+}
+
+template <size_t TileSize, class T, class P>
+T Matrix<BlockSparse<TileSize>,T,P>::operator () (IndexType i, IndexType j) const
+{
+    const size_t b = getTileSize();
+    const size_t outer = columnMajor ? j : i, inner = columnMajor ? i : j;
+    auto first = beginKey() + offset_.getDataPointer()[outer / b];
+    auto last = beginKey() + offset_.getDataPointer()[outer / b + 1];
+    auto iter = std::lower_bound(first, last, inner / b);
+    if (iter == last or *iter != inner / b) return T(0);
+    return getTile(iter - beginKey())[(outer % b) * b + inner % b];
+}
+
+template <size_t TileSize, class T, class P>
+template <class F>
+void Matrix<BlockSparse<TileSize>,T,P>::forEachTile(F const& f) const
+{
+    IndexType const* offset = offset_.getDataPointer();
+    IndexType const* key = key_.getDataPointer();
+    for (size_t outer = 0; outer != getNbOuterTiles(); ++outer)
+        for (size_t e = offset[outer]; e != offset[outer + 1]; ++e)
+            f(columnMajor ? size_t(key[e]) : outer, columnMajor ? outer : size_t(key[e]), e);
+}
+
+template <size_t TileSize, class T, class P>
+template <class F>
+void Matrix<BlockSparse<TileSize>,T,P>::forEachElement(F const& f) const
+{
+    const size_t b = getTileSize();
+    IndexType const* offset = offset_.getDataPointer();
+    IndexType const* key = key_.getDataPointer();
+    for (size_t outer = 0; outer != getNbOuterTiles(); ++outer) {
+        const size_t outerSize = std::min(b, this->getMinorDimension() - outer * b);
+        for (size_t e = offset[outer]; e != offset[outer + 1]; ++e) {
+            const size_t innerSize = std::min(b, this->getMajorDimension() - key[e] * b);
+            T const* tile = getTile(e);
+            for (size_t o = 0; o != outerSize; ++o)
+                for (size_t i = 0; i != innerSize; ++i) {
+                    const size_t globalOuter = outer * b + o, globalInner = key[e] * b + i;
+                    f(columnMajor ? globalInner : globalOuter, columnMajor ? globalOuter : globalInner, tile[o * b + i]);
+                }
+        }
+    }
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "BlockSparseKernel.h"
+#include "BlockSparseMatrix.h"
+#include "DenseMatrix.h"
+#include "MultiplicationFunctor.h"
+#include "SparseMatrix.h"
+#include "SparseMultiplication.h"
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/**
+ * \brief Native multiplication of a block-sparse and a dense matrix.
+ *
+ * Each stored tile A(I,K) multiplies the tile row K of B into the tile row I
+ * of C. The columns of B and C are processed in panels, so that the panel of
+ * C stays in the cache while all tiles are applied.
+ */
+template <size_t TileSize, class T1, class P1, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<BlockSparse<TileSize>, T1, P1, Dense, T2, P2, Dense, T3, P3, Native>
+{
+    typedef typename std::common_type<T1,T2>::type compute_type;
+
+    /// Number of columns of B and C per panel
+    static constexpr size_t panelWidth = 64;
+
+    void operator () (Matrix<BlockSparse<TileSize>,T1,P1> const& A, Matrix<Dense,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<BlockSparse,Dense,Dense,Native>: dimension mismatch.");
+
+        scale(C, beta);
+
+        const size_t tileSize = A.getTileSize();
+        const size_t rsB = getRowStride(B), csB = getColumnStride(B);
+        const size_t rsC = getRowStride(C), csC = getColumnStride(C);
+
+        for (size_t j = 0; j < B.getNbColumns(); j += panelWidth) {
+            const size_t n = std::min(panelWidth, B.getNbColumns() - j);
+            A.forEachTile([&](size_t I, size_t K, size_t e) {
+                BlockSparseKernel<compute_type>::template multiply<TileSize>(A.getTileRows(I), n, A.getTileColumns(K), alpha,
+                    A.getTile(e), A.getTileRowStride(), A.getTileColumnStride(),
+                    B.getDataPointer() + K * tileSize * rsB + j * csB, rsB, csB,
+                    C.getDataPointer() + I * tileSize * rsC + j * csC, rsC, csC);
+            });
+        }
+    }
+};
+
+/**
+ * \brief Native multiplication of a dense and a block-sparse matrix.
+ *
+ * Each stored tile B(K,J) adds the product of the tile column K of A into the
+ * tile column J of C.
+ */
+template <class T1, class P1, size_t TileSize, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Dense, T1, P1, BlockSparse<TileSize>, T2, P2, Dense, T3, P3, Native>
+{
+    typedef typename std::common_type<T1,T2>::type compute_type;
+
+    void operator () (Matrix<Dense,T1,P1> const& A, Matrix<BlockSparse<TileSize>,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Dense,BlockSparse,Dense,Native>: dimension mismatch.");
+
+        scale(C, beta);
+
+        const size_t tileSize = B.getTileSize();
+        const size_t rsA = getRowStride(A), csA = getColumnStride(A);
+        const size_t rsC = getRowStride(C), csC = getColumnStride(C);
+
+        B.forEachTile([&](size_t K, size_t J, size_t e) {
+            BlockSparseKernel<compute_type>::template multiply<TileSize>(A.getNbRows(), B.getTileColumns(J), B.getTileRows(K), alpha,
+                A.getDataPointer() + K * tileSize * csA, rsA, csA,
+                B.getTile(e), B.getTileRowStride(), B.getTileColumnStride(),
+                C.getDataPointer() + J * tileSize * csC, rsC, csC);
+        });
+    }
+};
+
+/**
+ * \brief Native multiplication of two block-sparse matrices with equal tile size.
+ *
+ * C(I,J) += A(I,K) * B(K,J) for all pairs of stored tiles. The tiles of B are
+ * indexed by tile row first, so that both orientations of B are covered.
+ */
+template <size_t TileSize1, class T1, class P1, size_t TileSize2, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<BlockSparse<TileSize1>, T1, P1, BlockSparse<TileSize2>, T2, P2, Dense, T3, P3, Native>
+{
+    typedef typename std::common_type<T1,T2>::type compute_type;
+
+    static_assert(TileSize1 == 0 or TileSize2 == 0 or TileSize1 == TileSize2,
+        "MultiplicationFunctor<BlockSparse,BlockSparse,Dense,Native>: tile sizes differ.");
+
+    static constexpr size_t TileSize = TileSize1 ? TileSize1 : TileSize2;
+
+    void operator () (Matrix<BlockSparse<TileSize1>,T1,P1> const& A, Matrix<BlockSparse<TileSize2>,T2,P2> const& B,
+        Matrix<Dense,T3,P3>& C, T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<BlockSparse,BlockSparse,Dense,Native>: dimension mismatch.");
+        if (A.getTileSize() != B.getTileSize())
+            throw std::runtime_error("MultiplicationFunctor<BlockSparse,BlockSparse,Dense,Native>: tile sizes differ.");
+
+        scale(C, beta);
+
+        const size_t tileSize = A.getTileSize();
+        const size_t rsC = getRowStride(C), csC = getColumnStride(C);
+
+        // Tiles of B (tile column, tile index) sorted by tile row
+        const size_t nbTileRowsB = B.getNbTileRows();
+        std::vector<size_t> rowOffset(nbTileRowsB + 1, 0);
+        std::vector<std::pair<size_t, size_t>> rowTiles(B.getNbTiles());
+        B.forEachTile([&](size_t K, size_t, size_t) { ++rowOffset[K + 1]; });
+        for (size_t K = 0; K != nbTileRowsB; ++K) rowOffset[K + 1] += rowOffset[K];
+        std::vector<size_t> cursor(rowOffset.begin(), rowOffset.end() - 1);
+        B.forEachTile([&](size_t K, size_t J, size_t e) { rowTiles[cursor[K]++] = {J, e}; });
+
+        A.forEachTile([&](size_t I, size_t K, size_t ea) {
+            T1 const* tileA = A.getTile(ea);
+            for (size_t t = rowOffset[K]; t != rowOffset[K + 1]; ++t) {
+                const size_t J = rowTiles[t].first;
+                BlockSparseKernel<compute_type>::template multiply<TileSize>(A.getTileRows(I), B.getTileColumns(J), A.getTileColumns(K), alpha,
+                    tileA, A.getTileRowStride(), A.getTileColumnStride(),
+                    B.getTile(rowTiles[t].second), B.getTileRowStride(), B.getTileColumnStride(),
+                    C.getDataPointer() + I * tileSize * rsC + J * tileSize * csC, rsC, csC);
+            }
+        });
+    }
+};
+
+/// Multiplication of a block-sparse and a sparse matrix, the block-sparse matrix is converted into sparse
+template <size_t TileSize, class T1, class P1, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<BlockSparse<TileSize>, T1, P1, Sparse, T2, P2, Dense, T3, P3, Native>
+{
+    void operator () (Matrix<BlockSparse<TileSize>,T1,P1> const& A, Matrix<Sparse,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        Matrix<Sparse,T1,P1> sparseA(A, [](T1 const& value){ return value != T1(0); });
+        MultiplicationFunctor<Sparse, T1, P1, Sparse, T2, P2, Dense, T3, P3, Native>()(sparseA, B, C, alpha, beta);
+    }
+};
+
+/// Multiplication of a sparse and a block-sparse matrix, the block-sparse matrix is converted into sparse
+template <class T1, class P1, size_t TileSize, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Sparse, T1, P1, BlockSparse<TileSize>, T2, P2, Dense, T3, P3, Native>
+{
+    void operator () (Matrix<Sparse,T1,P1> const& A, Matrix<BlockSparse<TileSize>,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        Matrix<Sparse,T2,P2> sparseB(B, [](T2 const& value){ return value != T2(0); });
+        MultiplicationFunctor<Sparse, T1, P1, Sparse, T2, P2, Dense, T3, P3, Native>()(A, sparseB, C, alpha, beta);
+    }
+};
+
+} // namespace BlasBooster
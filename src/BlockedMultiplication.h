@@ -0,0 +1,142 @@
+#pragma once
+
+#include "CostModel.h"
+#include "DenseMatrix.h"
+#include "DynamicMatrix.h"
+#include "DynamicMatrixTypeList.h"
+#include "Memory.h"
+#include "WorkStealingScheduler.h"
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Options of the blocked multiplication
+struct BlockedMultiplicationSettings
+{
+    /// Products A_ik x B_kj with ||A_ik|| * ||B_kj|| below the tolerance are skipped, zero disables the screening
+    double screeningTolerance = 0.0;
+
+    /// Calibrated kernel runtimes used as cost estimate of the scheduler
+    std::shared_ptr<CostModel const> costModel = CostModel::getDefault();
+};
+
+/**
+ * \brief Blocked matrix multiplication C = A x B of DynamicMatrix blocks.
+ *
+ * The tile C_ij = sum_k A_ik x B_kj is a single task, so that each tile of C has
+ * exactly one owner and is never locked. The tasks are executed by the
+ * WorkStealingScheduler with the predicted runtime of the block products as cost
+ * estimate. Without calibrated cost model the number of dense floating point
+ * operations of the non-zero block products is used.
+ *
+ * With a positive screening tolerance the norm-based screening of SpAMM is applied:
+ * the product A_ik x B_kj is skipped if ||A_ik|| * ||B_kj|| < tolerance. For the
+ * submultiplicative NormOne and NormTwo the error of the tile C_ij is therefore
+ * bounded by the number of skipped products times the tolerance. The cached block
+ * norms are determined in a parallel pass before the multiplication.
+ *
+ * The tiles of C are Matrix<Dense,double>, the block products are accumulated by
+ * blockProduct(A_ik, B_kj, C_ij), which must add the product to C_ij. Temporary
+ * buffers of blockProduct may use the ArenaAllocator, which is rewound after each tile.
+ * The arenas of the workers are reset at the end of each phase, so that the chunks
+ * grown by the largest products are merged for the next phase.
+ */
+template <class PA, class PB, class PC, class BlockProduct>
+void multiplyBlocked(Matrix<Dense,DynamicMatrix,PA> const& A, Matrix<Dense,DynamicMatrix,PB> const& B,
+    Matrix<Dense,DynamicMatrix,PC>& C, BlockProduct const& blockProduct,
+    WorkStealingScheduler const& scheduler = WorkStealingScheduler(),
+    BlockedMultiplicationSettings const& settings = BlockedMultiplicationSettings())
+{
+    typedef Matrix<Dense,double> Tile;
+
+    static const size_t zeroTypeIndex = GetIndex<Matrix<Zero>, DynamicMatrixTypeList>::value;
+
+    if (A.getNbColumns() != B.getNbRows())
+        throw std::runtime_error("multiplyBlocked: number of blocks mismatch.");
+    if (A.getNbColumns() == 0)
+        throw std::runtime_error("multiplyBlocked: empty blocked matrix.");
+
+    const size_t nbBlockRows = A.getNbRows();
+    const size_t nbBlockColumns = B.getNbColumns();
+    const size_t nbInnerBlocks = A.getNbColumns();
+
+    C.resize(nbBlockRows, nbBlockColumns, A.getUnblockedRows(), B.getUnblockedColumns());
+
+    // The scratch memory of a phase is released, the calling thread may still use its arena outside
+    auto endPhase = [] {
+        ArenaPool::getGlobal().reset();
+        if (Arena::getLocal().getUsedBytes() == 0) Arena::getLocal().reset();
+    };
+
+    auto isZero = [](DynamicMatrix const& block) {
+        return block.empty() or block.getTypeIndex() == zeroTypeIndex;
+    };
+
+    // Empty DynamicMatrix blocks have no size, the tiles of C are sized by the block grid
+    const auto blockRows = getBlockRowSizes(A);
+    const auto blockColumns = getBlockColumnSizes(B);
+
+    // Each block is visited by a single task, so that the norm caches are written without race
+    std::vector<double> normA, normB;
+    if (settings.screeningTolerance > 0.0) {
+        normA.resize(nbBlockRows * nbInnerBlocks);
+        normB.resize(nbInnerBlocks * nbBlockColumns);
+        scheduler.run(normA.size() + normB.size(), [&](size_t index) {
+            if (index < normA.size()) normA[index] = A(index % nbBlockRows, index / nbBlockRows).getNorm();
+            else {
+                index -= normA.size();
+                normB[index] = B(index % nbInnerBlocks, index / nbInnerBlocks).getNorm();
+            }
+        });
+        endPhase();
+    }
+
+    auto skip = [&](size_t i, size_t k, size_t j) {
+        if (isZero(A(i, k)) or isZero(B(k, j))) return true;
+        return !normA.empty() and normA[i + k * nbBlockRows] * normB[k + j * nbInnerBlocks] < settings.screeningTolerance;
+    };
+
+    auto cost = [&](size_t task)
+    {
+        size_t i = task % nbBlockRows, j = task / nbBlockRows;
+        double sum = 0.0;
+        for (size_t k = 0; k != nbInnerBlocks; ++k) {
+            DynamicMatrix const& a = A(i, k);
+            DynamicMatrix const& b = B(k, j);
+            if (skip(i, k, j)) continue;
+            if (settings.costModel) sum += settings.costModel->predict(a.getTypeIndex(), b.getTypeIndex(), a.getNbRows(),
+                b.getNbColumns(), a.getNbColumns(), a.getOccupation(), b.getOccupation());
+            else sum += 2.0 * a.getNbRows() * a.getNbColumns() * b.getNbColumns();
+        }
+        return sum;
+    };
+
+    auto task = [&](size_t task)
+    {
+        size_t i = task % nbBlockRows, j = task / nbBlockRows;
+        // Scratch memory of the block products is released after each tile
+        ArenaScope scope;
+        Tile* tile = new Tile(blockRows[i], blockColumns[j]);
+        DynamicMatrix result(tile);
+        tile->fill(0.0);
+
+        for (size_t k = 0; k != nbInnerBlocks; ++k) {
+            DynamicMatrix const& a = A(i, k);
+            DynamicMatrix const& b = B(k, j);
+            if (a.empty() or b.empty()) continue;
+            if (a.getNbColumns() != b.getNbRows() or a.getNbRows() != tile->getNbRows() or b.getNbColumns() != tile->getNbColumns())
+                throw std::runtime_error("multiplyBlocked: block dimension mismatch.");
+            if (skip(i, k, j)) continue;
+            blockProduct(a, b, *tile);
+        }
+
+        C(i, j) = std::move(result);
+    };
+
+    scheduler.run(nbBlockRows * nbBlockColumns, task, cost);
+    endPhase();
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "CostModel.h"
+#include "DenseMatrix.h"
+#include "DynamicMatrix.h"
+#include "DynamicMatrixTypeList.h"
+#include "DynamicMultiplication.h"
+#include "MatrixConverter.h"
+#include "TypeList.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Sizes and occupations of the calibration blocks
+struct CalibrationSettings
+{
+    /// Edge lengths of the square blocks
+    std::vector<size_t> blockSizes{64, 128, 256};
+
+    /// Occupations of the sparse types, dense types are always fully occupied
+    std::vector<double> occupations{0.01, 0.03, 0.1, 0.3, 0.6, 1.0};
+
+    /// The minimum time of the repetitions is taken
+    size_t nbRepetitions = 3;
+
+    unsigned int seed = 42;
+};
+
+/// Dependency of the kernel work on the occupation of the matrix type X
+template <class X>
+struct CalibrationKind
+{
+    static constexpr CostModel::Kind value = CostModel::Kind::Dense;
+};
+
+template <class P>
+struct CalibrationKind<Matrix<Zero,NullType,P>>
+{
+    static constexpr CostModel::Kind value = CostModel::Kind::Zero;
+};
+
+template <class T, class P>
+struct CalibrationKind<Matrix<Sparse,T,P>>
+{
+    static constexpr CostModel::Kind value = CostModel::Kind::Sparse;
+};
+
+/// The work scales with the number of stored tiles
+template <size_t TileSize, class T, class P>
+struct CalibrationKind<Matrix<BlockSparse<TileSize>,T,P>>
+{
+    static constexpr CostModel::Kind value = CostModel::Kind::Sparse;
+};
+
+/// Edge length of the square tiles, in which the significant elements of the calibration blocks for X are clustered
+template <class X>
+struct CalibrationTileSize
+{
+    static constexpr size_t value = 1;
+};
+
+/// Fully occupied tiles, so that the occupation of the block-sparse matrix is the fraction of significant tiles
+template <size_t TileSize, class T, class P>
+struct CalibrationTileSize<Matrix<BlockSparse<TileSize>,T,P>>
+{
+    static constexpr size_t value = TileSize ? TileSize : BlockStatistics::tileSize;
+};
+
+/**
+ * \brief Determination of the cost model of the host by microbenchmarks.
+ *
+ * Random blocks of all types of DynamicMatrixTypeList are created for each
+ * block size and occupation. The significant elements are placed independently,
+ * for block-sparse types in fully occupied tiles (see CalibrationTileSize), so
+ * that all types are sampled over their whole range of occupations. The
+ * multiplication of all type pairs are timed using the dispatch table and the coefficients of the CostModel are fitted.
+ * Types without conversion and pairs without kernel are skipped.
+ */
+class Calibration
+{
+public:
+
+    typedef DynamicMatrixTypeList TypeList;
+
+    static const size_t nbTypes = GetSize<TypeList>::value;
+
+    Calibration(CalibrationSettings const& settings = CalibrationSettings())
+     : settings_(settings)
+    {}
+
+    CostModel operator () () const;
+
+private:
+
+    /// Random square block with the given occupation, the significant elements fill tiles of tileSize x tileSize
+    static Matrix<Dense,double> createSource(size_t size, double occupation, size_t tileSize, std::mt19937& generator)
+    {
+        Matrix<Dense,double> source(size, size);
+        std::uniform_real_distribution<double> value(0.5, 1.5);
+        std::bernoulli_distribution significant(occupation);
+        source.fill(0.0);
+        for (size_t tj = 0; tj < size; tj += tileSize) {
+            for (size_t ti = 0; ti < size; ti += tileSize) {
+                if (!significant(generator)) continue;
+                for (size_t j = tj; j != std::min(size, tj + tileSize); ++j)
+                    for (size_t i = ti; i != std::min(size, ti + tileSize); ++i) source(i, j) = value(generator);
+            }
+        }
+        return source;
+    }
+
+    /// Random square block with the given occupation converted into each type, empty if not available
+    std::vector<DynamicMatrix> createBlocks(size_t size, double occupation, std::mt19937& generator) const
+    {
+        std::vector<DynamicMatrix> blocks;
+        std::map<size_t, Matrix<Dense,double>> sources;
+        createBlocks(size, occupation, generator, sources, blocks, std::make_index_sequence<nbTypes>());
+        return blocks;
+    }
+
+    template <size_t... I>
+    static void createBlocks(size_t size, double occupation, std::mt19937& generator,
+        std::map<size_t, Matrix<Dense,double>>& sources, std::vector<DynamicMatrix>& blocks, std::index_sequence<I...>)
+    {
+        auto getSource = [&](size_t tileSize) -> Matrix<Dense,double> const& {
+            auto iter = sources.find(tileSize);
+            if (iter == sources.end()) iter = sources.emplace(tileSize, createSource(size, occupation, tileSize, generator)).first;
+            return iter->second;
+        };
+        (blocks.push_back(createBlock<typename GetType<I,TypeList>::type>(
+            getSource(CalibrationTileSize<typename GetType<I,TypeList>::type>::value))), ...);
+    }
+
+    template <class X>
+    static DynamicMatrix createBlock(Matrix<Dense,double> const& source)
+    {
+        auto statistics = MatrixConverter::analyse(source.getDataPointer(), getRowStride(source),
+            getColumnStride(source), source.getNbRows(), source.getNbColumns(), 0.0);
+        try {
+            return BlockConversion<X>::apply(source.getDataPointer(), getRowStride(source), getColumnStride(source),
+                source.getNbRows(), source.getNbColumns(), statistics, 0.0);
+        } catch (std::runtime_error const&) {
+            return DynamicMatrix();
+        }
+    }
+
+    template <size_t... I>
+    static void setKinds(CostModel& model, std::index_sequence<I...>)
+    {
+        (model.setKind(I, CalibrationKind<typename GetType<I,TypeList>::type>::value), ...);
+    }
+
+    /// Minimum time of C += A x B in seconds, negative if no kernel is available
+    double measure(DynamicMatrix const& A, DynamicMatrix const& B) const
+    {
+        Matrix<Dense,double> C(A.getNbRows(), B.getNbColumns());
+        C.fill(0.0);
+        double time = -1.0;
+        for (size_t r = 0; r != settings_.nbRepetitions; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            try {
+                multiply(A, B, C);
+            } catch (std::runtime_error const&) {
+                return -1.0;
+            }
+            std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+            time = time < 0.0 ? duration.count() : std::min(time, duration.count());
+        }
+        return time;
+    }
+
+    CalibrationSettings settings_;
+
+};
+
+inline CostModel Calibration::operator () () const
+{
+    if (settings_.blockSizes.empty() or settings_.occupations.empty())
+        throw std::runtime_error("Calibration: no block sizes or occupations given.");
+
+    CostModel model;
+    setKinds(model, std::make_index_sequence<nbTypes>());
+
+    std::mt19937 generator(settings_.seed);
+    std::vector<std::vector<CostSample>> samples(nbTypes * nbTypes);
+    std::vector<bool> available(nbTypes * nbTypes, true);
+
+    for (auto size : settings_.blockSizes) {
+
+        // blocks[o][t]: block of type t with occupation o
+        std::vector<std::vector<DynamicMatrix>> blocks;
+        for (auto occupation : settings_.occupations) blocks.push_back(createBlocks(size, occupation, generator));
+
+        for (size_t a = 0; a != nbTypes; ++a) {
+            for (size_t b = 0; b != nbTypes; ++b) {
+                // Occupation of dense types and zero matrices does not matter, the last source block is taken
+                size_t nbA = model.getKind(a) == CostModel::Kind::Sparse ? blocks.size() : 1;
+                size_t nbB = model.getKind(b) == CostModel::Kind::Sparse ? blocks.size() : 1;
+                for (size_t oa = 0; oa != nbA and available[a * nbTypes + b]; ++oa) {
+                    for (size_t ob = 0; ob != nbB and available[a * nbTypes + b]; ++ob) {
+                        DynamicMatrix const& A = blocks[nbA == 1 ? blocks.size() - 1 : oa][a];
+                        DynamicMatrix const& B = blocks[nbB == 1 ? blocks.size() - 1 : ob][b];
+                        if (A.empty() or B.empty()) { available[a * nbTypes + b] = false; break; }
+
+                        double time = measure(A, B);
+                        if (time < 0.0) { available[a * nbTypes + b] = false; break; }
+
+                        samples[a * nbTypes + b].push_back({model.getWork(a, b, size, size, size,
+                            A.getOccupation(), B.getOccupation()), static_cast<double>(size * size), time});
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t a = 0; a != nbTypes; ++a)
+        for (size_t b = 0; b != nbTypes; ++b)
+            if (available[a * nbTypes + b] and !samples[a * nbTypes + b].empty())
+                model.fit(a, b, samples[a * nbTypes + b]);
+
+    return model;
+}
+
+} // namespace BlasBooster
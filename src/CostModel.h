@@ -0,0 +1,346 @@
+#pragma once
+
+#include "BlockSparseMatrix.h"
+#include "DenseMatrix.h"
+#include "DynamicMatrixTypeList.h"
+#include "MultipleMatrix.h"
+#include "SparseMatrix.h"
+#include "TypeList.h"
+#include "ZeroMatrix.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Sample of the calibration: work of the kernel and measured time
+struct CostSample
+{
+    /// Effective floating point operations, 2*m*n*k scaled by the occupations
+    double work;
+
+    /// Size of the result block m*n
+    double outputSize;
+
+    /// Measured time in seconds
+    double time;
+};
+
+/**
+ * \brief Machine-calibrated runtime model of the block multiplication kernels.
+ *
+ * For each pair of types (i,j) of DynamicMatrixTypeList the time of the
+ * kernel C += A x B is modeled by
+ *
+ *   time = c0 + c1 * 2*m*n*k * f_i * f_j + c2 * m*n
+ *
+ * where f is the occupation for sparse types, one for dense types and zero for
+ * the ZeroMatrix. The coefficients are fitted to the results of the calibration
+ * and are stored per CPU model in a database file, so that one file can serve
+ * a cluster with different CPU generations. The file header contains the
+ * format version and the names of the types, as the coefficients are stored by
+ * type index. Files of another version or type list are rejected.
+ */
+class CostModel
+{
+public:
+
+    static const size_t nbTypes = GetSize<DynamicMatrixTypeList>::value;
+
+    /// Version of the database file format
+    static const int fileVersion = 2;
+
+    /// Dependency of the work on the occupation of a matrix type
+    enum class Kind { Zero, Sparse, Dense };
+
+    struct Coefficients
+    {
+        bool valid = false;
+        std::array<double, 3> c{};
+    };
+
+    /// Name of the CPU of the current host
+    static std::string getHostCpuName();
+
+    /// Kind of the matrix types, must be set by the calibration
+    void setKind(size_t type, Kind kind) { kinds_.at(type) = kind; }
+    Kind getKind(size_t type) const { return kinds_.at(type); }
+
+    Coefficients const& getCoefficients(size_t typeA, size_t typeB) const { return coefficients_.at(typeA).at(typeB); }
+    void setCoefficients(size_t typeA, size_t typeB, Coefficients const& c) { coefficients_.at(typeA).at(typeB) = c; }
+
+    /// Least squares fit of the coefficients of a type pair
+    void fit(size_t typeA, size_t typeB, std::vector<CostSample> const& samples);
+
+    double getWork(size_t typeA, size_t typeB, double m, double n, double k, double occupationA, double occupationB) const
+    {
+        return 2.0 * m * n * k * getFactor(typeA, occupationA) * getFactor(typeB, occupationB);
+    }
+
+    /// Predicted time in seconds, infinite for type pairs without kernel
+    double predict(size_t typeA, size_t typeB, double m, double n, double k,
+        double occupationA = 1.0, double occupationB = 1.0) const;
+
+    /**
+     * Occupation below which the block A is faster as sparse type than as dense type,
+     * both multiplied with a dense block of type partner.
+     */
+    double getCrossoverOccupation(size_t sparseType, size_t denseType, size_t partnerType, double blockSize) const;
+
+    /// Write the model of the current CPU into the database, other CPUs are kept
+    void save(std::string const& filename) const;
+
+    /// Read the model of the given CPU from the database, throws if the version or the type list differ
+    static std::shared_ptr<CostModel const> load(std::string const& filename, std::string const& cpuName = getHostCpuName());
+
+    /// Model of the current host loaded once from the file given by BLASBOOSTER_COST_MODEL, an invalid file is ignored with a warning
+    static std::shared_ptr<CostModel const> getDefault();
+
+    std::string const& getCpuName() const { return cpuName_; }
+    void setCpuName(std::string const& cpuName) { cpuName_ = cpuName; }
+
+    /// Names of the types of DynamicMatrixTypeList in the order of the type indices
+    static std::vector<std::string> getTypeNames() { return getTypeNames(std::make_index_sequence<nbTypes>()); }
+
+private:
+
+    template <size_t... I>
+    static std::vector<std::string> getTypeNames(std::index_sequence<I...>)
+    {
+        return {GetType<I,DynamicMatrixTypeList>::type::name()...};
+    }
+
+    static std::string getFileHeader()
+    {
+        return "# BlasBooster cost model database, version " + std::to_string(fileVersion);
+    }
+
+    double getFactor(size_t type, double occupation) const
+    {
+        switch (kinds_.at(type)) {
+            case Kind::Zero: return 0.0;
+            case Kind::Sparse: return occupation;
+            default: return 1.0;
+        }
+    }
+
+    /// Database sections of all CPUs in the file, empty if the file does not exist
+    static std::vector<std::pair<std::string, std::string>> readSections(std::string const& filename);
+
+    std::string cpuName_ = getHostCpuName();
+
+    std::array<Kind, nbTypes> kinds_{};
+
+    std::array<std::array<Coefficients, nbTypes>, nbTypes> coefficients_;
+
+};
+
+inline std::string CostModel::getHostCpuName()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            auto pos = line.find(':');
+            if (pos != std::string::npos) {
+                auto name = line.substr(line.find_first_not_of(" \t", pos + 1));
+                return name;
+            }
+        }
+    }
+    return "unknown";
+}
+
+inline void CostModel::fit(size_t typeA, size_t typeB, std::vector<CostSample> const& samples)
+{
+    // Columns of the design matrix: 1, work, outputSize. Columns without information are dropped.
+    std::array<double, 3> scale{1.0, 0.0, 0.0};
+    for (auto const& s : samples) {
+        scale[1] = std::max(scale[1], s.work);
+        scale[2] = std::max(scale[2], s.outputSize);
+    }
+
+    std::vector<size_t> active;
+    for (size_t c = 0; c != 3; ++c) if (scale[c] > 0.0) active.push_back(c);
+
+    auto column = [&](CostSample const& s, size_t c) {
+        double value = c == 0 ? 1.0 : c == 1 ? s.work : s.outputSize;
+        return value / scale[c];
+    };
+
+    // Normal equations
+    const size_t n = active.size();
+    std::vector<std::vector<double>> M(n, std::vector<double>(n + 1, 0.0));
+    for (auto const& s : samples) {
+        for (size_t r = 0; r != n; ++r) {
+            for (size_t c = 0; c != n; ++c) M[r][c] += column(s, active[r]) * column(s, active[c]);
+            M[r][n] += column(s, active[r]) * s.time;
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+    std::vector<double> x(n, 0.0);
+    for (size_t p = 0; p != n; ++p) {
+        size_t pivot = p;
+        for (size_t r = p + 1; r != n; ++r) if (std::abs(M[r][p]) > std::abs(M[pivot][p])) pivot = r;
+        std::swap(M[p], M[pivot]);
+        if (std::abs(M[p][p]) < 1e-300) continue;
+        for (size_t r = p + 1; r != n; ++r) {
+            double f = M[r][p] / M[p][p];
+            for (size_t c = p; c != n + 1; ++c) M[r][c] -= f * M[p][c];
+        }
+    }
+    for (size_t p = n; p-- > 0; ) {
+        if (std::abs(M[p][p]) < 1e-300) continue;
+        double sum = M[p][n];
+        for (size_t c = p + 1; c != n; ++c) sum -= M[p][c] * x[c];
+        x[p] = sum / M[p][p];
+    }
+
+    Coefficients result;
+    result.valid = !samples.empty();
+    for (size_t i = 0; i != n; ++i) result.c[active[i]] = std::max(0.0, x[i] / scale[active[i]]);
+    setCoefficients(typeA, typeB, result);
+}
+
+inline double CostModel::predict(size_t typeA, size_t typeB, double m, double n, double k,
+    double occupationA, double occupationB) const
+{
+    auto const& coefficients = getCoefficients(typeA, typeB);
+    if (!coefficients.valid) return HUGE_VAL;
+    auto const& c = coefficients.c;
+    return c[0] + c[1] * getWork(typeA, typeB, m, n, k, occupationA, occupationB) + c[2] * m * n;
+}
+
+inline double CostModel::getCrossoverOccupation(size_t sparseType, size_t denseType, size_t partnerType, double blockSize) const
+{
+    auto const& s = getCoefficients(sparseType, partnerType);
+    auto const& d = getCoefficients(denseType, partnerType);
+    if (!s.valid) return 0.0;
+    if (!d.valid) return 1.0;
+
+    double flops = 2.0 * blockSize * blockSize * blockSize;
+    double outputSize = blockSize * blockSize;
+    double denseTime = d.c[0] + d.c[1] * flops + d.c[2] * outputSize;
+    double sparseFixedTime = s.c[0] + s.c[2] * outputSize;
+    double sparseSlope = s.c[1] * flops;
+
+    if (sparseSlope <= 0.0) return sparseFixedTime < denseTime ? 1.0 : 0.0;
+    return std::clamp((denseTime - sparseFixedTime) / sparseSlope, 0.0, 1.0);
+}
+
+inline std::vector<std::pair<std::string, std::string>> CostModel::readSections(std::string const& filename)
+{
+    std::vector<std::pair<std::string, std::string>> sections;
+    std::ifstream file(filename);
+    std::string line;
+    if (!std::getline(file, line)) return sections;
+
+    if (line != getFileHeader())
+        throw std::runtime_error("CostModel: " + filename + " is not a cost model database of version "
+            + std::to_string(fileVersion) + ", calibrate again.");
+
+    // Type list of the calibration
+    std::vector<std::string> typeNames;
+    while (std::getline(file, line) and line.rfind("type ", 0) == 0) {
+        std::istringstream type(line.substr(5));
+        size_t index;
+        std::string name;
+        type >> index >> name;
+        if (index != typeNames.size()) break;
+        typeNames.push_back(name);
+    }
+    if (typeNames != getTypeNames())
+        throw std::runtime_error("CostModel: type list of " + filename + " does not match DynamicMatrixTypeList, calibrate again.");
+
+    do {
+        if (line.rfind("cpu ", 0) != 0) continue;
+        std::pair<std::string, std::string> section(line.substr(4), "");
+        while (std::getline(file, line) and line != "end") section.second += line + "\n";
+        sections.push_back(section);
+    } while (std::getline(file, line));
+    return sections;
+}
+
+inline void CostModel::save(std::string const& filename) const
+{
+    auto sections = readSections(filename);
+
+    std::ostringstream body;
+    body.precision(17);
+    for (size_t t = 0; t != nbTypes; ++t) body << "kind " << t << " " << static_cast<int>(kinds_[t]) << "\n";
+    for (size_t a = 0; a != nbTypes; ++a) {
+        for (size_t b = 0; b != nbTypes; ++b) {
+            auto const& c = coefficients_[a][b];
+            if (!c.valid) continue;
+            body << "pair " << a << " " << b << " " << c.c[0] << " " << c.c[1] << " " << c.c[2] << "\n";
+        }
+    }
+
+    auto iter = std::find_if(sections.begin(), sections.end(), [&](auto const& s){ return s.first == cpuName_; });
+    if (iter != sections.end()) iter->second = body.str();
+    else sections.emplace_back(cpuName_, body.str());
+
+    std::ofstream file(filename);
+    if (!file) throw std::runtime_error("CostModel: can not write " + filename);
+    file << getFileHeader() << "\n";
+    auto typeNames = getTypeNames();
+    for (size_t t = 0; t != nbTypes; ++t) file << "type " << t << " " << typeNames[t] << "\n";
+    for (auto const& s : sections) file << "cpu " << s.first << "\n" << s.second << "end\n";
+}
+
+inline std::shared_ptr<CostModel const> CostModel::load(std::string const& filename, std::string const& cpuName)
+{
+    for (auto const& section : readSections(filename)) {
+        if (section.first != cpuName) continue;
+
+        auto model = std::make_shared<CostModel>();
+        model->cpuName_ = cpuName;
+        std::istringstream body(section.second);
+        std::string key;
+        while (body >> key) {
+            if (key == "kind") {
+                size_t t;
+                int kind;
+                body >> t >> kind;
+                model->setKind(t, static_cast<Kind>(kind));
+            } else if (key == "pair") {
+                size_t a, b;
+                Coefficients c;
+                body >> a >> b >> c.c[0] >> c.c[1] >> c.c[2];
+                c.valid = true;
+                model->setCoefficients(a, b, c);
+            } else {
+                throw std::runtime_error("CostModel: unknown key " + key + " in " + filename);
+            }
+        }
+        return model;
+    }
+    return nullptr;
+}
+
+inline std::shared_ptr<CostModel const> CostModel::getDefault()
+{
+    static const std::shared_ptr<CostModel const> model = []() -> std::shared_ptr<CostModel const> {
+        const char* filename = std::getenv("BLASBOOSTER_COST_MODEL");
+        if (!filename) return nullptr;
+        try {
+            return load(filename);
+        } catch (std::runtime_error const& e) {
+            std::fprintf(stderr, "%s The cost model is ignored.\n", e.what());
+            return nullptr;
+        }
+    }();
+    return model;
+}
+
+} // namespace BlasBooster
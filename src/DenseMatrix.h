@@ -4,9 +4,13 @@
 #include "DynamicMatrixTypeList.h"
 #include "Matrix.h"
 #include "MatrixBase.h"
+#include "NormPolicy.h"
 #include "Storage.h"
 #include "TypeName.h"
 #include "Utilities.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 #include <fstream>
@@ -14,10 +18,15 @@
 #include <iomanip>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <typeinfo>
 
 namespace BlasBooster {
 
+/// Forward declaration
+template <class X1, class X2>
+struct MatrixMultExp;
+
 /**
  * \brief Column- or row major stored dense matrix.
  */
@@ -27,8 +36,8 @@ class Matrix<Dense,T,P>
    public P::dimension,
    public P::leadingDimension,
    public P::unblockedDimension,
-   public Storage<T,P::onStack,P::isFixed,P::dimension::size,P::isSubMatrix>//,
-   //public NormPolicy<Matrix<Dense,T,P>, typename P::NormType>,
+   public Storage<T,P::onStack,P::isFixed,P::dimension::size,P::isSubMatrix,typename P::AllocatorType>,
+   public NormPolicy<Matrix<Dense,T,P>, typename P::NormType>//,
    //public OccupationPolicy<Matrix<Dense,T,P>>
 {
 public: // typedefs
@@ -45,7 +54,8 @@ public: // typedefs
     typedef typename P::leadingDimension leadingDimension;
     typedef typename P::unblockedDimension unblockedDimension;
     typedef typename P::IndexType IndexType;
-    typedef Storage<T,P::onStack,P::isFixed,P::dimension::size,P::isSubMatrix> storage;
+    typedef Storage<T,P::onStack,P::isFixed,P::dimension::size,P::isSubMatrix,typename P::AllocatorType> storage;
+    typedef NormPolicy<self, typename P::NormType> norm_policy;
     typedef typename storage::iterator iterator;
     typedef typename storage::const_iterator const_iterator;
 
@@ -162,15 +172,19 @@ public: // member functions
 
     /// Conversion from ZeroMatrix
     template <class P2>
-    Matrix(Matrix<Zero,P2> const& other);
+    Matrix(Matrix<Zero,NullType,P2> const& other);
+
+    /// Conversion from BlockSparseMatrix
+    template <size_t TileSize, class T2, class P2>
+    Matrix(Matrix<BlockSparse<TileSize>,T2,P2> const& other);
 
     // /// Conversion from MultipleMatrix
     // template <class X1, class X2>
     // Matrix(MultipleMatrix<X1,X2> const& other);
 
-    // /// Construction by multiplication expression template
-    // template <class Op1, class Op2>
-    // Matrix(MatrixMultExp<Op1, Op2> const& expression);
+    /// Construction by multiplication expression template
+    template <class Op1, class Op2>
+    Matrix(MatrixMultExp<Op1, Op2> const& expression);
 
     /// Default copy constructor
     Matrix(self const& other) = default;
@@ -178,7 +192,10 @@ public: // member functions
     /// Move constructor
     Matrix(self&& other)
      : dimension(std::move(other)),
-       storage(std::forward<storage>(other))
+       leadingDimension(std::move(other)),
+       unblockedDimension(std::move(other)),
+       storage(std::forward<storage>(other)),
+       norm_policy(other)
     {
         debug_print("DenseMatrix: Move constructor was called.");
     }
@@ -198,6 +215,7 @@ public: // member functions
         leadingDimension::operator=(std::forward<leadingDimension>(rhs));
         unblockedDimension::operator=(std::forward<unblockedDimension>(rhs));
         storage::operator=(std::forward<storage>(rhs));
+        norm_policy::operator=(rhs);
         return *this;
     }
 
@@ -238,6 +256,12 @@ public: // member functions
     T& operator () (IndexType row, IndexType column);
     const T& operator () (IndexType row, IndexType column) const;
 
+    /// Number of elements accepted by the value checker
+    template <class ValueChecker>
+    size_t getNbOfSignificantElements(ValueChecker const& valueChecker) const {
+        return std::count_if(this->begin(), this->end(), valueChecker);
+    }
+
     // TODO: move to dimension
     template <class U = P>
     IndexType getLdColumns(typename std::enable_if<!U::isSubMatrix>::type* = 0) const {
@@ -263,8 +287,12 @@ public: // member functions
 
     size_t getTypeIndex() const { return typeIndex_; }
 
+    double getNorm() const { return this->norm(); }
+
     friend void swap( self& a, self& b ) noexcept {
         using std::swap; // bring in swap for built-in types
+        a.invalidateNorm();
+        b.invalidateNorm();
         swap(a.data_,b.data_);
         swap(a.size_,b.size_);
         swap(a.ownMemory_,b.ownMemory_);
@@ -273,7 +301,7 @@ public: // member functions
         //swap(a.storage,b.storage);
     }
 
-    static const size_t typeIndex_ = GetIndex<self, DynamicMatrixTypeList>::value;
+    static constexpr size_t typeIndex_ = GetIndex<self, DynamicMatrixTypeList>::value;
 
     static const std::string name() { return "Matrix<Dense," + TypeName<T>::value() + ">"; }
 
@@ -335,9 +363,13 @@ Matrix<Dense,T,P>::Matrix(std::initializer_list<std::initializer_list<T>> values
  : dimension(values.size(), values.begin()->size()),
    storage(values.size() * values.begin()->size())
 {
+    IndexType row(0);
     for (auto const& inner : values)
     {
-        std::memcpy(this->data_, inner.begin(), inner.size());
+        if (inner.size() != this->getNbColumns()) throw std::runtime_error("DenseMatrix: inconsistent number of columns.");
+        IndexType column(0);
+        for (auto const& value : inner) (*this)(row, column++) = value;
+        ++row;
     }
 }
 
@@ -381,10 +413,10 @@ Matrix<Dense,T,P>::Matrix(Matrix<Dense,T2,P2> const& other, typename P::IndexTyp
         U::isSubMatrix
     >::type*)
  : dimension(nbRows,nbColumns),
-   leadingDimension(other.getNbRows(),other.getNbColumns()),
+   leadingDimension(other.getLdRows(),other.getLdColumns()),
    // TODO: avoid const_cast
-   storage(const_cast<T2*>(other.getDataPointer() + beginRow + beginColumn * other.getNbRows()),
-       nbRows, nbColumns, other.getNbRows() - nbRows)
+   storage(const_cast<T2*>(other.getDataPointer() + beginRow + beginColumn * other.getLdRows()),
+       nbRows, nbColumns, other.getLdRows() - nbRows)
 {}
 
 template <class T, class P>
@@ -397,11 +429,9 @@ Matrix<Dense,T,P>::Matrix(Matrix<Dense,T2,P2> const& other, typename P::IndexTyp
         U::isSubMatrix
     >::type*)
  : dimension(nbRows,nbColumns),
-   leadingDimension(other.getNbRows(),other.getNbColumns()),
-   storage(
-       const_cast<T2*>(other.getDataPointer()) + beginRow * other.getNbColumns() + beginColumn,
-       other.getSize() - beginRow * other.getNbColumns() - beginColumn
-   )
+   leadingDimension(other.getLdRows(),other.getLdColumns()),
+   storage(const_cast<T2*>(other.getDataPointer() + beginRow * other.getLdColumns() + beginColumn),
+       nbColumns, nbRows, other.getLdColumns() - nbColumns)
 {}
 
 // Conversion from DenseMatrix with same orientation
@@ -425,8 +455,25 @@ Matrix<Dense,T,P>::Matrix(Matrix<Dense,T2,P2> const& other, ValueChecker const&
         !P2::isSubMatrix and !P2::isBlockedMatrix
     >::type*)
   : dimension(other.getNbRows(), other.getNbColumns()),
-    storage(transpose(other))
-{}
+    storage(other.getSize())
+{
+    // Blocked, so that the lines of both matrices stay in cache
+    const size_t blockSize = 32;
+    const size_t rs = getRowStride(*this), cs = getColumnStride(*this);
+    const size_t rsOther = getRowStride(other), csOther = getColumnStride(other);
+    T* data = this->getDataPointer();
+    T2 const* otherData = other.getDataPointer();
+
+    for (size_t rowBegin = 0; rowBegin < this->getNbRows(); rowBegin += blockSize) {
+        const size_t rowEnd = std::min(rowBegin + blockSize, static_cast<size_t>(this->getNbRows()));
+        for (size_t columnBegin = 0; columnBegin < this->getNbColumns(); columnBegin += blockSize) {
+            const size_t columnEnd = std::min(columnBegin + blockSize, static_cast<size_t>(this->getNbColumns()));
+            for (size_t row = rowBegin; row != rowEnd; ++row)
+                for (size_t column = columnBegin; column != columnEnd; ++column)
+                    data[row * rs + column * cs] = otherData[row * rsOther + column * csOther];
+        }
+    }
+}
 
 /// Conversion from SubDenseMatrix
 template <class T, class P>
@@ -550,7 +597,7 @@ Matrix<Dense,T,P>::Matrix(Matrix<Sparse,T2,P2> const& other,
     typedef typename Matrix<Sparse,T2,P2>::const_index_iterator ConstIndexIterator;
     typedef typename Matrix<Sparse,T2,P2>::const_iterator ConstIterator;
 
-    this->fill(0.0);
+    this->fillNewZero();
 
     iterator iterDense = this->begin();
     for (ConstIndexIterator iterOffsetCur(other.beginOffset()),
@@ -576,7 +623,7 @@ Matrix<Dense,T,P>::Matrix(Matrix<Sparse,T2,P2> const& other,
     typedef typename Matrix<Sparse,T2,P2>::const_index_iterator ConstIndexIterator;
     typedef typename Matrix<Sparse,T2,P2>::const_iterator ConstIterator;
 
-    this->fill(0.0);
+    this->fillNewZero();
 
     iterator iterDense = this->begin();
     for (ConstIndexIterator iterOffsetCur(other.beginOffset()),
@@ -595,10 +642,20 @@ Matrix<Dense,T,P>::Matrix(Matrix<Sparse,T2,P2> const& other,
 // Conversion from ZeroMatrix
 template <class T, class P>
 template <class P2>
-Matrix<Dense,T,P>::Matrix(Matrix<Zero,P2> const& other)
+Matrix<Dense,T,P>::Matrix(Matrix<Zero,NullType,P2> const& other)
+ : dimension(other.getNbRows(), other.getNbColumns()), storage(other.getNbRows() * other.getNbColumns())
+{
+    this->fillNewZero();
+}
+
+// Conversion from BlockSparseMatrix
+template <class T, class P>
+template <size_t TileSize, class T2, class P2>
+Matrix<Dense,T,P>::Matrix(Matrix<BlockSparse<TileSize>,T2,P2> const& other)
  : dimension(other.getNbRows(), other.getNbColumns()), storage(other.getNbRows() * other.getNbColumns())
 {
-   AllFiller<T>(0.0)(*this);
+    this->fillNewZero();
+    other.forEachElement([&](size_t i, size_t j, T2 const& value){ (*this)(i, j) = value; });
 }
 
 // // Conversion from MultipleMatrix
@@ -611,13 +668,15 @@ Matrix<Dense,T,P>::Matrix(Matrix<Zero,P2> const& other)
 //     *this += other.getMatrix2();
 // }
 
-// // Construction by multiplication expression template
-// template <class T, class P>
-// template <class Op1, class Op2>
-// Matrix<Dense,T,P>::Matrix(MatrixMultExp<Op1, Op2> const& expression)
-// {
-//     *this = expression.template execute<Native>();
-// }
+// Construction by multiplication expression template
+template <class T, class P>
+template <class Op1, class Op2>
+Matrix<Dense,T,P>::Matrix(MatrixMultExp<Op1, Op2> const& expression)
+ : dimension(expression.getNbRows(), expression.getNbColumns()),
+   storage(expression.getNbRows() * expression.getNbColumns())
+{
+    expression.template execute<Native>(*this);
+}
 
 template <class T, class P>
 Matrix<Dense,T,P>& Matrix<Dense,T,P>::operator = (T value)
@@ -626,6 +685,7 @@ Matrix<Dense,T,P>& Matrix<Dense,T,P>::operator = (T value)
     {
         *iterCur = value;
     }
+    this->invalidateNorm();
     return *this;
 }
 
@@ -634,6 +694,7 @@ void Matrix<Dense,T,P>::resize(typename P::IndexType nbRows, typename P::IndexTy
 {
     static_cast<dimension*>(this)->resize(nbRows, nbColumns);
     static_cast<storage*>(this)->resize(nbRows * nbColumns);
+    this->invalidateNorm();
     filler();
 }
 
@@ -648,6 +709,7 @@ void Matrix<Dense,T,P>::resize(typename P::IndexType nbRows, typename P::IndexTy
     this->ubRows_ = nbUnblockedRows;
     this->ubColumns_ = nbUnblockedColumns;
     static_cast<storage*>(this)->resize(nbRows*nbColumns);
+    this->invalidateNorm();
 }
 
 template <class T, class P>
@@ -703,6 +765,22 @@ size_t Matrix<Dense,T,P>::getPosition(typename P::IndexType row, typename P::Ind
     return row * this->getLdColumns() + column;
 }
 
+/// Distance between two consecutive rows of a dense matrix
+template <class T, class P>
+size_t getRowStride(Matrix<Dense,T,P> const& A)
+{
+    if constexpr (std::is_same<typename P::orientation, RowMajor>::value) return A.getLdColumns();
+    else return 1;
+}
+
+/// Distance between two consecutive columns of a dense matrix
+template <class T, class P>
+size_t getColumnStride(Matrix<Dense,T,P> const& A)
+{
+    if constexpr (std::is_same<typename P::orientation, ColumnMajor>::value) return A.getLdRows();
+    else return 1;
+}
+
 } // namespace BlasBooster
 
 /// Pretty printing
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <type_traits>
 #include <utility>
 
 namespace BlasBooster {
@@ -87,8 +88,15 @@ struct Dimension<VariableSize, OrientationArg>
     size_t getNbColumns() const { return nbColumns_; }
     size_t getSize() const { return full_size_; }
 
-    size_t getMajorDimension() const;
-    size_t getMinorDimension() const;
+    /// Number of contiguous elements, i.e. nbRows for ColumnMajor and nbColumns for RowMajor
+    size_t getMajorDimension() const {
+        return std::is_same<OrientationArg, ColumnMajor>::value ? nbRows_ : nbColumns_;
+    }
+
+    /// Number of contiguous stripes, i.e. nbColumns for ColumnMajor and nbRows for RowMajor
+    size_t getMinorDimension() const {
+        return std::is_same<OrientationArg, ColumnMajor>::value ? nbColumns_ : nbRows_;
+    }
 
 protected:
 
@@ -1,22 +1,82 @@
 #pragma once
 
+#include "DynamicMatrixTypeList.h"
 #include "Matrix.h"
 #include "MatrixBase.h"
+#include <cstddef>
 #include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace BlasBooster {
 
+/**
+ * \brief Owner of a matrix block, which type is determined at runtime.
+ *
+ * The type index, the dimension and the occupation of the block are stored beside the pointer,
+ * so that the blocked algorithms can use them without dereferencing the block
+ * or calling a virtual function.
+ */
 struct DynamicMatrix
 {
-    template <typename M, typename T>
-    DynamicMatrix(Matrix<M,T>* ptr) : ptr(ptr) {}
+    /// Empty block
+    DynamicMatrix() : typeIndex_(GetSize<DynamicMatrixTypeList>::value), nbRows_(0), nbColumns_(0), occupation_(0.0) {}
 
-    auto getTypeIndex() const { return ptr->getTypeIndex(); }
+    /// Take ownership of a matrix of type X listed in DynamicMatrixTypeList
+    template <typename X>
+    DynamicMatrix(X* ptr)
+     : ptr(ptr), typeIndex_(X::typeIndex_), nbRows_(ptr->getNbRows()), nbColumns_(ptr->getNbColumns()),
+       occupation_(computeOccupation(*ptr))
+    {}
+
+    DynamicMatrix(DynamicMatrix&& other) = default;
+
+    DynamicMatrix& operator = (DynamicMatrix&& other) = default;
+
+    size_t getTypeIndex() const { return typeIndex_; }
+
+    size_t getNbRows() const { return nbRows_; }
+    size_t getNbColumns() const { return nbColumns_; }
+
+    /// Fraction of stored elements: zero for Matrix<Zero>, one for dense matrices
+    double getOccupation() const { return occupation_; }
+
+    bool empty() const { return !ptr; }
+
+    /// Cached norm of the block, zero for an empty block
+    double getNorm() const { return ptr ? ptr->getNorm() : 0.0; }
+
+    MatrixBase const& operator * () const { return *ptr; }
+    MatrixBase& operator * () { return *ptr; }
+
+    /// Access to the concrete matrix type X, which must be checked before by the type index.
+    template <class X>
+    X const& get() const { return static_cast<X const&>(*ptr); }
+
+    template <class X>
+    X& get() { return static_cast<X&>(*ptr); }
 
 private:
 
+    template <typename X>
+    static double computeOccupation(X const& x)
+    {
+        if constexpr (std::is_same<typename X::matrix_type, Zero>::value) return 0.0;
+        else if constexpr (requires { x.nnz(); }) {
+            double size = static_cast<double>(x.getNbRows()) * x.getNbColumns();
+            return size ? x.nnz() / size : 0.0;
+        }
+        else return 1.0;
+    }
+
     std::unique_ptr<MatrixBase> ptr;
-    
+
+    size_t typeIndex_;
+    size_t nbRows_;
+    size_t nbColumns_;
+    double occupation_;
+
 };
 
 template <typename T, typename... Args>
@@ -25,4 +85,45 @@ auto make_dynamic(Args&&... args)
     return DynamicMatrix(new T(std::forward<Args>(args)...));
 }
 
+/**
+ * Edge lengths of the nbBlocks block rows or columns of a blocked matrix, getSize(b, k) is the
+ * size of the k-th of nbOtherBlocks blocks in block row or column b, zero for an empty DynamicMatrix.
+ * The first stored block gives the size, a single block row or column without stored blocks
+ * gets the remainder of the unblocked size.
+ */
+template <class GetSize>
+std::vector<size_t> getBlockSizes(size_t nbBlocks, size_t nbOtherBlocks, size_t nbUnblocked, GetSize const& getSize)
+{
+    std::vector<size_t> sizes(nbBlocks, 0);
+    size_t sum = 0, nbUnknown = 0, unknown = 0;
+    for (size_t b = 0; b != nbBlocks; ++b) {
+        for (size_t k = 0; k != nbOtherBlocks and sizes[b] == 0; ++k) sizes[b] = getSize(b, k);
+        if (sizes[b] == 0) ++nbUnknown, unknown = b;
+        sum += sizes[b];
+    }
+    if (nbUnknown == 1 and sum <= nbUnblocked) {
+        sizes[unknown] = nbUnblocked - sum;
+        sum = nbUnblocked;
+    }
+    if (nbUnknown > 1 or sum != nbUnblocked)
+        throw std::runtime_error("getBlockSizes: block sizes do not match the unblocked size.");
+    return sizes;
+}
+
+/// Number of rows of each block row of a blocked matrix of DynamicMatrix, see getBlockSizes
+template <class X>
+std::vector<size_t> getBlockRowSizes(X const& A)
+{
+    return getBlockSizes(A.getNbRows(), A.getNbColumns(), A.getUnblockedRows(),
+        [&](size_t i, size_t j) { return A(i, j).empty() ? size_t(0) : A(i, j).getNbRows(); });
+}
+
+/// Number of columns of each block column of a blocked matrix of DynamicMatrix, see getBlockSizes
+template <class X>
+std::vector<size_t> getBlockColumnSizes(X const& A)
+{
+    return getBlockSizes(A.getNbColumns(), A.getNbRows(), A.getUnblockedColumns(),
+        [&](size_t j, size_t i) { return A(i, j).empty() ? size_t(0) : A(i, j).getNbColumns(); });
+}
+
 } // namespace BlasBooster
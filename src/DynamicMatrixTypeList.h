@@ -1,14 +1,11 @@
 #pragma once
 
 #include "EmptyTypes.h"
+#include "Matrix.h"
 #include "TypeList.h"
 
 namespace BlasBooster {
 
-/// Forward declaration
-template <class M, class T, class P>
-struct Matrix;
-
 /// Forward declaration
 template <class T1, class T2>
 struct MultipleMatrix;
@@ -21,11 +18,14 @@ struct MultipleMatrix;
  *
  * The order of the matrix type list is fixed by the important for the MatrixConverter.
  * The source matrix will be converted into the first matrix type which match the criteria.
+ * The cost model database stores the names of the types by index, so that a
+ * calibration of another type list is rejected by CostModel::load.
  */
 using DynamicMatrixTypeList = TypeList <
     Matrix<Zero>,
     Matrix<Sparse, float>,
     Matrix<Dense, float>,
+    Matrix<BlockSparse<4>, double>,
     Matrix<Sparse, double>,
     MultipleMatrix<Matrix<Sparse, double>, Matrix<Sparse, float>>,
     MultipleMatrix<Matrix<Sparse, double>, Matrix<Dense, float>>,
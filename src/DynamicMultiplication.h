@@ -0,0 +1,134 @@
+#pragma once
+
+#include "BlockSparseMultiplication.h"
+#include "BlockedMultiplication.h"
+#include "DenseMatrix.h"
+#include "DynamicMatrix.h"
+#include "DynamicMatrixTypeList.h"
+#include "MultipleMatrix.h"
+#include "MultipleMultiplication.h"
+#include "MultiplicationFunctor.h"
+#include "SparseMatrix.h"
+#include "SparseMultiplication.h"
+#include "TypeList.h"
+#include "ZeroMatrix.h"
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace BlasBooster {
+
+/**
+ * \brief Accumulation of the product of two blocks X1 x X2 into a dense tile.
+ *
+ * Primary template for type combinations without kernel.
+ */
+template <class X1, class X2>
+struct BlockMultiplication
+{
+    static void apply(DynamicMatrix const& A, DynamicMatrix const& B, Matrix<Dense,double>& C)
+    {
+        throw std::runtime_error("BlockMultiplication: no kernel for type indices "
+            + std::to_string(A.getTypeIndex()) + " x " + std::to_string(B.getTypeIndex()) + ".");
+    }
+};
+
+template <class M1, class T1, class P1, class M2, class T2, class P2>
+struct BlockMultiplication<Matrix<M1,T1,P1>, Matrix<M2,T2,P2>>
+{
+    static void apply(DynamicMatrix const& A, DynamicMatrix const& B, Matrix<Dense,double>& C)
+    {
+        MultiplicationFunctor<M1, T1, P1, M2, T2, P2, Dense, double, Parameter<>, Native>()(
+            A.get<Matrix<M1,T1,P1>>(), B.get<Matrix<M2,T2,P2>>(), C, 1.0, 1.0);
+    }
+};
+
+/// Products with a MultipleMatrix, fused for a dense bulk and a dense partner
+template <class X1, class X2, class M2, class T2, class P2>
+struct BlockMultiplication<MultipleMatrix<X1,X2>, Matrix<M2,T2,P2>>
+{
+    static void apply(DynamicMatrix const& A, DynamicMatrix const& B, Matrix<Dense,double>& C)
+    {
+        multiplyAdd(A.get<MultipleMatrix<X1,X2>>(), B.get<Matrix<M2,T2,P2>>(), C);
+    }
+};
+
+template <class M1, class T1, class P1, class X1, class X2>
+struct BlockMultiplication<Matrix<M1,T1,P1>, MultipleMatrix<X1,X2>>
+{
+    static void apply(DynamicMatrix const& A, DynamicMatrix const& B, Matrix<Dense,double>& C)
+    {
+        multiplyAdd(A.get<Matrix<M1,T1,P1>>(), B.get<MultipleMatrix<X1,X2>>(), C);
+    }
+};
+
+template <class X1, class X2, class Y1, class Y2>
+struct BlockMultiplication<MultipleMatrix<X1,X2>, MultipleMatrix<Y1,Y2>>
+{
+    static void apply(DynamicMatrix const& A, DynamicMatrix const& B, Matrix<Dense,double>& C)
+    {
+        multiplyAdd(A.get<MultipleMatrix<X1,X2>>(), B.get<MultipleMatrix<Y1,Y2>>(), C);
+    }
+};
+
+/**
+ * \brief Compile-time N x N table of the block multiplication kernels.
+ *
+ * The entry [i][j] is the kernel for GetType<i,L> x GetType<j,L>, so that
+ * the dispatch for two blocks is a single indirect call using their type indices.
+ */
+template <class L>
+struct DynamicMultiplicationTable
+{
+    typedef void (*function_type)(DynamicMatrix const&, DynamicMatrix const&, Matrix<Dense,double>&);
+
+    static constexpr size_t size = GetSize<L>::value;
+
+    typedef std::array<std::array<function_type, size>, size> table_type;
+
+    template <size_t I, size_t... J>
+    static constexpr std::array<function_type, size> createRow(std::index_sequence<J...>)
+    {
+        return {{ &BlockMultiplication<typename GetType<I,L>::type, typename GetType<J,L>::type>::apply... }};
+    }
+
+    template <size_t... I>
+    static constexpr table_type createTable(std::index_sequence<I...> indices)
+    {
+        return {{ createRow<I>(indices)... }};
+    }
+
+    static constexpr table_type value = createTable(std::make_index_sequence<size>());
+};
+
+/// C += A x B for two blocks listed in DynamicMatrixTypeList
+inline void multiply(DynamicMatrix const& A, DynamicMatrix const& B, Matrix<Dense,double>& C)
+{
+    typedef DynamicMultiplicationTable<DynamicMatrixTypeList> Table;
+
+    if (A.getTypeIndex() >= Table::size or B.getTypeIndex() >= Table::size)
+        throw std::runtime_error("multiply: type of DynamicMatrix not in DynamicMatrixTypeList.");
+
+    Table::value[A.getTypeIndex()][B.getTypeIndex()](A, B, C);
+}
+
+/// Block product for multiplyBlocked using the dispatch table
+struct DynamicBlockProduct
+{
+    void operator () (DynamicMatrix const& A, DynamicMatrix const& B, Matrix<Dense,double>& C) const
+    {
+        multiply(A, B, C);
+    }
+};
+
+/// Blocked matrix multiplication with the dispatch table as block product
+template <class PA, class PB, class PC>
+void multiplyBlocked(Matrix<Dense,DynamicMatrix,PA> const& A, Matrix<Dense,DynamicMatrix,PB> const& B,
+    Matrix<Dense,DynamicMatrix,PC>& C, WorkStealingScheduler const& scheduler = WorkStealingScheduler(),
+    BlockedMultiplicationSettings const& settings = BlockedMultiplicationSettings())
+{
+    multiplyBlocked(A, B, C, DynamicBlockProduct(), scheduler, settings);
+}
+
+} // namespace BlasBooster
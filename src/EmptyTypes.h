@@ -1,12 +1,20 @@
 #pragma once
 
+#include <cstddef>
+
 namespace BlasBooster {
 
 struct Dense {};      ///< Type for dense matrix
 struct Sparse {};     ///< Type for sparse matrix
 struct Zero {};       ///< Type for zero matrix
+struct Multiple {};   ///< Type for sum of matrices
 struct Plus {};       ///< Type for addition in BinaryOperation
 struct Minus {};      ///< Type for subtraction in BinaryOperation
 struct NullType {};   ///< Type for empty class
+struct Native {};     ///< Type for native BlasBooster kernels
+
+/// Type for block-sparse matrix with dense TileSize x TileSize tiles, TileSize = 0: tile size set at runtime
+template <size_t TileSize = 0>
+struct BlockSparse {};
 
 }
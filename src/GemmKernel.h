@@ -0,0 +1,299 @@
+#pragma once
+
+#include "Memory.h"
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <xsimd/xsimd.hpp>
+
+namespace BlasBooster {
+
+/**
+ * \brief Cache-blocked, register-tiled dense matrix multiplication.
+ *
+ * C = alpha * A * B + beta * C for arbitrary row and column strides, so that
+ * ColumnMajor, RowMajor and sub-matrices with a leading dimension are covered
+ * by the same code path.
+ *
+ * The algorithm follows the GotoBLAS/BLIS scheme: B is packed into KC x NC
+ * panels (L3), A into MC x KC panels (L2) and the MR x NR microkernel works on
+ * micro-panels of both (L1). The orientation of the operands only influences
+ * the packing, the microkernel always sees contiguous memory.
+ *
+ * T: compute type, the packed panels of A and B are converted into T.
+ */
+template <class T>
+struct GemmKernel
+{
+    typedef xsimd::batch<T> batch;
+
+    static constexpr size_t simdSize = batch::size;
+
+    /// Register tile: MR rows (two SIMD vectors) times NR columns
+    static constexpr size_t MR = 2 * simdSize;
+    static constexpr size_t NR = 6;
+
+    /// Cache blocking, MC and NC are multiples of MR and NR, respectively
+    static constexpr size_t MC = 128;
+    static constexpr size_t KC = 256;
+    static constexpr size_t NC = 4080;
+
+    template <class TA, class TB, class TC>
+    static void gemm(size_t m, size_t n, size_t k, TC alpha,
+        TA const* a, size_t rsA, size_t csA,
+        TB const* b, size_t rsB, size_t csB,
+        TC beta, TC* c, size_t rsC, size_t csC);
+
+    /**
+     * C = alpha * A * B + beta * C in panels of panelWidth columns of C.
+     *
+     * A is packed once for all panels. done(j0, j1) is called as soon as the
+     * columns [j0, j1) of C are final, so that a further update of the panel,
+     * e.g. by sparse outliers, finds it in the cache.
+     */
+    template <class TA, class TB, class TC, class PanelDone>
+    static void gemmPanels(size_t m, size_t n, size_t k, TC alpha,
+        TA const* a, size_t rsA, size_t csA,
+        TB const* b, size_t rsB, size_t csB,
+        TC beta, TC* c, size_t rsC, size_t csC,
+        size_t panelWidth, PanelDone const& done);
+
+private:
+
+    /// Pack mc x kc block of A into row micro-panels of height MR, zero-padded
+    template <class TA>
+    static void packA(size_t mc, size_t kc, TA const* a, size_t rsA, size_t csA, T* buffer);
+
+    /// Pack kc x nc block of B into column micro-panels of width NR, zero-padded
+    template <class TB>
+    static void packB(size_t kc, size_t nc, TB const* b, size_t rsB, size_t csB, T* buffer);
+
+    /// MR x NR register tile, result is stored column-wise into ab
+    static void microKernel(size_t kc, T const* a, T const* b, T* ab);
+
+    /// C = alpha * ab + beta * C for the valid mr x nr part of the tile
+    template <class TC>
+    static void updateTile(size_t mr, size_t nr, TC alpha, T const* ab,
+        TC beta, TC* c, size_t rsC, size_t csC);
+
+    /// C = alpha * A * B + beta * C of the packed mc x kc block of A and the packed kc x nc block of B
+    template <class TC>
+    static void multiplyPacked(size_t mc, size_t nc, size_t kc, TC alpha, T const* packedA, T const* packedB,
+        TC beta, TC* c, size_t rsC, size_t csC);
+
+    template <class TC>
+    static void scale(size_t m, size_t n, TC beta, TC* c, size_t rsC, size_t csC);
+
+};
+
+template <class T>
+template <class TA, class TB, class TC>
+void GemmKernel<T>::gemm(size_t m, size_t n, size_t k, TC alpha,
+    TA const* a, size_t rsA, size_t csA,
+    TB const* b, size_t rsB, size_t csB,
+    TC beta, TC* c, size_t rsC, size_t csC)
+{
+    if (m == 0 or n == 0) return;
+    if (k == 0 or alpha == TC(0)) {
+        scale(m, n, beta, c, rsC, csC);
+        return;
+    }
+
+    // Packing buffers from the arena of the calling thread, whose chunks are reused by the next call
+    ArenaScope scope;
+    T* bufferA = ArenaAllocator::allocate<T>(MC * std::min(k, KC));
+    T* bufferB = ArenaAllocator::allocate<T>(std::min(k, KC) * ((std::min(n, NC) + NR - 1) / NR) * NR);
+
+    for (size_t jc = 0; jc < n; jc += NC) {
+        size_t nc = std::min(NC, n - jc);
+        for (size_t pc = 0; pc < k; pc += KC) {
+            size_t kc = std::min(KC, k - pc);
+            packB(kc, nc, b + pc * rsB + jc * csB, rsB, csB, bufferB);
+
+            // beta is only applied for the first rank-kc update
+            TC betaCur = pc == 0 ? beta : TC(1);
+
+            for (size_t ic = 0; ic < m; ic += MC) {
+                size_t mc = std::min(MC, m - ic);
+                packA(mc, kc, a + ic * rsA + pc * csA, rsA, csA, bufferA);
+                multiplyPacked(mc, nc, kc, alpha, bufferA, bufferB, betaCur, c + ic * rsC + jc * csC, rsC, csC);
+            }
+        }
+    }
+}
+
+template <class T>
+template <class TA, class TB, class TC, class PanelDone>
+void GemmKernel<T>::gemmPanels(size_t m, size_t n, size_t k, TC alpha,
+    TA const* a, size_t rsA, size_t csA,
+    TB const* b, size_t rsB, size_t csB,
+    TC beta, TC* c, size_t rsC, size_t csC,
+    size_t panelWidth, PanelDone const& done)
+{
+    if (m == 0 or n == 0) return;
+    panelWidth = std::max(size_t(1), std::min(panelWidth, NC));
+    if (k == 0 or alpha == TC(0)) {
+        scale(m, n, beta, c, rsC, csC);
+        for (size_t j0 = 0; j0 < n; j0 += panelWidth) done(j0, std::min(n, j0 + panelWidth));
+        return;
+    }
+
+    // All of A is packed: the block (pc, ic) starts at pc * paddedM + ic * kc
+    const size_t paddedM = (m + MR - 1) / MR * MR;
+    ArenaScope scope;
+    T* bufferA = ArenaAllocator::allocate<T>(paddedM * k);
+    T* bufferB = ArenaAllocator::allocate<T>(std::min(k, KC) * ((std::min(n, panelWidth) + NR - 1) / NR) * NR);
+
+    for (size_t pc = 0; pc < k; pc += KC) {
+        size_t kc = std::min(KC, k - pc);
+        for (size_t ic = 0; ic < m; ic += MC)
+            packA(std::min(MC, m - ic), kc, a + ic * rsA + pc * csA, rsA, csA, bufferA + pc * paddedM + ic * kc);
+    }
+
+    for (size_t jc = 0; jc < n; jc += panelWidth) {
+        size_t nc = std::min(panelWidth, n - jc);
+        for (size_t pc = 0; pc < k; pc += KC) {
+            size_t kc = std::min(KC, k - pc);
+            packB(kc, nc, b + pc * rsB + jc * csB, rsB, csB, bufferB);
+
+            // beta is only applied for the first rank-kc update
+            TC betaCur = pc == 0 ? beta : TC(1);
+
+            for (size_t ic = 0; ic < m; ic += MC) {
+                multiplyPacked(std::min(MC, m - ic), nc, kc, alpha, bufferA + pc * paddedM + ic * kc, bufferB,
+                    betaCur, c + ic * rsC + jc * csC, rsC, csC);
+            }
+        }
+        done(jc, jc + nc);
+    }
+}
+
+template <class T>
+template <class TC>
+void GemmKernel<T>::multiplyPacked(size_t mc, size_t nc, size_t kc, TC alpha, T const* packedA, T const* packedB,
+    TC beta, TC* c, size_t rsC, size_t csC)
+{
+    alignas(64) T ab[MR * NR];
+
+    for (size_t jr = 0; jr < nc; jr += NR) {
+        size_t nr = std::min(NR, nc - jr);
+        for (size_t ir = 0; ir < mc; ir += MR) {
+            size_t mr = std::min(MR, mc - ir);
+            microKernel(kc, packedA + ir * kc, packedB + jr * kc, ab);
+            updateTile(mr, nr, alpha, ab, beta, c + ir * rsC + jr * csC, rsC, csC);
+        }
+    }
+}
+
+template <class T>
+template <class TA>
+void GemmKernel<T>::packA(size_t mc, size_t kc, TA const* a, size_t rsA, size_t csA, T* buffer)
+{
+    for (size_t ir = 0; ir < mc; ir += MR) {
+        size_t mr = std::min(MR, mc - ir);
+        TA const* panel = a + ir * rsA;
+        if (rsA == 1 and mr == MR) {
+            for (size_t p = 0; p < kc; ++p, buffer += MR) {
+                TA const* column = panel + p * csA;
+                for (size_t i = 0; i < MR; ++i) buffer[i] = static_cast<T>(column[i]);
+            }
+        } else {
+            for (size_t p = 0; p < kc; ++p, buffer += MR) {
+                for (size_t i = 0; i < mr; ++i) buffer[i] = static_cast<T>(panel[i * rsA + p * csA]);
+                for (size_t i = mr; i < MR; ++i) buffer[i] = T(0);
+            }
+        }
+    }
+}
+
+template <class T>
+template <class TB>
+void GemmKernel<T>::packB(size_t kc, size_t nc, TB const* b, size_t rsB, size_t csB, T* buffer)
+{
+    for (size_t jr = 0; jr < nc; jr += NR) {
+        size_t nr = std::min(NR, nc - jr);
+        TB const* panel = b + jr * csB;
+        if (csB == 1 and nr == NR) {
+            for (size_t p = 0; p < kc; ++p, buffer += NR) {
+                TB const* row = panel + p * rsB;
+                for (size_t j = 0; j < NR; ++j) buffer[j] = static_cast<T>(row[j]);
+            }
+        } else {
+            for (size_t p = 0; p < kc; ++p, buffer += NR) {
+                for (size_t j = 0; j < nr; ++j) buffer[j] = static_cast<T>(panel[p * rsB + j * csB]);
+                for (size_t j = nr; j < NR; ++j) buffer[j] = T(0);
+            }
+        }
+    }
+}
+
+template <class T>
+void GemmKernel<T>::microKernel(size_t kc, T const* a, T const* b, T* ab)
+{
+    batch c0[NR], c1[NR];
+    for (size_t j = 0; j < NR; ++j) {
+        c0[j] = batch(T(0));
+        c1[j] = batch(T(0));
+    }
+
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        batch a0 = batch::load_unaligned(a);
+        batch a1 = batch::load_unaligned(a + simdSize);
+        for (size_t j = 0; j < NR; ++j) {
+            batch bj(b[j]);
+            c0[j] = xsimd::fma(a0, bj, c0[j]);
+            c1[j] = xsimd::fma(a1, bj, c1[j]);
+        }
+    }
+
+    for (size_t j = 0; j < NR; ++j) {
+        c0[j].store_aligned(ab + j * MR);
+        c1[j].store_aligned(ab + j * MR + simdSize);
+    }
+}
+
+template <class T>
+template <class TC>
+void GemmKernel<T>::updateTile(size_t mr, size_t nr, TC alpha, T const* ab,
+    TC beta, TC* c, size_t rsC, size_t csC)
+{
+    if constexpr (std::is_same<T, TC>::value) {
+        if (rsC == 1 and mr == MR) {
+            batch alphaVec(alpha), betaVec(beta);
+            for (size_t j = 0; j < nr; ++j, c += csC, ab += MR) {
+                batch r0 = alphaVec * batch::load_aligned(ab);
+                batch r1 = alphaVec * batch::load_aligned(ab + simdSize);
+                if (beta != TC(0)) {
+                    r0 = xsimd::fma(betaVec, batch::load_unaligned(c), r0);
+                    r1 = xsimd::fma(betaVec, batch::load_unaligned(c + simdSize), r1);
+                }
+                r0.store_unaligned(c);
+                r1.store_unaligned(c + simdSize);
+            }
+            return;
+        }
+    }
+
+    for (size_t j = 0; j < nr; ++j) {
+        for (size_t i = 0; i < mr; ++i) {
+            TC& cij = c[i * rsC + j * csC];
+            TC value = alpha * static_cast<TC>(ab[i + j * MR]);
+            cij = beta == TC(0) ? value : value + beta * cij;
+        }
+    }
+}
+
+template <class T>
+template <class TC>
+void GemmKernel<T>::scale(size_t m, size_t n, TC beta, TC* c, size_t rsC, size_t csC)
+{
+    if (beta == TC(1)) return;
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < m; ++i) {
+            TC& cij = c[i * rsC + j * csC];
+            cij = beta == TC(0) ? TC(0) : beta * cij;
+        }
+    }
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BlasBooster {
+
+/**
+ * \brief RAII mapping of a whole file into memory.
+ *
+ * Private mappings are copy-on-write, so that a matrix opened from a file can
+ * be modified in memory without changing the file. Shared mappings write
+ * through to the file, e.g. for out-of-core results. The pages are read by the
+ * OS on first access, so that opening a file is independent of its size.
+ */
+class MappedFile
+{
+public:
+
+    enum class Mode { Private, Shared };
+
+    /// Map an existing file
+    MappedFile(std::string const& filename, Mode mode = Mode::Private)
+     : filename_(filename)
+    {
+        fd_ = ::open(filename.c_str(), mode == Mode::Shared ? O_RDWR : O_RDONLY);
+        if (fd_ < 0) throwConstructionError("open");
+
+        struct stat status;
+        if (::fstat(fd_, &status) != 0) throwConstructionError("fstat");
+        size_ = status.st_size;
+
+        map(mode);
+    }
+
+    /// Create a file of size bytes, or truncate an existing one, and map it shared
+    MappedFile(std::string const& filename, size_t size)
+     : filename_(filename), size_(size)
+    {
+        fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) throwConstructionError("open");
+        if (::ftruncate(fd_, size) != 0) throwConstructionError("ftruncate");
+
+        map(Mode::Shared);
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator = (MappedFile const&) = delete;
+
+    ~MappedFile()
+    {
+        if (data_ and size_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    char* getData() { return static_cast<char*>(data_); }
+    char const* getData() const { return static_cast<char const*>(data_); }
+
+    size_t getSize() const { return size_; }
+
+    std::string const& getFilename() const { return filename_; }
+
+    /// Write modified pages of a shared mapping to the file
+    void sync()
+    {
+        if (data_ and size_ and ::msync(data_, size_, MS_SYNC) != 0) throwError("msync");
+    }
+
+    /// Hint for the read-ahead of the OS, e.g. MADV_SEQUENTIAL or MADV_WILLNEED
+    void advise(int advice) const
+    {
+        if (data_ and size_) ::madvise(data_, size_, advice);
+    }
+
+private:
+
+    void map(Mode mode)
+    {
+        // mmap of zero bytes is invalid, an empty file has no data
+        if (size_ == 0) return;
+        data_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, mode == Mode::Shared ? MAP_SHARED : MAP_PRIVATE, fd_, 0);
+        if (data_ == MAP_FAILED) {
+            data_ = nullptr;
+            throwConstructionError("mmap");
+        }
+    }
+
+    [[noreturn]] void throwError(std::string const& function) const
+    {
+        throw std::runtime_error("MappedFile: " + function + " of " + filename_ + " failed: " + std::strerror(errno));
+    }
+
+    /// The destructor is not called if the constructor throws
+    [[noreturn]] void throwConstructionError(std::string const& function)
+    {
+        int error = errno;
+        if (fd_ >= 0) ::close(fd_);
+        errno = error;
+        throwError(function);
+    }
+
+    std::string filename_;
+
+    int fd_ = -1;
+
+    void* data_ = nullptr;
+
+    size_t size_ = 0;
+
+};
+
+} // namespace BlasBooster
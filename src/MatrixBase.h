@@ -25,6 +25,9 @@ struct MatrixBase
     virtual const std::type_info& getTypeInfo() const = 0;
 
     virtual size_t getTypeIndex() const = 0;
+
+    /// Norm given by the NormType of the matrix parameter
+    virtual double getNorm() const = 0;
 };
 
 } // namespace BlasBooster
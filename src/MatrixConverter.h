@@ -0,0 +1,603 @@
+#pragma once
+
+#include "BlockSparseMatrix.h"
+#include "CostModel.h"
+#include "DenseMatrix.h"
+#include "DynamicMatrix.h"
+#include "DynamicMatrixTypeList.h"
+#include "MultipleMatrix.h"
+#include "SparseMatrix.h"
+#include "TypeList.h"
+#include "WorkStealingScheduler.h"
+#include "ZeroMatrix.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Criteria for the choice of the block representation
+struct ConverterSettings
+{
+    /// Edge length of the square blocks, the last block row and column may be smaller
+    size_t blockSize = 256;
+
+    /// Absolute accuracy, elements with |x| <= threshold are not significant
+    double threshold = 0.0;
+
+    /// Blocks with a lower occupation are stored as sparse matrix, if no cost model is available
+    double sparseOccupation = 0.3;
+
+    /// Blocks with a lower fraction of significant tiles are stored as block-sparse matrix, if no cost model is available
+    double blockSparseOccupation = 0.5;
+
+    /// Minimal fraction of significant elements within the significant tiles for a block-sparse matrix
+    double minTileFill = 0.5;
+
+    /// Calibrated kernel runtimes of the host, which replace sparseOccupation by the measured crossover
+    std::shared_ptr<CostModel const> costModel = CostModel::getDefault();
+
+    /// Occupation below which a block multiplied with a dense block is faster as sparse than as dense type
+    double getSparseOccupation(size_t sparseType, size_t denseType) const
+    {
+        if (!costModel) return sparseOccupation;
+        static const size_t partnerType = GetIndex<Matrix<Dense,double>, DynamicMatrixTypeList>::value;
+        return costModel->getCrossoverOccupation(sparseType, denseType, partnerType, static_cast<double>(blockSize));
+    }
+};
+
+/**
+ * \brief Result of the fused scan over a block.
+ *
+ * All values are determined by a single pass over the memory of the block.
+ */
+struct BlockStatistics
+{
+    /// Number of bins of the magnitude histogram, each bin covers four binary orders of magnitude
+    static const size_t nbBins = 64;
+
+    /// Lowest binary exponent of the histogram, smaller magnitudes are counted in the first bin
+    static const int minExponent = -128;
+
+    /// Edge length of the tiles counted for the block-sparse matrix type
+    static const size_t tileSize = 4;
+
+    size_t nbElements = 0;
+
+    /// Number of elements with |x| > threshold
+    size_t nbSignificant = 0;
+
+    /// Number of tileSize x tileSize tiles with a significant element
+    size_t nbSignificantTiles = 0;
+
+    /// Number of elements, which can not be stored in single precision within the threshold
+    size_t nbDouble = 0;
+
+    /// Maximum absolute column sum
+    double normOne = 0.0;
+
+    /// Frobenius norm
+    double normTwo = 0.0;
+
+    /// Maximum absolute value
+    double normMax = 0.0;
+
+    std::array<size_t, nbBins> histogram{};
+
+    double getOccupation() const { return nbElements ? static_cast<double>(nbSignificant) / nbElements : 0.0; }
+
+    /// Fraction of elements stored in a block-sparse matrix, i.e. including the zeros of the significant tiles
+    double getTileOccupation() const {
+        return nbElements ? std::min(1.0, static_cast<double>(nbSignificantTiles * tileSize * tileSize) / nbElements) : 0.0;
+    }
+
+    /// Fraction of significant elements within the significant tiles
+    double getTileFill() const {
+        return nbSignificantTiles ? static_cast<double>(nbSignificant) / (nbSignificantTiles * tileSize * tileSize) : 0.0;
+    }
+
+    template <class NormType>
+    double getNorm() const
+    {
+        if constexpr (std::is_same<NormType, NormOne>::value) return normOne;
+        else if constexpr (std::is_same<NormType, NormTwo>::value) return normTwo;
+        else return normMax;
+    }
+
+    static size_t getBin(double absValue)
+    {
+        int exponent = static_cast<int>((std::bit_cast<std::uint64_t>(absValue) >> 52) & 0x7ff) - 1023;
+        return std::clamp((exponent - minExponent) >> 2, 0, static_cast<int>(nbBins) - 1);
+    }
+};
+
+/**
+ * \brief Criterion if a block can be stored as matrix type X.
+ *
+ * Primary template for matrix types, which are not available for conversion.
+ */
+template <class X>
+struct ConversionCriterion
+{
+    static bool check(BlockStatistics const&, ConverterSettings const&) { return false; }
+};
+
+template <class P>
+struct ConversionCriterion<Matrix<Zero,NullType,P>>
+{
+    static bool check(BlockStatistics const& s, ConverterSettings const&) { return s.nbSignificant == 0; }
+};
+
+template <class P>
+struct ConversionCriterion<Matrix<Sparse,float,P>>
+{
+    static bool check(BlockStatistics const& s, ConverterSettings const& settings) {
+        return s.nbDouble == 0 and s.getOccupation() < settings.getSparseOccupation(
+            GetIndex<Matrix<Sparse,float,P>, DynamicMatrixTypeList>::value,
+            GetIndex<Matrix<Dense,float,P>, DynamicMatrixTypeList>::value);
+    }
+};
+
+template <class P>
+struct ConversionCriterion<Matrix<Dense,float,P>>
+{
+    static bool check(BlockStatistics const& s, ConverterSettings const&) { return s.nbDouble == 0; }
+};
+
+/// The significant elements are clustered into few and well filled tiles
+template <class P>
+struct ConversionCriterion<Matrix<BlockSparse<BlockStatistics::tileSize>,double,P>>
+{
+    static bool check(BlockStatistics const& s, ConverterSettings const& settings) {
+        if (s.nbSignificantTiles == 0 or s.getTileFill() < settings.minTileFill) return false;
+        return s.getTileOccupation() < (settings.costModel ? settings.getSparseOccupation(
+            GetIndex<Matrix<BlockSparse<BlockStatistics::tileSize>,double,P>, DynamicMatrixTypeList>::value,
+            GetIndex<Matrix<Dense,double,P>, DynamicMatrixTypeList>::value) : settings.blockSparseOccupation);
+    }
+};
+
+template <class P>
+struct ConversionCriterion<Matrix<Sparse,double,P>>
+{
+    static bool check(BlockStatistics const& s, ConverterSettings const& settings) {
+        return s.getOccupation() < settings.getSparseOccupation(
+            GetIndex<Matrix<Sparse,double,P>, DynamicMatrixTypeList>::value,
+            GetIndex<Matrix<Dense,double,P>, DynamicMatrixTypeList>::value);
+    }
+};
+
+/// The elements, which need double precision, are few enough for a sparse matrix
+template <class P1, class P2>
+struct ConversionCriterion<MultipleMatrix<Matrix<Sparse,double,P1>, Matrix<Dense,float,P2>>>
+{
+    static bool check(BlockStatistics const& s, ConverterSettings const& settings) {
+        return s.nbElements and static_cast<double>(s.nbDouble) / s.nbElements < settings.getSparseOccupation(
+            GetIndex<Matrix<Sparse,double,P1>, DynamicMatrixTypeList>::value,
+            GetIndex<Matrix<Dense,double,P1>, DynamicMatrixTypeList>::value);
+    }
+};
+
+template <class P>
+struct ConversionCriterion<Matrix<Dense,double,P>>
+{
+    static bool check(BlockStatistics const&, ConverterSettings const&) { return true; }
+};
+
+/**
+ * \brief Construction of a block of type X from a region of a dense matrix.
+ *
+ * Primary template for matrix types, which are not available for conversion.
+ */
+template <class X>
+struct BlockConversion
+{
+    template <class T>
+    static DynamicMatrix apply(T const*, size_t, size_t, size_t, size_t, BlockStatistics const&, double)
+    {
+        throw std::runtime_error("BlockConversion: matrix type not available for conversion.");
+    }
+};
+
+template <class P>
+struct BlockConversion<Matrix<Zero,NullType,P>>
+{
+    template <class T>
+    static DynamicMatrix apply(T const*, size_t, size_t, size_t m, size_t n, BlockStatistics const&, double)
+    {
+        return DynamicMatrix(new Matrix<Zero,NullType,P>(m, n));
+    }
+};
+
+template <class T2, class P>
+struct BlockConversion<Matrix<Dense,T2,P>>
+{
+    /// The norm of the scan is cached in the block, dropped elements only make it a slight upper bound.
+    template <class T>
+    static DynamicMatrix apply(T const* data, size_t rs, size_t cs, size_t m, size_t n,
+        BlockStatistics const& statistics, double threshold)
+    {
+        auto block = new Matrix<Dense,T2,P>(m, n);
+        DynamicMatrix result(block);
+        for (size_t j = 0; j != n; ++j) {
+            for (size_t i = 0; i != m; ++i) {
+                T value = data[i * rs + j * cs];
+                (*block)(i, j) = std::abs(value) > threshold ? static_cast<T2>(value) : T2(0);
+            }
+        }
+        block->setNorm(statistics.template getNorm<typename P::NormType>());
+        return result;
+    }
+};
+
+template <class T2, class P>
+struct BlockConversion<Matrix<Sparse,T2,P>>
+{
+    /// The exact storage size and the norm are known by the statistics, no counting pass is needed.
+    template <class T>
+    static DynamicMatrix apply(T const* data, size_t rs, size_t cs, size_t m, size_t n,
+        BlockStatistics const& statistics, double threshold)
+    {
+        const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+        const size_t nbOuter = columnMajor ? n : m;
+        const size_t nbInner = columnMajor ? m : n;
+        const size_t strideOuter = columnMajor ? cs : rs;
+        const size_t strideInner = columnMajor ? rs : cs;
+
+        auto block = new Matrix<Sparse,T2,P>(m, n, statistics.nbSignificant);
+        DynamicMatrix result(block);
+
+        auto value = block->begin();
+        auto key = block->beginKey();
+        auto offset = block->beginOffset();
+        typename P::IndexType position(0);
+
+        for (size_t outer = 0; outer != nbOuter; ++outer) {
+            *offset++ = position;
+            for (size_t inner = 0; inner != nbInner; ++inner) {
+                T x = data[outer * strideOuter + inner * strideInner];
+                if (std::abs(x) > threshold) {
+                    *value++ = static_cast<T2>(x);
+                    *key++ = inner;
+                    ++position;
+                }
+            }
+        }
+        *offset = position;
+        block->setNorm(statistics.template getNorm<typename P::NormType>());
+        return result;
+    }
+};
+
+/// The tile size of the scan is taken for a runtime tile size
+template <size_t TileSize, class T2, class P>
+struct BlockConversion<Matrix<BlockSparse<TileSize>,T2,P>>
+{
+    template <class T>
+    static DynamicMatrix apply(T const* data, size_t rs, size_t cs, size_t m, size_t n,
+        BlockStatistics const& statistics, double threshold)
+    {
+        auto block = new Matrix<BlockSparse<TileSize>,T2,P>(data, rs, cs, m, n,
+            [threshold](T const& x){ return std::abs(x) > threshold; }, TileSize ? TileSize : BlockStatistics::tileSize);
+        DynamicMatrix result(block);
+        block->setNorm(statistics.template getNorm<typename P::NormType>());
+        return result;
+    }
+};
+
+/// Elements above the precision limit of float are the outliers in double precision
+template <class T1, class P1, class T2, class P2>
+struct BlockConversion<MultipleMatrix<Matrix<Sparse,T1,P1>, Matrix<Dense,T2,P2>>>
+{
+    typedef MultipleMatrix<Matrix<Sparse,T1,P1>, Matrix<Dense,T2,P2>> block_type;
+
+    template <class T>
+    static DynamicMatrix apply(T const* data, size_t rs, size_t cs, size_t m, size_t n,
+        BlockStatistics const& statistics, double threshold)
+    {
+        const double outlierThreshold = threshold / std::numeric_limits<float>::epsilon();
+        auto block = new block_type(data, rs, cs, m, n, outlierThreshold, threshold);
+        DynamicMatrix result(block);
+        block->setNorm(statistics.template getNorm<typename P1::NormType>());
+        return result;
+    }
+};
+
+/**
+ * \brief Addition of a block into a region of a dense matrix.
+ *
+ * Primary template for matrix types without conversion into dense.
+ */
+template <class X>
+struct BlockToDense
+{
+    template <class T>
+    static void apply(DynamicMatrix const&, T*, size_t, size_t)
+    {
+        throw std::runtime_error("BlockToDense: matrix type not available for conversion.");
+    }
+};
+
+template <class P>
+struct BlockToDense<Matrix<Zero,NullType,P>>
+{
+    template <class T>
+    static void apply(DynamicMatrix const&, T*, size_t, size_t)
+    {}
+};
+
+template <class T2, class P>
+struct BlockToDense<Matrix<Dense,T2,P>>
+{
+    template <class T>
+    static void apply(DynamicMatrix const& dynBlock, T* data, size_t rs, size_t cs)
+    {
+        add(dynBlock.get<Matrix<Dense,T2,P>>(), data, rs, cs);
+    }
+
+    template <class T>
+    static void add(Matrix<Dense,T2,P> const& block, T* data, size_t rs, size_t cs)
+    {
+        for (size_t j = 0; j != block.getNbColumns(); ++j)
+            for (size_t i = 0; i != block.getNbRows(); ++i)
+                data[i * rs + j * cs] += block(i, j);
+    }
+};
+
+template <class T2, class P>
+struct BlockToDense<Matrix<Sparse,T2,P>>
+{
+    template <class T>
+    static void apply(DynamicMatrix const& dynBlock, T* data, size_t rs, size_t cs)
+    {
+        add(dynBlock.get<Matrix<Sparse,T2,P>>(), data, rs, cs);
+    }
+
+    template <class T>
+    static void add(Matrix<Sparse,T2,P> const& block, T* data, size_t rs, size_t cs)
+    {
+        const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+        auto value = block.begin();
+        auto key = block.beginKey();
+        auto offset = block.beginOffset();
+        for (size_t outer = 0; outer != block.getMinorDimension(); ++outer) {
+            for (auto e = offset[outer]; e != offset[outer + 1]; ++e) {
+                size_t i = columnMajor ? key[e] : outer;
+                size_t j = columnMajor ? outer : key[e];
+                data[i * rs + j * cs] += value[e];
+            }
+        }
+    }
+};
+
+template <size_t TileSize, class T2, class P>
+struct BlockToDense<Matrix<BlockSparse<TileSize>,T2,P>>
+{
+    template <class T>
+    static void apply(DynamicMatrix const& dynBlock, T* data, size_t rs, size_t cs)
+    {
+        add(dynBlock.get<Matrix<BlockSparse<TileSize>,T2,P>>(), data, rs, cs);
+    }
+
+    template <class T>
+    static void add(Matrix<BlockSparse<TileSize>,T2,P> const& block, T* data, size_t rs, size_t cs)
+    {
+        block.forEachElement([&](size_t i, size_t j, T2 const& value){ data[i * rs + j * cs] += value; });
+    }
+};
+
+template <class X1, class X2>
+struct BlockToDense<MultipleMatrix<X1,X2>>
+{
+    template <class T>
+    static void apply(DynamicMatrix const& dynBlock, T* data, size_t rs, size_t cs)
+    {
+        auto const& block = dynBlock.get<MultipleMatrix<X1,X2>>();
+        BlockToDense<X1>::add(block.getFirst(), data, rs, cs);
+        BlockToDense<X2>::add(block.getSecond(), data, rs, cs);
+    }
+};
+
+/**
+ * \brief Conversion between a dense matrix and a blocked matrix of DynamicMatrix.
+ *
+ * The source matrix is divided into square blocks. Each block is analysed by a
+ * single fused scan (occupation, significant tiles, precision, magnitude
+ * histogram and norms) and is converted into the first type of
+ * DynamicMatrixTypeList matching the criteria.
+ * All blocks are analysed and converted in parallel.
+ */
+class MatrixConverter
+{
+public:
+
+    typedef DynamicMatrixTypeList TypeList;
+
+    static const size_t nbTypes = GetSize<TypeList>::value;
+
+    MatrixConverter(ConverterSettings const& settings = ConverterSettings(),
+        WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+     : settings_(settings), scheduler_(scheduler)
+    {}
+
+    ConverterSettings const& getSettings() const { return settings_; }
+
+    /// Dense to blocked
+    template <class T, class P, class PB>
+    void operator () (Matrix<Dense,T,P> const& source, Matrix<Dense,DynamicMatrix,PB>& target) const
+    {
+        convert(source.getDataPointer(), getRowStride(source), getColumnStride(source),
+            source.getNbRows(), source.getNbColumns(), target);
+    }
+
+    /// Dense to blocked for a m x n matrix in external memory with arbitrary strides, e.g. a BLAS operand
+    template <class T, class PB>
+    void convert(T const* data, size_t rs, size_t cs, size_t nbRows, size_t nbColumns,
+        Matrix<Dense,DynamicMatrix,PB>& target) const;
+
+    /// Blocked to dense
+    template <class PB, class T, class P>
+    void operator () (Matrix<Dense,DynamicMatrix,PB> const& source, Matrix<Dense,T,P>& target) const;
+
+    /// Fused scan of a m x n block with arbitrary strides
+    template <class T>
+    static BlockStatistics analyse(T const* data, size_t rs, size_t cs, size_t m, size_t n, double threshold);
+
+    /// Index of the first type in DynamicMatrixTypeList matching the criteria
+    size_t selectType(BlockStatistics const& statistics) const
+    {
+        return selectType(statistics, std::make_index_sequence<nbTypes>());
+    }
+
+private:
+
+    template <size_t... I>
+    size_t selectType(BlockStatistics const& statistics, std::index_sequence<I...>) const
+    {
+        size_t index = nbTypes;
+        ((ConversionCriterion<typename GetType<I,TypeList>::type>::check(statistics, settings_)
+            ? (index = I, true) : false) or ...);
+        return index;
+    }
+
+    template <class T, size_t... I>
+    static DynamicMatrix convertBlock(size_t typeIndex, T const* data, size_t rs, size_t cs, size_t m, size_t n,
+        BlockStatistics const& statistics, double threshold, std::index_sequence<I...>)
+    {
+        typedef DynamicMatrix (*function_type)(T const*, size_t, size_t, size_t, size_t, BlockStatistics const&, double);
+        static constexpr function_type table[] = { &BlockConversion<typename GetType<I,TypeList>::type>::template apply<T>... };
+        return table[typeIndex](data, rs, cs, m, n, statistics, threshold);
+    }
+
+    template <class T, size_t... I>
+    static void addBlock(DynamicMatrix const& block, T* data, size_t rs, size_t cs, std::index_sequence<I...>)
+    {
+        typedef void (*function_type)(DynamicMatrix const&, T*, size_t, size_t);
+        static constexpr function_type table[] = { &BlockToDense<typename GetType<I,TypeList>::type>::template apply<T>... };
+        if (block.getTypeIndex() >= nbTypes) throw std::runtime_error("MatrixConverter: type of DynamicMatrix not in DynamicMatrixTypeList.");
+        table[block.getTypeIndex()](block, data, rs, cs);
+    }
+
+    ConverterSettings settings_;
+
+    WorkStealingScheduler scheduler_;
+
+};
+
+template <class T>
+BlockStatistics MatrixConverter::analyse(T const* data, size_t rs, size_t cs, size_t m, size_t n, double threshold)
+{
+    BlockStatistics s;
+    s.nbElements = m * n;
+
+    const double doubleThreshold = threshold / std::numeric_limits<float>::epsilon();
+    double sumSquares = 0.0;
+
+    static thread_local std::vector<double> columnSums;
+    columnSums.assign(n, 0.0);
+
+    // Significance flags of the tiles
+    const size_t tileSize = BlockStatistics::tileSize;
+    const size_t nbTileColumns = (n + tileSize - 1) / tileSize;
+    static thread_local std::vector<unsigned char> tiles;
+    tiles.assign(((m + tileSize - 1) / tileSize) * nbTileColumns, 0);
+
+    auto visit = [&](size_t i, size_t j, T x)
+    {
+        double absValue = std::abs(static_cast<double>(x));
+        bool significant = absValue > threshold;
+        columnSums[j] += absValue;
+        sumSquares += absValue * absValue;
+        s.normMax = std::max(s.normMax, absValue);
+        s.nbSignificant += significant;
+        s.nbDouble += absValue > doubleThreshold;
+        tiles[(i / tileSize) * nbTileColumns + j / tileSize] |= significant;
+        ++s.histogram[BlockStatistics::getBin(absValue)];
+    };
+
+    // Walk through the memory in storage order
+    if (cs == 1 and rs != 1) {
+        for (size_t i = 0; i != m; ++i)
+            for (size_t j = 0; j != n; ++j) visit(i, j, data[i * rs + j]);
+    } else {
+        for (size_t j = 0; j != n; ++j)
+            for (size_t i = 0; i != m; ++i) visit(i, j, data[i * rs + j * cs]);
+    }
+
+    s.nbSignificantTiles = std::count(tiles.begin(), tiles.end(), 1);
+    s.normTwo = std::sqrt(sumSquares);
+    for (auto columnSum : columnSums) s.normOne = std::max(s.normOne, columnSum);
+    return s;
+}
+
+template <class T, class PB>
+void MatrixConverter::convert(T const* source, size_t rs, size_t cs, size_t nbRows, size_t nbColumns,
+    Matrix<Dense,DynamicMatrix,PB>& target) const
+{
+    const size_t blockSize = settings_.blockSize;
+    if (blockSize == 0) throw std::runtime_error("MatrixConverter: block size must be positive.");
+
+    const size_t nbBlockRows = (nbRows + blockSize - 1) / blockSize;
+    const size_t nbBlockColumns = (nbColumns + blockSize - 1) / blockSize;
+
+    target.resize(nbBlockRows, nbBlockColumns, nbRows, nbColumns);
+
+    auto blockRows = [&](size_t bi) { return std::min(blockSize, nbRows - bi * blockSize); };
+    auto blockColumns = [&](size_t bj) { return std::min(blockSize, nbColumns - bj * blockSize); };
+
+    auto task = [&](size_t index)
+    {
+        size_t bi = index % nbBlockRows, bj = index / nbBlockRows;
+        size_t m = blockRows(bi), n = blockColumns(bj);
+        T const* data = source + bi * blockSize * rs + bj * blockSize * cs;
+
+        BlockStatistics statistics = analyse(data, rs, cs, m, n, settings_.threshold);
+        target(bi, bj) = convertBlock(selectType(statistics), data, rs, cs, m, n, statistics,
+            settings_.threshold, std::make_index_sequence<nbTypes>());
+    };
+
+    auto cost = [&](size_t index) {
+        return static_cast<double>(blockRows(index % nbBlockRows) * blockColumns(index / nbBlockRows));
+    };
+
+    scheduler_.run(nbBlockRows * nbBlockColumns, task, cost);
+}
+
+template <class PB, class T, class P>
+void MatrixConverter::operator () (Matrix<Dense,DynamicMatrix,PB> const& source, Matrix<Dense,T,P>& target) const
+{
+    if (target.getNbRows() != source.getUnblockedRows() or target.getNbColumns() != source.getUnblockedColumns())
+        target.resize(source.getUnblockedRows(), source.getUnblockedColumns(), [](){});
+
+    const size_t nbBlockRows = source.getNbRows();
+    const size_t nbBlockColumns = source.getNbColumns();
+    const size_t rs = getRowStride(target), cs = getColumnStride(target);
+
+    // Empty DynamicMatrix blocks are zero, their sizes are given by the other blocks of the grid
+    const auto blockRows = getBlockRowSizes(source);
+    const auto blockColumns = getBlockColumnSizes(source);
+    std::vector<size_t> rowOffsets(nbBlockRows + 1, 0), columnOffsets(nbBlockColumns + 1, 0);
+    for (size_t bi = 0; bi != nbBlockRows; ++bi) rowOffsets[bi + 1] = rowOffsets[bi] + blockRows[bi];
+    for (size_t bj = 0; bj != nbBlockColumns; ++bj) columnOffsets[bj + 1] = columnOffsets[bj] + blockColumns[bj];
+
+    auto task = [&](size_t index)
+    {
+        size_t bi = index % nbBlockRows, bj = index / nbBlockRows;
+        DynamicMatrix const& block = source(bi, bj);
+        T* data = target.getDataPointer() + rowOffsets[bi] * rs + columnOffsets[bj] * cs;
+        for (size_t j = 0; j != blockColumns[bj]; ++j)
+            for (size_t i = 0; i != blockRows[bi]; ++i) data[i * rs + j * cs] = T(0);
+        if (!block.empty()) addBlock(block, data, rs, cs, std::make_index_sequence<nbTypes>());
+    };
+
+    scheduler_.run(nbBlockRows * nbBlockColumns, task);
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,370 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "MappedFile.h"
+#include "SparseMatrix.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Codes of the element types in a matrix file
+template <class T>
+struct FileValueType;
+
+template <> struct FileValueType<float> { static constexpr uint32_t value = 1; };
+template <> struct FileValueType<double> { static constexpr uint32_t value = 2; };
+template <> struct FileValueType<int32_t> { static constexpr uint32_t value = 3; };
+template <> struct FileValueType<int64_t> { static constexpr uint32_t value = 4; };
+template <> struct FileValueType<uint32_t> { static constexpr uint32_t value = 5; };
+template <> struct FileValueType<uint64_t> { static constexpr uint32_t value = 6; };
+
+/**
+ * \brief Header of the binary matrix file format, version 1.
+ *
+ * The header is followed by the arrays of the matrix in native byte order,
+ * each starting at a multiple of 4096 bytes, so that the mapped arrays are
+ * page aligned. Dense matrices have a single array of nbRows x nbColumns
+ * elements in the given orientation. Sparse matrices have the value and key
+ * arrays of nnz elements and the offset array of nbColumns + 1 (CSC) or
+ * nbRows + 1 (CSR) elements of the index type.
+ */
+struct MatrixFileHeader
+{
+    static constexpr char magic[8] = {'B', 'B', 'M', 'A', 'T', 'R', 'I', 'X'};
+    static constexpr uint32_t currentVersion = 1;
+    static constexpr uint32_t byteOrderMark = 0x01020304;
+    static constexpr size_t alignment = 4096;
+
+    enum MatrixType : uint32_t { DenseType = 1, SparseType = 2 };
+    enum Orientation : uint32_t { ColumnMajorOrientation = 0, RowMajorOrientation = 1 };
+
+    char identifier[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t matrixType;
+    uint32_t valueType;
+    /// Size of the index type in bytes, only sparse
+    uint32_t indexSize;
+    uint32_t orientation;
+    uint64_t nbRows;
+    uint64_t nbColumns;
+    /// Number of stored elements, only sparse
+    uint64_t nnz;
+    /// Positions of the arrays in bytes from the beginning of the file
+    uint64_t valuePosition;
+    uint64_t keyPosition;
+    uint64_t offsetPosition;
+
+    template <class T, class P>
+    static MatrixFileHeader create(MatrixType matrixType, size_t nbRows, size_t nbColumns)
+    {
+        MatrixFileHeader header{};
+        std::memcpy(header.identifier, magic, sizeof(magic));
+        header.version = currentVersion;
+        header.byteOrder = byteOrderMark;
+        header.matrixType = matrixType;
+        header.valueType = FileValueType<T>::value;
+        header.orientation = getOrientation<P>();
+        header.nbRows = nbRows;
+        header.nbColumns = nbColumns;
+        return header;
+    }
+
+    template <class P>
+    static uint32_t getOrientation()
+    {
+        return std::is_same<typename P::orientation, RowMajor>::value ? RowMajorOrientation : ColumnMajorOrientation;
+    }
+
+    static size_t align(size_t position)
+    {
+        return (position + alignment - 1) / alignment * alignment;
+    }
+
+    /// a * b, sizes of a corrupted header or a too large matrix must not wrap around
+    static size_t multiply(size_t a, size_t b)
+    {
+        if (a != 0 and b > std::numeric_limits<size_t>::max() / a)
+            throw std::runtime_error("MatrixFile: size overflow.");
+        return a * b;
+    }
+
+    /// a + b without wrap around
+    static size_t add(size_t a, size_t b)
+    {
+        if (b > std::numeric_limits<size_t>::max() - a)
+            throw std::runtime_error("MatrixFile: size overflow.");
+        return a + b;
+    }
+
+    /// Check that the file contains a matrix of the expected type and return its header
+    template <class T, class P>
+    static MatrixFileHeader const& check(MappedFile const& file, MatrixType matrixType)
+    {
+        if (file.getSize() < sizeof(MatrixFileHeader))
+            throw std::runtime_error("MatrixFile: " + file.getFilename() + " is too small.");
+
+        auto const& header = *reinterpret_cast<MatrixFileHeader const*>(file.getData());
+        if (std::memcmp(header.identifier, magic, sizeof(magic)) != 0)
+            throw std::runtime_error("MatrixFile: " + file.getFilename() + " is not a matrix file.");
+        if (header.version != currentVersion)
+            throw std::runtime_error("MatrixFile: version " + std::to_string(header.version) + " is not supported.");
+        if (header.byteOrder != byteOrderMark)
+            throw std::runtime_error("MatrixFile: byte order mismatch.");
+        if (header.matrixType != matrixType)
+            throw std::runtime_error("MatrixFile: matrix type mismatch.");
+        if (header.valueType != FileValueType<T>::value)
+            throw std::runtime_error("MatrixFile: value type mismatch, expected " + TypeName<T>::value() + ".");
+        if (header.orientation != getOrientation<P>())
+            throw std::runtime_error("MatrixFile: orientation mismatch.");
+        return header;
+    }
+
+    /// Array of size elements at position, which must be within the file
+    template <class T>
+    static T* getArray(MappedFile& file, size_t position, size_t size)
+    {
+        if (position % alignof(T) != 0 or position > file.getSize() or size > (file.getSize() - position) / sizeof(T))
+            throw std::runtime_error("MatrixFile: " + file.getFilename() + " is truncated.");
+        return reinterpret_cast<T*>(file.getData() + position);
+    }
+};
+
+static_assert(sizeof(MatrixFileHeader) == 80, "MatrixFileHeader: unexpected padding.");
+
+/// Write the header and pad the stream to the alignment
+inline void writeHeader(std::ofstream& out, MatrixFileHeader const& header)
+{
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    std::vector<char> padding(MatrixFileHeader::align(sizeof(header)) - sizeof(header), 0);
+    out.write(padding.data(), padding.size());
+}
+
+/**
+ * \brief Reading and writing of a matrix type in the binary matrix file format.
+ *
+ * map returns a matrix using the memory of the mapped file.
+ * Dense matrices can also be created in a new file.
+ */
+template <class X>
+struct MatrixFile
+{
+    static_assert(sizeof(X) == 0, "MatrixFile: matrix type not supported.");
+};
+
+template <class T, class P>
+struct MatrixFile<Matrix<Dense,T,P>>
+{
+    typedef Matrix<Dense,T,P> matrix_type;
+
+    static_assert(!P::onStack and !P::isFixed and !P::isSubMatrix and !P::isBlockedMatrix,
+        "MatrixFile: only variable sized dense matrices on heap can be mapped.");
+
+    static size_t getDataPosition()
+    {
+        return MatrixFileHeader::align(sizeof(MatrixFileHeader));
+    }
+
+    /// Call write(data, bytes) for each column (ColumnMajor) or row (RowMajor) of the matrix
+    template <class P2, class Write>
+    static void forEachLine(Matrix<Dense,T,P2> const& matrix, Write const& write)
+    {
+        const bool columnMajor = std::is_same<typename P2::orientation, ColumnMajor>::value;
+        const size_t nbLines = columnMajor ? matrix.getNbColumns() : matrix.getNbRows();
+        const size_t lineSize = columnMajor ? matrix.getNbRows() : matrix.getNbColumns();
+        const size_t lineStride = columnMajor ? getColumnStride(matrix) : getRowStride(matrix);
+        for (size_t line = 0; line != nbLines; ++line)
+            write(reinterpret_cast<char const*>(matrix.getDataPointer() + line * lineStride), lineSize * sizeof(T));
+    }
+
+    /// Sub-matrices are written line by line, so that the file is contiguous
+    template <class P2>
+    static void write(Matrix<Dense,T,P2> const& matrix, std::string const& filename)
+    {
+        std::ofstream out(filename, std::ios::binary);
+        if (!out) throw std::runtime_error("MatrixFile: can not open " + filename + ".");
+
+        auto header = MatrixFileHeader::create<T,P2>(MatrixFileHeader::DenseType, matrix.getNbRows(), matrix.getNbColumns());
+        header.valuePosition = getDataPosition();
+        writeHeader(out, header);
+
+        forEachLine(matrix, [&](char const* data, size_t size){ out.write(data, size); });
+
+        if (!out) throw std::runtime_error("MatrixFile: writing " + filename + " failed.");
+    }
+
+    static matrix_type map(MappedFile& file)
+    {
+        auto const& header = MatrixFileHeader::check<T,P>(file, MatrixFileHeader::DenseType);
+        return matrix_type(header.nbRows, header.nbColumns,
+            MatrixFileHeader::getArray<T>(file, header.valuePosition, MatrixFileHeader::multiply(header.nbRows, header.nbColumns)));
+    }
+
+    /// Uninitialized matrix in a new file
+    static matrix_type create(MappedFile& file, size_t nbRows, size_t nbColumns)
+    {
+        auto header = MatrixFileHeader::create<T,P>(MatrixFileHeader::DenseType, nbRows, nbColumns);
+        header.valuePosition = getDataPosition();
+        std::memcpy(file.getData(), &header, sizeof(header));
+        return map(file);
+    }
+
+    static size_t getFileSize(size_t nbRows, size_t nbColumns)
+    {
+        return MatrixFileHeader::add(getDataPosition(),
+            MatrixFileHeader::multiply(MatrixFileHeader::multiply(nbRows, nbColumns), sizeof(T)));
+    }
+};
+
+template <class T, class P>
+struct MatrixFile<Matrix<Sparse,T,P>>
+{
+    typedef Matrix<Sparse,T,P> matrix_type;
+    typedef typename P::IndexType IndexType;
+
+    static_assert(!P::isFixed, "MatrixFile: only variable sized sparse matrices can be mapped.");
+
+    template <class P2>
+    static void write(Matrix<Sparse,T,P2> const& matrix, std::string const& filename)
+    {
+        static_assert(sizeof(typename P2::IndexType) == sizeof(IndexType), "MatrixFile: index type mismatch.");
+
+        std::ofstream out(filename, std::ios::binary);
+        if (!out) throw std::runtime_error("MatrixFile: can not open " + filename + ".");
+
+        const size_t nnz = matrix.nnz();
+        const size_t nbOffsets = matrix.sizeOffset();
+
+        auto header = createHeader(matrix.getNbRows(), matrix.getNbColumns(), nnz);
+        writeHeader(out, header);
+
+        writeArray(out, matrix.begin().base(), nnz, header.keyPosition - header.valuePosition);
+        writeArray(out, matrix.beginKey().base(), nnz, header.offsetPosition - header.keyPosition);
+        writeArray(out, matrix.beginOffset().base(), nbOffsets, nbOffsets * sizeof(IndexType));
+
+        if (!out) throw std::runtime_error("MatrixFile: writing " + filename + " failed.");
+    }
+
+    /// Header of a matrix with nnz elements and page aligned arrays
+    static MatrixFileHeader createHeader(size_t nbRows, size_t nbColumns, size_t nnz)
+    {
+        auto header = MatrixFileHeader::create<T,P>(MatrixFileHeader::SparseType, nbRows, nbColumns);
+        header.indexSize = sizeof(IndexType);
+        header.nnz = nnz;
+        header.valuePosition = MatrixFileHeader::align(sizeof(MatrixFileHeader));
+        header.keyPosition = MatrixFileHeader::align(MatrixFileHeader::add(header.valuePosition, MatrixFileHeader::multiply(nnz, sizeof(T))));
+        header.offsetPosition = MatrixFileHeader::align(MatrixFileHeader::add(header.keyPosition, MatrixFileHeader::multiply(nnz, sizeof(IndexType))));
+        return header;
+    }
+
+    /// Size of the file up to the end of the offset array
+    static size_t getFileSize(MatrixFileHeader const& header)
+    {
+        const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+        const size_t nbOffsets = MatrixFileHeader::add(columnMajor ? header.nbColumns : header.nbRows, 1);
+        return MatrixFileHeader::add(header.offsetPosition, MatrixFileHeader::multiply(nbOffsets, sizeof(IndexType)));
+    }
+
+    /// The arrays are used in place, only the size and the last offset are checked
+    static matrix_type map(MappedFile& file)
+    {
+        auto const& header = MatrixFileHeader::check<T,P>(file, MatrixFileHeader::SparseType);
+        if (header.indexSize != sizeof(IndexType))
+            throw std::runtime_error("MatrixFile: index size mismatch, expected " + std::to_string(sizeof(IndexType)) + " bytes.");
+
+        const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+        const size_t nbOffsets = MatrixFileHeader::add(columnMajor ? header.nbColumns : header.nbRows, 1);
+
+        T* values = MatrixFileHeader::getArray<T>(file, header.valuePosition, header.nnz);
+        IndexType* keys = MatrixFileHeader::getArray<IndexType>(file, header.keyPosition, header.nnz);
+        IndexType* offsets = MatrixFileHeader::getArray<IndexType>(file, header.offsetPosition, nbOffsets);
+        if (offsets[0] != 0 or offsets[nbOffsets - 1] != header.nnz)
+            throw std::runtime_error("MatrixFile: offsets of " + file.getFilename() + " are inconsistent.");
+
+        return matrix_type(header.nbRows, header.nbColumns, header.nnz, values, keys, offsets);
+    }
+
+private:
+
+    /// Array of size elements padded with zeros to bytes
+    template <class U>
+    static void writeArray(std::ofstream& out, U const* data, size_t size, size_t bytes)
+    {
+        if (size) out.write(reinterpret_cast<char const*>(data), size * sizeof(U));
+        std::vector<char> padding(bytes - size * sizeof(U), 0);
+        out.write(padding.data(), padding.size());
+    }
+};
+
+/// Keeps the mapping alive, base class of MappedMatrix to be constructed before the matrix
+struct MappedFileHolder
+{
+    std::shared_ptr<MappedFile> file_;
+};
+
+/**
+ * \brief Matrix using the memory of a mapped file.
+ *
+ * The matrix is available immediately after opening, the OS reads the pages on
+ * first access and can drop unmodified pages under memory pressure, so that
+ * matrices larger than the main memory can be used. The mapping lives as long
+ * as the MappedMatrix. Format<X> defines the layout of the file, by default
+ * the binary matrix file format.
+ */
+template <class X, template <class> class Format = MatrixFile>
+class MappedMatrix : private MappedFileHolder, public X
+{
+public:
+
+    typedef X matrix_type;
+
+    /// Open an existing file, with Mode::Shared modifications are written to the file
+    explicit MappedMatrix(std::string const& filename, MappedFile::Mode mode = MappedFile::Mode::Private)
+     : MappedFileHolder{std::make_shared<MappedFile>(filename, mode)},
+       X(Format<X>::map(*file_))
+    {}
+
+    /// Create a new file for a nbRows x nbColumns matrix, e.g. for an out-of-core result
+    MappedMatrix(std::string const& filename, size_t nbRows, size_t nbColumns)
+     : MappedFileHolder{std::make_shared<MappedFile>(filename, Format<X>::getFileSize(nbRows, nbColumns))},
+       X(Format<X>::create(*file_, nbRows, nbColumns))
+    {}
+
+    /// Matrix in a mapping shared with other matrices, e.g. an entry of an archive
+    MappedMatrix(std::shared_ptr<MappedFile> file, X&& matrix)
+     : MappedFileHolder{std::move(file)},
+       X(std::move(matrix))
+    {}
+
+    MappedMatrix(MappedMatrix const&) = delete;
+    MappedMatrix& operator = (MappedMatrix const&) = delete;
+
+    MappedMatrix(MappedMatrix&&) = default;
+    MappedMatrix& operator = (MappedMatrix&&) = default;
+
+    MappedFile& getFile() { return *file_; }
+    MappedFile const& getFile() const { return *file_; }
+
+    /// Write modifications of a shared mapping to the file
+    void sync() { file_->sync(); }
+
+};
+
+/// Write a matrix in the binary matrix file format, sub-matrices are written as full matrix
+template <class X>
+void saveMatrix(X const& matrix, std::string const& filename)
+{
+    typedef typename X::parameter P;
+    MatrixFile<Matrix<typename X::matrix_type, typename X::value_type, Parameter<typename P::IndexType, typename P::orientation>>>
+        ::write(matrix, filename);
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "MappedFile.h"
+#include "MatrixFile.h"
+#include "SparseMatrix.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace BlasBooster {
+
+/**
+ * \brief Magnitude class of a tile.
+ *
+ * The classes are designed for the criteria of the MatrixConverter with the
+ * threshold of the generator, so that a tile is converted into the named
+ * type of DynamicMatrixTypeList, if the tile size is the block size of the
+ * converter. MultipleMatrix<Matrix<Sparse,double>, Matrix<Sparse,float>> has
+ * no tile class, because the converter has no ConversionCriterion for it.
+ */
+enum class TileClass
+{
+    Zero,              ///< Matrix<Zero>
+    SparseSingle,      ///< Matrix<Sparse,float>
+    DenseSingle,       ///< Matrix<Dense,float>
+    BlockSparseDouble, ///< Matrix<BlockSparse<4>,double>
+    SparseDouble,      ///< Matrix<Sparse,double>
+    DenseMixed,        ///< MultipleMatrix<Matrix<Sparse,double>, Matrix<Dense,float>>
+    DenseDouble        ///< Matrix<Dense,double>
+};
+
+/// Structure and magnitudes of generated matrices
+struct MatrixGeneratorSettings
+{
+    size_t nbRows = 0;
+    size_t nbColumns = 0;
+
+    /// Probability of an element within the structure to be nonzero
+    double occupation = 1.0;
+
+    /// Only elements with |i - j| <= bandwidth are nonzero
+    size_t bandwidth = std::numeric_limits<size_t>::max();
+
+    /// Block-sparse structure: blocks of blockSize x blockSize are nonzero with the probability blockOccupation
+    size_t blockSize = 1;
+    double blockOccupation = 1.0;
+
+    /// Magnitude of the diagonal, the values are uniformly distributed in [0.5, 1.5] x magnitude with random sign
+    double magnitude = 1.0;
+
+    /// Exponential off-diagonal decay: the magnitude is scaled by exp(-decay |i - j|)
+    double decay = 0.0;
+
+    /// Elements with a magnitude below the cutoff are zero, e.g. to truncate the decay
+    double cutoff = 0.0;
+
+    /// Tiles of tileSize x tileSize cycle through the tile classes, which replace the magnitudes and the occupation
+    size_t tileSize = 256;
+    std::vector<TileClass> tileClasses;
+
+    /// Threshold of the converter the tile classes are designed for
+    double threshold = 1e-8;
+
+    /// Occupation of the sparse tile classes and fraction of double precision elements in mixed tiles
+    double sparseOccupation = 0.05;
+
+    /// Fraction of the fully occupied clusters of clusterSize x clusterSize in block-sparse tile classes
+    double clusterOccupation = 0.25;
+
+    uint64_t seed = 42;
+};
+
+/**
+ * \brief Generator of reproducible dense and sparse test matrices.
+ *
+ * Each element is determined by a counter-based hash of the seed and its
+ * position, so that the matrix is independent of the orientation, the
+ * storage type and the number of threads. Only the positions within the band
+ * and the nonzero blocks are visited, so that the cost is proportional to the
+ * number of candidates and not to the size of the matrix. Very large sparse
+ * matrices are written directly into a matrix file, only the offsets are
+ * kept in memory.
+ */
+class MatrixGenerator
+{
+public:
+
+    /// Edge length of the clusters in block-sparse tile classes, the tile size of the block-sparse type
+    static const size_t clusterSize = 4;
+
+    MatrixGenerator(MatrixGeneratorSettings const& settings, WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+     : settings_(settings), scheduler_(scheduler)
+    {
+        if (settings_.blockSize == 0 or settings_.tileSize == 0)
+            throw std::runtime_error("MatrixGenerator: block and tile size must be positive.");
+        if (!settings_.tileClasses.empty() and settings_.threshold <= 0.0)
+            throw std::runtime_error("MatrixGenerator: tile classes need a positive threshold.");
+    }
+
+    MatrixGeneratorSettings const& getSettings() const { return settings_; }
+
+    /// Value of element (i,j)
+    double operator () (size_t i, size_t j) const
+    {
+        if (!isCandidate(i, j) or !isBlockOccupied(i / settings_.blockSize, j / settings_.blockSize)) return 0.0;
+        return getValue(i, j);
+    }
+
+    /// Generated matrix of the size given by the settings
+    template <class T, class P = Parameter<>>
+    Matrix<Dense,T,P> createDense() const
+    {
+        Matrix<Dense,T,P> matrix(settings_.nbRows, settings_.nbColumns);
+        fill(matrix);
+        return matrix;
+    }
+
+    /// Fill a dense matrix of the size given by the settings, e.g. a MappedMatrix for an out-of-core instance
+    template <class T, class P>
+    void fill(Matrix<Dense,T,P>& matrix) const
+    {
+        if (matrix.getNbRows() != settings_.nbRows or matrix.getNbColumns() != settings_.nbColumns)
+            throw std::runtime_error("MatrixGenerator: dimension mismatch.");
+
+        const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+        const size_t lineStride = columnMajor ? getColumnStride(matrix) : getRowStride(matrix);
+        const size_t nbInner = columnMajor ? settings_.nbRows : settings_.nbColumns;
+
+        scheduler_.run(getNbOuter<P>(), [&](size_t outer) {
+            T* line = matrix.getDataPointer() + outer * lineStride;
+            std::fill(line, line + nbInner, T(0));
+            forEachElement<P>(outer, [&](size_t inner, double value){ line[inner] = static_cast<T>(value); });
+        });
+    }
+
+    /// Generated sparse matrix with the exact storage size
+    template <class T, class P = Parameter<>>
+    Matrix<Sparse,T,P> createSparse() const
+    {
+        typedef Matrix<Sparse,T,P> matrix_type;
+
+        auto offsets = countElements<P>();
+        const size_t nnz = offsets[getNbOuter<P>()];
+
+        return matrix_type(settings_.nbRows, settings_.nbColumns, nnz, [&](matrix_type& matrix) {
+            std::copy(offsets.begin(), offsets.end(), matrix.beginOffset().base());
+            fillLines<P>(matrix.begin().base(), matrix.beginKey().base(), offsets);
+        });
+    }
+
+    /**
+     * Write the sparse matrix into a matrix file, which can be opened by MappedMatrix.
+     *
+     * The elements are counted in a first pass and written in a second pass
+     * into the shared mapping of the file, so that the OS writes the pages
+     * back and the matrix does not need to fit into memory.
+     */
+    template <class T, class P = Parameter<>>
+    void writeSparse(std::string const& filename) const
+    {
+        typedef typename P::IndexType IndexType;
+        typedef MatrixFile<Matrix<Sparse,T,Parameter<IndexType, typename P::orientation>>> File;
+
+        auto offsets = countElements<P>();
+        auto header = File::createHeader(settings_.nbRows, settings_.nbColumns, offsets.back());
+
+        MappedFile file(filename, File::getFileSize(header));
+        std::memcpy(file.getData(), &header, sizeof(header));
+        std::memcpy(file.getData() + header.offsetPosition, offsets.data(), offsets.size() * sizeof(IndexType));
+        fillLines<P>(reinterpret_cast<T*>(file.getData() + header.valuePosition),
+            reinterpret_cast<IndexType*>(file.getData() + header.keyPosition), offsets);
+        file.sync();
+    }
+
+private:
+
+    /// Parameters of a tile class
+    struct TileParameter
+    {
+        double occupation;
+        double magnitude;
+        double outlierMagnitude;
+        double outlierFraction;
+        bool clustered = false;
+    };
+
+    static uint64_t mix(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
+    /// Uniform random number in [0,1) of the position (i,j) in the random stream
+    double uniform(size_t i, size_t j, uint64_t stream) const
+    {
+        return (mix(mix(mix(settings_.seed ^ stream) + i) + j) >> 11) * 0x1.0p-53;
+    }
+
+    bool isCandidate(size_t i, size_t j) const
+    {
+        return (i > j ? i - j : j - i) <= settings_.bandwidth;
+    }
+
+    bool isBlockOccupied(size_t bi, size_t bj) const
+    {
+        return settings_.blockOccupation >= 1.0 or uniform(bi, bj, 1) < settings_.blockOccupation;
+    }
+
+    TileParameter getTileParameter(size_t i, size_t j) const
+    {
+        const size_t nbTileColumns = (settings_.nbColumns + settings_.tileSize - 1) / settings_.tileSize;
+        const size_t tile = (i / settings_.tileSize) * nbTileColumns + j / settings_.tileSize;
+
+        // Magnitudes between the threshold and the precision limit of float, and above
+        const double floatLimit = settings_.threshold / std::numeric_limits<float>::epsilon();
+        const double single = std::sqrt(settings_.threshold * floatLimit);
+        const double high = 10.0 * floatLimit;
+
+        switch (settings_.tileClasses[tile % settings_.tileClasses.size()]) {
+            case TileClass::Zero: return {0.0, 0.0, 0.0, 0.0};
+            case TileClass::SparseSingle: return {settings_.sparseOccupation, single, 0.0, 0.0};
+            case TileClass::DenseSingle: return {1.0, single, 0.0, 0.0};
+            case TileClass::BlockSparseDouble: return {settings_.clusterOccupation, high, 0.0, 0.0, true};
+            case TileClass::SparseDouble: return {settings_.sparseOccupation, high, 0.0, 0.0};
+            case TileClass::DenseMixed: return {1.0, single, high, settings_.sparseOccupation};
+            case TileClass::DenseDouble: return {1.0, high, 0.0, 0.0};
+        }
+        return {0.0, 0.0, 0.0, 0.0};
+    }
+
+    /// Value of a candidate element, zero if not drawn
+    double getValue(size_t i, size_t j) const
+    {
+        double occupation = settings_.occupation;
+        double magnitude = settings_.magnitude * std::exp(-settings_.decay * static_cast<double>(i > j ? i - j : j - i));
+
+        if (!settings_.tileClasses.empty()) {
+            auto tile = getTileParameter(i, j);
+            if (tile.clustered and uniform(i / clusterSize, j / clusterSize, 5) >= tile.occupation) return 0.0;
+            occupation = tile.clustered ? 1.0 : tile.occupation;
+            magnitude = uniform(i, j, 3) < tile.outlierFraction ? tile.outlierMagnitude : tile.magnitude;
+        } else if (magnitude < settings_.cutoff) {
+            return 0.0;
+        }
+
+        if (occupation < 1.0 and uniform(i, j, 2) >= occupation) return 0.0;
+
+        double u = uniform(i, j, 4);
+        return (u < 0.5 ? -1.0 : 1.0) * magnitude * (0.5 + 2.0 * std::abs(u - 0.5));
+    }
+
+    template <class P>
+    size_t getNbOuter() const
+    {
+        return std::is_same<typename P::orientation, ColumnMajor>::value ? settings_.nbColumns : settings_.nbRows;
+    }
+
+    /// Call visit(inner, value) for the nonzero elements of the outer line in increasing order
+    template <class P, class Visit>
+    void forEachElement(size_t outer, Visit const& visit) const
+    {
+        const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+        const size_t nbInner = columnMajor ? settings_.nbRows : settings_.nbColumns;
+        const size_t blockSize = settings_.blockSize;
+
+        // The band limits the candidates of the line
+        const size_t begin = outer > settings_.bandwidth ? outer - settings_.bandwidth : 0;
+        const size_t end = settings_.bandwidth < nbInner ? std::min(nbInner, outer + settings_.bandwidth + 1) : nbInner;
+
+        for (size_t blockBegin = begin; blockBegin < end; ) {
+            const size_t blockEnd = std::min(end, (blockBegin / blockSize + 1) * blockSize);
+            const size_t bOuter = outer / blockSize, bInner = blockBegin / blockSize;
+            if (columnMajor ? isBlockOccupied(bInner, bOuter) : isBlockOccupied(bOuter, bInner)) {
+                for (size_t inner = blockBegin; inner != blockEnd; ++inner) {
+                    double value = columnMajor ? getValue(inner, outer) : getValue(outer, inner);
+                    if (value != 0.0) visit(inner, value);
+                }
+            }
+            blockBegin = blockEnd;
+        }
+    }
+
+    /// Offsets of the lines by a counting pass
+    template <class P>
+    std::vector<typename P::IndexType> countElements() const
+    {
+        const size_t nbOuter = getNbOuter<P>();
+        std::vector<typename P::IndexType> offsets(nbOuter + 1, 0);
+        scheduler_.run(nbOuter, [&](size_t outer) {
+            typename P::IndexType count = 0;
+            forEachElement<P>(outer, [&](size_t, double){ ++count; });
+            offsets[outer + 1] = count;
+        });
+        for (size_t outer = 0; outer != nbOuter; ++outer) offsets[outer + 1] += offsets[outer];
+        return offsets;
+    }
+
+    /// Write the values and keys of all lines at the given offsets
+    template <class P, class T, class IndexType>
+    void fillLines(T* values, IndexType* keys, std::vector<IndexType> const& offsets) const
+    {
+        scheduler_.run(offsets.size() - 1, [&](size_t outer) {
+            IndexType position = offsets[outer];
+            forEachElement<P>(outer, [&](size_t inner, double value) {
+                values[position] = static_cast<T>(value);
+                keys[position++] = inner;
+            });
+        });
+    }
+
+    MatrixGeneratorSettings settings_;
+
+    WorkStealingScheduler scheduler_;
+
+};
+
+} // namespace BlasBooster
@@ -0,0 +1,326 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "SparseMatrix.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Banner and size line of a Matrix Market file in coordinate format
+struct MatrixMarketHeader
+{
+    enum class Field { Real, Integer, Pattern };
+    enum class Symmetry { General, Symmetric, SkewSymmetric };
+
+    Field field = Field::Real;
+    Symmetry symmetry = Symmetry::General;
+    size_t nbRows = 0;
+    size_t nbColumns = 0;
+    /// Number of entry lines, symmetric files store only one triangle
+    size_t nbEntries = 0;
+
+    /// Parse the header at the beginning of text and return the position of the first entry line
+    static std::pair<MatrixMarketHeader, size_t> parse(std::string_view text)
+    {
+        MatrixMarketHeader header;
+        size_t position = 0;
+
+        auto nextLine = [&]() {
+            size_t end = text.find('\n', position);
+            std::string_view line = text.substr(position, end == std::string_view::npos ? std::string_view::npos : end - position);
+            position = end == std::string_view::npos ? text.size() : end + 1;
+            return line;
+        };
+
+        auto toLower = [](std::string_view word) {
+            std::string result(word);
+            for (auto& c : result) c = std::tolower(static_cast<unsigned char>(c));
+            return result;
+        };
+
+        std::vector<std::string> banner;
+        std::string_view line = nextLine();
+        for (size_t begin = 0; begin < line.size();) {
+            size_t end = std::min(line.find_first_of(" \t\r", begin), line.size());
+            if (end != begin) banner.push_back(toLower(line.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+
+        if (banner.size() != 5 or banner[0] != "%%matrixmarket" or banner[1] != "matrix")
+            throw std::runtime_error("MatrixMarket: invalid banner.");
+        if (banner[2] != "coordinate")
+            throw std::runtime_error("MatrixMarket: only the coordinate format is supported.");
+
+        if (banner[3] == "real") header.field = Field::Real;
+        else if (banner[3] == "integer") header.field = Field::Integer;
+        else if (banner[3] == "pattern") header.field = Field::Pattern;
+        else throw std::runtime_error("MatrixMarket: field " + banner[3] + " is not supported.");
+
+        if (banner[4] == "general") header.symmetry = Symmetry::General;
+        else if (banner[4] == "symmetric") header.symmetry = Symmetry::Symmetric;
+        else if (banner[4] == "skew-symmetric") header.symmetry = Symmetry::SkewSymmetric;
+        else throw std::runtime_error("MatrixMarket: symmetry " + banner[4] + " is not supported.");
+
+        do {
+            if (position == text.size()) throw std::runtime_error("MatrixMarket: size line is missing.");
+            line = nextLine();
+        } while (line.empty() or line[0] == '%' or line.find_first_not_of(" \t\r") == std::string_view::npos);
+
+        char const* cur = line.data();
+        char const* end = line.data() + line.size();
+        if (!parseNumber(cur, end, header.nbRows) or !parseNumber(cur, end, header.nbColumns) or !parseNumber(cur, end, header.nbEntries))
+            throw std::runtime_error("MatrixMarket: invalid size line.");
+
+        return {header, position};
+    }
+
+    /// Skip blanks and parse a number, cur is set behind the number
+    template <class U>
+    static bool parseNumber(char const*& cur, char const* end, U& value)
+    {
+        while (cur != end and (*cur == ' ' or *cur == '\t')) ++cur;
+        auto result = std::from_chars(cur, end, value);
+        cur = result.ptr;
+        return result.ec == std::errc();
+    }
+};
+
+/**
+ * \brief Parallel reader of Matrix Market files into CSR or CSC storage.
+ *
+ * The file is mapped and split into chunks at line boundaries. A counting pass
+ * determines the number of entries per row (CSR) or column (CSC), so that the
+ * value and key arrays are allocated once with their final size and the second
+ * pass writes each entry directly to its position. Finally, the keys of each
+ * row or column are sorted. No triplet copy of the matrix is created.
+ */
+template <class X>
+struct MatrixMarketReader;
+
+template <class T, class P>
+struct MatrixMarketReader<Matrix<Sparse,T,P>>
+{
+    typedef Matrix<Sparse,T,P> matrix_type;
+    typedef typename P::IndexType IndexType;
+
+    static const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+
+    /// Size of the chunks parsed by one task
+    static constexpr size_t chunkSize = size_t(1) << 22;
+
+    static matrix_type read(std::string const& filename, WorkStealingScheduler const& scheduler)
+    {
+        MappedFile file(filename);
+        file.advise(MADV_SEQUENTIAL);
+        std::string_view text(file.getData(), file.getSize());
+
+        auto [header, bodyBegin] = MatrixMarketHeader::parse(text);
+        const bool symmetric = header.symmetry != MatrixMarketHeader::Symmetry::General;
+        if (symmetric and header.nbRows != header.nbColumns)
+            throw std::runtime_error("MatrixMarket: symmetric matrix must be square.");
+
+        // Chunk boundaries are moved to the beginning of the next line
+        const size_t nbChunks = std::max(size_t(1), (text.size() - bodyBegin) / chunkSize);
+        std::vector<size_t> chunkBegin(nbChunks + 1, text.size());
+        chunkBegin[0] = bodyBegin;
+        for (size_t chunk = 1; chunk != nbChunks; ++chunk) {
+            size_t newline = text.find('\n', bodyBegin + chunk * (text.size() - bodyBegin) / nbChunks);
+            chunkBegin[chunk] = std::max(chunkBegin[chunk - 1], newline == std::string_view::npos ? text.size() : newline + 1);
+        }
+
+        const size_t nbOuter = columnMajor ? header.nbColumns : header.nbRows;
+
+        // Counting pass, the counts are converted to offsets afterwards
+        std::vector<IndexType> offsets(nbOuter + 1, 0);
+        std::vector<size_t> nbEntries(nbChunks, 0);
+        scheduler.run(nbChunks, [&](size_t chunk) {
+            nbEntries[chunk] = parseChunk(text, chunkBegin[chunk], chunkBegin[chunk + 1], header,
+                [&](size_t outer, size_t, T) { std::atomic_ref<IndexType>(offsets[outer + 1]).fetch_add(1, std::memory_order_relaxed); });
+        });
+
+        size_t nbLines = 0;
+        for (auto n : nbEntries) nbLines += n;
+        if (nbLines != header.nbEntries)
+            throw std::runtime_error("MatrixMarket: " + std::to_string(nbLines) + " entries found, "
+                + std::to_string(header.nbEntries) + " expected.");
+
+        for (size_t outer = 0; outer != nbOuter; ++outer) offsets[outer + 1] += offsets[outer];
+        const size_t nnz = offsets[nbOuter];
+
+        return matrix_type(header.nbRows, header.nbColumns, nnz, [&](matrix_type& matrix)
+        {
+            T* value = matrix.begin().base();
+            IndexType* key = matrix.beginKey().base();
+            std::copy(offsets.begin(), offsets.end(), matrix.beginOffset());
+
+            // Filling pass, each entry is written to the next free position of its row or column
+            std::vector<IndexType>& cursor = offsets;
+            scheduler.run(nbChunks, [&](size_t chunk) {
+                parseChunk(text, chunkBegin[chunk], chunkBegin[chunk + 1], header, [&](size_t outer, size_t inner, T x) {
+                    IndexType position = std::atomic_ref<IndexType>(cursor[outer]).fetch_add(1, std::memory_order_relaxed);
+                    value[position] = x;
+                    key[position] = inner;
+                });
+            });
+
+            // The order within a row or column depends on the thread timing
+            IndexType const* offset = matrix.beginOffset().base();
+            const size_t nbTasks = std::min(nbOuter, scheduler.getNbThreads() * 8);
+            scheduler.run(nbTasks, [&](size_t task) {
+                std::vector<std::pair<IndexType,T>> entries;
+                for (size_t outer = nbOuter * task / nbTasks; outer != nbOuter * (task + 1) / nbTasks; ++outer) {
+                    if (std::is_sorted(key + offset[outer], key + offset[outer + 1])) continue;
+                    entries.clear();
+                    for (size_t e = offset[outer]; e != offset[outer + 1]; ++e) entries.emplace_back(key[e], value[e]);
+                    std::sort(entries.begin(), entries.end(), [](auto const& a, auto const& b){ return a.first < b.first; });
+                    for (size_t e = offset[outer], i = 0; e != offset[outer + 1]; ++e, ++i) {
+                        key[e] = entries[i].first;
+                        value[e] = entries[i].second;
+                    }
+                }
+            });
+        });
+    }
+
+private:
+
+    /// Call add(outer, inner, value) for all entries of the lines starting in [begin, end), returns the number of lines
+    template <class Add>
+    static size_t parseChunk(std::string_view text, size_t begin, size_t end, MatrixMarketHeader const& header, Add const& add)
+    {
+        const bool pattern = header.field == MatrixMarketHeader::Field::Pattern;
+        const bool symmetric = header.symmetry != MatrixMarketHeader::Symmetry::General;
+        const bool skew = header.symmetry == MatrixMarketHeader::Symmetry::SkewSymmetric;
+
+        size_t nbLines = 0;
+        char const* cur = text.data() + begin;
+        char const* chunkEnd = text.data() + end;
+        char const* textEnd = text.data() + text.size();
+
+        while (cur < chunkEnd) {
+            char const* lineEnd = static_cast<char const*>(std::memchr(cur, '\n', textEnd - cur));
+            if (!lineEnd) lineEnd = textEnd;
+
+            char const* first = cur;
+            while (first != lineEnd and (*first == ' ' or *first == '\t' or *first == '\r')) ++first;
+            if (first != lineEnd and *first != '%') {
+                size_t row, column;
+                double x = 1.0;
+                if (!MatrixMarketHeader::parseNumber(cur, lineEnd, row) or !MatrixMarketHeader::parseNumber(cur, lineEnd, column)
+                    or (!pattern and !MatrixMarketHeader::parseNumber(cur, lineEnd, x)))
+                    throw std::runtime_error("MatrixMarket: invalid entry '" + std::string(first, lineEnd) + "'.");
+                if (row == 0 or row > header.nbRows or column == 0 or column > header.nbColumns)
+                    throw std::runtime_error("MatrixMarket: index out of range in '" + std::string(first, lineEnd) + "'.");
+                --row;
+                --column;
+
+                add(columnMajor ? column : row, columnMajor ? row : column, static_cast<T>(x));
+                if (symmetric and row != column)
+                    add(columnMajor ? row : column, columnMajor ? column : row, static_cast<T>(skew ? -x : x));
+                ++nbLines;
+            }
+            cur = lineEnd + 1;
+        }
+        return nbLines;
+    }
+};
+
+/// Read a Matrix Market file in coordinate format into a sparse matrix
+template <class X>
+X readMatrixMarket(std::string const& filename, WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+{
+    return MatrixMarketReader<X>::read(filename, scheduler);
+}
+
+/**
+ * \brief Write a sparse matrix as Matrix Market file in coordinate real general format.
+ *
+ * Groups of rows or columns are formatted in parallel and written in order,
+ * so that only one group per thread is held in memory. With symmetric only the
+ * lower triangle is written, the symmetry of the matrix is not checked.
+ */
+template <class T, class P>
+void writeMatrixMarket(Matrix<Sparse,T,P> const& matrix, std::string const& filename, bool symmetric = false,
+    WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+{
+    typedef typename P::IndexType IndexType;
+    const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+
+    if (symmetric and matrix.getNbRows() != matrix.getNbColumns())
+        throw std::runtime_error("writeMatrixMarket: symmetric matrix must be square.");
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) throw std::runtime_error("writeMatrixMarket: can not open " + filename + ".");
+
+    T const* value = matrix.begin().base();
+    IndexType const* key = matrix.beginKey().base();
+    IndexType const* offset = matrix.beginOffset().base();
+    const size_t nbOuter = matrix.getMinorDimension();
+
+    auto isWritten = [&](size_t outer, size_t e) { return !symmetric or (columnMajor ? key[e] >= outer : key[e] <= outer); };
+
+    size_t nbEntries = matrix.nnz();
+    if (symmetric) {
+        nbEntries = 0;
+        for (size_t outer = 0; outer != nbOuter; ++outer)
+            for (size_t e = offset[outer]; e != offset[outer + 1]; ++e) nbEntries += isWritten(outer, e);
+    }
+
+    out << "%%MatrixMarket matrix coordinate real " << (symmetric ? "symmetric" : "general") << "\n"
+        << matrix.getNbRows() << " " << matrix.getNbColumns() << " " << nbEntries << "\n";
+
+    // Groups of about 64k entries, at least one row or column
+    std::vector<size_t> groupBegin{0};
+    for (size_t outer = 0; outer != nbOuter; ++outer)
+        if (offset[outer + 1] - offset[groupBegin.back()] >= (size_t(1) << 16) or outer + 1 == nbOuter) groupBegin.push_back(outer + 1);
+
+    const size_t nbGroups = groupBegin.size() - 1;
+    const size_t batchSize = scheduler.getNbThreads() * 2;
+    std::vector<std::string> buffers(batchSize);
+
+    for (size_t batch = 0; batch < nbGroups; batch += batchSize) {
+        const size_t nbTasks = std::min(batchSize, nbGroups - batch);
+        scheduler.run(nbTasks, [&](size_t task) {
+            std::string& buffer = buffers[task];
+            buffer.clear();
+            char line[128];
+            // One byte behind the bound of to_chars is reserved for the separator
+            char* const end = line + sizeof(line) - 1;
+            auto write = [&](char* cur, auto x, char separator) {
+                auto [ptr, ec] = std::to_chars(cur, end, x);
+                if (ec != std::errc()) throw std::runtime_error("writeMatrixMarket: line of " + filename + " is too long.");
+                *ptr = separator;
+                return ptr + 1;
+            };
+            for (size_t outer = groupBegin[batch + task]; outer != groupBegin[batch + task + 1]; ++outer) {
+                for (size_t e = offset[outer]; e != offset[outer + 1]; ++e) {
+                    if (!isWritten(outer, e)) continue;
+                    size_t row = columnMajor ? key[e] : outer;
+                    size_t column = columnMajor ? outer : key[e];
+                    char* cur = write(line, row + 1, ' ');
+                    cur = write(cur, column + 1, ' ');
+                    cur = write(cur, value[e], '\n');
+                    buffer.append(line, cur);
+                }
+            }
+        });
+        for (size_t task = 0; task != nbTasks; ++task) out.write(buffers[task].data(), buffers[task].size());
+    }
+
+    if (!out) throw std::runtime_error("writeMatrixMarket: writing " + filename + " failed.");
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "EmptyTypes.h"
+#include "Matrix.h"
+#include "MultiplicationFunctor.h"
+#include <type_traits>
+
+namespace BlasBooster {
+
+/// Default result type of a matrix multiplication
+template <class X1, class X2>
+struct MultiplicationResult
+{
+    typedef Matrix<
+        Dense,
+        typename std::common_type<typename X1::value_type, typename X2::value_type>::type,
+        Parameter<typename X1::IndexType, typename X1::parameter::orientation>
+    > type;
+};
+
+/**
+ * \brief Expression template for the matrix multiplication.
+ *
+ * The multiplication will be executed by the assignment to the result matrix,
+ * so that the result can be written directly into its final storage.
+ */
+template <class X1, class X2>
+struct MatrixMultExp
+{
+    typedef typename MultiplicationResult<X1,X2>::type result_type;
+
+    MatrixMultExp(X1 const& op1, X2 const& op2)
+     : op1_(op1), op2_(op2)
+    {}
+
+    size_t getNbRows() const { return op1_.getNbRows(); }
+    size_t getNbColumns() const { return op2_.getNbColumns(); }
+
+    /// Execute multiplication into an existing result matrix
+    template <class Interface, class X3>
+    void execute(X3& result) const
+    {
+        MultiplicationFunctor<
+            typename X1::matrix_type, typename X1::value_type, typename X1::parameter,
+            typename X2::matrix_type, typename X2::value_type, typename X2::parameter,
+            typename X3::matrix_type, typename X3::value_type, typename X3::parameter,
+            Interface
+        >()(op1_, op2_, result);
+    }
+
+    /// Execute multiplication into a new matrix of the default result type
+    template <class Interface>
+    result_type execute() const
+    {
+        result_type result(getNbRows(), getNbColumns());
+        execute<Interface>(result);
+        return result;
+    }
+
+private:
+
+    X1 const& op1_;
+    X2 const& op2_;
+
+};
+
+template <class M1, class T1, class P1, class M2, class T2, class P2>
+MatrixMultExp<Matrix<M1,T1,P1>, Matrix<M2,T2,P2>>
+operator * (Matrix<M1,T1,P1> const& A, Matrix<M2,T2,P2> const& B)
+{
+    return MatrixMultExp<Matrix<M1,T1,P1>, Matrix<M2,T2,P2>>(A, B);
+}
+
+} // namespace BlasBooster
@@ -1,5 +1,15 @@
 #pragma once
 
+#include "Arena.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+#include <type_traits>
+#include <vector>
+
 namespace BlasBooster {
 
 template <typename T>
@@ -14,4 +24,214 @@ void deallocate(T* memory) noexcept
     delete [] memory;
 }
 
+/**
+ * \brief Allocator policies of the heap storage, selected by the Parameter of a matrix.
+ *
+ * A policy provides allocate<T>(size) and deallocate<T>(memory, size).
+ * Types which are not trivially default constructible, e.g. DynamicMatrix,
+ * are always constructed.
+ */
+struct DefaultAllocator
+{
+    template <typename T>
+    static T* allocate(size_t size) { return BlasBooster::allocate<T>(size); }
+
+    template <typename T>
+    static void deallocate(T* memory, size_t) noexcept { BlasBooster::deallocate<T>(memory); }
+};
+
+/// Memory aligned to Alignment bytes, elements are zero-initialized if Initialize is true
+template <size_t Alignment = 64, bool Initialize = true>
+struct AlignedAllocator
+{
+    static_assert(Alignment and (Alignment & (Alignment - 1)) == 0, "AlignedAllocator: alignment must be a power of two.");
+
+    static constexpr size_t alignment = Alignment;
+
+    static constexpr bool zeroInitialized = Initialize;
+
+    template <typename T>
+    static T* allocate(size_t size)
+    {
+        if (size == 0) return nullptr;
+        T* memory = static_cast<T*>(::operator new(getBytes<T>(size), std::align_val_t(Alignment)));
+        construct(memory, size);
+        return memory;
+    }
+
+    template <typename T>
+    static void deallocate(T* memory, size_t size) noexcept
+    {
+        if (!memory) return;
+        std::destroy_n(memory, size);
+        ::operator delete(memory, std::align_val_t(Alignment));
+    }
+
+private:
+
+    /// Size rounded up to a multiple of the alignment
+    template <typename T>
+    static size_t getBytes(size_t size) { return (size * sizeof(T) + Alignment - 1) / Alignment * Alignment; }
+
+    template <typename T>
+    static void construct(T* memory, size_t size)
+    {
+        if constexpr (!std::is_trivially_default_constructible<T>::value) std::uninitialized_default_construct_n(memory, size);
+        else if constexpr (Initialize) std::uninitialized_value_construct_n(memory, size);
+    }
+};
+
+/// Cache line aligned memory without initialization, e.g. for matrices which are completely overwritten
+typedef AlignedAllocator<64, false> UninitializedAllocator;
+
+/**
+ * \brief Memory with transparent huge pages for large allocations.
+ *
+ * Allocations of at least one huge page are aligned to 2 MB and marked by
+ * madvise(MADV_HUGEPAGE), so that the TLB misses of large matrices are reduced.
+ * Smaller allocations are cache line aligned. The elements are not initialized,
+ * so that the pages are placed by the first touch of the user.
+ */
+struct HugePageAllocator
+{
+    static constexpr size_t hugePageSize = size_t(2) << 20;
+
+    typedef AlignedAllocator<hugePageSize, false> LargeAllocator;
+    typedef AlignedAllocator<64, false> SmallAllocator;
+
+    template <typename T>
+    static bool isLarge(size_t size) { return size * sizeof(T) >= hugePageSize; }
+
+    template <typename T>
+    static T* allocate(size_t size)
+    {
+        if (!isLarge<T>(size)) return SmallAllocator::allocate<T>(size);
+        T* memory = LargeAllocator::allocate<T>(size);
+#ifdef MADV_HUGEPAGE
+        // Only a hint, the memory is also valid without huge pages
+        madvise(memory, (size * sizeof(T) + hugePageSize - 1) / hugePageSize * hugePageSize, MADV_HUGEPAGE);
+#endif
+        return memory;
+    }
+
+    template <typename T>
+    static void deallocate(T* memory, size_t size) noexcept
+    {
+        if (isLarge<T>(size)) LargeAllocator::deallocate<T>(memory, size);
+        else SmallAllocator::deallocate<T>(memory, size);
+    }
+};
+
+/**
+ * \brief Placement of the pages of large heap storages on NUMA systems.
+ *
+ * Linux places a page on the NUMA node of the thread which touches it first.
+ * None: all pages are touched by the calling thread.
+ * Interleaved: the pages are touched round-robin by all workers, so that the
+ * bandwidth of all nodes is used independent of the access pattern.
+ * Blocked: the pages are split into one contiguous chunk per worker, each chunk
+ * is touched by its owner in the partition of the scheduler (see firstTouch).
+ */
+enum class NumaPlacement { None, Interleaved, Blocked };
+
+/// Storages smaller than 4 MB are touched by the calling thread
+constexpr size_t numaMinBytes = size_t(4) << 20;
+
+constexpr size_t pageSize = 4096;
+
+/**
+ * \brief Call touch(begin, size) for all chunks of [data, data + size) in the workers given by placement.
+ *
+ * The chunks are touched by runOnEachWorker of the scheduler without stealing.
+ * With Blocked placement chunk c of getNbThreads() equal chunks is touched by
+ * the owner of task c in getPartition of getNbThreads() equal tasks. The pages
+ * are only local to the computation, if the caller runs it on a pinned scheduler
+ * with the same number of threads as getNbThreads() tasks of equal cost, task c
+ * processing chunk c, e.g. the column panels of a matrix. Steals still move some
+ * chunks to other nodes.
+ *
+ * NumaAllocator touches with the default pinned scheduler, but multiplyBlocked,
+ * MatrixConverter and boostedGemm use their own schedulers, unpinned by default,
+ * and partition their blocks by cost. For them Blocked placement only spreads
+ * contiguous chunks over the nodes, like Interleaved with coarser granularity.
+ */
+template <class T, class Touch>
+void firstTouch(T* data, size_t size, NumaPlacement placement, Touch const& touch,
+    WorkStealingScheduler const& scheduler = WorkStealingScheduler(0, true))
+{
+    const size_t nbWorkers = scheduler.getNbThreads();
+    if (placement == NumaPlacement::None or nbWorkers == 1 or size * sizeof(T) < numaMinBytes) {
+        touch(data, size);
+        return;
+    }
+
+    const size_t pageElements = std::max(size_t(1), pageSize / sizeof(T));
+    const size_t nbPages = (size + pageElements - 1) / pageElements;
+    const std::vector<size_t> owner = scheduler.getPartition(nbWorkers, [](size_t){ return 1.0; });
+
+    scheduler.runOnEachWorker([&](size_t id)
+    {
+        if (placement == NumaPlacement::Blocked) {
+            // Chunk boundaries are aligned to pages, so that each page is touched by exactly one worker
+            for (size_t chunk = 0; chunk != nbWorkers; ++chunk) {
+                if (owner[chunk] != id) continue;
+                size_t begin = std::min(size, nbPages * chunk / nbWorkers * pageElements);
+                size_t end = std::min(size, nbPages * (chunk + 1) / nbWorkers * pageElements);
+                if (begin != end) touch(data + begin, end - begin);
+            }
+        } else {
+            for (size_t page = id; page < nbPages; page += nbWorkers) {
+                size_t begin = page * pageElements;
+                touch(data + begin, std::min(pageElements, size - begin));
+            }
+        }
+    });
+}
+
+/// Placement of an allocator policy, policies without placement member are not NUMA-aware
+template <class Allocator>
+constexpr NumaPlacement getNumaPlacement()
+{
+    if constexpr (requires { Allocator::placement; }) return Allocator::placement;
+    else return NumaPlacement::None;
+}
+
+/// True if the allocator policy writes zeros into new memory of trivially default constructible types
+template <class Allocator>
+constexpr bool isZeroInitialized()
+{
+    if constexpr (requires { Allocator::zeroInitialized; }) return Allocator::zeroInitialized;
+    else return false;
+}
+
+/**
+ * \brief Memory placed on the NUMA nodes by a parallel first touch.
+ *
+ * The memory of BaseAllocator must not be initialized, because the first touch
+ * is the zero-initialization in the threads given by Placement.
+ * Types which are not trivially default constructible are constructed by BaseAllocator.
+ */
+template <NumaPlacement Placement, class BaseAllocator = AlignedAllocator<pageSize, false>>
+struct NumaAllocator
+{
+    static constexpr NumaPlacement placement = Placement;
+
+    static constexpr bool zeroInitialized = true;
+
+    template <typename T>
+    static T* allocate(size_t size)
+    {
+        T* memory = BaseAllocator::template allocate<T>(size);
+        if constexpr (std::is_trivially_default_constructible<T>::value)
+            firstTouch(memory, size, Placement, [](T* begin, size_t n){ std::fill_n(begin, n, T()); });
+        return memory;
+    }
+
+    template <typename T>
+    static void deallocate(T* memory, size_t size) noexcept
+    {
+        BaseAllocator::template deallocate<T>(memory, size);
+    }
+};
+
 } // namespce BlasBooster
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "DynamicMatrixTypeList.h"
+#include "EmptyTypes.h"
+#include "MatrixBase.h"
+#include "SparseMatrix.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace BlasBooster {
+
+/**
+ * \brief Construction of one part of a MultipleMatrix from a region of a dense matrix.
+ *
+ * Only the elements x with isPart(|x|) are stored, all others are zero.
+ */
+template <class X>
+struct MultiplePart;
+
+template <class T2, class P>
+struct MultiplePart<Matrix<Dense,T2,P>>
+{
+    template <class T, class Predicate>
+    static Matrix<Dense,T2,P> create(T const* data, size_t rs, size_t cs, size_t m, size_t n, Predicate const& isPart)
+    {
+        Matrix<Dense,T2,P> part(m, n);
+        for (size_t j = 0; j != n; ++j) {
+            for (size_t i = 0; i != m; ++i) {
+                T value = data[i * rs + j * cs];
+                part(i, j) = isPart(std::abs(value)) ? static_cast<T2>(value) : T2(0);
+            }
+        }
+        return part;
+    }
+};
+
+template <class T2, class P>
+struct MultiplePart<Matrix<Sparse,T2,P>>
+{
+    template <class T, class Predicate>
+    static Matrix<Sparse,T2,P> create(T const* data, size_t rs, size_t cs, size_t m, size_t n, Predicate const& isPart)
+    {
+        const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+        const size_t nbOuter = columnMajor ? n : m;
+        const size_t nbInner = columnMajor ? m : n;
+        const size_t strideOuter = columnMajor ? cs : rs;
+        const size_t strideInner = columnMajor ? rs : cs;
+
+        size_t nnz = 0;
+        for (size_t outer = 0; outer != nbOuter; ++outer)
+            for (size_t inner = 0; inner != nbInner; ++inner)
+                nnz += isPart(std::abs(data[outer * strideOuter + inner * strideInner]));
+
+        return Matrix<Sparse,T2,P>(m, n, nnz, [&](Matrix<Sparse,T2,P>& part)
+        {
+            auto value = part.begin();
+            auto key = part.beginKey();
+            auto offset = part.beginOffset();
+            typename P::IndexType position(0);
+
+            for (size_t outer = 0; outer != nbOuter; ++outer) {
+                *offset++ = position;
+                for (size_t inner = 0; inner != nbInner; ++inner) {
+                    T x = data[outer * strideOuter + inner * strideInner];
+                    if (isPart(std::abs(x))) {
+                        *value++ = static_cast<T2>(x);
+                        *key++ = inner;
+                        ++position;
+                    }
+                }
+            }
+            *offset = position;
+        });
+    }
+};
+
+/**
+ * \brief Matrix stored as sum of two matrices of different type and precision.
+ *
+ * The first part stores the few large elements, which need double precision,
+ * as sparse matrix and the second part the bulk of the small elements in single
+ * precision as dense or sparse matrix, e.g.
+ * MultipleMatrix<Matrix<Sparse,double>, Matrix<Dense,float>>. Each element is
+ * stored in exactly one part, so that the bulk needs only half of the memory
+ * bandwidth of a double precision matrix.
+ */
+template <class X1, class X2>
+struct MultipleMatrix : public MatrixBase
+{
+public: // typedefs
+
+    typedef MultipleMatrix<X1,X2> self;
+    typedef Multiple matrix_type;
+    typedef X1 first_type;
+    typedef X2 second_type;
+
+    static_assert(std::is_same<typename X1::matrix_type, Sparse>::value, "MultipleMatrix: first part must be sparse.");
+
+public: // member functions
+
+    MultipleMatrix() = default;
+
+    /// Composition of two parts of the same dimension
+    MultipleMatrix(X1&& first, X2&& second)
+     : first_(std::move(first)), second_(std::move(second))
+    {
+        if (first_.getNbRows() != second_.getNbRows() or first_.getNbColumns() != second_.getNbColumns())
+            throw std::runtime_error("MultipleMatrix: dimension mismatch of the parts.");
+    }
+
+    /**
+     * Split of a m x n matrix with arbitrary strides.
+     * Elements with |x| > outlierThreshold are stored in the first part,
+     * elements with threshold < |x| <= outlierThreshold in the second part.
+     */
+    template <class T>
+    MultipleMatrix(T const* data, size_t rs, size_t cs, size_t m, size_t n, double outlierThreshold, double threshold = 0.0)
+     : first_(MultiplePart<X1>::create(data, rs, cs, m, n,
+           [=](double absValue){ return absValue > outlierThreshold; })),
+       second_(MultiplePart<X2>::create(data, rs, cs, m, n,
+           [=](double absValue){ return absValue > threshold and absValue <= outlierThreshold; }))
+    {}
+
+    /// Split of a dense matrix
+    template <class T, class P>
+    MultipleMatrix(Matrix<Dense,T,P> const& other, double outlierThreshold, double threshold = 0.0)
+     : MultipleMatrix(other.getDataPointer(), getRowStride(other), getColumnStride(other),
+           other.getNbRows(), other.getNbColumns(), outlierThreshold, threshold)
+    {}
+
+    size_t getNbRows() const { return first_.getNbRows(); }
+    size_t getNbColumns() const { return first_.getNbColumns(); }
+
+    X1 const& getFirst() const { return first_; }
+    X2 const& getSecond() const { return second_; }
+
+    /// Number of stored elements, only if both parts are sparse
+    size_t nnz() const requires std::is_same<typename X2::matrix_type, Sparse>::value
+    {
+        return first_.nnz() + second_.nnz();
+    }
+
+    const std::type_info& getTypeInfo() const { return typeid(*this); }
+
+    size_t getTypeIndex() const { return typeIndex_; }
+
+    /// Sum of the norms of the parts, which is an upper bound by the triangle inequality, if not set by the converter
+    double getNorm() const
+    {
+        if (norm_ < 0.0) norm_ = first_.getNorm() + second_.getNorm();
+        return norm_;
+    }
+
+    void setNorm(double norm) const { norm_ = norm; }
+
+    static constexpr size_t typeIndex_ = GetIndex<self, DynamicMatrixTypeList>::value;
+
+    static const std::string name() { return "MultipleMatrix<" + X1::name() + "," + X2::name() + ">"; }
+
+private:
+
+    X1 first_;
+
+    X2 second_;
+
+    mutable double norm_ = -1.0;
+
+};
+
+template <class X>
+struct IsMultipleMatrix : std::false_type
+{};
+
+template <class X1, class X2>
+struct IsMultipleMatrix<MultipleMatrix<X1,X2>> : std::true_type
+{};
+
+} // namespace BlasBooster
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "GemmKernel.h"
+#include "MultipleMatrix.h"
+#include "MultiplicationFunctor.h"
+#include "SparseMultiplication.h"
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/**
+ * \brief Fused multiplication C += A x B of a MultipleMatrix with sparse outliers and dense bulk.
+ *
+ * C is processed in panels of columns by GemmKernel::gemmPanels, which packs
+ * the left operand only once. For each panel the bulk product is computed in
+ * the common type of the bulk and the dense operand, and the outliers are added
+ * directly afterwards, while the panel of C is still in cache. Therefore, C is
+ * passed only once through the memory instead of once per part. CSR outliers
+ * of a right-hand MultipleMatrix are bucketed by panel in advance, so that each
+ * panel only visits its own outliers.
+ */
+struct MultipleMultiplication
+{
+    /// Number of columns of C per panel, 256 x 64 doubles of C fit into the L2 cache
+    static constexpr size_t panelWidth = 64;
+
+    /// MultipleMatrix x Dense
+    template <class T1, class P1, class T2, class P2, class TB, class PB, class T3, class P3>
+    void operator () (MultipleMatrix<Matrix<Sparse,T1,P1>, Matrix<Dense,T2,P2>> const& A,
+        Matrix<Dense,TB,PB> const& B, Matrix<Dense,T3,P3>& C) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultipleMultiplication<Multiple,Dense>: dimension mismatch.");
+
+        typedef typename std::common_type<T2,TB>::type compute_type;
+
+        auto const& bulk = A.getSecond();
+        SparseView<T1,P1> a(A.getFirst());
+        TB const* b = B.getDataPointer();
+        T3* c = C.getDataPointer();
+        const size_t rsB = getRowStride(B), csB = getColumnStride(B);
+        const size_t rsC = getRowStride(C), csC = getColumnStride(C);
+        const size_t m = A.getNbRows(), n = B.getNbColumns(), k = A.getNbColumns();
+
+        // Each outlier updates a row of every panel
+        GemmKernel<compute_type>::gemmPanels(m, n, k, T3(1),
+            bulk.getDataPointer(), getRowStride(bulk), getColumnStride(bulk),
+            b, rsB, csB, T3(1), c, rsC, csC, panelWidth, [&](size_t j0, size_t j1) {
+            for (size_t outer = 0; outer != a.nbOuter; ++outer) {
+                for (size_t e = a.offset[outer]; e != a.offset[outer + 1]; ++e) {
+                    size_t i = a.columnMajor ? a.key[e] : outer;
+                    size_t l = a.columnMajor ? outer : a.key[e];
+                    T3 value = static_cast<T3>(a.value[e]);
+                    for (size_t j = j0; j != j1; ++j) c[i * rsC + j * csC] += value * b[l * rsB + j * csB];
+                }
+            }
+        });
+    }
+
+    /// Dense x MultipleMatrix
+    template <class TA, class PA, class T1, class P1, class T2, class P2, class T3, class P3>
+    void operator () (Matrix<Dense,TA,PA> const& A,
+        MultipleMatrix<Matrix<Sparse,T1,P1>, Matrix<Dense,T2,P2>> const& B, Matrix<Dense,T3,P3>& C) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultipleMultiplication<Dense,Multiple>: dimension mismatch.");
+
+        typedef typename std::common_type<TA,T2>::type compute_type;
+
+        auto const& bulk = B.getSecond();
+        SparseView<T1,P1> b(B.getFirst());
+        TA const* a = A.getDataPointer();
+        T2 const* bulkData = bulk.getDataPointer();
+        T3* c = C.getDataPointer();
+        const size_t rsA = getRowStride(A), csA = getColumnStride(A);
+        const size_t rsBulk = getRowStride(bulk), csBulk = getColumnStride(bulk);
+        const size_t rsC = getRowStride(C), csC = getColumnStride(C);
+        const size_t m = A.getNbRows(), n = B.getNbColumns(), k = A.getNbColumns();
+
+        auto addOutlier = [&](size_t l, size_t j, size_t e) {
+            T3 value = static_cast<T3>(b.value[e]);
+            for (size_t i = 0; i != m; ++i) c[i * rsC + j * csC] += value * a[i * rsA + l * csA];
+        };
+
+        // CSR: (row, entry) of the outliers sorted by panel, CSC: the columns of the panel are the outer indices
+        const size_t nbPanels = (n + panelWidth - 1) / panelWidth;
+        std::vector<size_t> panelOffset;
+        std::vector<std::pair<size_t, size_t>> panelOutliers;
+        if (!b.columnMajor) {
+            panelOffset.assign(nbPanels + 1, 0);
+            for (size_t e = 0; e != b.offset[b.nbOuter]; ++e) ++panelOffset[b.key[e] / panelWidth + 1];
+            for (size_t p = 0; p != nbPanels; ++p) panelOffset[p + 1] += panelOffset[p];
+            panelOutliers.resize(panelOffset[nbPanels]);
+            std::vector<size_t> cursor(panelOffset.begin(), panelOffset.end() - 1);
+            for (size_t outer = 0; outer != b.nbOuter; ++outer)
+                for (size_t e = b.offset[outer]; e != b.offset[outer + 1]; ++e)
+                    panelOutliers[cursor[b.key[e] / panelWidth]++] = {outer, e};
+        }
+
+        GemmKernel<compute_type>::gemmPanels(m, n, k, T3(1), a, rsA, csA,
+            bulkData, rsBulk, csBulk, T3(1), c, rsC, csC, panelWidth, [&](size_t j0, size_t j1) {
+            if (b.columnMajor) {
+                for (size_t j = j0; j != j1; ++j)
+                    for (size_t e = b.offset[j]; e != b.offset[j + 1]; ++e) addOutlier(b.key[e], j, e);
+            } else {
+                const size_t p = j0 / panelWidth;
+                for (size_t t = panelOffset[p]; t != panelOffset[p + 1]; ++t) {
+                    auto [l, e] = panelOutliers[t];
+                    addOutlier(l, b.key[e], e);
+                }
+            }
+        });
+    }
+};
+
+template <class X>
+struct IsFusedMultipleMatrix : std::false_type
+{};
+
+template <class T1, class P1, class T2, class P2>
+struct IsFusedMultipleMatrix<MultipleMatrix<Matrix<Sparse,T1,P1>, Matrix<Dense,T2,P2>>> : std::true_type
+{};
+
+/**
+ * \brief C += A x B for all matrix types including MultipleMatrix.
+ *
+ * MultipleMatrix with dense bulk and a dense partner uses the fused kernel,
+ * all other MultipleMatrix are expanded into the sum of the products of their parts.
+ */
+template <class XA, class XB, class T3, class P3>
+void multiplyAdd(XA const& A, XB const& B, Matrix<Dense,T3,P3>& C)
+{
+    const bool isDenseA = std::is_same<typename XA::matrix_type, Dense>::value;
+    const bool isDenseB = std::is_same<typename XB::matrix_type, Dense>::value;
+
+    if constexpr (IsFusedMultipleMatrix<XA>::value and isDenseB) {
+        MultipleMultiplication()(A, B, C);
+    } else if constexpr (isDenseA and IsFusedMultipleMatrix<XB>::value) {
+        MultipleMultiplication()(A, B, C);
+    } else if constexpr (IsMultipleMatrix<XA>::value) {
+        multiplyAdd(A.getFirst(), B, C);
+        multiplyAdd(A.getSecond(), B, C);
+    } else if constexpr (IsMultipleMatrix<XB>::value) {
+        multiplyAdd(A, B.getFirst(), C);
+        multiplyAdd(A, B.getSecond(), C);
+    } else {
+        MultiplicationFunctor<typename XA::matrix_type, typename XA::value_type, typename XA::parameter,
+            typename XB::matrix_type, typename XB::value_type, typename XB::parameter, Dense, T3, P3, Native>()(
+            A, B, C, T3(1), T3(1));
+    }
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "EmptyTypes.h"
+#include "GemmKernel.h"
+#include "ZeroMatrix.h"
+#include <stdexcept>
+#include <type_traits>
+
+namespace BlasBooster {
+
+/**
+ * \brief Primary template for the matrix multiplication C = alpha * A * B + beta * C.
+ *
+ * Specialized for each combination of matrix types and each interface (Native, ...).
+ */
+template <class M1, class T1, class P1, class M2, class T2, class P2, class M3, class T3, class P3, class Interface>
+struct MultiplicationFunctor;
+
+/// C = beta * C
+template <class T, class P>
+void scale(Matrix<Dense,T,P>& C, T beta)
+{
+    if (beta == T(1)) return;
+    for (auto& c : C) c = beta == T(0) ? T(0) : beta * c;
+}
+
+/**
+ * \brief Native dense matrix multiplication.
+ *
+ * The computation is done in the common type of T1 and T2 and is accumulated into T3.
+ * The orientation of all three matrices can be chosen independently.
+ */
+template <class T1, class P1, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Dense, T1, P1, Dense, T2, P2, Dense, T3, P3, Native>
+{
+    typedef typename std::common_type<T1,T2>::type compute_type;
+
+    static_assert(std::is_floating_point<compute_type>::value, "Native multiplication only for floating point types.");
+
+    void operator () (Matrix<Dense,T1,P1> const& A, Matrix<Dense,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Dense,Dense,Dense,Native>: dimension mismatch.");
+
+        GemmKernel<compute_type>::gemm(A.getNbRows(), B.getNbColumns(), A.getNbColumns(), alpha,
+            A.getDataPointer(), getRowStride(A), getColumnStride(A),
+            B.getDataPointer(), getRowStride(B), getColumnStride(B),
+            beta, C.getDataPointer(), getRowStride(C), getColumnStride(C));
+    }
+};
+
+/// Multiplication with ZeroMatrix from left side, only C will be scaled
+template <class P1, class M2, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Zero, NullType, P1, M2, T2, P2, Dense, T3, P3, Native>
+{
+    template <class X2>
+    void operator () (Matrix<Zero,NullType,P1> const& A, X2 const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Zero,Any,Dense,Native>: dimension mismatch.");
+        scale(C, beta);
+    }
+};
+
+/// Multiplication with ZeroMatrix from right side, only C will be scaled
+template <class M1, class T1, class P1, class P2, class T3, class P3>
+struct MultiplicationFunctor<M1, T1, P1, Zero, NullType, P2, Dense, T3, P3, Native>
+{
+    template <class X1>
+    void operator () (X1 const& A, Matrix<Zero,NullType,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Any,Zero,Dense,Native>: dimension mismatch.");
+        scale(C, beta);
+    }
+};
+
+/// Multiplication of two ZeroMatrix, only C will be scaled
+template <class P1, class P2, class T3, class P3>
+struct MultiplicationFunctor<Zero, NullType, P1, Zero, NullType, P2, Dense, T3, P3, Native>
+{
+    void operator () (Matrix<Zero,NullType,P1> const& A, Matrix<Zero,NullType,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Zero,Zero,Dense,Native>: dimension mismatch.");
+        scale(C, beta);
+    }
+};
+
+} // namespace BlasBooster
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "DynamicMatrix.h"
+#include "EmptyTypes.h"
+#include "Parameter.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Absolute value of an element, the norm of a block for blocked matrices
+template <class T>
+double getElementNorm(T const& value)
+{
+    if constexpr (std::is_same<T, DynamicMatrix>::value) return value.getNorm();
+    else return std::abs(static_cast<double>(value));
+}
+
+/**
+ * \brief Computation of the norm of a dense or sparse matrix.
+ *
+ * NormOne: maximum absolute column sum
+ * NormTwo: Frobenius norm, an upper bound of the spectral norm
+ * NormMax: maximum absolute value
+ *
+ * For blocked matrices the norms of the blocks are combined like the absolute
+ * values of elements.
+ */
+template <class NormType>
+struct NormFunctor
+{
+    template <class X>
+    double operator () (X const& A) const
+    {
+        std::vector<double> columnSums(std::is_same<NormType, NormOne>::value ? A.getNbColumns() : 0, 0.0);
+        double result = 0.0;
+
+        auto visit = [&](size_t j, double absValue)
+        {
+            if constexpr (std::is_same<NormType, NormOne>::value) columnSums[j] += absValue;
+            else if constexpr (std::is_same<NormType, NormTwo>::value) result += absValue * absValue;
+            else result = std::max(result, absValue);
+        };
+
+        if constexpr (std::is_same<typename X::matrix_type, Sparse>::value) {
+            const bool columnMajor = std::is_same<typename X::orientation, ColumnMajor>::value;
+            auto value = A.begin();
+            auto key = A.beginKey();
+            auto offset = A.beginOffset();
+            for (size_t outer = 0; outer != A.getMinorDimension(); ++outer)
+                for (auto e = offset[outer]; e != offset[outer + 1]; ++e)
+                    visit(columnMajor ? outer : key[e], getElementNorm(value[e]));
+        } else if constexpr (requires { A.getTileSize(); }) {
+            A.forEachElement([&](size_t, size_t j, auto const& value){ visit(j, getElementNorm(value)); });
+        } else {
+            for (size_t j = 0; j != A.getNbColumns(); ++j)
+                for (size_t i = 0; i != A.getNbRows(); ++i) visit(j, getElementNorm(A(i, j)));
+        }
+
+        if constexpr (std::is_same<NormType, NormOne>::value) {
+            for (auto columnSum : columnSums) result = std::max(result, columnSum);
+        } else if constexpr (std::is_same<NormType, NormTwo>::value) {
+            result = std::sqrt(result);
+        }
+        return result;
+    }
+};
+
+/**
+ * \brief Mixin providing the norm of a matrix, which is cached after the first call.
+ *
+ * The cache is reset by the assignment of a value and by resize. After the
+ * modification of elements by the element access or the iterators,
+ * invalidateNorm() must be called.
+ */
+template <class Derived, class NormType>
+class NormPolicy
+{
+public:
+
+    typedef NormType norm_type;
+
+    double norm() const
+    {
+        if (norm_ < 0.0) norm_ = NormFunctor<NormType>()(static_cast<Derived const&>(*this));
+        return norm_;
+    }
+
+    /// Set the norm, if it is already known, e.g. by the scan of the converter
+    void setNorm(double norm) const { norm_ = norm; }
+
+    void invalidateNorm() const { norm_ = -1.0; }
+
+private:
+
+    mutable double norm_ = -1.0;
+
+};
+
+} // namespace BlasBooster
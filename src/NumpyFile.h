@@ -0,0 +1,559 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "MappedFile.h"
+#include "MatrixFile.h"
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Kind character of the NumPy dtype
+template <class T>
+struct NumpyKind;
+
+template <> struct NumpyKind<float> { static constexpr char value = 'f'; };
+template <> struct NumpyKind<double> { static constexpr char value = 'f'; };
+template <> struct NumpyKind<int32_t> { static constexpr char value = 'i'; };
+template <> struct NumpyKind<int64_t> { static constexpr char value = 'i'; };
+template <> struct NumpyKind<uint32_t> { static constexpr char value = 'u'; };
+template <> struct NumpyKind<uint64_t> { static constexpr char value = 'u'; };
+
+/// NumPy type string in native byte order, e.g. '<f8' for double
+template <class T>
+std::string getNumpyDescr()
+{
+    return std::string(1, std::endian::native == std::endian::little ? '<' : '>') + NumpyKind<T>::value + std::to_string(sizeof(T));
+}
+
+/**
+ * \brief Header of the NumPy .npy format.
+ *
+ * The magic string and version are followed by the length and the text of a
+ * Python dict with the keys descr, fortran_order and shape. The data starts
+ * at a multiple of 64 bytes.
+ */
+struct NumpyHeader
+{
+    static constexpr char magic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+    static constexpr size_t alignment = 64;
+
+    std::string descr;
+    bool fortranOrder = false;
+    std::vector<size_t> shape;
+
+    /// Position of the data from the beginning of the header
+    size_t dataPosition = 0;
+
+    /// One-dimensional arrays are column vectors
+    size_t getNbRows() const { return shape.size() > 0 ? shape[0] : 1; }
+    size_t getNbColumns() const { return shape.size() > 1 ? shape[1] : 1; }
+
+    /// Vectors and scalars have the same layout in both orders
+    bool isOrderIndependent() const { return getNbRows() == 1 or getNbColumns() == 1; }
+
+    static NumpyHeader parse(char const* data, size_t size)
+    {
+        if (size < 10 or std::memcmp(data, magic, sizeof(magic)) != 0)
+            throw std::runtime_error("NumpyFile: no .npy data.");
+
+        auto byte = [&](size_t i) { return static_cast<size_t>(static_cast<unsigned char>(data[i])); };
+
+        size_t begin, length;
+        if (data[6] == 1) {
+            begin = 10;
+            length = byte(8) | byte(9) << 8;
+        } else if (data[6] == 2 or data[6] == 3) {
+            if (size < 12) throw std::runtime_error("NumpyFile: header is truncated.");
+            begin = 12;
+            length = byte(8) | byte(9) << 8 | byte(10) << 16 | byte(11) << 24;
+        } else {
+            throw std::runtime_error("NumpyFile: version " + std::to_string(data[6]) + " is not supported.");
+        }
+        if (begin + length > size) throw std::runtime_error("NumpyFile: header is truncated.");
+
+        std::string_view dict(data + begin, length);
+        NumpyHeader header;
+        header.dataPosition = begin + length;
+
+        auto getValue = [&](std::string_view key) {
+            size_t position = dict.find(key);
+            if (position == std::string_view::npos) throw std::runtime_error("NumpyFile: key " + std::string(key) + " is missing.");
+            position = dict.find(':', position + key.size());
+            if (position == std::string_view::npos) throw std::runtime_error("NumpyFile: invalid header.");
+            return dict.substr(dict.find_first_not_of(" ", position + 1));
+        };
+
+        std::string_view descr = getValue("'descr'");
+        if (descr.empty() or (descr[0] != '\'' and descr[0] != '"')) throw std::runtime_error("NumpyFile: invalid descr.");
+        header.descr = std::string(descr.substr(1, descr.find(descr[0], 1) - 1));
+        // Byte order is not relevant for single bytes, '=' is the native order
+        if (!header.descr.empty() and (header.descr[0] == '|' or header.descr[0] == '='))
+            header.descr[0] = std::endian::native == std::endian::little ? '<' : '>';
+
+        header.fortranOrder = getValue("'fortran_order'").starts_with("True");
+
+        std::string_view shape = getValue("'shape'");
+        if (shape.empty() or shape[0] != '(') throw std::runtime_error("NumpyFile: invalid shape.");
+        shape = shape.substr(1, shape.find(')') - 1);
+        for (char const* cur = shape.data(), *end = shape.data() + shape.size(); cur != end;) {
+            while (cur != end and (*cur == ' ' or *cur == ',')) ++cur;
+            if (cur == end) break;
+            size_t extent;
+            auto result = std::from_chars(cur, end, extent);
+            if (result.ec != std::errc()) throw std::runtime_error("NumpyFile: invalid shape.");
+            header.shape.push_back(extent);
+            cur = result.ptr;
+        }
+        if (header.shape.size() > 2)
+            throw std::runtime_error("NumpyFile: arrays with " + std::to_string(header.shape.size()) + " dimensions are not supported.");
+
+        return header;
+    }
+
+    /// Header of version 1.0 padded to the alignment
+    std::string format() const
+    {
+        std::string dict = "{'descr': '" + descr + "', 'fortran_order': " + (fortranOrder ? "True" : "False") + ", 'shape': (";
+        for (auto extent : shape) dict += std::to_string(extent) + ", ";
+        // Trailing comma only for one-dimensional shapes, like numpy
+        if (shape.size() > 1) dict.resize(dict.size() - 2);
+        else if (shape.size() == 1) dict.resize(dict.size() - 1);
+        dict += "), }";
+
+        size_t length = (10 + dict.size() + 1 + alignment - 1) / alignment * alignment - 10;
+        dict.resize(length - 1, ' ');
+        dict += '\n';
+
+        std::string result(magic, sizeof(magic));
+        result += '\x01';
+        result += '\x00';
+        result += static_cast<char>(length & 0xff);
+        result += static_cast<char>(length >> 8);
+        return result + dict;
+    }
+};
+
+/**
+ * \brief Reading and writing of dense matrices as NumPy .npy data.
+ *
+ * The orientation of the matrix must match fortran_order, so that the data is
+ * used without transposition. openNumpy selects the orientation at runtime.
+ */
+template <class X>
+struct NumpyFile
+{
+    static_assert(sizeof(X) == 0, "NumpyFile: matrix type not supported.");
+};
+
+template <class T, class P>
+struct NumpyFile<Matrix<Dense,T,P>>
+{
+    typedef Matrix<Dense,T,P> matrix_type;
+
+    static_assert(!P::onStack and !P::isFixed and !P::isSubMatrix and !P::isBlockedMatrix,
+        "NumpyFile: only variable sized dense matrices on heap can be mapped.");
+
+    static const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+
+    static NumpyHeader createHeader(size_t nbRows, size_t nbColumns)
+    {
+        NumpyHeader header;
+        header.descr = getNumpyDescr<T>();
+        header.fortranOrder = columnMajor;
+        header.shape = {nbRows, nbColumns};
+        return header;
+    }
+
+    /// Check type, orientation and size of the .npy data of size bytes
+    static void check(NumpyHeader const& header, size_t size)
+    {
+        if (header.descr != getNumpyDescr<T>())
+            throw std::runtime_error("NumpyFile: dtype " + header.descr + " does not match " + getNumpyDescr<T>() + ".");
+        if (header.fortranOrder != columnMajor and !header.isOrderIndependent())
+            throw std::runtime_error("NumpyFile: fortran_order does not match the orientation.");
+
+        const size_t nbElements = MatrixFileHeader::multiply(header.getNbRows(), header.getNbColumns());
+        if ((size - header.dataPosition) / sizeof(T) < nbElements)
+            throw std::runtime_error("NumpyFile: data is truncated.");
+    }
+
+    /// Matrix using the .npy data of size bytes
+    static matrix_type map(char* data, size_t size)
+    {
+        auto header = NumpyHeader::parse(data, size);
+        check(header, size);
+        if (reinterpret_cast<std::uintptr_t>(data + header.dataPosition) % alignof(T) != 0)
+            throw std::runtime_error("NumpyFile: data is not aligned.");
+
+        return matrix_type(header.getNbRows(), header.getNbColumns(), reinterpret_cast<T*>(data + header.dataPosition));
+    }
+
+    static matrix_type map(MappedFile& file)
+    {
+        return map(file.getData(), file.getSize());
+    }
+
+    /// Uninitialized matrix in a new file
+    static matrix_type create(MappedFile& file, size_t nbRows, size_t nbColumns)
+    {
+        std::string header = createHeader(nbRows, nbColumns).format();
+        std::memcpy(file.getData(), header.data(), header.size());
+        return map(file);
+    }
+
+    static size_t getFileSize(size_t nbRows, size_t nbColumns)
+    {
+        return MatrixFileHeader::add(createHeader(nbRows, nbColumns).format().size(),
+            MatrixFileHeader::multiply(MatrixFileHeader::multiply(nbRows, nbColumns), sizeof(T)));
+    }
+
+    /// Call write(data, bytes) for the header and the lines of the matrix, sub-matrices are written contiguously
+    template <class P2, class Write>
+    static void write(Matrix<Dense,T,P2> const& matrix, Write const& write)
+    {
+        auto header = createHeader(matrix.getNbRows(), matrix.getNbColumns());
+        header.fortranOrder = std::is_same<typename P2::orientation, ColumnMajor>::value;
+        std::string text = header.format();
+        write(text.data(), text.size());
+        MatrixFile<Matrix<Dense,T,Parameter<size_t, typename P2::orientation>>>::forEachLine(matrix, write);
+    }
+};
+
+/// Matrix of a .npy file in the orientation given by fortran_order
+template <class T>
+using NumpyMatrix = std::variant<
+    MappedMatrix<Matrix<Dense,T,Parameter<size_t,ColumnMajor>>, NumpyFile>,
+    MappedMatrix<Matrix<Dense,T,Parameter<size_t,RowMajor>>, NumpyFile>>;
+
+/// Matrix in the .npy data of size bytes within file, unaligned data is copied
+template <class T>
+NumpyMatrix<T> makeNumpyMatrix(std::shared_ptr<MappedFile> const& file, char* data, size_t size)
+{
+    typedef Matrix<Dense,T,Parameter<size_t,ColumnMajor>> ColumnMajorMatrix;
+    typedef Matrix<Dense,T,Parameter<size_t,RowMajor>> RowMajorMatrix;
+
+    auto header = NumpyHeader::parse(data, size);
+    const bool aligned = reinterpret_cast<std::uintptr_t>(data + header.dataPosition) % alignof(T) == 0;
+
+    auto create = [&](auto tag) {
+        typedef typename decltype(tag)::type X;
+        if (aligned) return MappedMatrix<X, NumpyFile>(file, NumpyFile<X>::map(data, size));
+        // Copy to aligned memory, e.g. an array at an odd position within an archive
+        NumpyFile<X>::check(header, size);
+        X matrix(header.getNbRows(), header.getNbColumns());
+        std::memcpy(matrix.getDataPointer(), data + header.dataPosition, matrix.getSize() * sizeof(T));
+        return MappedMatrix<X, NumpyFile>(file, std::move(matrix));
+    };
+
+    if (header.fortranOrder) return NumpyMatrix<T>(std::in_place_index<0>, create(std::type_identity<ColumnMajorMatrix>()));
+    return NumpyMatrix<T>(std::in_place_index<1>, create(std::type_identity<RowMajorMatrix>()));
+}
+
+/// Map a .npy file as matrix with the orientation of the file
+template <class T>
+NumpyMatrix<T> openNumpy(std::string const& filename, MappedFile::Mode mode = MappedFile::Mode::Private)
+{
+    auto file = std::make_shared<MappedFile>(filename, mode);
+    return makeNumpyMatrix<T>(file, file->getData(), file->getSize());
+}
+
+/// Write a dense matrix as .npy file, fortran_order is set for ColumnMajor
+template <class T, class P>
+void saveNumpy(Matrix<Dense,T,P> const& matrix, std::string const& filename)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) throw std::runtime_error("NumpyFile: can not open " + filename + ".");
+    NumpyFile<Matrix<Dense,T,Parameter<size_t, typename P::orientation>>>::write(matrix,
+        [&](char const* data, size_t size){ out.write(data, size); });
+    if (!out) throw std::runtime_error("NumpyFile: writing " + filename + " failed.");
+}
+
+/// CRC-32 of the zip format
+inline uint32_t crc32(uint32_t crc, char const* data, size_t size)
+{
+    static const auto table = []{
+        std::array<uint32_t, 256> table;
+        for (uint32_t i = 0; i != 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k != 8; ++k) c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i != size; ++i) crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+/**
+ * \brief NumPy .npz archive of uncompressed arrays as written by numpy.savez.
+ *
+ * The archive is mapped once and the arrays are used in place, only arrays
+ * which are not aligned within the archive are copied. Compressed archives
+ * (numpy.savez_compressed) are not supported.
+ */
+class NumpyArchive
+{
+public:
+
+    explicit NumpyArchive(std::string const& filename)
+     : file_(std::make_shared<MappedFile>(filename))
+    {
+        char const* data = file_->getData();
+        const size_t size = file_->getSize();
+
+        // End of central directory record, followed by a comment of at most 64 kB
+        size_t eocd = std::string_view::npos;
+        for (size_t position = size >= 22 ? size - 22 : 0; size >= 22; --position) {
+            if (read32(data + position) == 0x06054b50) { eocd = position; break; }
+            if (position == 0 or size - position > 22 + 0xffff) break;
+        }
+        if (eocd == std::string_view::npos) throw std::runtime_error("NumpyArchive: " + filename + " is not a zip archive.");
+
+        uint64_t nbEntries = read16(data + eocd + 10);
+        uint64_t directory = read32(data + eocd + 16);
+        if (nbEntries == 0xffff or directory == 0xffffffff) {
+            // Zip64 end of central directory locator
+            if (eocd < 20 or read32(data + eocd - 20) != 0x07064b50) throw std::runtime_error("NumpyArchive: invalid zip64 archive.");
+            uint64_t record = read64(data + eocd - 20 + 8);
+            checkRange(record, 56);
+            nbEntries = read64(data + record + 32);
+            directory = read64(data + record + 48);
+        }
+
+        uint64_t position = directory;
+        for (uint64_t i = 0; i != nbEntries; ++i) {
+            checkRange(position, 46);
+            if (read32(data + position) != 0x02014b50) throw std::runtime_error("NumpyArchive: invalid central directory.");
+            Entry entry;
+            entry.method = read16(data + position + 10);
+            entry.size = read32(data + position + 20);
+            uint64_t local = read32(data + position + 42);
+            size_t nameLength = read16(data + position + 28);
+            size_t extraLength = read16(data + position + 30);
+            size_t commentLength = read16(data + position + 32);
+            checkRange(position + 46, nameLength + extraLength);
+            std::string name(data + position + 46, nameLength);
+
+            // Zip64 extended information, only the fields which are 0xffffffff in the header are present
+            uint64_t uncompressedSize = read32(data + position + 24);
+            for (char const* extra = data + position + 46 + nameLength, *end = extra + extraLength; extra + 4 <= end;) {
+                size_t id = read16(extra), length = read16(extra + 2);
+                char const* field = extra + 4;
+                if (id == 0x0001) {
+                    if (uncompressedSize == 0xffffffff) field += 8;
+                    if (entry.size == 0xffffffff) { entry.size = read64(field); field += 8; }
+                    if (local == 0xffffffff) local = read64(field);
+                }
+                extra += 4 + length;
+            }
+
+            checkRange(local, 30);
+            entry.position = local + 30 + read16(data + local + 26) + read16(data + local + 28);
+            checkRange(entry.position, entry.size);
+
+            if (name.ends_with(".npy")) name.resize(name.size() - 4);
+            entries_[name] = entry;
+            position += 46 + nameLength + extraLength + commentLength;
+        }
+    }
+
+    std::vector<std::string> getNames() const
+    {
+        std::vector<std::string> names;
+        for (auto const& entry : entries_) names.push_back(entry.first);
+        return names;
+    }
+
+    bool contains(std::string const& name) const { return entries_.count(name) != 0; }
+
+    /// Array name as matrix in the orientation of the array, which keeps the archive mapped
+    template <class T>
+    NumpyMatrix<T> get(std::string const& name) const
+    {
+        auto iter = entries_.find(name);
+        if (iter == entries_.end()) throw std::runtime_error("NumpyArchive: array " + name + " not found.");
+        if (iter->second.method != 0) throw std::runtime_error("NumpyArchive: compressed array " + name + " is not supported.");
+        return makeNumpyMatrix<T>(file_, file_->getData() + iter->second.position, iter->second.size);
+    }
+
+private:
+
+    struct Entry
+    {
+        uint64_t position = 0;
+        uint64_t size = 0;
+        size_t method = 0;
+    };
+
+    static uint64_t readLittleEndian(char const* data, size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i != bytes; ++i) value |= uint64_t(static_cast<unsigned char>(data[i])) << (8 * i);
+        return value;
+    }
+
+    static uint64_t read16(char const* data) { return readLittleEndian(data, 2); }
+    static uint64_t read32(char const* data) { return readLittleEndian(data, 4); }
+    static uint64_t read64(char const* data) { return readLittleEndian(data, 8); }
+
+    void checkRange(uint64_t position, uint64_t size) const
+    {
+        if (position > file_->getSize() or size > file_->getSize() - position)
+            throw std::runtime_error("NumpyArchive: " + file_->getFilename() + " is truncated.");
+    }
+
+    std::shared_ptr<MappedFile> file_;
+
+    std::map<std::string, Entry> entries_;
+
+};
+
+/**
+ * \brief Streaming writer of uncompressed .npz archives.
+ *
+ * Each array is written directly to the file, the CRC and the sizes are
+ * patched into the local header afterwards. Arrays and archives must be
+ * smaller than 4 GB, zip64 is not written.
+ */
+class NumpyArchiveWriter
+{
+public:
+
+    explicit NumpyArchiveWriter(std::string const& filename)
+     : out_(filename, std::ios::binary), filename_(filename)
+    {
+        if (!out_) throw std::runtime_error("NumpyArchiveWriter: can not open " + filename + ".");
+    }
+
+    NumpyArchiveWriter(NumpyArchiveWriter const&) = delete;
+    NumpyArchiveWriter& operator = (NumpyArchiveWriter const&) = delete;
+
+    ~NumpyArchiveWriter()
+    {
+        try {
+            close();
+        } catch (...) {}
+    }
+
+    template <class T, class P>
+    void add(std::string const& name, Matrix<Dense,T,P> const& matrix)
+    {
+        if (closed_) throw std::runtime_error("NumpyArchiveWriter: archive is closed.");
+
+        Entry entry;
+        entry.name = name + ".npy";
+        entry.position = out_.tellp();
+        writeLocalHeader(entry);
+
+        size_t size = 0;
+        NumpyFile<Matrix<Dense,T,Parameter<size_t, typename P::orientation>>>::write(matrix, [&](char const* data, size_t bytes) {
+            entry.crc = crc32(entry.crc, data, bytes);
+            out_.write(data, bytes);
+            size += bytes;
+        });
+        if (size >= 0xffffffff or uint64_t(out_.tellp()) >= 0xffffffff)
+            throw std::runtime_error("NumpyArchiveWriter: arrays larger than 4 GB are not supported.");
+        entry.size = size;
+
+        auto end = out_.tellp();
+        out_.seekp(entry.position);
+        writeLocalHeader(entry);
+        out_.seekp(end);
+
+        if (!out_) throw std::runtime_error("NumpyArchiveWriter: writing " + filename_ + " failed.");
+        entries_.push_back(entry);
+    }
+
+    /// Write the central directory
+    void close()
+    {
+        if (closed_) return;
+        closed_ = true;
+
+        uint64_t directory = out_.tellp();
+        for (auto const& entry : entries_) {
+            put32(0x02014b50);
+            put16(20);
+            writeCommonHeader(entry);
+            put16(0); // comment length
+            put16(0); // disk number
+            put16(0); // internal attributes
+            put32(0); // external attributes
+            put32(entry.position);
+            out_.write(entry.name.data(), entry.name.size());
+        }
+        uint64_t directorySize = uint64_t(out_.tellp()) - directory;
+
+        put32(0x06054b50);
+        put16(0);
+        put16(0);
+        put16(entries_.size());
+        put16(entries_.size());
+        put32(directorySize);
+        put32(directory);
+        put16(0);
+
+        out_.close();
+        if (!out_) throw std::runtime_error("NumpyArchiveWriter: writing " + filename_ + " failed.");
+    }
+
+private:
+
+    struct Entry
+    {
+        std::string name;
+        uint64_t position = 0;
+        uint64_t size = 0;
+        uint32_t crc = 0;
+    };
+
+    void put16(uint64_t value) { char bytes[2] = {char(value), char(value >> 8)}; out_.write(bytes, 2); }
+    void put32(uint64_t value) { put16(value & 0xffff); put16(value >> 16); }
+
+    /// Fields from version needed to extra length, shared by local and central header
+    void writeCommonHeader(Entry const& entry)
+    {
+        put16(20);     // version needed to extract
+        put16(0);      // flags
+        put16(0);      // stored
+        put16(0);      // time
+        put16(0x21);   // date 1980-01-01
+        put32(entry.crc);
+        put32(entry.size);
+        put32(entry.size);
+        put16(entry.name.size());
+        put16(0);      // extra length
+    }
+
+    void writeLocalHeader(Entry const& entry)
+    {
+        put32(0x04034b50);
+        writeCommonHeader(entry);
+        out_.write(entry.name.data(), entry.name.size());
+    }
+
+    std::ofstream out_;
+
+    std::string filename_;
+
+    std::vector<Entry> entries_;
+
+    bool closed_ = false;
+
+};
+
+} // namespace BlasBooster
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Dimension.h"
+#include "Memory.h"
 
 namespace BlasBooster {
 
@@ -18,7 +19,8 @@ template <
     class LeadingDimension = NoLeadingDimension,
     class UnblockedDimension = NoUnblockedDimension,
     class Norm = NormTwo,
-    class Storage = OnHeap
+    class Storage = OnHeap,
+    class Allocator = DefaultAllocator
 >
 struct Parameter
 {
@@ -29,6 +31,7 @@ struct Parameter
     typedef LeadingDimension leadingDimension;
     typedef UnblockedDimension unblockedDimension;
     typedef Norm NormType;
+    typedef Allocator AllocatorType;
     static const bool isSubMatrix = !std::is_same<LeadingDimension, NoLeadingDimension>::value;
     static const bool isBlockedMatrix = !std::is_same<UnblockedDimension, NoUnblockedDimension>::value;
     static const bool onStack = std::is_same<Storage, OnStack>::value;
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "SparseMatrix.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Element of a sparse matrix in coordinate (COO) format
+template <class T, class I = size_t>
+struct Triplet
+{
+    I row;
+    I column;
+    T value;
+};
+
+/// Unordered triplets collected by one thread
+template <class T, class I = size_t>
+using TripletBuffer = std::vector<Triplet<T,I>>;
+
+/**
+ * \brief Parallel assembly of triplets into a sparse matrix X (CSR or CSC).
+ *
+ * The triplets of all buffers are sorted by their major index (row for
+ * RowMajor, column for ColumnMajor) with a parallel two-pass radix sort. The
+ * first pass distributes the triplets by the high bits of the major index into
+ * at most maxNbBuckets buckets, each chunk of a buffer writes to its own
+ * positions of each bucket determined by a histogram, so that no atomics are
+ * needed. The second pass sorts each bucket by the remaining bits directly into
+ * the value and key arrays of the matrix. As a bucket covers a contiguous range
+ * of lines, its part of these arrays is small enough to stay in the cache,
+ * unlike a direct scatter of all triplets to their lines. Then each line is
+ * sorted by the minor index and duplicates are summed up, as in finite element
+ * assembly. Without duplicates the arrays are moved into the matrix, otherwise
+ * the lines are compacted into exactly sized arrays.
+ */
+template <class X>
+struct SparseAssembly
+{
+    typedef typename X::value_type value_type;
+    typedef typename X::IndexType IndexType;
+    typedef typename X::storage::value_storage value_storage;
+    typedef typename X::storage::index_storage index_storage;
+
+    static_assert(!X::parameter::isFixed, "SparseAssembly: only variable sized sparse matrices are supported.");
+
+    static constexpr bool columnMajor = std::is_same<typename X::orientation, ColumnMajor>::value;
+
+    /// Number of triplets processed by one task of the first pass
+    static constexpr size_t chunkSize = size_t(1) << 16;
+
+    /// Maximal number of buckets of the first pass, limited by the number of concurrent write streams
+    static constexpr size_t maxNbBuckets = 1024;
+
+    /// Triplet converted to the types of X
+    struct Element
+    {
+        IndexType outer;
+        IndexType inner;
+        value_type value;
+    };
+
+    template <class T, class I>
+    static X assemble(size_t nbRows, size_t nbColumns, std::vector<TripletBuffer<T,I>> const& buffers,
+        WorkStealingScheduler const& scheduler)
+    {
+        const size_t nbOuter = columnMajor ? nbColumns : nbRows;
+
+        // Split the buffers into chunks of equal size
+        std::vector<std::pair<size_t, size_t>> chunks;
+        size_t nbTriplets = 0;
+        for (size_t b = 0; b != buffers.size(); ++b) {
+            for (size_t begin = 0; begin < buffers[b].size(); begin += chunkSize) chunks.emplace_back(b, begin);
+            nbTriplets += buffers[b].size();
+        }
+        auto forEachTriplet = [&](size_t chunk, auto const& function) {
+            auto const& buffer = buffers[chunks[chunk].first];
+            const size_t begin = chunks[chunk].second, end = std::min(buffer.size(), begin + chunkSize);
+            for (size_t t = begin; t != end; ++t) function(buffer[t]);
+        };
+
+        // Radix digit of the first pass: bucket = outer >> shift
+        size_t shift = 0;
+        while ((nbOuter >> shift) >= maxNbBuckets) ++shift;
+        const size_t nbBuckets = (nbOuter >> shift) + 1;
+
+        // Histogram of the buckets per chunk
+        std::vector<size_t> position(chunks.size() * nbBuckets, 0);
+        scheduler.run(chunks.size(), [&](size_t chunk) {
+            size_t* histogram = position.data() + chunk * nbBuckets;
+            forEachTriplet(chunk, [&](Triplet<T,I> const& triplet) {
+                if (static_cast<size_t>(triplet.row) >= nbRows or static_cast<size_t>(triplet.column) >= nbColumns)
+                    throw std::runtime_error("SparseAssembly: triplet (" + std::to_string(triplet.row) + ", "
+                        + std::to_string(triplet.column) + ") is out of range.");
+                ++histogram[static_cast<size_t>(columnMajor ? triplet.column : triplet.row) >> shift];
+            });
+        });
+
+        // Start of each bucket and of its part written by each chunk
+        std::vector<size_t> bucketBegin(nbBuckets + 1);
+        size_t sum = 0;
+        for (size_t bucket = 0; bucket != nbBuckets; ++bucket) {
+            bucketBegin[bucket] = sum;
+            for (size_t chunk = 0; chunk != chunks.size(); ++chunk) {
+                const size_t count = position[chunk * nbBuckets + bucket];
+                position[chunk * nbBuckets + bucket] = sum;
+                sum += count;
+            }
+        }
+        bucketBegin[nbBuckets] = sum;
+
+        // First pass: distribute the triplets into the buckets
+        std::unique_ptr<Element[]> elements(new Element[nbTriplets]);
+        scheduler.run(chunks.size(), [&](size_t chunk) {
+            size_t* cursor = position.data() + chunk * nbBuckets;
+            forEachTriplet(chunk, [&](Triplet<T,I> const& triplet) {
+                const size_t outer = columnMajor ? triplet.column : triplet.row;
+                elements[cursor[outer >> shift]++] = Element{static_cast<IndexType>(outer),
+                    static_cast<IndexType>(columnMajor ? triplet.row : triplet.column), static_cast<value_type>(triplet.value)};
+            });
+        }, [&](size_t chunk) { return static_cast<double>(std::min(chunkSize, buffers[chunks[chunk].first].size() - chunks[chunk].second)); });
+
+        // Second pass: sort each bucket by line into the arrays of the matrix, then sort each line by key and sum up duplicates
+        value_storage values(nbTriplets);
+        index_storage keys(nbTriplets);
+        index_storage offsets(nbOuter + 1);
+        value_type* value = values.getDataPointer();
+        IndexType* key = keys.getDataPointer();
+        IndexType* offset = offsets.getDataPointer();
+        offset[nbOuter] = nbTriplets;
+        std::vector<IndexType> nbUnique(nbOuter);
+        auto getBucketCost = [&](size_t bucket) { return static_cast<double>(bucketBegin[bucket + 1] - bucketBegin[bucket] + 1); };
+
+        scheduler.run(nbBuckets, [&](size_t bucket) {
+            const size_t first = bucket << shift, last = std::min(nbOuter, (bucket + 1) << shift);
+            std::vector<IndexType> cursor(last - first + 1, 0);
+            for (size_t e = bucketBegin[bucket]; e != bucketBegin[bucket + 1]; ++e) ++cursor[elements[e].outer - first + 1];
+            cursor[0] = bucketBegin[bucket];
+            for (size_t outer = first; outer != last; ++outer) {
+                cursor[outer - first + 1] += cursor[outer - first];
+                offset[outer] = cursor[outer - first];
+            }
+            for (size_t e = bucketBegin[bucket]; e != bucketBegin[bucket + 1]; ++e) {
+                IndexType& p = cursor[elements[e].outer - first];
+                value[p] = elements[e].value;
+                key[p] = elements[e].inner;
+                ++p;
+            }
+
+            std::vector<std::pair<IndexType,value_type>> entries;
+            for (size_t outer = first; outer != last; ++outer) {
+                const size_t begin = offset[outer], end = outer + 1 != last ? offset[outer + 1] : bucketBegin[bucket + 1];
+                if (!std::is_sorted(key + begin, key + end)) {
+                    entries.clear();
+                    for (size_t e = begin; e != end; ++e) entries.emplace_back(key[e], value[e]);
+                    std::sort(entries.begin(), entries.end(), [](auto const& a, auto const& b){ return a.first < b.first; });
+                    for (size_t e = begin, i = 0; e != end; ++e, ++i) {
+                        key[e] = entries[i].first;
+                        value[e] = entries[i].second;
+                    }
+                }
+                size_t unique = begin;
+                for (size_t e = begin + 1; e < end; ++e) {
+                    if (key[e] == key[unique]) value[unique] += value[e];
+                    else {
+                        ++unique;
+                        key[unique] = key[e];
+                        value[unique] = value[e];
+                    }
+                }
+                nbUnique[outer] = end != begin ? unique + 1 - begin : 0;
+            }
+        }, getBucketCost);
+        elements.reset();
+
+        size_t nnz = 0;
+        for (size_t outer = 0; outer != nbOuter; ++outer) nnz += nbUnique[outer];
+        if (nnz == nbTriplets)
+            return X(nbRows, nbColumns, std::move(values), std::move(keys), std::move(offsets));
+
+        // Compaction into exactly sized arrays
+        value_storage uniqueValues(nnz);
+        index_storage uniqueKeys(nnz);
+        index_storage uniqueOffsets(nbOuter + 1);
+        IndexType* uniqueOffset = uniqueOffsets.getDataPointer();
+        uniqueOffset[0] = 0;
+        for (size_t outer = 0; outer != nbOuter; ++outer) uniqueOffset[outer + 1] = uniqueOffset[outer] + nbUnique[outer];
+
+        scheduler.run(nbBuckets, [&](size_t bucket) {
+            for (size_t outer = bucket << shift; outer < std::min(nbOuter, (bucket + 1) << shift); ++outer) {
+                std::copy_n(value + offset[outer], nbUnique[outer], uniqueValues.getDataPointer() + uniqueOffset[outer]);
+                std::copy_n(key + offset[outer], nbUnique[outer], uniqueKeys.getDataPointer() + uniqueOffset[outer]);
+            }
+        }, getBucketCost);
+        return X(nbRows, nbColumns, std::move(uniqueValues), std::move(uniqueKeys), std::move(uniqueOffsets));
+    }
+};
+
+/**
+ * Sparse matrix X of the triplets of all buffers, duplicates are summed up.
+ * The buffers are typically filled concurrently, one per thread.
+ */
+template <class X, class T, class I>
+X assembleSparse(size_t nbRows, size_t nbColumns, std::vector<TripletBuffer<T,I>> const& buffers,
+    WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+{
+    return SparseAssembly<X>::assemble(nbRows, nbColumns, buffers, scheduler);
+}
+
+} // namespace BlasBooster
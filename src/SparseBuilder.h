@@ -0,0 +1,241 @@
+#pragma once
+
+#include "SparseMatrix.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BlasBooster {
+
+/**
+ * \brief Sparse matrix X built line by line with growing storage.
+ *
+ * A line is a row of a RowMajor (CSR) and a column of a ColumnMajor (CSC)
+ * matrix. The elements of the current line are appended with push, endLine
+ * starts the next line. The value and key arrays grow geometrically, so that
+ * no estimate of the number of elements is needed. finalize shrinks them to
+ * the exact size and moves them into the matrix.
+ *
+ *   SparseAppendBuilder<Matrix<Sparse,double,Parameter<size_t,RowMajor>>> builder(m, n);
+ *   for (size_t i = 0; i != m; ++i) {
+ *       for (...) builder.push(j, value);
+ *       builder.endLine();
+ *   }
+ *   auto A = builder.finalize();
+ */
+template <class X>
+class SparseAppendBuilder
+{
+public:
+
+    typedef typename X::value_type T;
+    typedef typename X::IndexType IndexType;
+    typedef typename X::storage::value_storage value_storage;
+    typedef typename X::storage::index_storage index_storage;
+
+    static_assert(!X::parameter::isFixed, "SparseAppendBuilder: only variable sized sparse matrices are supported.");
+
+    static constexpr bool columnMajor = std::is_same<typename X::orientation, ColumnMajor>::value;
+
+    /// Capacity is the initial number of elements, e.g. an estimate of the nonzeros
+    SparseAppendBuilder(IndexType nbRows, IndexType nbColumns, size_t capacity = 0)
+     : nbRows_(nbRows), nbColumns_(nbColumns),
+       values_(capacity), keys_(capacity), offsets_((columnMajor ? nbColumns : nbRows) + 1)
+    {
+        offsets_.getDataPointer()[0] = 0;
+    }
+
+    /// Append an element with the given row (ColumnMajor) or column (RowMajor) index to the current line
+    void push(IndexType key, T const& value)
+    {
+        if (line_ == getNbLines())
+            throw std::runtime_error("SparseAppendBuilder: all lines are already finished.");
+        if (nnz_ == values_.size()) grow(std::max<size_t>(16, 2 * nnz_));
+        values_.getDataPointer()[nnz_] = value;
+        keys_.getDataPointer()[nnz_] = key;
+        ++nnz_;
+    }
+
+    /// Finish the current line
+    void endLine()
+    {
+        if (line_ == getNbLines())
+            throw std::runtime_error("SparseAppendBuilder: all lines are already finished.");
+        offsets_.getDataPointer()[++line_] = nnz_;
+    }
+
+    /// Number of elements pushed so far
+    size_t nnz() const { return nnz_; }
+
+    /// Number of finished lines
+    size_t getNbFinishedLines() const { return line_; }
+
+    /// Finish the remaining lines and move the exactly sized arrays into the matrix, the builder must not be used afterwards
+    X finalize()
+    {
+        while (line_ != getNbLines()) endLine();
+        if (nnz_ != values_.size()) grow(nnz_);
+        return X(nbRows_, nbColumns_, std::move(values_), std::move(keys_), std::move(offsets_));
+    }
+
+private:
+
+    size_t getNbLines() const { return offsets_.size() - 1; }
+
+    /// Reallocate values and keys to the given capacity and copy the pushed elements
+    void grow(size_t capacity)
+    {
+        value_storage values(capacity);
+        index_storage keys(capacity);
+        std::copy_n(values_.getDataPointer(), nnz_, values.getDataPointer());
+        std::copy_n(keys_.getDataPointer(), nnz_, keys.getDataPointer());
+        values_ = std::move(values);
+        keys_ = std::move(keys);
+    }
+
+    IndexType nbRows_;
+    IndexType nbColumns_;
+
+    value_storage values_;
+    index_storage keys_;
+    index_storage offsets_;
+
+    size_t nnz_ = 0;
+    size_t line_ = 0;
+
+};
+
+/**
+ * \brief Sparse matrix X built in two passes with exactly sized storage.
+ *
+ * The first pass counts the elements per line (row for RowMajor, column for
+ * ColumnMajor), allocate converts the counts into offsets and allocates the
+ * value and key arrays. In the second pass the elements can be inserted in
+ * any order, also concurrently as long as each line is filled by only one
+ * thread. finalize sorts the keys within each line. If fewer elements were
+ * inserted than counted, e.g. because the count was an upper bound, the lines
+ * are compacted and the arrays shrunk to fit.
+ */
+template <class X>
+class SparseCountedBuilder
+{
+public:
+
+    typedef typename X::value_type T;
+    typedef typename X::IndexType IndexType;
+    typedef typename X::storage::value_storage value_storage;
+    typedef typename X::storage::index_storage index_storage;
+
+    static_assert(!X::parameter::isFixed, "SparseCountedBuilder: only variable sized sparse matrices are supported.");
+
+    static constexpr bool columnMajor = std::is_same<typename X::orientation, ColumnMajor>::value;
+
+    SparseCountedBuilder(IndexType nbRows, IndexType nbColumns)
+     : nbRows_(nbRows), nbColumns_(nbColumns),
+       offsets_((columnMajor ? nbColumns : nbRows) + 1)
+    {
+        std::fill(offsets_.begin(), offsets_.end(), IndexType(0));
+    }
+
+    /// First pass: count n elements of line outer
+    void count(IndexType outer, IndexType n = 1)
+    {
+        if (allocated_) throw std::runtime_error("SparseCountedBuilder: count after allocate.");
+        offsets_.getDataPointer()[outer + 1] += n;
+    }
+
+    /// Convert the counts into offsets and allocate the value and key arrays
+    void allocate()
+    {
+        if (allocated_) throw std::runtime_error("SparseCountedBuilder: allocate was already called.");
+        IndexType* offset = offsets_.getDataPointer();
+        for (size_t outer = 0; outer != getNbLines(); ++outer) offset[outer + 1] += offset[outer];
+        values_.resize(offset[getNbLines()]);
+        keys_.resize(offset[getNbLines()]);
+        cursor_.assign(offset, offset + getNbLines());
+        allocated_ = true;
+    }
+
+    /// Second pass: insert the element (outer, key) into its line
+    void insert(IndexType outer, IndexType key, T const& value)
+    {
+        if (!allocated_) throw std::runtime_error("SparseCountedBuilder: insert before allocate.");
+        IndexType& position = cursor_[outer];
+        if (position == offsets_.getDataPointer()[outer + 1])
+            throw std::runtime_error("SparseCountedBuilder: more elements inserted into line " + std::to_string(outer) + " than counted.");
+        values_.getDataPointer()[position] = value;
+        keys_.getDataPointer()[position] = key;
+        ++position;
+    }
+
+    /**
+     * Sort the lines by key, compact and shrink the arrays to the inserted elements
+     * and move them into the matrix, the builder must not be used afterwards.
+     */
+    X finalize()
+    {
+        if (!allocated_) allocate();
+
+        T* value = values_.getDataPointer();
+        IndexType* key = keys_.getDataPointer();
+        IndexType* offset = offsets_.getDataPointer();
+
+        std::vector<std::pair<IndexType,T>> entries;
+        for (size_t outer = 0; outer != getNbLines(); ++outer) {
+            if (std::is_sorted(key + offset[outer], key + cursor_[outer])) continue;
+            entries.clear();
+            for (size_t e = offset[outer]; e != cursor_[outer]; ++e) entries.emplace_back(key[e], value[e]);
+            std::sort(entries.begin(), entries.end(), [](auto const& a, auto const& b){ return a.first < b.first; });
+            for (size_t e = offset[outer], i = 0; e != cursor_[outer]; ++e, ++i) {
+                key[e] = entries[i].first;
+                value[e] = entries[i].second;
+            }
+        }
+
+        // Remove the gaps of lines with fewer elements than counted
+        size_t nnz = 0;
+        for (size_t outer = 0; outer != getNbLines(); ++outer) {
+            const size_t begin = offset[outer], end = cursor_[outer];
+            offset[outer] = nnz;
+            if (begin != nnz) {
+                std::copy(value + begin, value + end, value + nnz);
+                std::copy(key + begin, key + end, key + nnz);
+            }
+            nnz += end - begin;
+        }
+        offset[getNbLines()] = nnz;
+
+        if (nnz != values_.size()) {
+            value_storage values(nnz);
+            index_storage keys(nnz);
+            std::copy_n(value, nnz, values.getDataPointer());
+            std::copy_n(key, nnz, keys.getDataPointer());
+            values_ = std::move(values);
+            keys_ = std::move(keys);
+        }
+
+        return X(nbRows_, nbColumns_, std::move(values_), std::move(keys_), std::move(offsets_));
+    }
+
+private:
+
+    size_t getNbLines() const { return offsets_.size() - 1; }
+
+    IndexType nbRows_;
+    IndexType nbColumns_;
+
+    value_storage values_;
+    index_storage keys_;
+    index_storage offsets_;
+
+    /// Next free position of each line during the second pass
+    std::vector<IndexType> cursor_;
+
+    bool allocated_ = false;
+
+};
+
+} // namespace BlasBooster
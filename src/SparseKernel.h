@@ -0,0 +1,575 @@
+#pragma once
+
+#include "Storage.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <xsimd/xsimd.hpp>
+
+namespace BlasBooster {
+
+/**
+ * \brief Multithreaded products of a sparse and a dense matrix.
+ *
+ * C = alpha * A * B + beta * C with A in CSR (RowMajor) or CSC (ColumnMajor)
+ * format and B (n x k), C (m x k) dense with arbitrary row and column strides.
+ * k = 1 is the sparse matrix-vector product.
+ *
+ * CSR: the rows are split into ranges of similar numbers of nonzeros, which
+ * are executed by the WorkStealingScheduler. For a single right-hand side or
+ * column-major B, each row is a dot product with x, whose elements are
+ * loaded by SIMD gathers. For row-major B and C the k right-hand sides are
+ * vectorized, each nonzero A_il adds a contiguous row of B to a row of C.
+ *
+ * CSC: the columns of A scatter into C. With enough right-hand sides the
+ * threads work on disjoint column slices of C, otherwise the columns of A
+ * are split and each part is accumulated into a private buffer of m x k,
+ * which are summed up afterwards. The number of buffers is limited by the
+ * sizes of A and C, so that few right-hand sides of a tall C do not allocate
+ * one copy of C per thread.
+ *
+ * T: compute type, which should be the widest value type. Operands of other
+ * value types are converted in the registers, e.g. a float matrix and float
+ * right-hand sides are widened to double for a double C, so that mixed
+ * precision products are vectorized as well.
+ */
+template <class T>
+struct SparseKernel
+{
+    typedef xsimd::batch<T> batch;
+
+    static constexpr size_t simdSize = batch::size;
+
+    /// Minimal number of multiply-adds per task, smaller products are not split
+    static constexpr size_t minWorkPerTask = 1 << 15;
+
+    /// The private buffers of the CSC product hold at most maxBufferRatio times the elements of A and C
+    static constexpr size_t maxBufferRatio = 2;
+
+    template <class TA, class I, class TB, class TC>
+    static void csr(size_t m, size_t k, TC alpha,
+        TA const* value, I const* key, I const* offset,
+        TB const* b, size_t rsB, size_t csB,
+        TC beta, TC* c, size_t rsC, size_t csC,
+        WorkStealingScheduler const& scheduler);
+
+    template <class TA, class I, class TB, class TC>
+    static void csc(size_t m, size_t n, size_t k, TC alpha,
+        TA const* value, I const* key, I const* offset,
+        TB const* b, size_t rsB, size_t csB,
+        TC beta, TC* c, size_t rsC, size_t csC,
+        WorkStealingScheduler const& scheduler);
+
+    /**
+     * Sparse times sparse in outer form: outer index i of C is the sum of the outer
+     * indices keyL[e] of R scaled by valueL[e] for all nonzeros e of outer index i of L,
+     * i.e. L = A, R = B for CSR and L = B, R = A for CSC.
+     *
+     * The symbolic phase counts the nonzeros of each outer index of C, then
+     * allocate(nnz) must return the pointers (value, key, offset) of C with exactly
+     * nnz elements and the numeric phase fills them with sorted keys.
+     */
+    template <class TL, class TR, class I, class TC, class Allocate>
+    static void spgemm(size_t nbOuter, size_t nbInner, TC alpha,
+        TL const* valueL, I const* keyL, I const* offsetL,
+        TR const* valueR, I const* keyR, I const* offsetR,
+        Allocate const& allocate, WorkStealingScheduler const& scheduler);
+
+    /// Rows with at least nbInner / denseRatio multiply-adds are merged in a dense accumulator, the others in a hash table
+    static constexpr size_t denseRatio = 8;
+
+    /**
+     * Split [0, nbOuter) into at most nbParts ranges of similar weight and return
+     * their bounds. The weight of an outer index is its number of nonzeros plus one,
+     * so that long runs of empty rows are also distributed.
+     */
+    template <class I>
+    static std::vector<size_t> partition(I const* offset, size_t nbOuter, size_t nbParts);
+
+private:
+
+    /// Number of tasks for a product with the given number of multiply-adds
+    static size_t getNbParts(size_t work, WorkStealingScheduler const& scheduler)
+    {
+        return std::min(4 * scheduler.getNbThreads(), std::max<size_t>(1, work / minWorkPerTask));
+    }
+
+    /// Elements p[0], ..., p[simdSize - 1] converted to T
+    template <class U>
+    static batch load(U const* p);
+
+    /// Store x converted to U into p[0], ..., p[simdSize - 1]
+    template <class U>
+    static void store(batch const& x, U* p);
+
+    /// Elements x[index[0]], ..., x[index[simdSize - 1]] converted to T
+    template <class U, class I>
+    static batch gather(U const* x, I const* index);
+
+    /// Rows [begin, end) of CSR times B
+    template <class TA, class I, class TB, class TC>
+    static void csrRows(size_t begin, size_t end, size_t k, TC alpha,
+        TA const* value, I const* key, I const* offset,
+        TB const* b, size_t rsB, size_t csB,
+        TC beta, TC* c, size_t rsC, size_t csC);
+
+    /// c[j] = alpha * sum_e value[e] * B(key[e], j) + beta * c[j] for j in [0, N * simdSize), B and c row-major
+    template <size_t N, class TA, class I, class TB, class TC>
+    static void rowTimesRows(size_t begin, size_t end, T alpha, TA const* value, I const* key,
+        TB const* b, size_t ldb, T beta, TC* c);
+
+    /// C(:, j0:j1) += alpha * A(:, begin:end) * B(begin:end, j0:j1), C(:, j0:j1) is already scaled by beta
+    template <class TA, class I, class TB, class TC>
+    static void cscColumns(size_t begin, size_t end, size_t j0, size_t j1, TC alpha,
+        TA const* value, I const* key, I const* offset,
+        TB const* b, size_t rsB, size_t csB,
+        TC* c, size_t rsC, size_t csC);
+
+    /// C(i0:i1, j0:j1) *= beta, beta = 0 also removes NaN
+    template <class TC>
+    static void scale(size_t i0, size_t i1, size_t j0, size_t j1, TC beta, TC* c, size_t rsC, size_t csC);
+
+    /// Thread-local buffers of the row merging in spgemm
+    template <class I>
+    struct Accumulator
+    {
+        std::vector<I> marker;
+        std::vector<T> dense;
+        std::vector<I> hashKeys;
+        std::vector<T> hashValues;
+        std::vector<I> keys;
+    };
+
+    /**
+     * Merge outer index i of C with flops multiply-adds and return its number of nonzeros.
+     * Numeric: nnz is the result of the symbolic phase, the sorted keys and values are written.
+     */
+    template <bool Numeric, class TL, class TR, class I, class TC>
+    static size_t mergeRow(size_t i, size_t flops, size_t nnz, size_t nbInner, TC alpha,
+        TL const* valueL, I const* keyL, I const* offsetL,
+        TR const* valueR, I const* keyR, I const* offsetR,
+        Accumulator<I>& accumulator, TC* valueC, I* keyC);
+
+};
+
+template <class T>
+template <class TA, class I, class TB, class TC>
+void SparseKernel<T>::csr(size_t m, size_t k, TC alpha,
+    TA const* value, I const* key, I const* offset,
+    TB const* b, size_t rsB, size_t csB,
+    TC beta, TC* c, size_t rsC, size_t csC,
+    WorkStealingScheduler const& scheduler)
+{
+    if (m == 0 or k == 0) return;
+
+    const size_t nnz = offset[m] - offset[0];
+    auto bounds = partition(offset, m, getNbParts((nnz + m) * k, scheduler));
+
+    scheduler.run(bounds.size() - 1,
+        [&](size_t p) {
+            csrRows(bounds[p], bounds[p + 1], k, alpha, value, key, offset, b, rsB, csB, beta, c, rsC, csC);
+        },
+        [&](size_t p) {
+            return static_cast<double>(offset[bounds[p + 1]] - offset[bounds[p]] + bounds[p + 1] - bounds[p]);
+        });
+}
+
+template <class T>
+template <class TA, class I, class TB, class TC>
+void SparseKernel<T>::csc(size_t m, size_t n, size_t k, TC alpha,
+    TA const* value, I const* key, I const* offset,
+    TB const* b, size_t rsB, size_t csB,
+    TC beta, TC* c, size_t rsC, size_t csC,
+    WorkStealingScheduler const& scheduler)
+{
+    if (m == 0 or k == 0) return;
+
+    const size_t nnz = offset[n] - offset[0];
+    const size_t nbParts = std::min(scheduler.getNbThreads(), getNbParts((nnz + n) * k, scheduler));
+
+    if (nbParts == 1) {
+        scale(0, m, 0, k, beta, c, rsC, csC);
+        cscColumns(0, n, 0, k, alpha, value, key, offset, b, rsB, csB, c, rsC, csC);
+        return;
+    }
+
+    // Disjoint slices of right-hand sides, multiples of the SIMD width
+    if (k >= nbParts * simdSize) {
+        const size_t sliceSize = (k / simdSize + nbParts - 1) / nbParts * simdSize;
+        scheduler.run((k + sliceSize - 1) / sliceSize, [&](size_t p) {
+            const size_t j0 = p * sliceSize, j1 = std::min(k, j0 + sliceSize);
+            scale(0, m, j0, j1, beta, c, rsC, csC);
+            cscColumns(0, n, j0, j1, alpha, value, key, offset, b, rsB, csB, c, rsC, csC);
+        });
+        return;
+    }
+
+    // Private row-major buffers for parts of the columns of A
+    auto bounds = partition(offset, n, std::min(nbParts, maxBufferRatio * (nnz + m * k) / (m * k)));
+    const size_t nbBuffers = bounds.size() - 1;
+    Storage<TC,false,false,0> buffers(nbBuffers * m * k);
+
+    scheduler.run(nbBuffers, [&](size_t p) {
+        TC* buffer = buffers.getDataPointer() + p * m * k;
+        std::fill(buffer, buffer + m * k, TC(0));
+        cscColumns(bounds[p], bounds[p + 1], 0, k, TC(1), value, key, offset, b, rsB, csB, buffer, k, 1);
+    });
+
+    auto rowBounds = partition(static_cast<I const*>(nullptr), m, nbParts);
+    scheduler.run(rowBounds.size() - 1, [&](size_t p) {
+        scale(rowBounds[p], rowBounds[p + 1], 0, k, beta, c, rsC, csC);
+        for (size_t q = 0; q != nbBuffers; ++q) {
+            TC const* buffer = buffers.getDataPointer() + q * m * k;
+            for (size_t i = rowBounds[p]; i != rowBounds[p + 1]; ++i)
+                for (size_t j = 0; j != k; ++j) c[i * rsC + j * csC] += alpha * buffer[i * k + j];
+        }
+    });
+}
+
+template <class T>
+template <class TL, class TR, class I, class TC, class Allocate>
+void SparseKernel<T>::spgemm(size_t nbOuter, size_t nbInner, TC alpha,
+    TL const* valueL, I const* keyL, I const* offsetL,
+    TR const* valueR, I const* keyR, I const* offsetR,
+    Allocate const& allocate, WorkStealingScheduler const& scheduler)
+{
+    // Upper bound of the nonzeros per outer index, its prefix sum is the work for the partitioning
+    std::vector<size_t> flops(nbOuter + 1);
+    flops[0] = 0;
+    for (size_t i = 0; i != nbOuter; ++i) {
+        size_t sum = 0;
+        for (size_t e = offsetL[i]; e != offsetL[i + 1]; ++e) sum += offsetR[keyL[e] + 1] - offsetR[keyL[e]];
+        flops[i + 1] = flops[i] + sum;
+    }
+
+    auto bounds = partition(flops.data(), nbOuter, getNbParts(flops[nbOuter] + nbOuter, scheduler));
+    const size_t nbParts = bounds.size() - 1;
+    auto cost = [&](size_t p) { return static_cast<double>(flops[bounds[p + 1]] - flops[bounds[p]] + bounds[p + 1] - bounds[p]); };
+
+    // Symbolic phase, the counts are stored shifted by one for the prefix sum
+    std::vector<size_t> nnz(nbOuter + 1);
+    nnz[0] = 0;
+    scheduler.run(nbParts, [&](size_t p) {
+        Accumulator<I> accumulator;
+        for (size_t i = bounds[p]; i != bounds[p + 1]; ++i)
+            nnz[i + 1] = mergeRow<false>(i, flops[i + 1] - flops[i], 0, nbInner, alpha,
+                valueL, keyL, offsetL, valueR, keyR, offsetR, accumulator, static_cast<TC*>(nullptr), static_cast<I*>(nullptr));
+    }, cost);
+    for (size_t i = 0; i != nbOuter; ++i) nnz[i + 1] += nnz[i];
+
+    auto [valueC, keyC, offsetC] = allocate(nnz[nbOuter]);
+    for (size_t i = 0; i <= nbOuter; ++i) offsetC[i] = nnz[i];
+
+    // Numeric phase into the exactly sized arrays
+    scheduler.run(nbParts, [&](size_t p) {
+        Accumulator<I> accumulator;
+        for (size_t i = bounds[p]; i != bounds[p + 1]; ++i)
+            mergeRow<true>(i, flops[i + 1] - flops[i], nnz[i + 1] - nnz[i], nbInner, alpha,
+                valueL, keyL, offsetL, valueR, keyR, offsetR, accumulator, valueC + nnz[i], keyC + nnz[i]);
+    }, cost);
+}
+
+template <class T>
+template <bool Numeric, class TL, class TR, class I, class TC>
+size_t SparseKernel<T>::mergeRow(size_t i, size_t flops, size_t nnz, size_t nbInner, TC alpha,
+    TL const* valueL, I const* keyL, I const* offsetL,
+    TR const* valueR, I const* keyR, I const* offsetR,
+    Accumulator<I>& accumulator, TC* valueC, I* keyC)
+{
+    if (flops == 0) return 0;
+
+    auto& keys = accumulator.keys;
+    keys.clear();
+
+    if (flops * denseRatio >= nbInner) {
+        // Dense accumulator, the marker of an inner index is the outer index plus one
+        auto& marker = accumulator.marker;
+        auto& dense = accumulator.dense;
+        if (marker.empty()) marker.assign(nbInner, I(0));
+        if (Numeric and dense.empty()) dense.assign(nbInner, T(0));
+        const I mark = static_cast<I>(i + 1);
+
+        if (!Numeric) {
+            size_t count = 0;
+            for (size_t e = offsetL[i]; e != offsetL[i + 1]; ++e) {
+                const size_t k = keyL[e];
+                for (size_t f = offsetR[k]; f != offsetR[k + 1]; ++f) {
+                    count += marker[keyR[f]] != mark;
+                    marker[keyR[f]] = mark;
+                }
+            }
+            return count;
+        }
+
+        // Rows with many nonzeros are collected by a scan of the markers, the others by sorting their keys
+        const bool scan = nnz * denseRatio >= nbInner;
+        for (size_t e = offsetL[i]; e != offsetL[i + 1]; ++e) {
+            const size_t k = keyL[e];
+            const T a = static_cast<T>(valueL[e]);
+            for (size_t f = offsetR[k]; f != offsetR[k + 1]; ++f) {
+                const I j = keyR[f];
+                dense[j] += a * static_cast<T>(valueR[f]);
+                if (!scan and marker[j] != mark) keys.push_back(j);
+                marker[j] = mark;
+            }
+        }
+
+        // The dense accumulator is reset to zero while reading
+        if (scan) {
+            size_t n = 0, j = 0;
+            // Branch-free while at least two nonzeros are left, the store of a miss is overwritten
+            for (; n + 1 < nnz; ++j) {
+                keyC[n] = static_cast<I>(j);
+                valueC[n] = alpha * static_cast<TC>(dense[j]);
+                dense[j] = T(0);
+                n += marker[j] == mark;
+            }
+            for (; n != nnz; ++j) {
+                if (marker[j] == mark) {
+                    keyC[n] = static_cast<I>(j);
+                    valueC[n++] = alpha * static_cast<TC>(dense[j]);
+                    dense[j] = T(0);
+                }
+            }
+        } else {
+            std::sort(keys.begin(), keys.end());
+            for (size_t n = 0; n != nnz; ++n) {
+                keyC[n] = keys[n];
+                valueC[n] = alpha * static_cast<TC>(dense[keys[n]]);
+                dense[keys[n]] = T(0);
+            }
+        }
+        return nnz;
+    }
+
+    // Hash table with linear probing and a load factor of at most one half
+    size_t size = 16, shift = 60;
+    for (; size < 2 * flops; size *= 2) --shift;
+    const size_t mask = size - 1;
+    const I empty = static_cast<I>(-1);
+
+    auto& hashKeys = accumulator.hashKeys;
+    auto& hashValues = accumulator.hashValues;
+    if (hashKeys.size() < size) {
+        hashKeys.resize(size);
+        if (Numeric) hashValues.resize(size);
+    }
+    std::fill(hashKeys.begin(), hashKeys.begin() + size, empty);
+
+    auto find = [&](I j) {
+        // Fibonacci hashing, the high bits of the product are the slot
+        size_t h = static_cast<size_t>((static_cast<uint64_t>(j) * 0x9E3779B97F4A7C15ull) >> shift);
+        while (hashKeys[h] != j and hashKeys[h] != empty) h = (h + 1) & mask;
+        return h;
+    };
+
+    for (size_t e = offsetL[i]; e != offsetL[i + 1]; ++e) {
+        const size_t k = keyL[e];
+        const T a = static_cast<T>(valueL[e]);
+        for (size_t f = offsetR[k]; f != offsetR[k + 1]; ++f) {
+            const I j = keyR[f];
+            const size_t h = find(j);
+            if (hashKeys[h] == empty) {
+                hashKeys[h] = j;
+                keys.push_back(j);
+                if (Numeric) hashValues[h] = a * static_cast<T>(valueR[f]);
+            } else if (Numeric) {
+                hashValues[h] += a * static_cast<T>(valueR[f]);
+            }
+        }
+    }
+
+    if (Numeric) {
+        std::sort(keys.begin(), keys.end());
+        for (size_t n = 0; n != keys.size(); ++n) {
+            keyC[n] = keys[n];
+            valueC[n] = alpha * static_cast<TC>(hashValues[find(keys[n])]);
+        }
+    }
+    return keys.size();
+}
+
+template <class T>
+template <class I>
+std::vector<size_t> SparseKernel<T>::partition(I const* offset, size_t nbOuter, size_t nbParts)
+{
+    // Without offsets all outer indices have the same weight
+    auto weight = [&](size_t outer) { return outer + (offset ? static_cast<size_t>(offset[outer] - offset[0]) : 0); };
+
+    std::vector<size_t> bounds{0};
+    const size_t total = weight(nbOuter);
+    for (size_t p = 1; p < nbParts; ++p) {
+        const size_t target = total / nbParts * p + total % nbParts * p / nbParts;
+        // First outer index with a weight not less than target, weight is strictly increasing
+        size_t first = bounds.back(), last = nbOuter;
+        while (first < last) {
+            size_t middle = first + (last - first) / 2;
+            if (weight(middle) < target) first = middle + 1;
+            else last = middle;
+        }
+        if (first > bounds.back() and first < nbOuter) bounds.push_back(first);
+    }
+    bounds.push_back(nbOuter);
+    return bounds;
+}
+
+template <class T>
+template <class U>
+typename SparseKernel<T>::batch SparseKernel<T>::load(U const* p)
+{
+    if constexpr (std::is_same<U,T>::value) {
+        return batch::load_unaligned(p);
+    } else {
+        alignas(64) T buffer[simdSize];
+        for (size_t i = 0; i != simdSize; ++i) buffer[i] = static_cast<T>(p[i]);
+        return batch::load_aligned(buffer);
+    }
+}
+
+template <class T>
+template <class U>
+void SparseKernel<T>::store(batch const& x, U* p)
+{
+    if constexpr (std::is_same<U,T>::value) {
+        x.store_unaligned(p);
+    } else {
+        alignas(64) T buffer[simdSize];
+        x.store_aligned(buffer);
+        for (size_t i = 0; i != simdSize; ++i) p[i] = static_cast<U>(buffer[i]);
+    }
+}
+
+template <class T>
+template <class U, class I>
+typename SparseKernel<T>::batch SparseKernel<T>::gather(U const* x, I const* index)
+{
+    if constexpr (std::is_same<U,T>::value and std::is_integral<I>::value and sizeof(I) == sizeof(T)) {
+        return batch::gather(x, xsimd::batch<I>::load_unaligned(index));
+    } else {
+        alignas(64) T buffer[simdSize];
+        for (size_t i = 0; i != simdSize; ++i) buffer[i] = static_cast<T>(x[index[i]]);
+        return batch::load_aligned(buffer);
+    }
+}
+
+template <class T>
+template <class TA, class I, class TB, class TC>
+void SparseKernel<T>::csrRows(size_t begin, size_t end, size_t k, TC alpha,
+    TA const* value, I const* key, I const* offset,
+    TB const* b, size_t rsB, size_t csB,
+    TC beta, TC* c, size_t rsC, size_t csC)
+{
+    auto update = [&](TC& y, T sum) { y = beta == TC(0) ? alpha * static_cast<TC>(sum) : alpha * static_cast<TC>(sum) + beta * y; };
+
+    if (k > 1 and csB == 1 and csC == 1) {
+        for (size_t i = begin; i != end; ++i) {
+            const size_t e0 = offset[i], e1 = offset[i + 1];
+            TC* row = c + i * rsC;
+            size_t j = 0;
+            for (; j + 4 * simdSize <= k; j += 4 * simdSize)
+                rowTimesRows<4>(e0, e1, static_cast<T>(alpha), value, key, b + j, rsB, static_cast<T>(beta), row + j);
+            for (; j + simdSize <= k; j += simdSize)
+                rowTimesRows<1>(e0, e1, static_cast<T>(alpha), value, key, b + j, rsB, static_cast<T>(beta), row + j);
+            for (; j != k; ++j) {
+                T sum(0);
+                for (size_t e = e0; e != e1; ++e) sum += static_cast<T>(value[e]) * static_cast<T>(b[key[e] * rsB + j]);
+                update(row[j], sum);
+            }
+        }
+        return;
+    }
+    if (rsB == 1) {
+        for (size_t j = 0; j != k; ++j) {
+            TB const* x = b + j * csB;
+            for (size_t i = begin; i != end; ++i) {
+                const size_t e0 = offset[i], e1 = offset[i + 1];
+                size_t e = e0;
+                batch sum(T(0));
+                for (; e + simdSize <= e1; e += simdSize)
+                    sum = xsimd::fma(load(value + e), gather(x, key + e), sum);
+                T result = xsimd::reduce_add(sum);
+                for (; e != e1; ++e) result += static_cast<T>(value[e]) * static_cast<T>(x[key[e]]);
+                update(c[i * rsC + j * csC], result);
+            }
+        }
+        return;
+    }
+
+    for (size_t j = 0; j != k; ++j) {
+        for (size_t i = begin; i != end; ++i) {
+            T sum(0);
+            for (size_t e = offset[i]; e != offset[i + 1]; ++e)
+                sum += static_cast<T>(value[e]) * static_cast<T>(b[key[e] * rsB + j * csB]);
+            update(c[i * rsC + j * csC], sum);
+        }
+    }
+}
+
+template <class T>
+template <size_t N, class TA, class I, class TB, class TC>
+void SparseKernel<T>::rowTimesRows(size_t begin, size_t end, T alpha, TA const* value, I const* key,
+    TB const* b, size_t ldb, T beta, TC* c)
+{
+    batch sum[N];
+    for (size_t v = 0; v != N; ++v) sum[v] = batch(T(0));
+
+    for (size_t e = begin; e != end; ++e) {
+        batch a(static_cast<T>(value[e]));
+        TB const* row = b + key[e] * ldb;
+        for (size_t v = 0; v != N; ++v) sum[v] = xsimd::fma(a, load(row + v * simdSize), sum[v]);
+    }
+
+    for (size_t v = 0; v != N; ++v) {
+        batch result = batch(alpha) * sum[v];
+        if (beta != T(0)) result = xsimd::fma(batch(beta), load(c + v * simdSize), result);
+        store(result, c + v * simdSize);
+    }
+}
+
+template <class T>
+template <class TA, class I, class TB, class TC>
+void SparseKernel<T>::cscColumns(size_t begin, size_t end, size_t j0, size_t j1, TC alpha,
+    TA const* value, I const* key, I const* offset,
+    TB const* b, size_t rsB, size_t csB,
+    TC* c, size_t rsC, size_t csC)
+{
+    if (csB == 1 and csC == 1) {
+        for (size_t l = begin; l != end; ++l) {
+            TB const* rowB = b + l * rsB;
+            for (size_t e = offset[l]; e != offset[l + 1]; ++e) {
+                const T scalar = static_cast<T>(alpha) * static_cast<T>(value[e]);
+                batch a(scalar);
+                TC* rowC = c + key[e] * rsC;
+                size_t j = j0;
+                for (; j + simdSize <= j1; j += simdSize) store(xsimd::fma(a, load(rowB + j), load(rowC + j)), rowC + j);
+                for (; j != j1; ++j) rowC[j] = static_cast<TC>(static_cast<T>(rowC[j]) + scalar * static_cast<T>(rowB[j]));
+            }
+        }
+        return;
+    }
+
+    for (size_t j = j0; j != j1; ++j) {
+        for (size_t l = begin; l != end; ++l) {
+            const T x = static_cast<T>(b[l * rsB + j * csB]);
+            for (size_t e = offset[l]; e != offset[l + 1]; ++e)
+                c[key[e] * rsC + j * csC] += alpha * static_cast<TC>(static_cast<T>(value[e]) * x);
+        }
+    }
+}
+
+template <class T>
+template <class TC>
+void SparseKernel<T>::scale(size_t i0, size_t i1, size_t j0, size_t j1, TC beta, TC* c, size_t rsC, size_t csC)
+{
+    if (beta == TC(1)) return;
+    for (size_t i = i0; i != i1; ++i)
+        for (size_t j = j0; j != j1; ++j) {
+            TC& y = c[i * rsC + j * csC];
+            y = beta == TC(0) ? TC(0) : beta * y;
+        }
+}
+
+} // namespace BlasBooster
@@ -4,6 +4,7 @@
 #include "DynamicMatrixTypeList.h"
 #include "Matrix.h"
 #include "MatrixBase.h"
+#include "NormPolicy.h"
 #include "Storage.h"
 #include "TypeName.h"
 #include "Utilities.h"
@@ -25,8 +26,8 @@ template <class T, class P>
 class Matrix<Sparse,T,P>
  : public MatrixBase,
    public P::dimension,
-   public SparseStorage<T,typename P::IndexType,P::dimension::fixed,P::dimension::size>//,
-//    public NormPolicy<Matrix<Sparse,T,P>, typename P::NormType>,
+   public SparseStorage<T,typename P::IndexType,P::dimension::fixed,P::dimension::size,typename P::AllocatorType>,
+   public NormPolicy<Matrix<Sparse,T,P>, typename P::NormType>//,
 //    public OccupationPolicy<Matrix<Sparse,T,P>>
 {
 public: // typedefs
@@ -38,10 +39,12 @@ public: // typedefs
     typedef const T* const_pointer;
     typedef P parameter;
     typedef typename P::dimension dimension;
+    typedef typename P::orientation orientation;
     typedef typename P::leadingDimension leadingDimension;
     typedef typename P::unblockedDimension unblockedDimension;
     typedef typename P::IndexType IndexType;
-    typedef SparseStorage<T,typename P::IndexType,P::dimension::fixed,P::dimension::size> storage;
+    typedef SparseStorage<T,typename P::IndexType,P::dimension::fixed,P::dimension::size,typename P::AllocatorType> storage;
+    typedef NormPolicy<self, typename P::NormType> norm_policy;
     typedef typename storage::iterator iterator;
     typedef typename storage::const_iterator const_iterator;
     typedef typename storage::index_iterator index_iterator;
@@ -53,8 +56,19 @@ public:
     Matrix();
 
     /// Parameter constructor
-    /// If nbSignificantElements equal zero, storage of size nbRows*nbColumns will be allocated.
-    Matrix(IndexType nbRows, IndexType nbColumns, IndexType nbSignificantElements = 0, auto const& filler = [](){});
+    /// Storage for exactly nbSignificantElements elements is allocated, the offsets are zero.
+    Matrix(IndexType nbRows, IndexType nbColumns, IndexType nbSignificantElements = 0);
+
+    /// Parameter constructor, the storage will be filled by filler(*this).
+    Matrix(IndexType nbRows, IndexType nbColumns, IndexType nbSignificantElements, auto const& filler);
+
+    /// Parameter constructor taking over the value, key and offset arrays without copying
+    Matrix(IndexType nbRows, IndexType nbColumns, typename storage::value_storage&& values,
+        typename storage::index_storage&& keys, typename storage::index_storage&& offsets);
+
+    /// Parameter constructor using external memory of the value, key and offset arrays
+    Matrix(IndexType nbRows, IndexType nbColumns, IndexType nbSignificantElements,
+        T* values, IndexType* keys, IndexType* offsets);
 
     /// Conversion from SparseMatrix
     template <class T2, class P2>
@@ -66,6 +80,11 @@ public:
     template <class T2, class P2>
     Matrix(Matrix<Dense,T2,P2> const& other, auto const& checker);
 
+    /// Conversion from BlockSparseMatrix
+    /// Elements of the tiles passing checker are stored.
+    template <size_t TileSize, class T2, class P2>
+    Matrix(Matrix<BlockSparse<TileSize>,T2,P2> const& other, auto const& checker);
+
     /// Conversion from DynamicMatrix
     Matrix(DynamicMatrix const& dynMatrix, double threshold = 0.0);
 
@@ -79,7 +98,8 @@ public:
     /// Move constructor
     Matrix(Matrix&& rhs)
      : dimension(std::forward<dimension>(rhs)),
-       storage(std::forward<storage>(rhs))
+       storage(std::forward<storage>(rhs)),
+       norm_policy(rhs)
     {
         debug_print("SparseMatrix: Move constructor was called.");
     }
@@ -96,12 +116,13 @@ public:
         debug_print("SparseMatrix: Move assignment operator was called.");
         dimension::operator=(std::forward<dimension>(rhs));
         storage::operator=(std::forward<storage>(rhs));
+        norm_policy::operator=(rhs);
         return *this;
     }
 
     //MatrixBase* clone() const { return new self(*this); }
 
-    /// If nbSignificantElements equal zero, storage of size nbRows*nbColumns will be allocated.
+    /// Storage for exactly nbSignificantElements elements is allocated, the offsets are zero.
     void resize(IndexType nbRows, IndexType nbColumns, IndexType nbSignificantElements = 0);
 
     bool operator == (Matrix const& rhs) const {
@@ -112,8 +133,12 @@ public:
 
     size_t getTypeIndex() const { return typeIndex_; }
 
+    double getNorm() const { return this->norm(); }
+
     friend void swap(Matrix& a, Matrix& b) noexcept {
         using std::swap; // bring in swap for built-in types
+        a.invalidateNorm();
+        b.invalidateNorm();
         swap(a.value_,b.value_);
         swap(a.key_,b.key_);
         swap(a.offset_,b.offset_);
@@ -121,7 +146,7 @@ public:
         swap(a.nbColumns_,b.nbColumns_);
     }
 
-    static const size_t typeIndex_ = GetIndex<self, DynamicMatrixTypeList>::value;
+    static constexpr size_t typeIndex_ = GetIndex<self, DynamicMatrixTypeList>::value;
 
     static const std::string name() { return "Matrix<Sparse," + TypeName<T>::value() + ">"; }
 
@@ -140,16 +165,45 @@ Matrix<Sparse,T,P>::Matrix()
  : dimension(), storage()
 {}
 
+template <class T, class P>
+Matrix<Sparse,T,P>::Matrix(typename P::IndexType nbRows, typename P::IndexType nbColumns,
+    typename P::IndexType nbSignificantElements)
+ : dimension(nbRows, nbColumns),
+   storage(nbSignificantElements, this->getMinorDimension() + 1)
+{
+    std::fill(this->beginOffset(), this->endOffset(), IndexType(0));
+}
+
 template <class T, class P>
 template <class Filler>
 Matrix<Sparse,T,P>::Matrix(typename P::IndexType nbRows, typename P::IndexType nbColumns,
     typename P::IndexType nbSignificantElements, Filler const& filler)
  : dimension(nbRows, nbColumns),
-   storage(nbSignificantElements ? nbSignificantElements : nbRows*nbColumns, nbColumns + 1)
+   storage(nbSignificantElements, this->getMinorDimension() + 1)
 {
     filler(*this);
 }
 
+template <class T, class P>
+Matrix<Sparse,T,P>::Matrix(typename P::IndexType nbRows, typename P::IndexType nbColumns,
+    typename storage::value_storage&& values, typename storage::index_storage&& keys,
+    typename storage::index_storage&& offsets)
+ : dimension(nbRows, nbColumns),
+   storage(std::move(values), std::move(keys), std::move(offsets))
+{
+    if (this->sizeOffset() != this->getMinorDimension() + 1)
+        throw std::runtime_error("SparseMatrix: wrong number of offsets.");
+    if (this->key_.size() != this->value_.size())
+        throw std::runtime_error("SparseMatrix: number of keys and values differ.");
+}
+
+template <class T, class P>
+Matrix<Sparse,T,P>::Matrix(typename P::IndexType nbRows, typename P::IndexType nbColumns,
+    typename P::IndexType nbSignificantElements, T* values, typename P::IndexType* keys, typename P::IndexType* offsets)
+ : dimension(nbRows, nbColumns),
+   storage(values, keys, offsets, nbSignificantElements, this->getMinorDimension() + 1)
+{}
+
 // Conversion from SparseMatrix
 template <class T, class P>
 template <class T2, class P2, class ValueChecker>
@@ -158,48 +212,65 @@ Matrix<Sparse,T,P>::Matrix(Matrix<Sparse,T2,P2> const& other, ValueChecker const
    storage(std::is_same<typename P::orientation, typename P2::orientation>::value ? other : transpose(other))
 {}
 
-// // Conversion from DenseMatrix
-// template <class T, class P>
-// template <class T2, class P2, class ValueChecker>
-// Matrix<Sparse,T,P>::Matrix(Matrix<Dense,T2,P2> const& other, ValueChecker const& valueChecker)
-//  : dimension(other.getNbRows(), other.getNbColumns()),
-//    storage(other.getNbOfSignificantElements(valueChecker), this->getMinorDimension() + 1)
-// {
-//     iterator iterValueCur(this->begin());
-//     index_iterator iterKeyCur(this->beginKey());
-//     index_iterator iterOffsetCur(this->beginOffset());
-
-//     typename P::IndexType key, offset(0);
-
-//     typedef typename std::conditional<
-//         std::is_same<typename P::orientation, typename P2::orientation>::value,
-//         Cursor<const Matrix<Dense,T2,P2>, Direction::Column>,
-//         Cursor<const Matrix<Dense,T2,P2>, Direction::Row>
-//     >::type OuterCursor;
-
-//     typedef typename std::conditional<
-//         std::is_same<typename OuterCursor::direction, Direction::Column>::value,
-//         Cursor<OuterCursor, Direction::Row>,
-//         Cursor<OuterCursor, Direction::Column>
-//     >::type InnerCursor;
-
-//     for (OuterCursor outerCur(other, 0), outerEnd(other, this->getMinorDimension());
-//         outerCur != outerEnd; ++outerCur)
-//     {
-//         *iterOffsetCur++ = offset;
-//         key = 0;
-//         for (InnerCursor innerCur(other,outerCur.begin()), innerEnd(other,outerCur.end());
-//             innerCur != innerEnd; ++innerCur, ++key)
-//         {
-//             if (valueChecker(*innerCur)) {
-//                 *iterValueCur++ = *innerCur;
-//                 *iterKeyCur++ = key;
-//                 ++offset;
-//             }
-//         }
-//     }
-//     *iterOffsetCur++ = offset;
-// }
+// Conversion from DenseMatrix
+template <class T, class P>
+template <class T2, class P2, class ValueChecker>
+Matrix<Sparse,T,P>::Matrix(Matrix<Dense,T2,P2> const& other, ValueChecker const& valueChecker)
+ : dimension(other.getNbRows(), other.getNbColumns()),
+   storage(other.getNbOfSignificantElements(valueChecker), this->getMinorDimension() + 1)
+{
+    iterator iterValueCur(this->begin());
+    index_iterator iterKeyCur(this->beginKey());
+    index_iterator iterOffsetCur(this->beginOffset());
+
+    const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+    typename P::IndexType offset(0);
+
+    for (typename P::IndexType outer(0); outer != this->getMinorDimension(); ++outer)
+    {
+        *iterOffsetCur++ = offset;
+        for (typename P::IndexType key(0); key != this->getMajorDimension(); ++key)
+        {
+            T2 const& value = columnMajor ? other(key, outer) : other(outer, key);
+            if (valueChecker(value)) {
+                *iterValueCur++ = value;
+                *iterKeyCur++ = key;
+                ++offset;
+            }
+        }
+    }
+    *iterOffsetCur = offset;
+}
+
+// Conversion from BlockSparseMatrix
+template <class T, class P>
+template <size_t TileSize, class T2, class P2, class ValueChecker>
+Matrix<Sparse,T,P>::Matrix(Matrix<BlockSparse<TileSize>,T2,P2> const& other, ValueChecker const& valueChecker)
+ : dimension(other.getNbRows(), other.getNbColumns()),
+   storage(0, this->getMinorDimension() + 1)
+{
+    const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+    const size_t nbOuter = this->getMinorDimension();
+
+    // Counting pass, the elements of each line are visited with ascending keys
+    IndexType* offset = this->beginOffset().base();
+    std::fill(offset, offset + nbOuter + 1, IndexType(0));
+    other.forEachElement([&](size_t i, size_t j, T2 const& value) {
+        if (valueChecker(value)) ++offset[(columnMajor ? j : i) + 1];
+    });
+    for (size_t outer = 0; outer != nbOuter; ++outer) offset[outer + 1] += offset[outer];
+
+    this->value_.resize(offset[nbOuter]);
+    this->key_.resize(offset[nbOuter]);
+    std::vector<IndexType> cursor(offset, offset + nbOuter);
+    other.forEachElement([&](size_t i, size_t j, T2 const& value) {
+        if (!valueChecker(value)) return;
+        IndexType& position = cursor[columnMajor ? j : i];
+        this->value_.getDataPointer()[position] = value;
+        this->key_.getDataPointer()[position] = columnMajor ? i : j;
+        ++position;
+    });
+}
 
 template <class M>
 struct ConvertToSparseMatrix
@@ -244,7 +315,9 @@ void Matrix<Sparse,T,P>::resize(typename P::IndexType nbRows, typename P::IndexT
     this->nbRows_ = nbRows;
     this->nbColumns_ = nbColumns;
     this->full_size_ = nbRows * nbColumns;
-    static_cast<storage*>(this)->resize(nbSignificantElements ? nbSignificantElements : nbRows*nbColumns, nbColumns + 1);
+    static_cast<storage*>(this)->resize(nbSignificantElements, this->getMinorDimension() + 1);
+    std::fill(this->beginOffset(), this->endOffset(), IndexType(0));
+    this->invalidateNorm();
 }
 
 } // namespace BlasBooster
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "Memory.h"
+#include "MultiplicationFunctor.h"
+#include "SparseKernel.h"
+#include "SparseMatrix.h"
+#include "WorkStealingScheduler.h"
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace BlasBooster {
+
+/**
+ * \brief Raw view on the three arrays of a sparse matrix.
+ *
+ * ColumnMajor: outer index is the column, key is the row (CSC).
+ * RowMajor: outer index is the row, key is the column (CSR).
+ */
+template <class T, class P>
+struct SparseView
+{
+    typedef typename P::IndexType IndexType;
+
+    static const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+
+    SparseView(Matrix<Sparse,T,P> const& A)
+     : value(A.begin().base()), key(A.beginKey().base()), offset(A.beginOffset().base()),
+       nbOuter(A.getMinorDimension())
+    {}
+
+    T const* value;
+    IndexType const* key;
+    IndexType const* offset;
+    size_t nbOuter;
+};
+
+/**
+ * \brief Multithreaded C = alpha * A * B + beta * C of a sparse and a dense matrix.
+ *
+ * The rows (CSR) or columns (CSC) of A are distributed by their numbers of
+ * nonzeros, see SparseKernel. Multiple right-hand sides should be stored
+ * RowMajor in B and C, so that the rows of B are loaded contiguously.
+ * The product is computed in the widest value type, e.g. float operands
+ * of a double C are widened in the kernel.
+ */
+template <class T1, class P1, class T2, class P2, class T3, class P3>
+void multiplySparseDense(Matrix<Sparse,T1,P1> const& A, Matrix<Dense,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+    T3 alpha = 1, T3 beta = 0, WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+{
+    typedef typename std::common_type<T1,T2,T3>::type compute_type;
+
+    if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+        throw std::runtime_error("multiplySparseDense: dimension mismatch.");
+
+    SparseView<T1,P1> a(A);
+    if constexpr (SparseView<T1,P1>::columnMajor) {
+        SparseKernel<compute_type>::csc(A.getNbRows(), A.getNbColumns(), B.getNbColumns(), alpha,
+            a.value, a.key, a.offset, B.getDataPointer(), getRowStride(B), getColumnStride(B),
+            beta, C.getDataPointer(), getRowStride(C), getColumnStride(C), scheduler);
+    } else {
+        SparseKernel<compute_type>::csr(A.getNbRows(), B.getNbColumns(), alpha,
+            a.value, a.key, a.offset, B.getDataPointer(), getRowStride(B), getColumnStride(B),
+            beta, C.getDataPointer(), getRowStride(C), getColumnStride(C), scheduler);
+    }
+}
+
+/**
+ * \brief Native multiplication of a sparse and a dense matrix.
+ *
+ * Single-threaded, because the blocks of a DynamicMatrix are already
+ * multiplied in parallel. Use multiplySparseDense for large matrices.
+ */
+template <class T1, class P1, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Sparse, T1, P1, Dense, T2, P2, Dense, T3, P3, Native>
+{
+    void operator () (Matrix<Sparse,T1,P1> const& A, Matrix<Dense,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Sparse,Dense,Dense,Native>: dimension mismatch.");
+
+        multiplySparseDense(A, B, C, alpha, beta, WorkStealingScheduler(1));
+    }
+};
+
+/**
+ * \brief Native multiplication of a dense and a sparse matrix.
+ *
+ * Reference implementation, each non-zero B_kj adds a scaled column of A to column j of C.
+ */
+template <class T1, class P1, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Dense, T1, P1, Sparse, T2, P2, Dense, T3, P3, Native>
+{
+    void operator () (Matrix<Dense,T1,P1> const& A, Matrix<Sparse,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Dense,Sparse,Dense,Native>: dimension mismatch.");
+
+        scale(C, beta);
+
+        SparseView<T2,P2> b(B);
+        T1 const* a = A.getDataPointer();
+        T3* c = C.getDataPointer();
+        const size_t rsA = getRowStride(A), csA = getColumnStride(A);
+        const size_t rsC = getRowStride(C), csC = getColumnStride(C);
+        const size_t m = A.getNbRows();
+
+        for (size_t outer = 0; outer != b.nbOuter; ++outer) {
+            for (size_t e = b.offset[outer]; e != b.offset[outer + 1]; ++e) {
+                size_t k = b.columnMajor ? b.key[e] : outer;
+                size_t j = b.columnMajor ? outer : b.key[e];
+                T3 value = alpha * static_cast<T3>(b.value[e]);
+                for (size_t i = 0; i != m; ++i) c[i * rsC + j * csC] += value * a[i * rsA + k * csA];
+            }
+        }
+    }
+};
+
+/**
+ * \brief Native multiplication of two sparse matrices into a dense matrix.
+ *
+ * Reference implementation for all four combinations of CSR and CSC.
+ */
+template <class T1, class P1, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Sparse, T1, P1, Sparse, T2, P2, Dense, T3, P3, Native>
+{
+    void operator () (Matrix<Sparse,T1,P1> const& A, Matrix<Sparse,T2,P2> const& B, Matrix<Dense,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (A.getNbColumns() != B.getNbRows() or A.getNbRows() != C.getNbRows() or B.getNbColumns() != C.getNbColumns())
+            throw std::runtime_error("MultiplicationFunctor<Sparse,Sparse,Dense,Native>: dimension mismatch.");
+
+        scale(C, beta);
+
+        SparseView<T1,P1> a(A);
+        SparseView<T2,P2> b(B);
+        T3* c = C.getDataPointer();
+        const size_t rsC = getRowStride(C), csC = getColumnStride(C);
+
+        if constexpr (SparseView<T1,P1>::columnMajor and SparseView<T2,P2>::columnMajor) {
+            // C(:,j) += A(:,k) * B(k,j)
+            for (size_t j = 0; j != b.nbOuter; ++j)
+                for (size_t eb = b.offset[j]; eb != b.offset[j + 1]; ++eb) {
+                    size_t k = b.key[eb];
+                    T3 value = alpha * static_cast<T3>(b.value[eb]);
+                    for (size_t ea = a.offset[k]; ea != a.offset[k + 1]; ++ea)
+                        c[a.key[ea] * rsC + j * csC] += static_cast<T3>(a.value[ea]) * value;
+                }
+        } else if constexpr (!SparseView<T1,P1>::columnMajor and !SparseView<T2,P2>::columnMajor) {
+            // C(i,:) += A(i,k) * B(k,:)
+            for (size_t i = 0; i != a.nbOuter; ++i)
+                for (size_t ea = a.offset[i]; ea != a.offset[i + 1]; ++ea) {
+                    size_t k = a.key[ea];
+                    T3 value = alpha * static_cast<T3>(a.value[ea]);
+                    for (size_t eb = b.offset[k]; eb != b.offset[k + 1]; ++eb)
+                        c[i * rsC + b.key[eb] * csC] += value * static_cast<T3>(b.value[eb]);
+                }
+        } else if constexpr (SparseView<T1,P1>::columnMajor) {
+            // C += A(:,k) * B(k,:), outer products
+            for (size_t k = 0; k != a.nbOuter; ++k)
+                for (size_t ea = a.offset[k]; ea != a.offset[k + 1]; ++ea) {
+                    T3 value = alpha * static_cast<T3>(a.value[ea]);
+                    for (size_t eb = b.offset[k]; eb != b.offset[k + 1]; ++eb)
+                        c[a.key[ea] * rsC + b.key[eb] * csC] += value * static_cast<T3>(b.value[eb]);
+                }
+        } else {
+            // C(i,j) += A(i,:) * B(:,j), row of A is scattered into a dense work vector
+            ArenaScope scope;
+            Storage<T3,false,false,0,false,ArenaAllocator> workStorage(A.getNbColumns());
+            workStorage.fill(T3(0));
+            T3* work = workStorage.getDataPointer();
+            for (size_t i = 0; i != a.nbOuter; ++i) {
+                if (a.offset[i] == a.offset[i + 1]) continue;
+                for (size_t ea = a.offset[i]; ea != a.offset[i + 1]; ++ea) work[a.key[ea]] = static_cast<T3>(a.value[ea]);
+                for (size_t j = 0; j != b.nbOuter; ++j) {
+                    T3 sum(0);
+                    for (size_t eb = b.offset[j]; eb != b.offset[j + 1]; ++eb) sum += work[b.key[eb]] * static_cast<T3>(b.value[eb]);
+                    c[i * rsC + j * csC] += alpha * sum;
+                }
+                for (size_t ea = a.offset[i]; ea != a.offset[i + 1]; ++ea) work[a.key[ea]] = T3(0);
+            }
+        }
+    }
+};
+
+/**
+ * \brief Multithreaded C = alpha * A * B of two sparse matrices into a sparse matrix.
+ *
+ * All three matrices must have the same orientation. A symbolic phase counts
+ * the nonzeros of each row (CSR) or column (CSC) of C, so that C is allocated
+ * with the exact number of elements before the numeric phase computes them.
+ * Each row is merged in a dense accumulator or a hash table depending on its
+ * number of multiply-adds, see SparseKernel::spgemm. Cancellations are kept
+ * as explicit zeros. C may be A or B, e.g. A = A x A, then the product is
+ * computed into a temporary, because C is reallocated while A and B are read.
+ */
+template <class T1, class P1, class T2, class P2, class T3, class P3>
+void multiplySparseSparse(Matrix<Sparse,T1,P1> const& A, Matrix<Sparse,T2,P2> const& B, Matrix<Sparse,T3,P3>& C,
+    T3 alpha = 1, WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+{
+    typedef typename std::common_type<T1,T2>::type compute_type;
+    typedef typename P3::IndexType IndexType;
+
+    static_assert(std::is_same<typename P1::orientation, typename P2::orientation>::value and
+        std::is_same<typename P1::orientation, typename P3::orientation>::value,
+        "multiplySparseSparse: all matrices must have the same orientation.");
+    static_assert(std::is_same<typename P1::IndexType, IndexType>::value and std::is_same<typename P2::IndexType, IndexType>::value,
+        "multiplySparseSparse: all matrices must have the same index type.");
+
+    if (A.getNbColumns() != B.getNbRows())
+        throw std::runtime_error("multiplySparseSparse: dimension mismatch.");
+
+    if (static_cast<void const*>(&C) == &A or static_cast<void const*>(&C) == &B) {
+        Matrix<Sparse,T3,P3> product;
+        multiplySparseSparse(A, B, product, alpha, scheduler);
+        C = std::move(product);
+        return;
+    }
+
+    auto allocate = [&](size_t nnz) {
+        C = Matrix<Sparse,T3,P3>(A.getNbRows(), B.getNbColumns(), nnz);
+        return std::make_tuple(C.begin().base(), C.beginKey().base(), C.beginOffset().base());
+    };
+
+    SparseView<T1,P1> a(A);
+    SparseView<T2,P2> b(B);
+    if constexpr (SparseView<T1,P1>::columnMajor) {
+        SparseKernel<compute_type>::spgemm(b.nbOuter, A.getNbRows(), alpha,
+            b.value, b.key, b.offset, a.value, a.key, a.offset, allocate, scheduler);
+    } else {
+        SparseKernel<compute_type>::spgemm(a.nbOuter, B.getNbColumns(), alpha,
+            a.value, a.key, a.offset, b.value, b.key, b.offset, allocate, scheduler);
+    }
+}
+
+/**
+ * \brief Native multiplication of two sparse matrices into a sparse matrix.
+ *
+ * C is replaced by the product, therefore beta must be zero. Single-threaded,
+ * use multiplySparseSparse for large matrices.
+ */
+template <class T1, class P1, class T2, class P2, class T3, class P3>
+struct MultiplicationFunctor<Sparse, T1, P1, Sparse, T2, P2, Sparse, T3, P3, Native>
+{
+    void operator () (Matrix<Sparse,T1,P1> const& A, Matrix<Sparse,T2,P2> const& B, Matrix<Sparse,T3,P3>& C,
+        T3 alpha = 1, T3 beta = 0) const
+    {
+        if (beta != T3(0))
+            throw std::runtime_error("MultiplicationFunctor<Sparse,Sparse,Sparse,Native>: beta must be zero.");
+
+        multiplySparseSparse(A, B, C, alpha, WorkStealingScheduler(1));
+    }
+};
+
+} // namespace BlasBooster
@@ -1,18 +1,19 @@
 #pragma once
 
 #include "Storage.h"
+#include <utility>
 
 namespace BlasBooster {
 
 /**
  * /brief Fixed size storage class for sparse arrays.
  */
-template <class ValueType, class IndexType, bool FixedSize, size_t Size>
+template <class ValueType, class IndexType, bool FixedSize, size_t Size, class Allocator = DefaultAllocator>
 class SparseStorage
 {
 public:
 
-    typedef SparseStorage<ValueType,IndexType,FixedSize,Size> self;
+    typedef SparseStorage<ValueType,IndexType,FixedSize,Size,Allocator> self;
     typedef ValueType* pointer;
     typedef const ValueType* const_pointer;
     typedef __gnu_cxx::__normal_iterator<pointer,self> iterator;
@@ -69,7 +70,7 @@ public:
 
 private:
 
-    template < class T2, class I2, bool F2, size_t S2 >
+    template < class T2, class I2, bool F2, size_t S2, class A2 >
     friend class SparseStorage;
 
     ValueType data_[Size];
@@ -81,20 +82,22 @@ private:
 /**
  * /brief Flexible size storage class for sparse arrays.
  */
-template <class ValueType, class IndexType>
-class SparseStorage<ValueType,IndexType,false,0>
+template <class ValueType, class IndexType, class Allocator>
+class SparseStorage<ValueType,IndexType,false,0,Allocator>
 {
 public:
 
-    typedef SparseStorage<ValueType,IndexType,false,0> self;
+    typedef SparseStorage<ValueType,IndexType,false,0,Allocator> self;
     typedef ValueType* pointer;
     typedef const ValueType* const_pointer;
     typedef IndexType* index_pointer;
     typedef const IndexType* const_index_pointer;
-    typedef typename Storage<ValueType,false,false,0>::iterator iterator;
-    typedef typename Storage<ValueType,false,false,0>::const_iterator const_iterator;
-    typedef typename Storage<IndexType,false,false,0>::iterator index_iterator;
-    typedef typename Storage<IndexType,false,false,0>::const_iterator const_index_iterator;
+    typedef typename Storage<ValueType,false,false,0,false,Allocator>::iterator iterator;
+    typedef typename Storage<ValueType,false,false,0,false,Allocator>::const_iterator const_iterator;
+    typedef typename Storage<IndexType,false,false,0,false,Allocator>::iterator index_iterator;
+    typedef typename Storage<IndexType,false,false,0,false,Allocator>::const_iterator const_index_iterator;
+    typedef Storage<ValueType,false,false,0,false,Allocator> value_storage;
+    typedef Storage<IndexType,false,false,0,false,Allocator> index_storage;
 
     /// Default constructor
     SparseStorage(IndexType nbOfValues = 0, IndexType nbOfOffsets = 0)
@@ -103,9 +106,23 @@ public:
        offset_(nbOfOffsets)
     {}
 
+    /// Proxy constructor using external memory of the three arrays
+    SparseStorage(ValueType* values, IndexType* keys, IndexType* offsets, IndexType nbOfValues, IndexType nbOfOffsets)
+     : value_(values, nbOfValues),
+       key_(keys, nbOfValues),
+       offset_(offsets, nbOfOffsets)
+    {}
+
+    /// Take over the three arrays without copying
+    SparseStorage(value_storage&& values, index_storage&& keys, index_storage&& offsets)
+     : value_(std::move(values)),
+       key_(std::move(keys)),
+       offset_(std::move(offsets))
+    {}
+
     /// Conversion constructor
-    template <class T2, class I2, bool F2, size_t S2>
-    SparseStorage(SparseStorage<T2,I2,F2,S2> const& rhs)
+    template <class T2, class I2, bool F2, size_t S2, class A2>
+    SparseStorage(SparseStorage<T2,I2,F2,S2,A2> const& rhs)
      : value_(rhs.value_),
        key_(rhs.key_),
        offset_(rhs.offset_)
@@ -125,13 +142,13 @@ public:
         return !operator==(rhs);
     }
 
-    template <class T2, class I2, bool F2, size_t S2>
-    bool equal(SparseStorage<T2,I2,F2,S2> const& rhs) const {
+    template <class T2, class I2, bool F2, size_t S2, class A2>
+    bool equal(SparseStorage<T2,I2,F2,S2,A2> const& rhs) const {
         return offset_.equal(rhs.offset_) and key_.equal(rhs.key_) and value_.equal(rhs.value_);
     }
 
-    template <class T2, class I2, bool F2, size_t S2>
-    bool notEqual(SparseStorage<T2,I2,F2,S2> const& rhs) const {
+    template <class T2, class I2, bool F2, size_t S2, class A2>
+    bool notEqual(SparseStorage<T2,I2,F2,S2,A2> const& rhs) const {
         return !equal(rhs);
     }
 
@@ -155,12 +172,12 @@ public:
 
 protected:
 
-    template <class T2, class I2, bool F2, size_t S2>
+    template <class T2, class I2, bool F2, size_t S2, class A2>
     friend class SparseStorage;
 
-    Storage<ValueType,false,false,0> value_;
-    Storage<IndexType,false,false,0> key_;
-    Storage<IndexType,false,false,0> offset_;
+    value_storage value_;
+    index_storage key_;
+    index_storage offset_;
 
 };
 
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace BlasBooster {
+
+/// Estimated value with lower and upper confidence bound
+struct ConfidenceInterval
+{
+    double value = 0.0;
+    double lower = 0.0;
+    double upper = 0.0;
+};
+
+/// Criteria of the sampling
+struct EstimatorSettings
+{
+    /// Edge length of the square blocks, equal to the block size of the converter
+    size_t blockSize = 256;
+
+    /// Number of tiles sampled in a full block, edge blocks are sampled proportionally to their size
+    size_t nbTilesPerBlock = 32;
+
+    /// Consecutive elements of a tile in storage order, so that a tile costs about one cache line
+    size_t tileSize = 8;
+
+    /// Upper limit of sampled elements of the whole matrix, the number of tiles per block is reduced if necessary
+    size_t maxSamples = size_t(1) << 20;
+
+    /// Absolute accuracy, elements with |x| <= threshold are not significant
+    double threshold = 0.0;
+
+    /// Quantile of the standard normal distribution of the confidence level, 1.96 for 95 %
+    double z = 1.96;
+
+    /// Levels of the magnitude quantiles
+    std::vector<double> quantiles{0.1, 0.5, 0.9, 0.99};
+
+    unsigned int seed = 42;
+};
+
+/// Result of the sampling of a m x n matrix
+struct SparsityEstimate
+{
+    size_t nbBlockRows = 0;
+    size_t nbBlockColumns = 0;
+
+    /// Occupations of the blocks in column major order
+    std::vector<ConfidenceInterval> blockOccupations;
+
+    /// Occupation of the whole matrix
+    ConfidenceInterval occupation;
+
+    /// Quantiles of |x| of the significant elements at the levels of EstimatorSettings::quantiles
+    std::vector<ConfidenceInterval> magnitudeQuantiles;
+
+    /// Number of sampled elements
+    size_t nbSamples = 0;
+
+    ConfidenceInterval const& getBlockOccupation(size_t bi, size_t bj) const
+    {
+        return blockOccupations.at(bi + bj * nbBlockRows);
+    }
+};
+
+/**
+ * \brief Estimation of the occupation and the magnitudes of a dense matrix by random sampling.
+ *
+ * The matrix is divided into the blocks of the converter and a fixed number
+ * of random tiles is read in each block, so that the costs depend on the
+ * number of blocks, but not on the block size, and are limited by maxSamples.
+ * If the matrix has more blocks than maxSamples allows tiles, only a part of
+ * the blocks is sampled and the others get the uninformative interval [0, 1].
+ *
+ * Elements within a tile are correlated, e.g. for banded matrices. Therefore,
+ * the confidence interval of the occupation is a Wilson score interval with the
+ * effective sample size given by the variance between the tiles, which is at
+ * least the number of tiles. The confidence intervals of the quantiles are the
+ * distribution-free bounds of the order statistics of the sampled magnitudes.
+ */
+class SparsityEstimator
+{
+public:
+
+    SparsityEstimator(EstimatorSettings const& settings = EstimatorSettings(),
+        WorkStealingScheduler const& scheduler = WorkStealingScheduler())
+     : settings_(settings), scheduler_(scheduler)
+    {}
+
+    EstimatorSettings const& getSettings() const { return settings_; }
+
+    template <class T, class P>
+    SparsityEstimate operator () (Matrix<Dense,T,P> const& matrix) const
+    {
+        return estimate(matrix.getDataPointer(), getRowStride(matrix), getColumnStride(matrix),
+            matrix.getNbRows(), matrix.getNbColumns());
+    }
+
+    /// m x n matrix in external memory with arbitrary strides, e.g. a BLAS operand
+    template <class T>
+    SparsityEstimate estimate(T const* data, size_t rs, size_t cs, size_t nbRows, size_t nbColumns) const;
+
+    /// Wilson score interval of the fraction p with effective sample size n
+    static ConfidenceInterval getWilsonInterval(double p, double n, double z)
+    {
+        if (n <= 0.0) return {p, 0.0, 1.0};
+        double z2n = z * z / n;
+        double center = (p + 0.5 * z2n) / (1.0 + z2n);
+        double halfWidth = z / (1.0 + z2n) * std::sqrt(p * (1.0 - p) / n + 0.25 * z2n / n);
+        return {p, std::max(0.0, center - halfWidth), std::min(1.0, center + halfWidth)};
+    }
+
+    /// Quantile of level q of the sorted values with the bounds of the order statistics
+    static ConfidenceInterval getQuantile(std::vector<double> const& sorted, double q, double z)
+    {
+        if (sorted.empty()) return {};
+        const double n = static_cast<double>(sorted.size());
+        const double last = n - 1.0;
+        auto at = [&](double rank) { return sorted[static_cast<size_t>(std::clamp(rank, 0.0, last))]; };
+
+        double rank = q * last;
+        double lowerRank = std::floor(rank), fraction = rank - lowerRank;
+        double value = at(lowerRank) + fraction * (at(lowerRank + 1.0) - at(lowerRank));
+
+        double halfWidth = z * std::sqrt(n * q * (1.0 - q));
+        return {value, at(std::floor(n * q - halfWidth)), at(std::ceil(n * q + halfWidth))};
+    }
+
+private:
+
+    /// Sampled counts of a block
+    struct BlockSamples
+    {
+        size_t nbSamples = 0;
+        size_t nbSignificant = 0;
+        size_t nbTiles = 0;
+
+        /// Sum of the squared occupations of the tiles
+        double sumSquares = 0.0;
+
+        std::vector<double> magnitudes;
+
+        /// Effective number of independent samples estimated by the variance between the tiles
+        double getEffectiveSize() const
+        {
+            if (nbTiles < 2) return static_cast<double>(nbTiles);
+            double p = static_cast<double>(nbSignificant) / nbSamples;
+            double tileVariance = (sumSquares / nbTiles - p * p) * nbTiles / (nbTiles - 1);
+            if (p * (1.0 - p) <= 0.0 or tileVariance <= 0.0) return static_cast<double>(nbTiles);
+            return std::clamp(p * (1.0 - p) * nbTiles / tileVariance, double(nbTiles), double(nbSamples));
+        }
+    };
+
+    EstimatorSettings settings_;
+
+    WorkStealingScheduler scheduler_;
+
+};
+
+template <class T>
+SparsityEstimate SparsityEstimator::estimate(T const* source, size_t rs, size_t cs, size_t nbRows, size_t nbColumns) const
+{
+    const size_t blockSize = settings_.blockSize;
+    if (blockSize == 0 or settings_.tileSize == 0) throw std::runtime_error("SparsityEstimator: block and tile size must be positive.");
+
+    SparsityEstimate result;
+    result.nbBlockRows = (nbRows + blockSize - 1) / blockSize;
+    result.nbBlockColumns = (nbColumns + blockSize - 1) / blockSize;
+    const size_t nbBlocks = result.nbBlockRows * result.nbBlockColumns;
+    if (nbBlocks == 0) {
+        result.magnitudeQuantiles.resize(settings_.quantiles.size());
+        return result;
+    }
+
+    // Row major storage is sampled by tiles within a row, all other by tiles within a column
+    const bool rowTiles = cs == 1 and rs != 1;
+
+    // Tiles of each block proportional to its size, rounded up as long as maxSamples is not exceeded,
+    // otherwise by rounding the prefix sums, so that some blocks of a large matrix are not sampled at all
+    const size_t maxTiles = settings_.maxSamples / settings_.tileSize;
+    const double nbFullBlocks = static_cast<double>(nbRows) * nbColumns / (blockSize * blockSize);
+    const double fullBlockTiles = std::min<double>(settings_.nbTilesPerBlock, maxTiles / nbFullBlocks);
+    std::vector<double> blockTiles(nbBlocks);
+    std::vector<size_t> nbTiles(nbBlocks);
+    size_t totalTiles = 0;
+    for (size_t index = 0; index != nbBlocks; ++index) {
+        size_t bi = index % result.nbBlockRows, bj = index / result.nbBlockRows;
+        size_t m = std::min(blockSize, nbRows - bi * blockSize), n = std::min(blockSize, nbColumns - bj * blockSize);
+        blockTiles[index] = fullBlockTiles * m * n / (blockSize * blockSize);
+        nbTiles[index] = static_cast<size_t>(std::ceil(blockTiles[index]));
+        totalTiles += nbTiles[index];
+    }
+    if (totalTiles > maxTiles) {
+        double sum = 0.0;
+        for (size_t index = 0; index != nbBlocks; ++index) {
+            const double previous = std::min<double>(maxTiles, std::round(sum));
+            sum += blockTiles[index];
+            nbTiles[index] = static_cast<size_t>(std::min<double>(maxTiles, std::round(sum)) - previous);
+        }
+    }
+
+    std::vector<BlockSamples> samples(nbBlocks);
+
+    auto task = [&](size_t index)
+    {
+        size_t bi = index % result.nbBlockRows, bj = index / result.nbBlockRows;
+        size_t m = std::min(blockSize, nbRows - bi * blockSize), n = std::min(blockSize, nbColumns - bj * blockSize);
+        T const* data = source + bi * blockSize * rs + bj * blockSize * cs;
+
+        // Independent generator per block, so that the result does not depend on the scheduling
+        std::mt19937_64 generator(settings_.seed + index * 0x9e3779b97f4a7c15ull);
+        const size_t tileLength = std::min(settings_.tileSize, rowTiles ? n : m);
+        std::uniform_int_distribution<size_t> outerDistribution(0, (rowTiles ? m : n) - 1);
+        std::uniform_int_distribution<size_t> innerDistribution(0, (rowTiles ? n : m) - tileLength);
+
+        auto& s = samples[index];
+        s.nbTiles = nbTiles[index];
+        for (size_t t = 0; t != s.nbTiles; ++t) {
+            size_t outer = outerDistribution(generator), inner = innerDistribution(generator);
+            size_t nbSignificant = 0;
+            for (size_t e = inner; e != inner + tileLength; ++e) {
+                double absValue = std::abs(static_cast<double>(rowTiles ? data[outer * rs + e] : data[e * rs + outer * cs]));
+                if (absValue <= settings_.threshold) continue;
+                ++nbSignificant;
+                s.magnitudes.push_back(absValue);
+            }
+            double tileOccupation = static_cast<double>(nbSignificant) / tileLength;
+            s.sumSquares += tileOccupation * tileOccupation;
+            s.nbSignificant += nbSignificant;
+            s.nbSamples += tileLength;
+        }
+    };
+
+    scheduler_.run(nbBlocks, task);
+
+    // Blocks are sampled proportionally to their size, so that the pooled samples are unweighted
+    size_t nbSignificant = 0;
+    double effectiveSize = 0.0;
+    std::vector<double> magnitudes;
+    result.blockOccupations.reserve(nbBlocks);
+    for (auto const& s : samples) {
+        double p = s.nbSamples ? static_cast<double>(s.nbSignificant) / s.nbSamples : 0.0;
+        result.blockOccupations.push_back(getWilsonInterval(p, s.getEffectiveSize(), settings_.z));
+        result.nbSamples += s.nbSamples;
+        nbSignificant += s.nbSignificant;
+        effectiveSize += s.getEffectiveSize();
+        magnitudes.insert(magnitudes.end(), s.magnitudes.begin(), s.magnitudes.end());
+    }
+
+    double p = result.nbSamples ? static_cast<double>(nbSignificant) / result.nbSamples : 0.0;
+    result.occupation = getWilsonInterval(p, effectiveSize, settings_.z);
+
+    std::sort(magnitudes.begin(), magnitudes.end());
+    for (double q : settings_.quantiles) result.magnitudeQuantiles.push_back(getQuantile(magnitudes, q, settings_.z));
+    return result;
+}
+
+} // namespace BlasBooster
@@ -9,13 +9,17 @@
 
 namespace BlasBooster {
 
-/// Fixed size storage class for dense arrays on stack.
-template <class T, bool OnStack, bool isFixed, size_t Size, bool Strided = false>
+/**
+ * \brief Fixed size storage class for dense arrays on stack.
+ *
+ * The heap storages obtain their memory by the Allocator policy of Memory.h.
+ */
+template <class T, bool OnStack, bool isFixed, size_t Size, bool Strided = false, class Allocator = DefaultAllocator>
 class Storage
 {
 public:
 
-    typedef Storage<T,OnStack,isFixed,Size,Strided> self;
+    typedef Storage<T,OnStack,isFixed,Size,Strided,Allocator> self;
     typedef T* pointer;
     typedef T const* const_pointer;
     typedef __gnu_cxx::__normal_iterator<pointer,self> iterator;
@@ -57,8 +61,8 @@ public:
         return data_ == rhs.data_ and size_ == rhs.size_;
     }
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
-    bool equal(Storage<T2,onStack2,isFixed2,Size2,Strided2> const& rhs) const
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
+    bool equal(Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2> const& rhs) const
     {
         if ( size_ != rhs.size_ ) return false;
         for ( size_t i(0); i != size_; ++i ) {
@@ -67,8 +71,8 @@ public:
         return true;
     }
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
-    bool notEqual(Storage<T2,onStack2,isFixed2,Size2,Strided2> const& rhs) const
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
+    bool notEqual(Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2> const& rhs) const
     {
         return !equal(rhs);
     }
@@ -103,7 +107,7 @@ public:
 
 private:
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
     friend class Storage;
 
     T data_[Size];
@@ -115,12 +119,12 @@ private:
 /**
  * /brief Fixed size storage class for dense arrays on heap.
  */
-template <class T, size_t Size>
-class Storage<T,false,true,Size,false>
+template <class T, size_t Size, class Allocator>
+class Storage<T,false,true,Size,false,Allocator>
 {
 public:
 
-    typedef Storage<T,false,true,Size,false> self;
+    typedef Storage<T,false,true,Size,false,Allocator> self;
     typedef T* pointer;
     typedef T const* const_pointer;
     typedef __gnu_cxx::__normal_iterator<pointer,self> iterator;
@@ -128,14 +132,14 @@ public:
 
     /// Default constructor
     Storage( size_t = 0 )
-     : data_(new T[size_]), ownMemory_(true)
+     : data_(Allocator::template allocate<T>(size_)), ownMemory_(true)
     {
         debug_print("Storage (fixed,onHeap): Default constructor is called.");
     }
 
     /// Initializer list constructor
     Storage( std::initializer_list<T> values )
-     : data_(new T[size_]), ownMemory_(true)
+     : data_(Allocator::template allocate<T>(size_)), ownMemory_(true)
     {
         debug_print("Storage (fixed,onHeap): Initializer list constructor is called.");
         if ( values.size() != size_ ) throw std::runtime_error("Storage (fixed,onHeap): values.size() != size_");
@@ -145,7 +149,7 @@ public:
 
     /// Copy constructor
     Storage( const Storage& rhs )
-     : data_(new T[size_]), ownMemory_(true)
+     : data_(Allocator::template allocate<T>(size_)), ownMemory_(true)
     {
         debug_print("Storage (fixed,onHeap): Copy constructor is called.");
         std::copy(rhs.begin(),rhs.end(),begin());
@@ -160,9 +164,9 @@ public:
     }
 
     /// Conversion constructor
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
-    Storage( const Storage<T2,onStack2,isFixed2,Size2,Strided2>& rhs )
-     : data_(new T[size_]), ownMemory_(true)
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
+    Storage( const Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2>& rhs )
+     : data_(Allocator::template allocate<T>(size_)), ownMemory_(true)
     {
         debug_print("Storage (fixed,onHeap): Conversion constructor is called.");
         if ( rhs.size_ != size_ ) throw std::runtime_error("Storage (fixed,onHeap): rhs.size_ != size_");
@@ -175,7 +179,7 @@ public:
     {}
 
     ~Storage() {
-        if (ownMemory_) delete [] data_;
+        if (ownMemory_) Allocator::deallocate(data_, size_);
     }
 
     /// Copy assignment
@@ -206,8 +210,8 @@ public:
         return data_ == rhs.data_ and ownMemory_ == rhs.ownMemory_;
     }
 
-    template < class T2, bool onStack2, bool isFixed2, size_t Size2 >
-    bool equal( const Storage<T2,onStack2,isFixed2,Size2>& rhs ) const {
+    template < class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2 >
+    bool equal( const Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2>& rhs ) const {
         if ( size_ != rhs.size_ ) return false;
         for ( size_t i(0); i != size_; ++i ) {
             if ( !equalWithinNumericalAccuracy(data_[i],rhs.data_[i]) ) return false;
@@ -215,8 +219,8 @@ public:
         return true;
     }
 
-    template < class T2, bool onStack2, bool isFixed2, size_t Size2 >
-    bool notEqual( const Storage<T2,onStack2,isFixed2,Size2>& rhs ) const {
+    template < class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2 >
+    bool notEqual( const Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2>& rhs ) const {
         return !equal(rhs);
     }
 
@@ -250,7 +254,7 @@ public:
 
 protected:
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
     friend class Storage;
 
     T* data_;
@@ -265,12 +269,12 @@ protected:
 /**
  * /brief Flexible size class for dense arrays on heap.
  */
-template <class T>
-class Storage<T,false,false,0,false>
+template <class T, class Allocator>
+class Storage<T,false,false,0,false,Allocator>
 {
 public:
 
-    typedef Storage<T,false,false,0,false> self;
+    typedef Storage<T,false,false,0,false,Allocator> self;
     typedef T* pointer;
     typedef T const* const_pointer;
     typedef __gnu_cxx::__normal_iterator<pointer,self> iterator;
@@ -285,14 +289,14 @@ public:
 
     /// Parameter constructor
     Storage(size_t size)
-     : data_(allocate<T>(size)), size_(size), ownMemory_(true)
+     : data_(Allocator::template allocate<T>(size)), size_(size), ownMemory_(true)
     {
         debug_print("Storage (onHeap): Parameter constructor is called.");
     }
 
     /// Initializer list constructor
     Storage(std::initializer_list<T> values)
-     : data_(allocate<T>(values.size())), size_(values.size()), ownMemory_(true)
+     : data_(Allocator::template allocate<T>(values.size())), size_(values.size()), ownMemory_(true)
     {
         debug_print("Storage (onHeap): Initializer list constructor is called.");
         size_t i(0);
@@ -301,7 +305,7 @@ public:
 
     /// Copy constructor
     Storage(Storage const& rhs)
-     : data_(allocate<T>(rhs.size_)), size_(rhs.size_), ownMemory_(rhs.ownMemory_)
+     : data_(Allocator::template allocate<T>(rhs.size_)), size_(rhs.size_), ownMemory_(true)
     {
         debug_print("Storage (onHeap): Copy constructor is called.");
         std::copy(rhs.begin(), rhs.end(), begin());
@@ -318,9 +322,9 @@ public:
     }
 
     /// Conversion constructor
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
-    Storage(Storage<T2,onStack2,isFixed2,Size2,Strided2> const& rhs)
-     : data_(allocate<T>(rhs.size_)), size_(rhs.size_), ownMemory_(true)
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
+    Storage(Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2> const& rhs)
+     : data_(Allocator::template allocate<T>(rhs.size_)), size_(rhs.size_), ownMemory_(true)
     {
         debug_print("Storage (onHeap): Conversion constructor is called.");
         std::copy(rhs.begin(),rhs.end(),begin());
@@ -332,14 +336,14 @@ public:
     {}
 
     ~Storage() {
-        if (ownMemory_ and data_) deallocate<T>(data_);
+        if (ownMemory_ and data_) Allocator::deallocate(data_, size_);
     }
 
     void resize(size_t size) {
         if (size_ == size) return;
         if (!ownMemory_) throw std::runtime_error("resize storage with not own memory.");
-        if (data_) deallocate<T>(data_);
-        data_ = allocate<T>(size);
+        if (data_) Allocator::deallocate(data_, size_);
+        data_ = Allocator::template allocate<T>(size);
         size_ = size;
     }
 
@@ -347,9 +351,9 @@ public:
     Storage& operator = ( const self& rhs ) {
         debug_print("Storage (onHeap): Copy assignment is called.");
         if ( this != &rhs ) {
-            if (ownMemory_) deallocate<T>(data_);
+            if (ownMemory_) Allocator::deallocate(data_, size_);
             if (rhs.ownMemory_) {
-                data_ = allocate<T>(rhs.size_);
+                data_ = Allocator::template allocate<T>(rhs.size_);
                 std::copy(rhs.begin(),rhs.end(),begin());
             } else {
                 data_ = rhs.data_;
@@ -364,7 +368,7 @@ public:
     Storage& operator = ( self&& rhs ) noexcept {
         debug_print("Storage (onHeap): Move assignment is called.");
         // clear own resources
-        if (ownMemory_) deallocate<T>(data_);
+        if (ownMemory_) Allocator::deallocate(data_, size_);
         // steal other resources
         data_ = rhs.data_;
         size_ = rhs.size_;
@@ -391,8 +395,8 @@ public:
             and ownMemory_ == rhs.ownMemory_;
     }
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2>
-    bool equal(Storage<T2,onStack2,isFixed2,Size2> const& rhs) const
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
+    bool equal(Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2> const& rhs) const
     {
         if (size_ != rhs.size_) return false;
         for (size_t i(0); i != size_; ++i) {
@@ -401,8 +405,8 @@ public:
         return true;
     }
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2>
-    bool notEqual(Storage<T2,onStack2,isFixed2,Size2> const& rhs) const
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
+    bool notEqual(Storage<T2,onStack2,isFixed2,Size2,Strided2,Allocator2> const& rhs) const
     {
         return !equal(rhs);
     }
@@ -435,13 +439,19 @@ public:
         return data_;
     }
 
+    /// Parallel for NUMA-aware allocators, so that each page is written by the thread placing it
     void fill(T const& value) {
-        std::fill(data_, data_ + size_, value);
+        firstTouch(data_, size_, getNumaPlacement<Allocator>(), [&](T* begin, size_t n){ std::fill_n(begin, n, value); });
+    }
+
+    /// Zeros in newly allocated memory, which is not written again if the allocator has already zero-initialized it
+    void fillNewZero() {
+        if constexpr (!isZeroInitialized<Allocator>() or !std::is_trivially_default_constructible<T>::value) fill(T(0));
     }
 
 protected:
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
     friend class Storage;
 
     T* data_;
@@ -455,12 +465,12 @@ protected:
 
 /// Flexible size class for striped arrays on heap
 /// Only available as proxy storage using external memory.
-template <class T>
-class Storage<T,false,false,0,true>
+template <class T, class Allocator>
+class Storage<T,false,false,0,true,Allocator>
 {
 public:
 
-    typedef Storage<T,false,false,0,true> self;
+    typedef Storage<T,false,false,0,true,Allocator> self;
     typedef T* pointer;
     typedef T const* const_pointer;
     typedef StripedIterator<T> iterator;
@@ -584,7 +594,7 @@ public:
 
 protected:
 
-    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2>
+    template <class T2, bool onStack2, bool isFixed2, size_t Size2, bool Strided2, class Allocator2>
     friend class Storage;
 
     template <class T2>
@@ -53,16 +53,20 @@ struct StripedIterator
             --ptr_;
             --position_;
         }
+        return *this;
     }
 
-    StripedIterator operator++(T) { StripedIterator tmp = *this; ++(*this); return tmp; }
-    StripedIterator operator--(T) { StripedIterator tmp = *this; --(*this); return tmp; }
+    StripedIterator operator++(int) { StripedIterator tmp = *this; ++(*this); return tmp; }
+    StripedIterator operator--(int) { StripedIterator tmp = *this; --(*this); return tmp; }
 
     friend bool operator== (const StripedIterator& a, const StripedIterator& b) { return a.ptr_ == b.ptr_; }
     friend bool operator!= (const StripedIterator& a, const StripedIterator& b) { return a.ptr_ != b.ptr_; } 
 
 private:
 
+    template <class T2>
+    friend struct ::StripedIterator;
+
     pointer ptr_;
 
     // Current position within the continuous memory space
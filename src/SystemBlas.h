@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/// Library of the system BLAS, which is set by the build system to the result of find_package(BLAS)
+#ifndef BLASBOOSTER_SYSTEM_BLAS_LIBRARY
+#define BLASBOOSTER_SYSTEM_BLAS_LIBRARY "libblas.so.3"
+#endif
+
+namespace BlasBooster {
+
+/// Integer type of the Fortran BLAS interface (LP64)
+typedef int blas_int;
+
+/**
+ * \brief Entry points of the system BLAS resolved at runtime.
+ *
+ * The library is opened with RTLD_LOCAL and the symbols are looked up in its
+ * handle, so that they are not resolved to the symbols of BlasBooster itself.
+ * The library can be changed by the environment variable BLASBOOSTER_SYSTEM_BLAS.
+ * Illegal arguments are reported by xerbla_, which is taken from the
+ * application if it defines one, as for a linked BLAS.
+ */
+class SystemBlas
+{
+public:
+
+    typedef void (*dgemm_type)(char const*, char const*, blas_int const*, blas_int const*, blas_int const*,
+        double const*, double const*, blas_int const*, double const*, blas_int const*,
+        double const*, double*, blas_int const*);
+
+    typedef void (*sgemm_type)(char const*, char const*, blas_int const*, blas_int const*, blas_int const*,
+        float const*, float const*, blas_int const*, float const*, blas_int const*,
+        float const*, float*, blas_int const*);
+
+    /// Fortran xerbla_ with the hidden length of the routine name
+    typedef void (*xerbla_type)(char const*, blas_int const*, size_t);
+
+    /// Type of xgemm_ of value type T
+    template <class T>
+    using GemmType = typename std::conditional<std::is_same<T, double>::value, dgemm_type, sgemm_type>::type;
+
+    /// Loaded at the first call, throws if the library or a symbol is not available
+    static SystemBlas const& instance()
+    {
+        static const SystemBlas systemBlas;
+        return systemBlas;
+    }
+
+    SystemBlas(SystemBlas const&) = delete;
+    SystemBlas& operator = (SystemBlas const&) = delete;
+
+    ~SystemBlas() { if (handle_) dlclose(handle_); }
+
+    std::string const& getLibrary() const { return library_; }
+
+    /// xgemm_ of value type T
+    template <class T>
+    auto gemm() const
+    {
+        if constexpr (std::is_same<T, double>::value) return dgemm_;
+        else return sgemm_;
+    }
+
+    /// Report the illegal parameter number info (starting at one) of the routine name
+    void xerbla(std::string const& name, blas_int info) const
+    {
+        xerbla_(name.c_str(), &info, name.size());
+    }
+
+private:
+
+    SystemBlas()
+    {
+        const char* library = std::getenv("BLASBOOSTER_SYSTEM_BLAS");
+        library_ = library ? library : BLASBOOSTER_SYSTEM_BLAS_LIBRARY;
+
+        handle_ = dlopen(library_.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle_) throw std::runtime_error("SystemBlas: " + std::string(dlerror()));
+
+        dgemm_ = reinterpret_cast<dgemm_type>(lookup("dgemm_"));
+        sgemm_ = reinterpret_cast<sgemm_type>(lookup("sgemm_"));
+
+        xerbla_ = reinterpret_cast<xerbla_type>(dlsym(RTLD_DEFAULT, "xerbla_"));
+        if (!xerbla_) xerbla_ = reinterpret_cast<xerbla_type>(lookup("xerbla_"));
+    }
+
+    void* lookup(const char* name) const
+    {
+        void* symbol = dlsym(handle_, name);
+        if (!symbol) throw std::runtime_error("SystemBlas: symbol " + std::string(name) + " not found in " + library_);
+        return symbol;
+    }
+
+    std::string library_;
+    void* handle_ = nullptr;
+    dgemm_type dgemm_ = nullptr;
+    sgemm_type sgemm_ = nullptr;
+    xerbla_type xerbla_ = nullptr;
+
+};
+
+} // namespace BlasBooster
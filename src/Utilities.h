@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 
 namespace BlasBooster {
 
@@ -9,4 +13,13 @@ void debug_print(auto const& message)
     //std::cout << message << std::endl;
 }
 
+/// Relative comparison with the accuracy of the less precise type
+template <class T1, class T2>
+bool equalWithinNumericalAccuracy(T1 a, T2 b)
+{
+    typedef typename std::conditional<(sizeof(T1) < sizeof(T2)), T1, T2>::type lower_type;
+    double tolerance = 100 * std::numeric_limits<lower_type>::epsilon();
+    return std::abs(a - b) <= tolerance * std::max({1.0, std::abs(double(a)), std::abs(double(b))});
+}
+
 } // namespace BlasBooster
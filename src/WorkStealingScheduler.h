@@ -0,0 +1,263 @@
+#pragma once
+
+#include "Arena.h"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace BlasBooster {
+
+/**
+ * \brief Work-stealing execution of independent tasks with uneven costs.
+ *
+ * Each task is owned by exactly one worker at a time, so that tasks writing
+ * disjoint data (e.g. one tile of C) need no locking.
+ *
+ * The tasks are first distributed by their estimated costs (longest task first
+ * to the least loaded worker, see getPartition). Each worker processes its own
+ * queue from the expensive end, idle workers steal from the cheap end of the
+ * other queues. Therefore, wrong cost estimates only cost some steals instead
+ * of idle cores.
+ *
+ * The worker threads are started for each run and bind an arena of the global
+ * ArenaPool, so that the scratch memory of the tasks survives the threads.
+ * Pinned workers are bound to the hardware threads of the process in a fixed
+ * order, so that worker w runs on the same core in every run, e.g. on the
+ * NUMA node which got its pages by firstTouch.
+ */
+class WorkStealingScheduler
+{
+public:
+
+    /// Zero threads means one thread per hardware thread
+    WorkStealingScheduler(size_t nbThreads = 0, bool pinned = false)
+     : nbThreads_(nbThreads ? nbThreads : std::max(1u, std::thread::hardware_concurrency())), pinned_(pinned)
+    {}
+
+    size_t getNbThreads() const { return nbThreads_; }
+
+    bool isPinned() const { return pinned_; }
+
+    /// Execute task(i) for all i in [0, nbTasks) with estimated costs cost(i)
+    template <class Task, class Cost>
+    void run(size_t nbTasks, Task const& task, Cost const& cost) const;
+
+    /// Execute task(i) for all i in [0, nbTasks) with equal costs
+    template <class Task>
+    void run(size_t nbTasks, Task const& task) const
+    {
+        run(nbTasks, task, [](size_t){ return 1.0; });
+    }
+
+    /// Execute task(w) once by each worker w in [0, getNbThreads()), there is no stealing
+    template <class Task>
+    void runOnEachWorker(Task const& task) const
+    {
+        if (nbThreads_ == 1) task(0);
+        else launch(nbThreads_, task);
+    }
+
+    /// Worker owning task i before any steal, equal costs give task i to worker i % getNbThreads()
+    template <class Cost>
+    std::vector<size_t> getPartition(size_t nbTasks, Cost const& cost) const
+    {
+        std::vector<size_t> owner(nbTasks, 0);
+        auto tasks = distribute(getCosts(nbTasks, cost), std::min(nbThreads_, nbTasks));
+        for (size_t worker = 0; worker != tasks.size(); ++worker)
+            for (size_t i : tasks[worker]) owner[i] = worker;
+        return owner;
+    }
+
+private:
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    /// Threads, which are joined on destruction, also if starting a further thread has thrown
+    struct ThreadGroup
+    {
+        std::vector<std::thread> threads;
+
+        ~ThreadGroup() { for (auto& thread : threads) thread.join(); }
+    };
+
+    /// Pin the calling thread for the lifetime of the scope, the previous affinity is restored
+    class ThreadPinning
+    {
+    public:
+
+        ThreadPinning(std::vector<int> const& cpus, size_t worker)
+        {
+#ifdef __linux__
+            if (cpus.empty() or pthread_getaffinity_np(pthread_self(), sizeof(previous_), &previous_) != 0) return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[worker % cpus.size()], &set);
+            // Only a hint, the workers are also correct without pinning
+            pinned_ = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            (void)cpus;
+            (void)worker;
+#endif
+        }
+
+        ThreadPinning(ThreadPinning const&) = delete;
+        ThreadPinning& operator = (ThreadPinning const&) = delete;
+
+        ~ThreadPinning()
+        {
+#ifdef __linux__
+            if (pinned_) pthread_setaffinity_np(pthread_self(), sizeof(previous_), &previous_);
+#endif
+        }
+
+    private:
+
+#ifdef __linux__
+        cpu_set_t previous_;
+#endif
+
+        bool pinned_ = false;
+
+    };
+
+    /// Hardware threads available to the process
+    static std::vector<int> getCpus()
+    {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            for (int cpu = 0; cpu != CPU_SETSIZE; ++cpu) if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+#endif
+        return cpus;
+    }
+
+    template <class Cost>
+    static std::vector<double> getCosts(size_t nbTasks, Cost const& cost)
+    {
+        std::vector<double> costs(nbTasks);
+        for (size_t i = 0; i != nbTasks; ++i) costs[i] = cost(i);
+        return costs;
+    }
+
+    /// Tasks of each worker by decreasing costs, longest processing time first
+    static std::vector<std::deque<size_t>> distribute(std::vector<double> const& costs, size_t nbWorkers)
+    {
+        std::vector<size_t> order(costs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return costs[a] > costs[b]; });
+
+        std::vector<std::deque<size_t>> tasks(nbWorkers);
+        std::vector<double> load(nbWorkers, 0.0);
+        for (size_t i : order) {
+            size_t worker = std::min_element(load.begin(), load.end()) - load.begin();
+            tasks[worker].push_back(i);
+            load[worker] += costs[i];
+        }
+        return tasks;
+    }
+
+    /// Execute worker(w) for all w in [0, nbWorkers), worker 0 in the calling thread
+    template <class Worker>
+    void launch(size_t nbWorkers, Worker const& worker) const;
+
+    /// Take the most expensive task of the own queue
+    static bool pop(Queue& queue, size_t& task)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    /// Take the cheapest task of a foreign queue
+    static bool steal(Queue& queue, size_t& task)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    size_t nbThreads_;
+
+    bool pinned_;
+
+};
+
+template <class Task, class Cost>
+void WorkStealingScheduler::run(size_t nbTasks, Task const& task, Cost const& cost) const
+{
+    if (nbTasks == 0) return;
+
+    size_t nbWorkers = std::min(nbThreads_, nbTasks);
+    if (nbWorkers == 1) {
+        for (size_t i = 0; i != nbTasks; ++i) task(i);
+        return;
+    }
+
+    auto tasks = distribute(getCosts(nbTasks, cost), nbWorkers);
+    std::vector<Queue> queues(nbWorkers);
+    for (size_t id = 0; id != nbWorkers; ++id) queues[id].tasks = std::move(tasks[id]);
+
+    launch(nbWorkers, [&](size_t id)
+    {
+        size_t i;
+        while (pop(queues[id], i)) task(i);
+        for (size_t victim = (id + 1) % nbWorkers; victim != id; victim = (victim + 1) % nbWorkers) {
+            while (steal(queues[victim], i)) task(i);
+        }
+    });
+}
+
+template <class Worker>
+void WorkStealingScheduler::launch(size_t nbWorkers, Worker const& worker) const
+{
+    const std::vector<int> cpus = pinned_ ? getCpus() : std::vector<int>();
+
+    std::exception_ptr exception;
+    std::mutex exceptionMutex;
+
+    auto guardedWorker = [&](size_t id, bool bindArena)
+    {
+        try {
+            ThreadPinning pinning(cpus, id);
+            if (bindArena) {
+                ArenaBinding binding;
+                worker(id);
+            } else {
+                worker(id);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(exceptionMutex);
+            if (!exception) exception = std::current_exception();
+        }
+    };
+
+    {
+        ThreadGroup group;
+        group.threads.reserve(nbWorkers - 1);
+        for (size_t id = 1; id != nbWorkers; ++id) group.threads.emplace_back(guardedWorker, id, true);
+        guardedWorker(0, false);
+    }
+
+    if (exception) std::rethrow_exception(exception);
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "DenseMatrix.h"
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <xtensor/xadapt.hpp>
+
+namespace BlasBooster {
+
+/// Number of elements between the first and behind the last element of a dense matrix
+template <class T, class P>
+size_t getSpan(Matrix<Dense,T,P> const& matrix)
+{
+    if (matrix.getNbRows() == 0 or matrix.getNbColumns() == 0) return 0;
+    return (matrix.getNbRows() - 1) * getRowStride(matrix) + (matrix.getNbColumns() - 1) * getColumnStride(matrix) + 1;
+}
+
+/**
+ * \brief Two-dimensional xtensor view on the memory of a dense matrix.
+ *
+ * The strides are taken from the matrix, so that sub-matrices with a leading
+ * dimension are viewed in place. The view can be used in lazy xtensor
+ * expressions and assigned to, the matrix must outlive the view.
+ */
+template <class T, class P>
+auto adaptMatrix(Matrix<Dense,T,P>& matrix)
+{
+    static_assert(!P::isBlockedMatrix, "adaptMatrix: blocked matrices are not supported.");
+    return xt::adapt(matrix.getDataPointer(), getSpan(matrix), xt::no_ownership(),
+        std::array<size_t, 2>{matrix.getNbRows(), matrix.getNbColumns()},
+        std::array<std::ptrdiff_t, 2>{static_cast<std::ptrdiff_t>(getRowStride(matrix)), static_cast<std::ptrdiff_t>(getColumnStride(matrix))});
+}
+
+/// Read-only xtensor view on the memory of a dense matrix
+template <class T, class P>
+auto adaptMatrix(Matrix<Dense,T,P> const& matrix)
+{
+    static_assert(!P::isBlockedMatrix, "adaptMatrix: blocked matrices are not supported.");
+    return xt::adapt(static_cast<T const*>(matrix.getDataPointer()), getSpan(matrix), xt::no_ownership(),
+        std::array<size_t, 2>{matrix.getNbRows(), matrix.getNbColumns()},
+        std::array<std::ptrdiff_t, 2>{static_cast<std::ptrdiff_t>(getRowStride(matrix)), static_cast<std::ptrdiff_t>(getColumnStride(matrix))});
+}
+
+/**
+ * \brief Dense matrix X using the buffer of a two-dimensional xtensor container or strided view.
+ *
+ * The elements must be contiguous along the orientation of X. With a
+ * LeadingDimension parameter the other stride can be larger than the number
+ * of rows (ColumnMajor) or columns (RowMajor), e.g. for a view on a block of
+ * a larger tensor. The expression must outlive the matrix.
+ */
+template <class X, class E>
+X borrowMatrix(E&& expression)
+{
+    typedef typename X::value_type T;
+    typedef typename X::parameter P;
+
+    static_assert(std::is_same<typename std::decay_t<E>::value_type, T>::value, "borrowMatrix: value types must be equal.");
+    static_assert(!P::onStack and !P::isFixed and !P::isBlockedMatrix, "borrowMatrix: only variable sized dense matrices on heap are supported.");
+
+    if (expression.dimension() != 2)
+        throw std::runtime_error("borrowMatrix: expression has " + std::to_string(expression.dimension()) + " dimensions instead of 2.");
+
+    const bool columnMajor = std::is_same<typename P::orientation, ColumnMajor>::value;
+    const size_t nbRows = expression.shape()[0];
+    const size_t nbColumns = expression.shape()[1];
+    const size_t nbLines = columnMajor ? nbColumns : nbRows;
+    const size_t lineSize = columnMajor ? nbRows : nbColumns;
+
+    // xtensor sets the stride of dimensions with extent one to zero
+    const std::ptrdiff_t elementStride = expression.strides()[columnMajor ? 0 : 1];
+    const std::ptrdiff_t lineStride = expression.strides()[columnMajor ? 1 : 0];
+    if (lineSize > 1 and elementStride != 1)
+        throw std::runtime_error("borrowMatrix: elements are not contiguous in the orientation of the matrix.");
+    if (nbLines > 1 and lineStride < static_cast<std::ptrdiff_t>(lineSize))
+        throw std::runtime_error("borrowMatrix: lines of the expression overlap.");
+    const size_t leadingDimension = nbLines > 1 ? lineStride : lineSize;
+
+    T* data = const_cast<T*>(expression.data() + expression.data_offset());
+
+    if constexpr (P::isSubMatrix) {
+        typedef Matrix<Dense,T,Parameter<typename P::IndexType, typename P::orientation>> FullMatrix;
+        FullMatrix full = columnMajor ? FullMatrix(leadingDimension, nbColumns, data) : FullMatrix(nbRows, leadingDimension, data);
+        return X(full, nbRows, nbColumns);
+    } else {
+        if (leadingDimension != lineSize)
+            throw std::runtime_error("borrowMatrix: expression is not contiguous, use a matrix with LeadingDimension.");
+        return X(nbRows, nbColumns, data);
+    }
+}
+
+} // namespace BlasBooster
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "DynamicMatrixTypeList.h"
+#include "Matrix.h"
+#include "MatrixBase.h"
+#include <string>
+#include <typeinfo>
+
+namespace BlasBooster {
+
+/**
+ * \brief Matrix with all elements equal to zero.
+ *
+ * Only the dimension is stored.
+ */
+template <class P>
+class Matrix<Zero,NullType,P>
+ : public MatrixBase,
+   public P::dimension
+{
+public: // typedefs
+
+    typedef Matrix<Zero,NullType,P> self;
+    typedef Zero matrix_type;
+    typedef NullType value_type;
+    typedef P parameter;
+    typedef typename P::dimension dimension;
+    typedef typename P::orientation orientation;
+    typedef typename P::IndexType IndexType;
+
+public: // member functions
+
+    /// Parameter constructor
+    Matrix(IndexType nbRows = 0, IndexType nbColumns = 0)
+     : dimension(nbRows, nbColumns)
+    {}
+
+    bool operator == (self const& rhs) const {
+        return dimension::operator==(rhs);
+    }
+
+    const std::type_info& getTypeInfo() const { return typeid(*this); }
+
+    size_t getTypeIndex() const { return typeIndex_; }
+
+    double getNorm() const { return 0.0; }
+
+    static constexpr size_t typeIndex_ = GetIndex<self, DynamicMatrixTypeList>::value;
+
+    static const std::string name() { return "Matrix<Zero>"; }
+
+};
+
+} // namespace BlasBooster
@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+#include "BlasAnalyzer.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace BlasBooster;
+
+TEST_CASE("BlasAnalyzer histogram bins", "[analyzer]")
+{
+    CHECK(BlasAnalyzer::getBin(0) == 0);
+    CHECK(BlasAnalyzer::getBin(1) == 1);
+    CHECK(BlasAnalyzer::getBin(3) == 2);
+    CHECK(BlasAnalyzer::getBin(4) == 3);
+    CHECK(BlasAnalyzer::getBin(1024) == 11);
+}
+
+TEST_CASE("BlasAnalyzer aggregation", "[analyzer]")
+{
+    BlasAnalyzer analyzer;
+    int site1, site2;
+    analyzer.record({"dgemm_", "NN", 100, 200, 300, 2.0 * 100 * 200 * 300, 0.5, 0.25, &site1});
+    analyzer.record({"dgemm_", "NT", 100, 200, 300, 2.0 * 100 * 200 * 300, 1.5, 1.5, &site2});
+    analyzer.record({"sgemm_", "NN", 8, 8, 8, 1024.0, 0.001, 0.001, &site1});
+
+    auto total = analyzer.getTotal();
+    CHECK(total.nbCalls == 3);
+    CHECK(total.time == 2.001);
+
+    auto dgemm = analyzer.getRoutine("dgemm_");
+    CHECK(dgemm.nbCalls == 2);
+    CHECK(dgemm.getSpeedup() == 2.0 / 1.75);
+    CHECK(analyzer.getRoutine("dtrsm_").nbCalls == 0);
+
+    auto callSites = analyzer.getCallSites();
+    REQUIRE(callSites.size() == 3);
+    CHECK(callSites[0].first.first == &site2);
+    CHECK(callSites[1].first.first == &site1);
+    CHECK(callSites[1].first.second == "dgemm_");
+
+    auto bin = analyzer.getHistogramBin(BlasAnalyzer::getBin(100));
+    CHECK(bin.nbCalls[0] == 2);
+    CHECK(bin.nbCalls[1] == 0);
+    CHECK(bin.time[0] == 2.0);
+
+    std::ostringstream os;
+    analyzer.report(os, 1);
+    auto report = os.str();
+    CHECK(report.find("dgemm_ NT") != std::string::npos);
+    CHECK(report.find("64-127") != std::string::npos);
+    CHECK(report.find("   2. ") == std::string::npos);
+}
+
+TEST_CASE("BlasAnalyzer speedup estimation", "[analyzer]")
+{
+    const size_t size = 64;
+    std::vector<double> sparse(size * size), dense(size * size, 1.0), C(size * size);
+    for (size_t i = 0; i != size; ++i) sparse[i + i * size] = 1.0;
+
+    AnalyzerSettings settings;
+    settings.booster.minDimension = 32;
+    settings.booster.converter.costModel = nullptr;
+    settings.sparseEfficiency = 0.5;
+
+    GemmCall<double> call{'N', 'N', size, size, size, 1.0, dense.data(), size, dense.data(), size, 0.0, C.data(), size};
+    CHECK(estimateBoostedTime(call, 1.0, settings) == 1.0);
+
+    call.B = sparse.data();
+    double occupation = sampleOccupation(sparse.data(), 1, size, size, size, settings.booster.nbSamples, 0.0);
+    CHECK(estimateBoostedTime(call, 1.0, settings) == occupation / 0.5);
+
+    settings.booster.minDimension = 128;
+    CHECK(estimateBoostedTime(call, 1.0, settings) == 1.0);
+}
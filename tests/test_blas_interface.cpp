@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+#include "BlasInterface.h"
+#include <cmath>
+#include <vector>
+
+using namespace BlasBooster;
+
+namespace {
+
+/// Column major reference of C = alpha * op(A) * op(B) + beta * C
+template <class T>
+std::vector<T> referenceGemm(GemmCall<T> const& call)
+{
+    std::vector<T> C(call.C, call.C + call.ldc * call.n);
+    for (size_t j = 0; j != call.n; ++j) {
+        for (size_t i = 0; i != call.m; ++i) {
+            double sum = 0.0;
+            for (size_t l = 0; l != call.k; ++l)
+                sum += double(call.A[i * call.getRowStrideA() + l * call.getColumnStrideA()])
+                     * double(call.B[l * call.getRowStrideB() + j * call.getColumnStrideB()]);
+            C[i + j * call.ldc] = static_cast<T>(call.alpha * sum + call.beta * C[i + j * call.ldc]);
+        }
+    }
+    return C;
+}
+
+double sparseValue(size_t i, size_t j) { return (i * 7 + j * 3) % 11 == 0 ? 1.0 + 0.25 * (i % 5) : 0.0; }
+
+} // namespace
+
+TEST_CASE("BLAS argument check", "[blas]")
+{
+    CHECK(isValidGemm('N', 'T', 4, 5, 6, 4, 5, 4));
+    CHECK(!isValidGemm('X', 'N', 4, 5, 6, 4, 6, 4));
+    CHECK(!isValidGemm('N', 'N', -1, 5, 6, 4, 6, 4));
+    CHECK(!isValidGemm('T', 'N', 4, 5, 6, 4, 6, 4));  // lda < k
+    CHECK(isValidGemm('N', 'N', 0, 0, 0, 1, 1, 1));
+}
+
+TEST_CASE("CBLAS row major call is mapped to column major", "[blas]")
+{
+    double A[6], B[12], C[8];
+    auto call = makeGemmCall<double>(CblasLayout::RowMajor, CblasTranspose::Trans, CblasTranspose::NoTrans,
+        2, 4, 3, 1.0, A, 2, B, 4, 0.0, C, 4);
+    CHECK(call.transA == 'N');
+    CHECK(call.transB == 'T');
+    CHECK(call.m == 4);
+    CHECK(call.n == 2);
+    CHECK(call.A == B);
+    CHECK(call.lda == 4);
+    CHECK(call.B == A);
+    CHECK(call.ldb == 2);
+}
+
+TEST_CASE("Boosted gemm with transposed operands", "[blas]")
+{
+    const size_t m = 70, n = 45, k = 53;
+    BoosterSettings settings;
+    settings.converter.blockSize = 16;
+
+    for (char transA : {'N', 'T'}) {
+        for (char transB : {'N', 'C'}) {
+            size_t lda = (transA == 'N' ? m : k) + 3, ldb = (transB == 'N' ? k : n) + 1, ldc = m + 2;
+            std::vector<double> A(lda * (transA == 'N' ? k : m)), B(ldb * (transB == 'N' ? n : k)), C(ldc * n);
+            for (size_t i = 0; i != A.size(); ++i) A[i] = sparseValue(i, i / 7);
+            for (size_t i = 0; i != B.size(); ++i) B[i] = 0.5 - double(i % 13) / 13;
+            for (size_t i = 0; i != C.size(); ++i) C[i] = double(i % 5);
+
+            GemmCall<double> call{transA, transB, m, n, k, 2.0, A.data(), lda, B.data(), ldb, -1.0, C.data(), ldc};
+            auto reference = referenceGemm(call);
+            boostedGemm(call, settings, WorkStealingScheduler(4));
+
+            double error = 0.0;
+            for (size_t j = 0; j != n; ++j)
+                for (size_t i = 0; i != m; ++i) error = std::max(error, std::abs(C[i + j * ldc] - reference[i + j * ldc]));
+            CHECK(error < 1e-12);
+
+            // Padding of C is not touched
+            CHECK(C[m] == double(m % 5));
+        }
+    }
+}
+
+TEST_CASE("Booster path selection", "[blas]")
+{
+    const size_t size = 64;
+    std::vector<float> sparse(size * size), dense(size * size, 1.0f), C(size * size);
+    for (size_t j = 0; j != size; ++j)
+        for (size_t i = 0; i != size; ++i) sparse[i + j * size] = float(sparseValue(i, j));
+
+    CHECK(std::abs(sampleOccupation(sparse.data(), 1, size, size, size, 4096, 0.0) - 1.0 / 11) < 0.02);
+    CHECK(sampleOccupation(dense.data(), 1, size, size, size, 256, 0.0) == 1.0);
+
+    BoosterSettings settings;
+    settings.minDimension = 32;
+    GemmCall<float> call{'N', 'N', size, size, size, 1.0f, dense.data(), size, sparse.data(), size, 0.0f, C.data(), size};
+    CHECK(isBoostable(call, settings));
+
+    call.B = dense.data();
+    CHECK(!isBoostable(call, settings));
+
+    call.B = sparse.data();
+    settings.minDimension = 128;
+    CHECK(!isBoostable(call, settings));
+}
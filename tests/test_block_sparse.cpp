@@ -0,0 +1,216 @@
+#include <catch2/catch_test_macros.hpp>
+#include "BlockSparseMatrix.h"
+#include "BlockSparseMultiplication.h"
+#include "DenseMatrix.h"
+#include "MatrixConverter.h"
+#include "MatrixGenerator.h"
+#include "MatrixMultExp.h"
+#include "SparseMatrix.h"
+#include <cmath>
+
+using namespace BlasBooster;
+
+namespace {
+
+typedef Parameter<size_t, ColumnMajor> CM;
+typedef Parameter<size_t, RowMajor> RM;
+
+/// Randomly filled 4 x 4 tiles, about a quarter of the tiles is nonzero
+MatrixGenerator createClusteredGenerator(size_t nbRows, size_t nbColumns, uint64_t seed)
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = nbRows;
+    settings.nbColumns = nbColumns;
+    settings.blockSize = 4;
+    settings.blockOccupation = 0.25;
+    settings.occupation = 0.8;
+    settings.seed = seed;
+    return MatrixGenerator(settings);
+}
+
+template <class P = CM>
+Matrix<Dense, double, P> createClusteredMatrix(size_t nbRows, size_t nbColumns, uint64_t seed)
+{
+    return createClusteredGenerator(nbRows, nbColumns, seed).createDense<double, P>();
+}
+
+auto nonZero = [](double value) { return value != 0.0; };
+
+template <class X, class Y>
+bool equal(X const& x, Y const& y)
+{
+    if (x.getNbRows() != y.getNbRows() or x.getNbColumns() != y.getNbColumns()) return false;
+    for (size_t i = 0; i != x.getNbRows(); ++i)
+        for (size_t j = 0; j != x.getNbColumns(); ++j)
+            if (std::abs(x(i, j) - y(i, j)) > 1e-12) return false;
+    return true;
+}
+
+/// Conversions Dense -> BlockSparse -> Dense and Sparse -> BlockSparse -> Sparse
+template <size_t TileSize, class P, class PS>
+void checkConversion(size_t nbRows, size_t nbColumns, size_t tileSize)
+{
+    auto A = createClusteredMatrix(nbRows, nbColumns, 7);
+
+    Matrix<BlockSparse<TileSize>, double, P> B(A, nonZero, tileSize);
+    REQUIRE(B.getTileSize() == tileSize);
+    CHECK(B.getNbTileRows() == (nbRows + tileSize - 1) / tileSize);
+    CHECK(B.getNbTileColumns() == (nbColumns + tileSize - 1) / tileSize);
+    CHECK(B.nnz() == B.getNbTiles() * tileSize * tileSize);
+    CHECK(equal(B, A));
+    CHECK(equal(Matrix<Dense, double>(B), A));
+    CHECK(std::abs(NormFunctor<NormOne>()(B) - NormFunctor<NormOne>()(A)) < 1e-12);
+
+    Matrix<Sparse, double, PS> sparseA(A, nonZero);
+    Matrix<BlockSparse<TileSize>, double, P> C(sparseA, tileSize);
+    CHECK(C == B);
+
+    Matrix<Sparse, double, PS> sparseC(C, nonZero);
+    CHECK(sparseC.nnz() == sparseA.nnz());
+    CHECK(equal(Matrix<Dense, double>(sparseC), A));
+}
+
+/// All kernels of BlockSparse x Dense, Dense x BlockSparse and BlockSparse x BlockSparse against the dense product
+template <size_t TileSize, class P, class PD>
+void checkMultiplication(size_t m, size_t n, size_t k, size_t tileSize)
+{
+    auto A = createClusteredMatrix<PD>(m, k, 1);
+    auto B = createClusteredMatrix<PD>(k, n, 2);
+    Matrix<Dense, double> reference = createClusteredMatrix(m, k, 1) * createClusteredMatrix(k, n, 2);
+
+    Matrix<BlockSparse<TileSize>, double, P> blockA(A, nonZero, tileSize);
+    Matrix<BlockSparse<TileSize>, double, P> blockB(B, nonZero, tileSize);
+
+    Matrix<Dense, double, PD> C1(m, n), C2(m, n), C3(m, n), C4(m, n);
+    MultiplicationFunctor<BlockSparse<TileSize>, double, P, Dense, double, PD, Dense, double, PD, Native>()(blockA, B, C1);
+    MultiplicationFunctor<Dense, double, PD, BlockSparse<TileSize>, double, P, Dense, double, PD, Native>()(A, blockB, C2);
+    MultiplicationFunctor<BlockSparse<TileSize>, double, P, BlockSparse<TileSize>, double, P, Dense, double, PD, Native>()(
+        blockA, blockB, C3);
+
+    // alpha and beta
+    C4 = 1.0;
+    MultiplicationFunctor<BlockSparse<TileSize>, double, P, Dense, double, PD, Dense, double, PD, Native>()(blockA, B, C4, 2.0, 3.0);
+
+    CHECK(equal(C1, reference));
+    CHECK(equal(C2, reference));
+    CHECK(equal(C3, reference));
+
+    bool scaled = true;
+    for (size_t i = 0; i != m; ++i)
+        for (size_t j = 0; j != n; ++j) scaled = scaled and std::abs(C4(i, j) - 3.0 - 2.0 * reference(i, j)) < 1e-12;
+    CHECK(scaled);
+}
+
+} // namespace
+
+TEST_CASE("BlockSparseMatrix conversions", "[block_sparse]")
+{
+    checkConversion<4, CM, CM>(16, 12, 4);
+    checkConversion<4, RM, RM>(16, 12, 4);
+    checkConversion<4, CM, RM>(19, 13, 4);
+    checkConversion<4, RM, CM>(13, 19, 4);
+    checkConversion<0, CM, CM>(23, 17, 3);
+    checkConversion<0, RM, CM>(17, 23, 5);
+}
+
+TEST_CASE("BlockSparseMatrix element access", "[block_sparse]")
+{
+    Matrix<Dense, double> A(6, 5);
+    A = 0.0;
+    A(0, 0) = 1.0;
+    A(5, 4) = 2.0;
+    A(1, 4) = 3.0;
+
+    Matrix<BlockSparse<4>, double> B(A, nonZero);
+    CHECK(B.getNbTiles() == 3);
+    CHECK(B(0, 0) == 1.0);
+    CHECK(B(5, 4) == 2.0);
+    CHECK(B(1, 4) == 3.0);
+    CHECK(B(4, 0) == 0.0);
+    CHECK(B(1, 1) == 0.0);
+
+    // Elements of the border tiles outside of the matrix are skipped
+    size_t nbElements = 0;
+    B.forEachElement([&](size_t i, size_t j, double) { nbElements += i < 6 and j < 5; });
+    CHECK(nbElements == 16 + 4 + 2);
+
+    Matrix<BlockSparse<4>, double> copy(B);
+    CHECK(copy == B);
+
+    CHECK_THROWS_AS((Matrix<BlockSparse<4>, double>(A, nonZero, 3)), std::runtime_error);
+    CHECK_THROWS_AS((Matrix<BlockSparse<>, double>(A, nonZero)), std::runtime_error);
+}
+
+TEST_CASE("BlockSparseMatrix multiplication", "[block_sparse]")
+{
+    checkMultiplication<4, CM, CM>(16, 20, 12, 4);
+    checkMultiplication<4, CM, CM>(70, 13, 19, 4);
+    checkMultiplication<4, RM, RM>(70, 13, 19, 4);
+    checkMultiplication<4, RM, CM>(21, 9, 15, 4);
+    checkMultiplication<4, CM, RM>(21, 9, 15, 4);
+    checkMultiplication<0, CM, CM>(22, 130, 17, 3);
+    checkMultiplication<0, RM, RM>(22, 130, 17, 6);
+}
+
+TEST_CASE("BlockSparseMatrix mixed precision and sparse partners", "[block_sparse]")
+{
+    auto A = createClusteredMatrix(18, 11, 3);
+    auto B = createClusteredMatrix(11, 14, 4);
+
+    // Values of A representable in single precision
+    for (auto& value : A) value = static_cast<float>(value);
+    Matrix<Dense, double> reference = A * B;
+
+    Matrix<BlockSparse<4>, float> blockA(A, nonZero);
+    Matrix<Sparse, double> sparseA(A, nonZero), sparseB(B, nonZero);
+    Matrix<BlockSparse<4>, double> blockB(B, nonZero);
+
+    Matrix<Dense, double> C1(18, 14), C2(18, 14), C3(18, 14);
+    MultiplicationFunctor<BlockSparse<4>, float, CM, Dense, double, CM, Dense, double, CM, Native>()(blockA, B, C1);
+    MultiplicationFunctor<BlockSparse<4>, float, CM, Sparse, double, CM, Dense, double, CM, Native>()(blockA, sparseB, C2);
+    MultiplicationFunctor<Sparse, double, CM, BlockSparse<4>, double, CM, Dense, double, CM, Native>()(sparseA, blockB, C3);
+
+    CHECK(equal(C1, reference));
+    CHECK(equal(C2, reference));
+    CHECK(equal(C3, reference));
+}
+
+TEST_CASE("MatrixConverter block-sparse selection", "[block_sparse]")
+{
+    typedef Parameter<size_t, ColumnMajor, VariableSize, NoLeadingDimension, UnblockedDimension> BlockedParameter;
+
+    // Block (0,0): clustered tiles, block (1,0): scattered elements, block (0,1) dense, all in double precision
+    Matrix<Dense, double> A(32, 32);
+    A = 0.0;
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t j = 0; j < 16; ++j) {
+            if ((i / 4 + j / 4) % 4 == 0) A(i, j) = 1.0 + i + 0.1 * j;
+            A(i, 16 + j) = 2.0 + i * j;
+        }
+        A(16 + i, (i * 5) % 16) = 3.0 + i;
+    }
+
+    auto s = MatrixConverter::analyse(A.getDataPointer(), 1, 32, 16, 16, 0.0);
+    CHECK(s.nbSignificantTiles == 4);
+    CHECK(s.getTileFill() == 1.0);
+    CHECK(s.getTileOccupation() == 0.25);
+
+    ConverterSettings settings;
+    settings.blockSize = 16;
+    settings.costModel = nullptr;
+    MatrixConverter converter(settings);
+
+    Matrix<Dense, DynamicMatrix, BlockedParameter> B;
+    converter(A, B);
+    CHECK(B(0, 0).getTypeIndex() == Matrix<BlockSparse<4>, double>::typeIndex_);
+    CHECK(B(1, 0).getTypeIndex() == Matrix<Sparse, double>::typeIndex_);
+    CHECK(B(0, 1).getTypeIndex() == Matrix<Dense, double>::typeIndex_);
+    CHECK(B(0, 0).getOccupation() == 0.25);
+
+    auto const& block = B(0, 0).get<Matrix<BlockSparse<4>, double>>();
+    CHECK(std::abs(block.norm() - NormFunctor<NormTwo>()(block)) < 1e-12);
+
+    Matrix<Dense, double> C;
+    converter(B, C);
+    CHECK(equal(C, A));
+}
@@ -0,0 +1,245 @@
+#include <catch2/catch_test_macros.hpp>
+#include "BlockedMultiplication.h"
+#include "MultiplicationFunctor.h"
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+using namespace BlasBooster;
+
+namespace {
+
+typedef Parameter<size_t, ColumnMajor, VariableSize, NoLeadingDimension, UnblockedDimension> BlockedParameter;
+typedef Matrix<Dense, DynamicMatrix, BlockedParameter> BlockedMatrix;
+
+double testValue(size_t i, size_t j, int seed)
+{
+    return static_cast<double>(static_cast<int>((i * 5 + j * 3 + seed) % 13) - 6) / 8;
+}
+
+/// Blocks alternate between Matrix<Dense,double> and Matrix<Dense,float>
+BlockedMatrix createBlocked(std::vector<size_t> const& rows, std::vector<size_t> const& columns, int seed)
+{
+    size_t ubRows = 0, ubColumns = 0;
+    for (auto r : rows) ubRows += r;
+    for (auto c : columns) ubColumns += c;
+
+    BlockedMatrix A(rows.size(), columns.size(), ubRows, ubColumns);
+    size_t rowOffset = 0;
+    for (size_t i = 0; i != rows.size(); ++i) {
+        size_t columnOffset = 0;
+        for (size_t j = 0; j != columns.size(); ++j) {
+            if ((i + j) % 2) {
+                auto block = new Matrix<Dense, float>(rows[i], columns[j]);
+                for (size_t r = 0; r != rows[i]; ++r)
+                    for (size_t c = 0; c != columns[j]; ++c)
+                        (*block)(r, c) = testValue(rowOffset + r, columnOffset + c, seed);
+                A(i, j) = DynamicMatrix(block);
+            } else {
+                auto block = new Matrix<Dense, double>(rows[i], columns[j]);
+                for (size_t r = 0; r != rows[i]; ++r)
+                    for (size_t c = 0; c != columns[j]; ++c)
+                        (*block)(r, c) = testValue(rowOffset + r, columnOffset + c, seed);
+                A(i, j) = DynamicMatrix(block);
+            }
+            columnOffset += columns[j];
+        }
+        rowOffset += rows[i];
+    }
+    return A;
+}
+
+struct DenseBlockProduct
+{
+    template <class X1, class X2>
+    void multiply(X1 const& a, X2 const& b, Matrix<Dense, double>& c) const
+    {
+        MultiplicationFunctor<Dense, typename X1::value_type, Parameter<>, Dense, typename X2::value_type, Parameter<>,
+            Dense, double, Parameter<>, Native>()(a, b, c, 1.0, 1.0);
+    }
+
+    template <class X1>
+    void multiply(X1 const& a, DynamicMatrix const& b, Matrix<Dense, double>& c) const
+    {
+        if (b.getTypeIndex() == Matrix<Dense, float>::typeIndex_) multiply(a, b.get<Matrix<Dense, float>>(), c);
+        else multiply(a, b.get<Matrix<Dense, double>>(), c);
+    }
+
+    void operator () (DynamicMatrix const& a, DynamicMatrix const& b, Matrix<Dense, double>& c) const
+    {
+        ++count;
+        if (a.getTypeIndex() == Matrix<Dense, float>::typeIndex_) multiply(a.get<Matrix<Dense, float>>(), b, c);
+        else multiply(a.get<Matrix<Dense, double>>(), b, c);
+    }
+
+    mutable std::atomic<size_t> count{0};
+};
+
+} // namespace
+
+TEST_CASE("WorkStealingScheduler executes each task once", "[scheduler]")
+{
+    std::vector<std::atomic<int>> executed(1000);
+    WorkStealingScheduler(8).run(executed.size(), [&](size_t i){ ++executed[i]; }, [](size_t i){ return double(i % 7); });
+
+    bool allOnce = true;
+    for (auto const& e : executed) allOnce = allOnce and e == 1;
+    CHECK(allOnce);
+}
+
+TEST_CASE("WorkStealingScheduler partition and pinned workers", "[scheduler]")
+{
+    WorkStealingScheduler scheduler(3, true);
+    CHECK(scheduler.isPinned());
+
+    // Longest processing time first, equal costs are dealt round-robin
+    CHECK(scheduler.getPartition(5, [](size_t){ return 1.0; }) == std::vector<size_t>{0, 1, 2, 0, 1});
+    CHECK(scheduler.getPartition(4, [](size_t i){ return i == 3 ? 10.0 : 1.0; }) == std::vector<size_t>{1, 2, 1, 0});
+
+    std::vector<std::atomic<int>> executed(3);
+    scheduler.runOnEachWorker([&](size_t id){ ++executed[id]; });
+    CHECK((executed[0] == 1 and executed[1] == 1 and executed[2] == 1));
+
+    std::atomic<size_t> sum{0};
+    scheduler.run(100, [&](size_t i){ sum += i; });
+    CHECK(sum == 4950);
+}
+
+TEST_CASE("WorkStealingScheduler forwards exceptions", "[scheduler]")
+{
+    CHECK_THROWS_AS(WorkStealingScheduler(4).run(100, [](size_t i){ if (i == 42) throw std::runtime_error("task"); }),
+        std::runtime_error);
+}
+
+TEST_CASE("Blocked multiplication of DynamicMatrix blocks", "[scheduler]")
+{
+    std::vector<size_t> rowsA{17, 32, 5}, inner{23, 8, 40, 11}, columnsB{29, 16};
+    BlockedMatrix A = createBlocked(rowsA, inner, 1);
+    BlockedMatrix B = createBlocked(inner, columnsB, 2);
+    BlockedMatrix C;
+
+    DenseBlockProduct product;
+    multiplyBlocked(A, B, C, product, WorkStealingScheduler(4));
+
+    CHECK(product.count == 3 * 4 * 2);
+    REQUIRE(C.getNbRows() == 3);
+    REQUIRE(C.getNbColumns() == 2);
+    CHECK(C.getUnblockedRows() == 54);
+    CHECK(C.getUnblockedColumns() == 45);
+
+    bool correct = true;
+    size_t rowOffset = 0;
+    for (size_t i = 0; i != 3; ++i) {
+        size_t columnOffset = 0;
+        for (size_t j = 0; j != 2; ++j) {
+            auto const& tile = C(i, j).get<Matrix<Dense, double>>();
+            for (size_t r = 0; r != tile.getNbRows(); ++r) {
+                for (size_t c = 0; c != tile.getNbColumns(); ++c) {
+                    double reference = 0.0;
+                    for (size_t k = 0; k != 82; ++k)
+                        reference += testValue(rowOffset + r, k, 1) * testValue(k, columnOffset + c, 2);
+                    correct = correct and std::abs(tile(r, c) - reference) < 1e-5;
+                }
+            }
+            columnOffset += tile.getNbColumns();
+        }
+        rowOffset += C(i, 0).getNbRows();
+    }
+    CHECK(correct);
+}
+
+TEST_CASE("Blocked multiplication with empty blocks", "[scheduler]")
+{
+    std::vector<size_t> rowsA{17, 32, 5}, inner{23, 8, 40, 11}, columnsB{29, 16};
+    BlockedMatrix A = createBlocked(rowsA, inner, 1);
+    BlockedMatrix B = createBlocked(inner, columnsB, 2);
+
+    // Block column 0 and the last block row of A, and block row 0 of B are not stored
+    for (size_t i = 0; i != 3; ++i) A(i, 0) = DynamicMatrix();
+    for (size_t k = 0; k != 4; ++k) A(2, k) = DynamicMatrix();
+    for (size_t j = 0; j != 2; ++j) B(0, j) = DynamicMatrix();
+    BlockedMatrix C;
+
+    DenseBlockProduct product;
+    multiplyBlocked(A, B, C, product, WorkStealingScheduler(4));
+    CHECK(product.count == 2 * 3 * 2);
+
+    bool correct = true;
+    size_t rowOffset = 0;
+    for (size_t i = 0; i != 3; ++i) {
+        size_t columnOffset = 0;
+        for (size_t j = 0; j != 2; ++j) {
+            auto const& tile = C(i, j).get<Matrix<Dense, double>>();
+            REQUIRE(tile.getNbRows() == rowsA[i]);
+            REQUIRE(tile.getNbColumns() == columnsB[j]);
+            for (size_t r = 0; r != rowsA[i]; ++r) {
+                for (size_t c = 0; c != columnsB[j]; ++c) {
+                    double reference = 0.0;
+                    for (size_t k = 23; k != 82 and i != 2; ++k)
+                        reference += testValue(rowOffset + r, k, 1) * testValue(k, columnOffset + c, 2);
+                    correct = correct and std::abs(tile(r, c) - reference) < 1e-5;
+                }
+            }
+            columnOffset += columnsB[j];
+        }
+        rowOffset += rowsA[i];
+    }
+    CHECK(correct);
+
+    // The sizes of two empty block rows can not be determined
+    for (size_t k = 0; k != 4; ++k) A(1, k) = DynamicMatrix();
+    CHECK_THROWS(multiplyBlocked(A, B, C, product, WorkStealingScheduler(4)));
+}
+
+TEST_CASE("Blocked multiplication with norm-based screening", "[scheduler]")
+{
+    // Blocks decaying exponentially away from the diagonal
+    const size_t nbBlocks = 6, blockSize = 8;
+    auto create = [&](int seed) {
+        BlockedMatrix A(nbBlocks, nbBlocks, nbBlocks * blockSize, nbBlocks * blockSize);
+        for (size_t i = 0; i != nbBlocks; ++i) {
+            for (size_t j = 0; j != nbBlocks; ++j) {
+                auto block = new Matrix<Dense, double>(blockSize, blockSize);
+                double decay = std::pow(10.0, -3.0 * std::abs(double(i) - double(j)));
+                for (size_t r = 0; r != blockSize; ++r)
+                    for (size_t c = 0; c != blockSize; ++c)
+                        (*block)(r, c) = decay * testValue(i * blockSize + r, j * blockSize + c, seed);
+                A(i, j) = DynamicMatrix(block);
+            }
+        }
+        return A;
+    };
+
+    BlockedMatrix A = create(1), B = create(2);
+    BlockedMatrix exact, screened;
+
+    DenseBlockProduct exactProduct, screenedProduct;
+    multiplyBlocked(A, B, exact, exactProduct, WorkStealingScheduler(4));
+
+    BlockedMultiplicationSettings settings;
+    settings.screeningTolerance = 1e-7;
+    multiplyBlocked(A, B, screened, screenedProduct, WorkStealingScheduler(4), settings);
+
+    // Only products with |i - k| + |k - j| <= 2 remain
+    size_t expected = 0;
+    for (size_t i = 0; i != nbBlocks; ++i)
+        for (size_t k = 0; k != nbBlocks; ++k)
+            for (size_t j = 0; j != nbBlocks; ++j)
+                expected += std::abs(double(i) - double(k)) + std::abs(double(k) - double(j)) <= 2;
+    CHECK(screenedProduct.count == expected);
+    CHECK(exactProduct.count == nbBlocks * nbBlocks * nbBlocks);
+
+    // Error of each tile is bounded by the number of inner blocks times the tolerance
+    bool bounded = true;
+    for (size_t i = 0; i != nbBlocks; ++i) {
+        for (size_t j = 0; j != nbBlocks; ++j) {
+            auto const& e = exact(i, j).get<Matrix<Dense, double>>();
+            auto const& s = screened(i, j).get<Matrix<Dense, double>>();
+            double error = 0.0;
+            for (size_t r = 0; r != blockSize; ++r)
+                for (size_t c = 0; c != blockSize; ++c) error += std::pow(e(r, c) - s(r, c), 2);
+            bounded = bounded and std::sqrt(error) < nbBlocks * settings.screeningTolerance;
+        }
+    }
+    CHECK(bounded);
+}
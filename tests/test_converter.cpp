@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+#include "MatrixConverter.h"
+#include "MatrixGenerator.h"
+#include <cmath>
+#include <numeric>
+
+using namespace BlasBooster;
+
+namespace {
+
+typedef Parameter<size_t, ColumnMajor, VariableSize, NoLeadingDimension, UnblockedDimension> BlockedParameter;
+
+/// 32 x 16 matrix with blocks of size 8 designed for each matrix type
+template <class P>
+Matrix<Dense, double, P> createTestMatrix()
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = 32;
+    settings.nbColumns = 16;
+    settings.tileSize = 8;
+    settings.threshold = 1e-8;
+    settings.sparseOccupation = 0.15;
+    settings.tileClasses = {
+        TileClass::Zero, TileClass::DenseDouble,
+        TileClass::SparseSingle, TileClass::Zero,
+        TileClass::DenseSingle, TileClass::Zero,
+        TileClass::SparseDouble, TileClass::Zero};
+    auto A = MatrixGenerator(settings).createDense<double, P>();
+
+    // Block (1,1): elements below the threshold
+    for (size_t i = 0; i < 8; ++i)
+        for (size_t j = 0; j < 8; ++j) A(8 + i, 8 + j) = 1e-12;
+    return A;
+}
+
+} // namespace
+
+TEST_CASE("MatrixConverter fused scan", "[converter]")
+{
+    Matrix<Dense, double> A
+    {
+        { 1.0, -2.0},
+        { 0.0,  1e-9}
+    };
+
+    auto s = MatrixConverter::analyse(A.getDataPointer(), 1, 2, 2, 2, 1e-8);
+    CHECK(s.nbElements == 4);
+    CHECK(s.nbSignificant == 2);
+    CHECK(s.nbDouble == 2);
+    CHECK(s.normMax == 2.0);
+    CHECK(std::abs(s.normOne - 2.0) < 1e-8);
+    CHECK(std::abs(s.normTwo - std::sqrt(5.0)) < 1e-12);
+    CHECK(std::accumulate(s.histogram.begin(), s.histogram.end(), size_t(0)) == 4);
+    CHECK(s.histogram[BlockStatistics::getBin(1.0)] == 2);
+    CHECK(s.histogram[BlockStatistics::getBin(1e-9)] == 1);
+}
+
+TEST_CASE("MatrixConverter type selection", "[converter]")
+{
+    auto A = createTestMatrix<Parameter<>>();
+
+    ConverterSettings settings;
+    settings.blockSize = 8;
+    settings.threshold = 1e-8;
+    MatrixConverter converter(settings, WorkStealingScheduler(4));
+
+    Matrix<Dense, DynamicMatrix, BlockedParameter> B;
+    converter(A, B);
+
+    REQUIRE(B.getNbRows() == 4);
+    REQUIRE(B.getNbColumns() == 2);
+    CHECK(B(0, 0).getTypeIndex() == Matrix<Zero>::typeIndex_);
+    CHECK(B(1, 0).getTypeIndex() == Matrix<Sparse, float>::typeIndex_);
+    CHECK(B(2, 0).getTypeIndex() == Matrix<Dense, float>::typeIndex_);
+    CHECK(B(3, 0).getTypeIndex() == Matrix<Sparse, double>::typeIndex_);
+    CHECK(B(0, 1).getTypeIndex() == Matrix<Dense, double>::typeIndex_);
+    CHECK(B(1, 1).getTypeIndex() == Matrix<Zero>::typeIndex_);
+    size_t nnz = 0;
+    for (size_t i = 0; i < 8; ++i)
+        for (size_t j = 0; j < 8; ++j) nnz += A(8 + i, j) != 0.0;
+    CHECK(nnz > 0);
+    CHECK(B(1, 0).get<Matrix<Sparse, float>>().nnz() == nnz);
+
+    // Norms are cached from the scan
+    auto const& sparse = B(3, 0).get<Matrix<Sparse, double>>();
+    CHECK(std::abs(sparse.norm() - NormFunctor<NormTwo>()(sparse)) < 1e-12);
+    CHECK(B(1, 1).getNorm() == 0.0);
+
+    Matrix<Dense, double> C;
+    converter(B, C);
+    REQUIRE(C.getNbRows() == 32);
+    REQUIRE(C.getNbColumns() == 16);
+
+    bool equal = true;
+    for (size_t i = 0; i < 32; ++i)
+        for (size_t j = 0; j < 16; ++j)
+            equal = equal and std::abs(C(i, j) - (std::abs(A(i, j)) > 1e-8 ? A(i, j) : 0.0)) < 1e-8;
+    CHECK(equal);
+}
+
+TEST_CASE("MatrixConverter RowMajor source with incomplete blocks", "[converter]")
+{
+    auto A = createTestMatrix<Parameter<size_t, RowMajor>>();
+
+    ConverterSettings settings;
+    settings.blockSize = 12;
+    settings.threshold = 1e-8;
+
+    Matrix<Dense, DynamicMatrix, BlockedParameter> B;
+    MatrixConverter converter(settings);
+    converter(A, B);
+    REQUIRE(B.getNbRows() == 3);
+    REQUIRE(B.getNbColumns() == 2);
+    CHECK(B(2, 1).getNbRows() == 8);
+    CHECK(B(2, 1).getNbColumns() == 4);
+
+    Matrix<Dense, double, Parameter<size_t, RowMajor>> C(32, 16);
+    converter(B, C);
+
+    bool equal = true;
+    for (size_t i = 0; i < 32; ++i)
+        for (size_t j = 0; j < 16; ++j)
+            equal = equal and std::abs(C(i, j) - (std::abs(A(i, j)) > 1e-8 ? A(i, j) : 0.0)) < 1e-8;
+    CHECK(equal);
+}
+
+TEST_CASE("MatrixConverter blocked source with empty blocks", "[converter]")
+{
+    auto A = createTestMatrix<Parameter<>>();
+
+    ConverterSettings settings;
+    settings.blockSize = 8;
+    settings.threshold = 1e-8;
+
+    Matrix<Dense, DynamicMatrix, BlockedParameter> B;
+    MatrixConverter converter(settings);
+    converter(A, B);
+
+    // Block row 0 and block column 0 are not stored except for block (3,0)
+    B(0, 0) = DynamicMatrix();
+    B(0, 1) = DynamicMatrix();
+    for (size_t i = 1; i != 3; ++i) B(i, 0) = DynamicMatrix();
+
+    Matrix<Dense, double> C(32, 16);
+    C = 1.0;
+    converter(B, C);
+
+    bool equal = true;
+    for (size_t i = 0; i < 32; ++i) {
+        for (size_t j = 0; j < 16; ++j) {
+            bool stored = i >= 8 and (j >= 8 or i >= 24);
+            double expected = stored and std::abs(A(i, j)) > 1e-8 ? A(i, j) : 0.0;
+            equal = equal and std::abs(C(i, j) - expected) < 1e-8;
+        }
+    }
+    CHECK(equal);
+}
@@ -0,0 +1,184 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "Calibration.h"
+#include "CostModel.h"
+#include "MatrixConverter.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace BlasBooster;
+
+namespace {
+
+std::string getTemporaryFilename(std::string const& name)
+{
+    return (std::filesystem::temp_directory_path() / ("blasbooster_" + name)).string();
+}
+
+const size_t sparseDouble = GetIndex<Matrix<Sparse,double>, DynamicMatrixTypeList>::value;
+const size_t denseDouble = GetIndex<Matrix<Dense,double>, DynamicMatrixTypeList>::value;
+
+/// Sparse double kernel 4 times slower per flop than the dense kernel
+CostModel createModel()
+{
+    CostModel model;
+    model.setKind(sparseDouble, CostModel::Kind::Sparse);
+    model.setKind(denseDouble, CostModel::Kind::Dense);
+    model.setCoefficients(sparseDouble, denseDouble, {true, {0.0, 4e-9, 0.0}});
+    model.setCoefficients(denseDouble, denseDouble, {true, {0.0, 1e-9, 0.0}});
+    return model;
+}
+
+} // namespace
+
+TEST_CASE("CostModel fit")
+{
+    CostModel model;
+    model.setKind(sparseDouble, CostModel::Kind::Sparse);
+    model.setKind(denseDouble, CostModel::Kind::Dense);
+
+    std::vector<CostSample> samples;
+    for (double work : {1e3, 1e5, 1e7})
+        for (double outputSize : {64.0, 1024.0})
+            samples.push_back({work, outputSize, 1e-6 + 2e-10 * work + 3e-9 * outputSize});
+
+    model.fit(sparseDouble, denseDouble, samples);
+
+    auto const& c = model.getCoefficients(sparseDouble, denseDouble);
+    REQUIRE(c.valid);
+    CHECK(c.c[0] == Catch::Approx(1e-6).epsilon(1e-6));
+    CHECK(c.c[1] == Catch::Approx(2e-10).epsilon(1e-6));
+    CHECK(c.c[2] == Catch::Approx(3e-9).epsilon(1e-6));
+
+    CHECK(model.predict(sparseDouble, denseDouble, 10, 10, 10, 0.5) == Catch::Approx(1e-6 + 2e-10 * 1000 + 3e-7));
+    CHECK(model.predict(denseDouble, sparseDouble, 10, 10, 10) == HUGE_VAL);
+}
+
+TEST_CASE("CostModel crossover occupation")
+{
+    CostModel model = createModel();
+    CHECK(model.getCrossoverOccupation(sparseDouble, denseDouble, denseDouble, 64) == Catch::Approx(0.25));
+
+    ConverterSettings settings;
+    settings.costModel = std::make_shared<CostModel>(model);
+    CHECK(settings.getSparseOccupation(sparseDouble, denseDouble) == Catch::Approx(0.25));
+
+    settings.costModel.reset();
+    CHECK(settings.getSparseOccupation(sparseDouble, denseDouble) == settings.sparseOccupation);
+}
+
+TEST_CASE("CostModel database")
+{
+    const std::string filename = getTemporaryFilename("cost_model.txt");
+    std::remove(filename.c_str());
+
+    CostModel model = createModel();
+    model.setCpuName("CPU A");
+    model.save(filename);
+
+    model.setCoefficients(denseDouble, denseDouble, {true, {0.0, 2e-9, 0.0}});
+    model.setCpuName("CPU B");
+    model.save(filename);
+
+    // Saving again replaces the section of the same CPU
+    model.save(filename);
+
+    auto a = CostModel::load(filename, "CPU A");
+    auto b = CostModel::load(filename, "CPU B");
+    REQUIRE(a);
+    REQUIRE(b);
+    CHECK(!CostModel::load(filename, "CPU C"));
+    CHECK(a->getKind(sparseDouble) == CostModel::Kind::Sparse);
+    CHECK(a->getCoefficients(denseDouble, denseDouble).c[1] == 1e-9);
+    CHECK(b->getCoefficients(denseDouble, denseDouble).c[1] == 2e-9);
+    CHECK(!b->getCoefficients(denseDouble, sparseDouble).valid);
+
+    std::ifstream file(filename);
+    size_t nbSections = 0;
+    for (std::string line; std::getline(file, line); ) nbSections += line.rfind("cpu ", 0) == 0;
+    CHECK(nbSections == 2);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("CostModel database of another version or type list")
+{
+    const std::string filename = getTemporaryFilename("cost_model_invalid.txt");
+
+    // Version 1 without type list
+    {
+        std::ofstream file(filename);
+        file << "# BlasBooster cost model database, version 1\n"
+             << "cpu CPU A\n" << "kind 3 1\n" << "pair 3 6 0 4e-09 0\n" << "end\n";
+    }
+    CHECK_THROWS_AS(CostModel::load(filename, "CPU A"), std::runtime_error);
+    CHECK_THROWS_AS(createModel().save(filename), std::runtime_error);
+
+    // Type list with a missing type
+    CostModel model = createModel();
+    model.setCpuName("CPU A");
+    std::remove(filename.c_str());
+    model.save(filename);
+    REQUIRE(CostModel::load(filename, "CPU A"));
+
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(filename);
+        for (std::string line; std::getline(file, line); )
+            if (line != "type 1 " + CostModel::getTypeNames()[1]) lines.push_back(line);
+    }
+    {
+        std::ofstream file(filename);
+        for (auto const& line : lines) file << line << "\n";
+    }
+    CHECK_THROWS_AS(CostModel::load(filename, "CPU A"), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Calibration")
+{
+    CalibrationSettings settings;
+    settings.blockSizes = {8, 16};
+    settings.occupations = {0.1, 0.5, 1.0};
+    settings.nbRepetitions = 1;
+
+    CostModel model = Calibration(settings)();
+
+    CHECK(model.getKind(sparseDouble) == CostModel::Kind::Sparse);
+    CHECK(model.getCoefficients(denseDouble, denseDouble).valid);
+    CHECK(model.getCoefficients(sparseDouble, denseDouble).valid);
+    CHECK(model.predict(sparseDouble, denseDouble, 16, 16, 16, 0.5) < HUGE_VAL);
+
+    // Block-sparse blocks are sampled with clustered tiles
+    const size_t blockSparse = Matrix<BlockSparse<4>,double>::typeIndex_;
+    CHECK(model.getKind(blockSparse) == CostModel::Kind::Sparse);
+    CHECK(model.getCoefficients(blockSparse, denseDouble).valid);
+
+    // MultipleMatrix with sparse bulk is not available for conversion
+    const size_t multiple = GetIndex<MultipleMatrix<Matrix<Sparse,double>, Matrix<Sparse,float>>, DynamicMatrixTypeList>::value;
+    CHECK(!model.getCoefficients(multiple, denseDouble).valid);
+}
+
+TEST_CASE("MatrixConverter with cost model")
+{
+    // 8 x 8 block with occupation 0.5
+    Matrix<Dense,double> A(8, 8);
+    for (size_t j = 0; j < 8; ++j)
+        for (size_t i = 0; i < 8; ++i) A(i, j) = (i + j) % 2 ? 1.0 : 0.0;
+
+    auto statistics = MatrixConverter::analyse(A.getDataPointer(), 1, 8, 8, 8, 0.0);
+
+    ConverterSettings settings;
+    settings.blockSize = 8;
+    settings.costModel.reset();
+    CHECK(MatrixConverter(settings).selectType(statistics) == denseDouble);
+
+    // Sparse kernel only slightly slower per flop: crossover at occupation 0.8
+    CostModel model = createModel();
+    model.setCoefficients(sparseDouble, denseDouble, {true, {0.0, 1.25e-9, 0.0}});
+    settings.costModel = std::make_shared<CostModel>(model);
+    CHECK(MatrixConverter(settings).selectType(statistics) == sparseDouble);
+}
@@ -1,5 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
 #include "DenseMatrix.h"
+#include <cmath>
 
 using namespace BlasBooster;
 
@@ -28,3 +29,37 @@ TEST_CASE("DenseMatrix initializer_list", "[double]")
     CHECK(A.getSize() == 6);
     // CHECK(A(0, 0) == 2.0);
 }
+
+TEST_CASE("DenseMatrix norms", "[double]")
+{
+    Matrix<Dense, double> A
+    {
+        { 2.0,  3.0},
+        {-4.0,  1.0},
+        { 7.0, -1.0}
+    };
+    CHECK(A.norm() == std::sqrt(80.0));
+    CHECK(NormFunctor<NormOne>()(A) == 13.0);
+    CHECK(NormFunctor<NormMax>()(A) == 7.0);
+
+    // The cached norm is reset by the assignment of a value
+    A = 1.0;
+    CHECK(A.norm() == std::sqrt(6.0));
+}
+
+TEST_CASE("DenseMatrix orientation conversion", "[double]")
+{
+    Matrix<Dense, double> A(37, 45);
+    for (size_t j = 0; j != 45; ++j)
+        for (size_t i = 0; i != 37; ++i) A(i, j) = i + 100.0 * j;
+
+    Matrix<Dense, float, Parameter<size_t, RowMajor>> B(A, [](double){ return true; });
+    CHECK(B.getNbRows() == 37);
+    CHECK(B.getNbColumns() == 45);
+    CHECK(B(36, 44) == 4436.0f);
+    CHECK(B.getDataPointer()[1] == 100.0f);
+
+    Matrix<Dense, double> C(B, [](float){ return true; });
+    CHECK(C(5, 33) == 3305.0);
+    CHECK(C.getDataPointer()[1] == 1.0);
+}
@@ -1,6 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include "DenseMatrix.h"
 #include "DynamicMatrix.h"
+#include "DynamicMultiplication.h"
+#include "MatrixGenerator.h"
+#include "MatrixMultExp.h"
+#include <cmath>
+#include <vector>
 
 using namespace BlasBooster;
 
@@ -9,6 +14,106 @@ TEST_CASE("DynamicMatrix", "default constructor")
     auto dynA = make_dynamic<Matrix<Dense, double>>(3, 3);
     auto dynB = make_dynamic<Matrix<Dense, float>>(3, 3);
 
-    CHECK(dynA.getTypeIndex() == 6);
+    CHECK(dynA.getTypeIndex() == 7);
     CHECK(dynB.getTypeIndex() == 2);
 }
+
+namespace {
+
+/// Test matrix with about half of the elements zero
+Matrix<Dense, double> createTestMatrix(size_t nbRows, size_t nbColumns, uint64_t seed)
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = nbRows;
+    settings.nbColumns = nbColumns;
+    settings.occupation = 0.5;
+    settings.magnitude = 2.0;
+    settings.seed = seed;
+    auto A = MatrixGenerator(settings).createDense<double>();
+
+    // Multiples of 1/2, so that the products are exact in single precision
+    for (auto& value : A) value = std::round(value) / 2;
+    return A;
+}
+
+/// All matrix types of DynamicMatrixTypeList, which have a multiplication kernel
+std::vector<DynamicMatrix> createAllTypes(Matrix<Dense, double> const& A)
+{
+    auto all = [](double) { return true; };
+    auto nonZero = [](double value) { return value != 0.0; };
+
+    std::vector<DynamicMatrix> result;
+    result.push_back(make_dynamic<Matrix<Zero>>(A.getNbRows(), A.getNbColumns()));
+    result.push_back(make_dynamic<Matrix<Sparse, float>>(A, nonZero));
+    result.push_back(make_dynamic<Matrix<Dense, float>>(A, all));
+    result.push_back(make_dynamic<Matrix<BlockSparse<4>, double>>(A, nonZero));
+    result.push_back(make_dynamic<Matrix<Sparse, double>>(A, nonZero));
+    result.push_back(make_dynamic<Matrix<Dense, double>>(A, all));
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("DynamicMultiplicationTable", "[dispatch]")
+{
+    typedef DynamicMultiplicationTable<DynamicMatrixTypeList> Table;
+    CHECK(Table::size == 8);
+
+    Matrix<Dense, double> A = createTestMatrix(13, 21, 1);
+    Matrix<Dense, double> B = createTestMatrix(21, 8, 2);
+    Matrix<Dense, double> reference = A * B;
+
+    auto dynA = createAllTypes(A);
+    auto dynB = createAllTypes(B);
+
+    for (auto const& a : dynA) {
+        for (auto const& b : dynB) {
+            Matrix<Dense, double> C(13, 8);
+            C = 1.0;
+            multiply(a, b, C);
+
+            bool isZero = a.getTypeIndex() == 0 or b.getTypeIndex() == 0;
+            bool correct = true;
+            for (size_t i = 0; i < 13; ++i)
+                for (size_t j = 0; j < 8; ++j)
+                    correct = correct and std::abs(C(i, j) - 1.0 - (isZero ? 0.0 : reference(i, j))) < 1e-6;
+
+            INFO("type indices " << a.getTypeIndex() << " x " << b.getTypeIndex());
+            CHECK(correct);
+        }
+    }
+}
+
+TEST_CASE("DynamicMultiplicationTable RowMajor sparse", "[dispatch]")
+{
+    typedef Parameter<size_t, RowMajor> RowMajorParameter;
+    auto nonZero = [](double value) { return value != 0.0; };
+
+    Matrix<Dense, double> A = createTestMatrix(9, 12, 3);
+    Matrix<Dense, double> B = createTestMatrix(12, 7, 4);
+    Matrix<Dense, double> reference = A * B;
+
+    Matrix<Sparse, double, RowMajorParameter> sparseA(A, nonZero);
+    Matrix<Sparse, double, RowMajorParameter> sparseRowB(B, nonZero);
+    Matrix<Sparse, double> sparseColumnB(B, nonZero);
+
+    Matrix<Dense, double> C1(9, 7), C2(9, 7), C3(9, 7);
+    MultiplicationFunctor<Sparse, double, RowMajorParameter, Sparse, double, RowMajorParameter,
+        Dense, double, Parameter<>, Native>()(sparseA, sparseRowB, C1);
+    MultiplicationFunctor<Sparse, double, RowMajorParameter, Sparse, double, Parameter<>,
+        Dense, double, Parameter<>, Native>()(sparseA, sparseColumnB, C2);
+    MultiplicationFunctor<Sparse, double, RowMajorParameter, Dense, double, Parameter<>,
+        Dense, double, Parameter<>, Native>()(sparseA, B, C3);
+
+    CHECK(C1.equal(reference));
+    CHECK(C2.equal(reference));
+    CHECK(C3.equal(reference));
+}
+
+TEST_CASE("DynamicMultiplicationTable without kernel", "[dispatch]")
+{
+    DynamicMatrix empty;
+    auto dynA = make_dynamic<Matrix<Dense, double>>(3, 3);
+    Matrix<Dense, double> C(3, 3);
+    CHECK_THROWS_AS(multiply(empty, dynA, C), std::runtime_error);
+}
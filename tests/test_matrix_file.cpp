@@ -0,0 +1,148 @@
+#include <catch2/catch_test_macros.hpp>
+#include "MatrixFile.h"
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace BlasBooster;
+
+namespace {
+
+std::string getTemporaryFilename(std::string const& name)
+{
+    return (std::filesystem::temp_directory_path() / ("blasbooster_" + name)).string();
+}
+
+} // namespace
+
+TEST_CASE("Dense matrix file round trip", "[file]")
+{
+    auto filename = getTemporaryFilename("dense.bbm");
+    Matrix<Dense, double> A(37, 11);
+    for (size_t j = 0; j != 11; ++j)
+        for (size_t i = 0; i != 37; ++i) A(i, j) = i + 100.0 * j;
+    saveMatrix(A, filename);
+
+    {
+        MappedMatrix<Matrix<Dense, double>> B(filename);
+        CHECK(B.getNbRows() == 37);
+        CHECK(B.getNbColumns() == 11);
+        CHECK(reinterpret_cast<std::uintptr_t>(B.getDataPointer()) % MatrixFileHeader::alignment == 0);
+        CHECK(B.equal(A));
+
+        // Private mapping, the file is not changed
+        B(3, 4) = -1.0;
+        CHECK(B(3, 4) == -1.0);
+    }
+    CHECK(MappedMatrix<Matrix<Dense, double>>(filename)(3, 4) == 403.0);
+
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Dense, float>>(filename)), std::runtime_error);
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Dense, double, Parameter<size_t, RowMajor>>>(filename)), std::runtime_error);
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Dense, double>>(getTemporaryFilename("missing.bbm"))), std::runtime_error);
+
+    std::filesystem::remove(filename);
+}
+
+TEST_CASE("Matrix file with overflowing sizes", "[file]")
+{
+    auto filename = getTemporaryFilename("overflow.bbm");
+    saveMatrix(Matrix<Dense, double>(4, 4), filename);
+
+    // 2^33 x 2^33 elements wrap around to zero
+    {
+        const uint64_t size = uint64_t(1) << 33;
+        std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offsetof(MatrixFileHeader, nbRows));
+        file.write(reinterpret_cast<char const*>(&size), sizeof(size));
+        file.write(reinterpret_cast<char const*>(&size), sizeof(size));
+    }
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Dense, double>>(filename)), std::runtime_error);
+    CHECK_THROWS_AS((MatrixFile<Matrix<Dense, double>>::getFileSize(size_t(1) << 33, size_t(1) << 33)), std::runtime_error);
+
+    std::filesystem::remove(filename);
+}
+
+TEST_CASE("Dense sub-matrix is written contiguously", "[file]")
+{
+    auto filename = getTemporaryFilename("submatrix.bbm");
+    Matrix<Dense, float, Parameter<size_t, RowMajor>> A(6, 8);
+    for (size_t i = 0; i != 6; ++i)
+        for (size_t j = 0; j != 8; ++j) A(i, j) = 10.0f * i + j;
+
+    Matrix<Dense, float, Parameter<size_t, RowMajor, VariableSize, LeadingDimension>> sub(A, 3, 4, 2, 1);
+    saveMatrix(sub, filename);
+
+    MappedMatrix<Matrix<Dense, float, Parameter<size_t, RowMajor>>> B(filename);
+    CHECK(B.getNbRows() == 3);
+    CHECK(B.getNbColumns() == 4);
+    CHECK(B(0, 0) == 21.0f);
+    CHECK(B(2, 3) == 44.0f);
+
+    std::filesystem::remove(filename);
+}
+
+TEST_CASE("Out-of-core matrix in shared mapping", "[file]")
+{
+    auto filename = getTemporaryFilename("shared.bbm");
+    {
+        MappedMatrix<Matrix<Dense, double>> C(filename, 100, 50);
+        C.fill(1.5);
+        C(99, 49) = 2.0;
+        C.sync();
+    }
+    MappedMatrix<Matrix<Dense, double>> D(filename, MappedFile::Mode::Shared);
+    CHECK(D(0, 0) == 1.5);
+    CHECK(D(99, 49) == 2.0);
+
+    std::filesystem::remove(filename);
+}
+
+TEST_CASE("Sparse matrix file round trip", "[file]")
+{
+    auto filename = getTemporaryFilename("sparse.bbm");
+    Matrix<Dense, double> A(40, 30);
+    for (size_t j = 0; j != 30; ++j)
+        for (size_t i = 0; i != 40; ++i) A(i, j) = (i + 2 * j) % 7 == 0 ? i - 0.5 * j : 0.0;
+
+    Matrix<Sparse, double> S(A, [](double x){ return x != 0.0; });
+    saveMatrix(S, filename);
+
+    MappedMatrix<Matrix<Sparse, double>> M(filename);
+    CHECK(M.getNbRows() == 40);
+    CHECK(M.getNbColumns() == 30);
+    CHECK(M.nnz() == S.nnz());
+    CHECK(reinterpret_cast<std::uintptr_t>(&*M.beginKey()) % MatrixFileHeader::alignment == 0);
+    CHECK(reinterpret_cast<std::uintptr_t>(&*M.beginOffset()) % MatrixFileHeader::alignment == 0);
+    CHECK(std::equal(M.begin(), M.end(), S.begin()));
+    CHECK(std::equal(M.beginKey(), M.endKey(), S.beginKey()));
+    CHECK(std::equal(M.beginOffset(), M.endOffset(), S.beginOffset()));
+
+    Matrix<Dense, double> B(M);
+    CHECK(B.equal(A));
+
+    // CSR file can not be read as CSC and dense file not as sparse
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Sparse, double, Parameter<size_t, RowMajor>>>(filename)), std::runtime_error);
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Dense, double>>(filename)), std::runtime_error);
+
+    std::filesystem::remove(filename);
+}
+
+TEST_CASE("Empty sparse matrix file", "[file]")
+{
+    auto filename = getTemporaryFilename("empty.bbm");
+    typedef Matrix<Sparse, float, Parameter<unsigned int, RowMajor>> CSR;
+    Matrix<Dense, float, Parameter<unsigned int, RowMajor>> A(5, 3);
+    A = 0.0f;
+    CSR S(A, [](float x){ return x != 0.0f; });
+    saveMatrix(S, filename);
+
+    MappedMatrix<CSR> M(filename);
+    CHECK(M.nnz() == 0);
+    CHECK(M.sizeOffset() == 6);
+    CHECK(*(M.endOffset() - 1) == 0);
+
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Sparse, float, Parameter<size_t, RowMajor>>>(filename)), std::runtime_error);
+
+    std::filesystem::remove(filename);
+}
@@ -0,0 +1,132 @@
+#include <catch2/catch_test_macros.hpp>
+#include "MatrixConverter.h"
+#include "MatrixGenerator.h"
+#include <cmath>
+#include <filesystem>
+
+using namespace BlasBooster;
+
+typedef Parameter<size_t, ColumnMajor, VariableSize, NoLeadingDimension, UnblockedDimension> BlockedParameter;
+
+TEST_CASE("Generated matrices are independent of orientation and storage", "[generator]")
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = 57;
+    settings.nbColumns = 43;
+    settings.occupation = 0.3;
+    MatrixGenerator generator(settings);
+
+    auto A = generator.createDense<double>();
+    auto B = generator.createDense<double, Parameter<size_t, RowMajor>>();
+    auto S = generator.createSparse<double, Parameter<size_t, RowMajor>>();
+    Matrix<Dense, double> C(S);
+
+    size_t nnz = 0;
+    for (size_t i = 0; i != 57; ++i) {
+        for (size_t j = 0; j != 43; ++j) {
+            CHECK(A(i, j) == generator(i, j));
+            CHECK(B(i, j) == A(i, j));
+            CHECK(C(i, j) == A(i, j));
+            nnz += A(i, j) != 0.0;
+        }
+    }
+    CHECK(S.nnz() == nnz);
+    CHECK(nnz > 0.2 * 57 * 43);
+    CHECK(nnz < 0.4 * 57 * 43);
+
+    settings.seed = 43;
+    CHECK(MatrixGenerator(settings).createDense<double>().notEqual(A));
+}
+
+TEST_CASE("Banded and block-sparse structure", "[generator]")
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = 100;
+    settings.nbColumns = 80;
+    settings.bandwidth = 5;
+    settings.decay = 1.0;
+    settings.cutoff = std::exp(-3.5);
+    MatrixGenerator banded(settings);
+
+    auto A = banded.createSparse<double>();
+    Matrix<Dense, double> B(A);
+    for (size_t i = 0; i != 100; ++i) {
+        for (size_t j = 0; j != 80; ++j) {
+            size_t distance = i > j ? i - j : j - i;
+            if (distance > 3) CHECK(B(i, j) == 0.0);
+            else CHECK(std::abs(B(i, j)) >= 0.5 * std::exp(-1.0 * distance));
+        }
+    }
+    CHECK(A.nnz() == 4 * 80 + 79 + 78 + 77);
+
+    settings = MatrixGeneratorSettings();
+    settings.nbRows = 64;
+    settings.nbColumns = 64;
+    settings.blockSize = 8;
+    settings.blockOccupation = 0.25;
+    auto C = MatrixGenerator(settings).createDense<float>();
+    size_t nbBlocks = 0;
+    for (size_t bi = 0; bi != 8; ++bi) {
+        for (size_t bj = 0; bj != 8; ++bj) {
+            size_t nnz = 0;
+            for (size_t i = 0; i != 8; ++i)
+                for (size_t j = 0; j != 8; ++j) nnz += C(bi * 8 + i, bj * 8 + j) != 0.0f;
+            CHECK((nnz == 0 or nnz == 64));
+            nbBlocks += nnz != 0;
+        }
+    }
+    CHECK(nbBlocks > 4);
+    CHECK(nbBlocks < 32);
+}
+
+TEST_CASE("Tile classes cover the dynamic matrix types", "[generator]")
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = 7 * 32;
+    settings.nbColumns = 32;
+    settings.tileSize = 32;
+    settings.tileClasses = {TileClass::Zero, TileClass::SparseSingle, TileClass::DenseSingle, TileClass::BlockSparseDouble,
+        TileClass::SparseDouble, TileClass::DenseMixed, TileClass::DenseDouble};
+    auto A = MatrixGenerator(settings).createDense<double>();
+
+    ConverterSettings converterSettings;
+    converterSettings.blockSize = 32;
+    converterSettings.threshold = settings.threshold;
+    converterSettings.costModel = nullptr;
+    Matrix<Dense, DynamicMatrix, BlockedParameter> B;
+    MatrixConverter converter(converterSettings);
+    converter(A, B);
+
+    REQUIRE(B.getNbRows() == 7);
+    CHECK(B(0, 0).getTypeIndex() == GetIndex<Matrix<Zero>, DynamicMatrixTypeList>::value);
+    CHECK(B(1, 0).getTypeIndex() == GetIndex<Matrix<Sparse, float>, DynamicMatrixTypeList>::value);
+    CHECK(B(2, 0).getTypeIndex() == GetIndex<Matrix<Dense, float>, DynamicMatrixTypeList>::value);
+    CHECK(B(3, 0).getTypeIndex() == GetIndex<Matrix<BlockSparse<4>, double>, DynamicMatrixTypeList>::value);
+    CHECK(B(4, 0).getTypeIndex() == GetIndex<Matrix<Sparse, double>, DynamicMatrixTypeList>::value);
+    CHECK(B(5, 0).getTypeIndex() == GetIndex<MultipleMatrix<Matrix<Sparse, double>, Matrix<Dense, float>>, DynamicMatrixTypeList>::value);
+    CHECK(B(6, 0).getTypeIndex() == GetIndex<Matrix<Dense, double>, DynamicMatrixTypeList>::value);
+}
+
+TEST_CASE("Generated sparse matrix streamed into a file", "[generator]")
+{
+    auto filename = (std::filesystem::temp_directory_path() / "blasbooster_generated.bbm").string();
+
+    MatrixGeneratorSettings settings;
+    settings.nbRows = 1000;
+    settings.nbColumns = 1000;
+    settings.bandwidth = 20;
+    settings.occupation = 0.5;
+    MatrixGenerator generator(settings);
+    generator.writeSparse<double, Parameter<size_t, RowMajor>>(filename);
+
+    {
+        MappedMatrix<Matrix<Sparse, double, Parameter<size_t, RowMajor>>> A(filename);
+        auto B = generator.createSparse<double, Parameter<size_t, RowMajor>>();
+        REQUIRE(A.nnz() == B.nnz());
+        CHECK(std::equal(B.beginOffset(), B.endOffset(), A.beginOffset()));
+        CHECK(std::equal(B.beginKey(), B.endKey(), A.beginKey()));
+        CHECK(std::equal(B.begin(), B.end(), A.begin()));
+    }
+
+    std::filesystem::remove(filename);
+}
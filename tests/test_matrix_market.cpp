@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+#include "DenseMatrix.h"
+#include "MatrixMarket.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace BlasBooster;
+
+namespace {
+
+std::string writeTemporaryFile(std::string const& name, std::string const& content)
+{
+    auto filename = (std::filesystem::temp_directory_path() / ("blasbooster_" + name)).string();
+    std::ofstream(filename) << content;
+    return filename;
+}
+
+} // namespace
+
+TEST_CASE("Matrix Market general real", "[matrix market]")
+{
+    auto filename = writeTemporaryFile("general.mtx",
+        "%%MatrixMarket matrix coordinate real general\n"
+        "% comment\n"
+        "3 4 5\n"
+        "3 1 -2.5\n"
+        "1 1 1.0\n"
+        "2 4 4e-3\n"
+        "  1 3 3\r\n"
+        "3 4 7\n");
+
+    auto A = readMatrixMarket<Matrix<Sparse, double>>(filename, WorkStealingScheduler(3));
+    CHECK(A.getNbRows() == 3);
+    CHECK(A.getNbColumns() == 4);
+    CHECK(A.nnz() == 5);
+
+    Matrix<Dense, double> D(A);
+    CHECK(D(0, 0) == 1.0);
+    CHECK(D(2, 0) == -2.5);
+    CHECK(D(0, 2) == 3.0);
+    CHECK(D(1, 3) == 4e-3);
+    CHECK(D(2, 3) == 7.0);
+    CHECK(D(1, 1) == 0.0);
+
+    // Keys are sorted within the columns
+    CHECK(std::is_sorted(A.beginKey(), A.beginKey() + 2));
+
+    auto B = readMatrixMarket<Matrix<Sparse, float, Parameter<size_t, RowMajor>>>(filename);
+    CHECK(B.nnz() == 5);
+    CHECK(Matrix<Dense, float, Parameter<size_t, RowMajor>>(B)(2, 0) == -2.5f);
+
+    std::filesystem::remove(filename);
+}
+
+TEST_CASE("Matrix Market symmetric and pattern", "[matrix market]")
+{
+    auto symmetric = writeTemporaryFile("symmetric.mtx",
+        "%%MatrixMarket matrix coordinate real symmetric\n"
+        "3 3 3\n"
+        "1 1 2\n"
+        "3 1 5\n"
+        "3 2 -1\n");
+    auto A = readMatrixMarket<Matrix<Sparse, double>>(symmetric);
+    CHECK(A.nnz() == 5);
+    Matrix<Dense, double> D(A);
+    CHECK(D(2, 0) == 5.0);
+    CHECK(D(0, 2) == 5.0);
+    CHECK(D(1, 2) == -1.0);
+
+    auto pattern = writeTemporaryFile("pattern.mtx",
+        "%%MatrixMarket matrix coordinate pattern skew-symmetric\n"
+        "2 2 1\n"
+        "2 1\n");
+    auto P = readMatrixMarket<Matrix<Sparse, double>>(pattern);
+    Matrix<Dense, double> E(P);
+    CHECK(E(1, 0) == 1.0);
+    CHECK(E(0, 1) == -1.0);
+
+    auto empty = writeTemporaryFile("empty.mtx",
+        "%%MatrixMarket matrix coordinate real general\n"
+        "100 200 0\n");
+    auto Z = readMatrixMarket<Matrix<Sparse, double>>(empty);
+    CHECK(Z.nnz() == 0);
+    CHECK(Z.getNbColumns() == 200);
+
+    std::filesystem::remove(symmetric);
+    std::filesystem::remove(pattern);
+    std::filesystem::remove(empty);
+}
+
+TEST_CASE("Matrix Market errors", "[matrix market]")
+{
+    auto wrongCount = writeTemporaryFile("wrong_count.mtx",
+        "%%MatrixMarket matrix coordinate real general\n"
+        "2 2 3\n"
+        "1 1 1\n");
+    CHECK_THROWS_AS((readMatrixMarket<Matrix<Sparse, double>>(wrongCount)), std::runtime_error);
+
+    auto outOfRange = writeTemporaryFile("out_of_range.mtx",
+        "%%MatrixMarket matrix coordinate real general\n"
+        "2 2 1\n"
+        "3 1 1\n");
+    CHECK_THROWS_AS((readMatrixMarket<Matrix<Sparse, double>>(outOfRange)), std::runtime_error);
+
+    auto complex = writeTemporaryFile("complex.mtx",
+        "%%MatrixMarket matrix coordinate complex general\n"
+        "1 1 1\n"
+        "1 1 1 0\n");
+    CHECK_THROWS_AS((readMatrixMarket<Matrix<Sparse, double>>(complex)), std::runtime_error);
+
+    std::filesystem::remove(wrongCount);
+    std::filesystem::remove(outOfRange);
+    std::filesystem::remove(complex);
+}
+
+TEST_CASE("Matrix Market round trip", "[matrix market]")
+{
+    const size_t size = 300;
+    Matrix<Dense, double> A(size, size);
+    for (size_t j = 0; j != size; ++j)
+        for (size_t i = 0; i != size; ++i) A(i, j) = (i * 7 + j * 3) % 11 == 0 ? 1.0 / (1.0 + i + j) : 0.0;
+    Matrix<Sparse, double> S(A, [](double x){ return x != 0.0; });
+
+    auto filename = (std::filesystem::temp_directory_path() / "blasbooster_round_trip.mtx").string();
+    writeMatrixMarket(S, filename, false, WorkStealingScheduler(4));
+    auto B = readMatrixMarket<Matrix<Sparse, double>>(filename, WorkStealingScheduler(4));
+    CHECK(B.nnz() == S.nnz());
+    CHECK(Matrix<Dense, double>(B).equal(A));
+
+    // Symmetric part of A + A^T
+    Matrix<Dense, double, Parameter<size_t, RowMajor>> C(size, size);
+    for (size_t j = 0; j != size; ++j)
+        for (size_t i = 0; i != size; ++i) C(i, j) = A(i, j) + A(j, i);
+    Matrix<Sparse, double, Parameter<size_t, RowMajor>> T(C, [](double x){ return x != 0.0; });
+    writeMatrixMarket(T, filename, true);
+    auto U = readMatrixMarket<Matrix<Sparse, double>>(filename);
+    CHECK(U.nnz() == T.nnz());
+    Matrix<Dense, double> V(U);
+    bool equal = true;
+    for (size_t j = 0; j != size; ++j)
+        for (size_t i = 0; i != size; ++i) equal = equal and V(i, j) == C(i, j);
+    CHECK(equal);
+
+    std::filesystem::remove(filename);
+}
@@ -0,0 +1,194 @@
+#include <catch2/catch_test_macros.hpp>
+#include "DenseMatrix.h"
+#include "Memory.h"
+#include "SparseMatrix.h"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace BlasBooster;
+
+namespace {
+
+template <size_t Alignment, class T>
+bool isAligned(T const* ptr)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % Alignment == 0;
+}
+
+template <class Allocator>
+using AllocatorParameter = Parameter<size_t, ColumnMajor, VariableSize, NoLeadingDimension,
+    NoUnblockedDimension, NormTwo, OnHeap, Allocator>;
+
+} // namespace
+
+TEST_CASE("AlignedAllocator", "[memory]")
+{
+    double* p = AlignedAllocator<>::allocate<double>(13);
+    CHECK(isAligned<64>(p));
+    for (size_t i = 0; i != 13; ++i) CHECK(p[i] == 0.0);
+    AlignedAllocator<>::deallocate(p, 13);
+
+    float* q = AlignedAllocator<4096, false>::allocate<float>(3);
+    CHECK(isAligned<4096>(q));
+    AlignedAllocator<4096, false>::deallocate(q, 3);
+
+    CHECK(AlignedAllocator<>::allocate<double>(0) == nullptr);
+}
+
+TEST_CASE("HugePageAllocator", "[memory]")
+{
+    const size_t large = HugePageAllocator::hugePageSize / sizeof(double) + 1;
+    double* p = HugePageAllocator::allocate<double>(large);
+    CHECK(isAligned<HugePageAllocator::hugePageSize>(p));
+    p[0] = 1.0;
+    p[large - 1] = 2.0;
+    HugePageAllocator::deallocate(p, large);
+
+    double* q = HugePageAllocator::allocate<double>(10);
+    CHECK(isAligned<64>(q));
+    HugePageAllocator::deallocate(q, 10);
+}
+
+TEST_CASE("DenseMatrix with allocator policy", "[memory]")
+{
+    Matrix<Dense, double, AllocatorParameter<UninitializedAllocator>> A(5, 7);
+    CHECK(isAligned<64>(A.getDataPointer()));
+    for (size_t j = 0; j != 7; ++j)
+        for (size_t i = 0; i != 5; ++i) A(i, j) = i + 10.0 * j;
+
+    // Copy, conversion and resize with a different policy
+    auto B = A;
+    CHECK(isAligned<64>(B.getDataPointer()));
+    CHECK(B(4, 6) == 64.0);
+
+    Matrix<Dense, double> C(A, [](double){ return true; });
+    CHECK(C(3, 2) == 23.0);
+    CHECK(C.equal(A));
+
+    Matrix<Dense, float, AllocatorParameter<HugePageAllocator>> D(A, [](double){ return true; });
+    CHECK(D(4, 6) == 64.0f);
+
+    B.resize(100, 100, []{});
+    CHECK(isAligned<64>(B.getDataPointer()));
+    CHECK(B.getSize() == 10000);
+}
+
+TEST_CASE("Parallel first touch", "[memory]")
+{
+    // Not a multiple of the page size
+    const size_t size = numaMinBytes / sizeof(double) + 1001;
+    std::vector<double> data(size, 0.0);
+
+    for (auto placement : {NumaPlacement::None, NumaPlacement::Interleaved, NumaPlacement::Blocked}) {
+        firstTouch(data.data(), size, placement, [](double* begin, size_t n){ for (size_t i = 0; i != n; ++i) begin[i] += 1.0; },
+            WorkStealingScheduler(3, true));
+    }
+    CHECK(std::all_of(data.begin(), data.end(), [](double x){ return x == 3.0; }));
+
+    // Blocked: one contiguous chunk per worker
+    std::vector<std::thread::id> toucher(size);
+    firstTouch(data.data(), size, NumaPlacement::Blocked, [&](double* begin, size_t n){
+        std::fill_n(toucher.begin() + (begin - data.data()), n, std::this_thread::get_id());
+    }, WorkStealingScheduler(3, true));
+    size_t nbChanges = 0;
+    for (size_t i = 1; i != size; ++i) nbChanges += toucher[i] != toucher[i - 1];
+    CHECK(nbChanges == 2);
+    CHECK(toucher.front() == std::this_thread::get_id());
+}
+
+TEST_CASE("DenseMatrix with NUMA placement", "[memory]")
+{
+    const size_t size = 1024;
+    Matrix<Dense, double, AllocatorParameter<NumaAllocator<NumaPlacement::Blocked>>> A(size, size);
+    CHECK(isAligned<pageSize>(A.getDataPointer()));
+    CHECK(A(0, 0) == 0.0);
+    CHECK(A(size - 1, size - 1) == 0.0);
+
+    A.fill(2.0);
+    CHECK(std::all_of(A.begin(), A.end(), [](double x){ return x == 2.0; }));
+
+    Matrix<Sparse, double> S(A, [](double){ return true; });
+    Matrix<Dense, double, AllocatorParameter<NumaAllocator<NumaPlacement::Interleaved, HugePageAllocator>>> B(S);
+    CHECK(B(17, 1000) == 2.0);
+}
+
+TEST_CASE("Arena", "[memory]")
+{
+    Arena arena(1024);
+    void* a = arena.allocate(100);
+    void* b = arena.allocate(10);
+    CHECK(isAligned<Arena::alignment>(a));
+    CHECK(static_cast<char*>(b) - static_cast<char*>(a) == 128);
+    CHECK(arena.getUsedBytes() == 192);
+
+    // Only the last allocation is returned
+    arena.release(a, 100);
+    CHECK(arena.getUsedBytes() == 192);
+    arena.release(b, 10);
+    CHECK(arena.getUsedBytes() == 128);
+
+    auto marker = arena.getMarker();
+    arena.allocate(2000);
+    arena.allocate(1000);
+    CHECK(arena.getReservedBytes() == 1024 + 2048 + 1024);
+    arena.rewind(marker);
+    CHECK(arena.getUsedBytes() == 128);
+    CHECK(arena.allocate(512) == static_cast<char*>(a) + 128);
+
+    arena.reset();
+    CHECK(arena.getUsedBytes() == 0);
+    CHECK(arena.getReservedBytes() == 1024 + 2048 + 1024);
+    arena.allocate(4000);
+    CHECK(arena.getReservedBytes() == 1024 + 2048 + 1024);
+}
+
+TEST_CASE("SparseMatrix with ArenaAllocator", "[memory]")
+{
+    typedef Matrix<Sparse, double, AllocatorParameter<ArenaAllocator>> ScratchSparse;
+
+    Matrix<Dense, double> A{{1.0, 0.0}, {0.0, 2.0}, {3.0, 0.0}};
+    size_t used = Arena::getLocal().getUsedBytes();
+    {
+        ArenaScope scope;
+        ScratchSparse S(A, [](double x){ return x != 0.0; });
+        CHECK(S.nnz() == 3);
+        CHECK(isAligned<Arena::alignment>(&*S.begin()));
+        CHECK(Arena::getLocal().getUsedBytes() > used);
+        CHECK(*(S.end() - 1) == 2.0);
+    }
+    CHECK(Arena::getLocal().getUsedBytes() == used);
+}
+
+TEST_CASE("ArenaPool keeps the arenas of finished threads", "[memory]")
+{
+    ArenaPool pool;
+    Arena* first = nullptr;
+    std::thread([&]{
+        ArenaBinding binding(pool);
+        first = &Arena::getLocal();
+        Arena::getLocal().allocate(3000);
+    }).join();
+    REQUIRE(pool.getNbIdle() == 1);
+
+    Arena* second = nullptr;
+    size_t used = 1, reserved = 0;
+    std::thread([&]{
+        ArenaBinding binding(pool);
+        second = &Arena::getLocal();
+        used = second->getUsedBytes();
+        reserved = second->getReservedBytes();
+    }).join();
+    CHECK(second == first);
+    CHECK(used == 0);
+    CHECK(reserved >= 3000);
+
+    // The thread-local arena is used again after the binding
+    Arena* local = &Arena::getLocal();
+    {
+        ArenaBinding binding(pool);
+        CHECK(&Arena::getLocal() == first);
+    }
+    CHECK(&Arena::getLocal() == local);
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+#include "DynamicMultiplication.h"
+#include "MatrixConverter.h"
+#include "MatrixGenerator.h"
+#include "MultipleMatrix.h"
+#include <cmath>
+
+using namespace BlasBooster;
+
+namespace {
+
+typedef MultipleMatrix<Matrix<Sparse, double>, Matrix<Dense, float>> SparseDenseMultiple;
+typedef MultipleMatrix<Matrix<Sparse, double>, Matrix<Sparse, float>> SparseSparseMultiple;
+
+/// Bulk of values below 1, about every 7th element is an outlier above 1, all exactly representable in float
+Matrix<Dense, double> createTestMatrix(size_t nbRows, size_t nbColumns, uint64_t seed)
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = nbRows;
+    settings.nbColumns = nbColumns;
+    settings.tileClasses = {TileClass::DenseMixed};
+    settings.threshold = 1e-7;
+    settings.sparseOccupation = 1.0 / 7;
+    settings.seed = seed;
+    auto A = MatrixGenerator(settings).createDense<double>();
+    for (auto& value : A) value = static_cast<float>(value);
+    return A;
+}
+
+Matrix<Dense, double> referenceProduct(Matrix<Dense, double> const& A, Matrix<Dense, double> const& B)
+{
+    Matrix<Dense, double> C(A.getNbRows(), B.getNbColumns());
+    C.fill(0.0);
+    for (size_t j = 0; j < C.getNbColumns(); ++j)
+        for (size_t i = 0; i < C.getNbRows(); ++i)
+            for (size_t k = 0; k < A.getNbColumns(); ++k) C(i, j) += A(i, k) * B(k, j);
+    return C;
+}
+
+double maxError(Matrix<Dense, double> const& C, Matrix<Dense, double> const& reference)
+{
+    double error = 0.0;
+    for (size_t j = 0; j < C.getNbColumns(); ++j)
+        for (size_t i = 0; i < C.getNbRows(); ++i) error = std::max(error, std::abs(C(i, j) - reference(i, j)));
+    return error;
+}
+
+} // namespace
+
+TEST_CASE("MultipleMatrix split by magnitude", "[multiple]")
+{
+    auto A = createTestMatrix(14, 9, 0);
+    SparseDenseMultiple M(A, 1.0);
+
+    CHECK(M.getNbRows() == 14);
+    CHECK(M.getNbColumns() == 9);
+    CHECK(M.getNorm() > 0.0);
+
+    size_t nbOutliers = 0;
+    bool bulk = true;
+    for (size_t j = 0; j < 9; ++j) {
+        for (size_t i = 0; i < 14; ++i) {
+            const bool outlier = std::abs(A(i, j)) > 1.0;
+            nbOutliers += outlier;
+            bulk = bulk and M.getSecond()(i, j) == (outlier ? 0.0f : static_cast<float>(A(i, j)));
+        }
+    }
+    CHECK(nbOutliers > 0);
+    CHECK(M.getFirst().nnz() == nbOutliers);
+    CHECK(bulk);
+
+    // Each element is stored in exactly one part
+    Matrix<Dense, double> sum(14, 9);
+    sum.fill(0.0);
+    BlockToDense<Matrix<Sparse, double>>::add(M.getFirst(), sum.getDataPointer(), 1, 14);
+    BlockToDense<Matrix<Dense, float>>::add(M.getSecond(), sum.getDataPointer(), 1, 14);
+    CHECK(maxError(sum, A) == 0.0);
+
+    // Elements below the threshold, about the median magnitude of the bulk, are dropped
+    SparseSparseMultiple S(A, 1.0, 3e-4);
+    CHECK(S.getFirst().nnz() == nbOutliers);
+    CHECK(S.getSecond().nnz() > 0);
+    CHECK(S.getSecond().nnz() + S.getFirst().nnz() < 14 * 9);
+
+    auto dynamic = make_dynamic<SparseSparseMultiple>(A, 1.0, 3e-4);
+    CHECK(dynamic.getTypeIndex() == SparseSparseMultiple::typeIndex_);
+    CHECK(dynamic.getOccupation() < 1.0);
+    CHECK(make_dynamic<SparseDenseMultiple>(A, 1.0).getOccupation() == 1.0);
+}
+
+TEST_CASE("MultipleMatrix fused multiplication", "[multiple]")
+{
+    // More columns than one panel
+    auto A = createTestMatrix(21, 33, 1);
+    auto B = createTestMatrix(33, 150, 2);
+    auto reference = referenceProduct(A, B);
+
+    Matrix<Dense, double> C(21, 150);
+    C.fill(0.0);
+    multiplyAdd(SparseDenseMultiple(A, 1.0), B, C);
+    CHECK(maxError(C, reference) < 1e-9);
+
+    // Outliers of B stored as CSR
+    typedef MultipleMatrix<Matrix<Sparse, double, Parameter<size_t, RowMajor>>, Matrix<Dense, float>> RowMajorMultiple;
+    C.fill(0.0);
+    multiplyAdd(A, RowMajorMultiple(B, 1.0), C);
+    CHECK(maxError(C, reference) < 1e-9);
+}
+
+TEST_CASE("MultipleMatrix in dispatch table", "[multiple]")
+{
+    auto A = createTestMatrix(16, 12, 3);
+    auto B = createTestMatrix(12, 10, 4);
+    auto reference = referenceProduct(A, B);
+
+    std::vector<DynamicMatrix> operandsA, operandsB;
+    operandsA.push_back(make_dynamic<SparseDenseMultiple>(A, 1.0));
+    operandsA.push_back(make_dynamic<SparseSparseMultiple>(A, 1.0));
+    operandsA.push_back(make_dynamic<Matrix<Dense, double>>(A));
+    operandsB.push_back(make_dynamic<SparseDenseMultiple>(B, 1.0));
+    operandsB.push_back(make_dynamic<SparseSparseMultiple>(B, 1.0));
+    operandsB.push_back(make_dynamic<Matrix<Sparse, double>>(B, [](double x){ return x != 0.0; }));
+
+    for (auto const& dynA : operandsA) {
+        for (auto const& dynB : operandsB) {
+            Matrix<Dense, double> C(16, 10);
+            C.fill(0.0);
+            multiply(dynA, dynB, C);
+            CHECK(maxError(C, reference) < 1e-9);
+        }
+    }
+}
+
+TEST_CASE("MatrixConverter selects MultipleMatrix for few outliers", "[multiple]")
+{
+    MatrixGeneratorSettings generatorSettings;
+    generatorSettings.nbRows = 16;
+    generatorSettings.nbColumns = 16;
+    generatorSettings.tileSize = 16;
+    generatorSettings.tileClasses = {TileClass::DenseMixed};
+    generatorSettings.seed = 5;
+    auto A = MatrixGenerator(generatorSettings).createDense<double>();
+
+    ConverterSettings settings;
+    settings.blockSize = 16;
+    settings.threshold = generatorSettings.threshold;
+    settings.costModel.reset();
+    MatrixConverter converter(settings);
+
+    Matrix<Dense, DynamicMatrix, Parameter<size_t, ColumnMajor, VariableSize, NoLeadingDimension, UnblockedDimension>> blocked;
+    converter(A, blocked);
+    REQUIRE(blocked(0, 0).getTypeIndex() == SparseDenseMultiple::typeIndex_);
+
+    Matrix<Dense, double> C;
+    converter(blocked, C);
+    CHECK(maxError(C, A) < 1e-10);
+}
@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include "DenseMatrix.h"
+#include "GemmKernel.h"
+#include "MatrixMultExp.h"
+#include <cmath>
+#include <vector>
+
+using namespace BlasBooster;
+
+namespace {
+
+template <class X>
+void fillTestValues(X& A, int seed)
+{
+    for (size_t i = 0; i < A.getNbRows(); ++i)
+        for (size_t j = 0; j < A.getNbColumns(); ++j)
+            A(i, j) = static_cast<typename X::value_type>(((i * 7 + j * 3 + seed) % 11) - 5) / 4;
+}
+
+template <class X1, class X2, class X3>
+bool checkProduct(X1 const& A, X2 const& B, X3 const& C, double tolerance = 1e-10)
+{
+    for (size_t i = 0; i < C.getNbRows(); ++i) {
+        for (size_t j = 0; j < C.getNbColumns(); ++j) {
+            double reference = 0.0;
+            for (size_t k = 0; k < A.getNbColumns(); ++k) reference += A(i, k) * B(k, j);
+            if (std::abs(C(i, j) - reference) > tolerance) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("DenseMatrix multiplication initializer_list", "[multiplication]")
+{
+    Matrix<Dense, double> A
+    {
+        { 2.0,  3.0},
+        {-4.0,  1.0},
+        { 7.0, -1.0}
+    };
+    Matrix<Dense, double> B
+    {
+        { 1.0,  0.0, 2.0},
+        { 0.0, -1.0, 1.0}
+    };
+    Matrix<Dense, double> C = A * B;
+
+    CHECK(C.getNbRows() == 3);
+    CHECK(C.getNbColumns() == 3);
+    CHECK(C(0, 0) == 2.0);
+    CHECK(C(1, 1) == -1.0);
+    CHECK(C(2, 2) == 13.0);
+}
+
+TEST_CASE("DenseMatrix multiplication ColumnMajor", "[multiplication]")
+{
+    Matrix<Dense, double> A(157, 301), B(301, 83);
+    fillTestValues(A, 1);
+    fillTestValues(B, 2);
+    Matrix<Dense, double> C = A * B;
+    CHECK(checkProduct(A, B, C));
+}
+
+TEST_CASE("DenseMatrix multiplication RowMajor", "[multiplication]")
+{
+    typedef Parameter<size_t, RowMajor> RowMajorParameter;
+    Matrix<Dense, double, RowMajorParameter> A(61, 270), B(270, 45);
+    Matrix<Dense, double> C(61, 45);
+    fillTestValues(A, 3);
+    fillTestValues(B, 4);
+
+    MultiplicationFunctor<Dense, double, RowMajorParameter, Dense, double, RowMajorParameter,
+        Dense, double, Parameter<>, Native>()(A, B, C);
+    CHECK(checkProduct(A, B, C));
+}
+
+TEST_CASE("DenseMatrix multiplication float and mixed precision", "[multiplication]")
+{
+    Matrix<Dense, float> A(33, 47);
+    Matrix<Dense, double> B(47, 29);
+    fillTestValues(A, 5);
+    fillTestValues(B, 6);
+
+    Matrix<Dense, double> C = A * B;
+    CHECK(checkProduct(A, B, C, 1e-4));
+
+    Matrix<Dense, float> E(47, 20);
+    fillTestValues(E, 7);
+    Matrix<Dense, float> D = A * E;
+    CHECK(checkProduct(A, E, D, 1e-4));
+}
+
+TEST_CASE("DenseMatrix multiplication of sub-matrices", "[multiplication]")
+{
+    typedef Parameter<size_t, ColumnMajor, VariableSize, LeadingDimension> SubColumnMajor;
+    typedef Parameter<size_t, RowMajor, VariableSize, LeadingDimension> SubRowMajor;
+
+    Matrix<Dense, double> A(40, 50);
+    Matrix<Dense, double, Parameter<size_t, RowMajor>> B(50, 40);
+    fillTestValues(A, 7);
+    fillTestValues(B, 8);
+
+    Matrix<Dense, double, SubColumnMajor> subA(A, 21, 17, 3, 5);
+    Matrix<Dense, double, SubRowMajor> subB(B, 17, 13, 2, 9);
+    CHECK(subA(0, 0) == A(3, 5));
+    CHECK(subB(1, 2) == B(3, 11));
+
+    Matrix<Dense, double> C(40, 30);
+    C = 1.0;
+    Matrix<Dense, double, SubColumnMajor> subC(C, 21, 13, 10, 10);
+
+    MultiplicationFunctor<Dense, double, SubColumnMajor, Dense, double, SubRowMajor,
+        Dense, double, SubColumnMajor, Native>()(subA, subB, subC);
+    CHECK(checkProduct(subA, subB, subC));
+    CHECK(C(9, 10) == 1.0);
+    CHECK(C(31, 22) == 1.0);
+}
+
+TEST_CASE("GemmKernel in panels with A packed once", "[multiplication]")
+{
+    // More rows than MC and a deeper inner dimension than KC
+    Matrix<Dense, double> A(150, 300);
+    Matrix<Dense, double, Parameter<size_t, RowMajor>> B(300, 70);
+    fillTestValues(A, 1);
+    fillTestValues(B, 2);
+
+    Matrix<Dense, double> C(150, 70);
+    std::vector<std::pair<size_t, size_t>> panels;
+    bool final = true;
+    GemmKernel<double>::gemmPanels(150, 70, 300, 1.0, A.getDataPointer(), 1, 150, B.getDataPointer(), 70, 1,
+        0.0, C.getDataPointer(), 1, 150, 32, [&](size_t j0, size_t j1) {
+            panels.emplace_back(j0, j1);
+            Matrix<Dense, double, Parameter<size_t, ColumnMajor, VariableSize, LeadingDimension>> panel(C, 150, j1 - j0, 0, j0);
+            Matrix<Dense, double, Parameter<size_t, RowMajor, VariableSize, LeadingDimension>> panelB(B, 300, j1 - j0, 0, j0);
+            final = final and checkProduct(A, panelB, panel);
+        });
+
+    CHECK(panels == std::vector<std::pair<size_t, size_t>>{{0, 32}, {32, 64}, {64, 70}});
+    CHECK(final);
+}
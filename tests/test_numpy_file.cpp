@@ -0,0 +1,175 @@
+#include <catch2/catch_test_macros.hpp>
+#include "NumpyFile.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace BlasBooster;
+
+namespace {
+
+std::string getTemporaryFilename(std::string const& name)
+{
+    return (std::filesystem::temp_directory_path() / ("blasbooster_" + name)).string();
+}
+
+/// Write a .npy file with the header text as written by numpy
+void writeNumpy(std::string const& filename, std::string const& dict, std::vector<double> const& data)
+{
+    std::string header = dict;
+    while ((10 + header.size() + 1) % 64 != 0) header += ' ';
+    header += '\n';
+
+    std::ofstream out(filename, std::ios::binary);
+    out.write("\x93NUMPY\x01\x00", 8);
+    char length[2] = {char(header.size() & 0xff), char(header.size() >> 8)};
+    out.write(length, 2);
+    out.write(header.data(), header.size());
+    out.write(reinterpret_cast<char const*>(data.data()), data.size() * sizeof(double));
+}
+
+} // namespace
+
+TEST_CASE("NumPy header", "[numpy]")
+{
+    NumpyHeader header;
+    header.descr = "<f8";
+    header.fortranOrder = true;
+    header.shape = {3, 5};
+    std::string text = header.format();
+    CHECK(text.size() % NumpyHeader::alignment == 0);
+    CHECK(text.back() == '\n');
+
+    auto parsed = NumpyHeader::parse(text.data(), text.size());
+    CHECK(parsed.descr == "<f8");
+    CHECK(parsed.fortranOrder);
+    CHECK(parsed.shape == std::vector<size_t>{3, 5});
+    CHECK(parsed.dataPosition == text.size());
+
+    header.shape = {7};
+    text = header.format();
+    parsed = NumpyHeader::parse(text.data(), text.size());
+    CHECK(parsed.getNbRows() == 7);
+    CHECK(parsed.getNbColumns() == 1);
+
+    CHECK_THROWS_AS(NumpyHeader::parse("no numpy data", 13), std::runtime_error);
+}
+
+TEST_CASE("NumPy file written by numpy", "[numpy]")
+{
+    if (std::endian::native != std::endian::little) return;
+    auto filename = getTemporaryFilename("numpy.npy");
+
+    // numpy.save of numpy.arange(6.0).reshape(2, 3)
+    writeNumpy(filename, "{'descr': '<f8', 'fortran_order': False, 'shape': (2, 3), }", {0, 1, 2, 3, 4, 5});
+    auto matrix = openNumpy<double>(filename);
+    REQUIRE(matrix.index() == 1);
+    auto& A = std::get<1>(matrix);
+    CHECK(A.getNbRows() == 2);
+    CHECK(A.getNbColumns() == 3);
+    CHECK(A(0, 2) == 2.0);
+    CHECK(A(1, 0) == 3.0);
+    CHECK(reinterpret_cast<char*>(A.getDataPointer()) == A.getFile().getData() + 128);
+
+    CHECK_THROWS_AS(openNumpy<float>(filename), std::runtime_error);
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Dense, double>, NumpyFile>(filename)), std::runtime_error);
+
+    // Fortran order
+    writeNumpy(filename, "{'descr': '<f8', 'fortran_order': True, 'shape': (2, 3), }", {0, 1, 2, 3, 4, 5});
+    matrix = openNumpy<double>(filename);
+    REQUIRE(matrix.index() == 0);
+    auto& B = std::get<0>(matrix);
+    CHECK(B(0, 2) == 4.0);
+    CHECK(B(1, 0) == 1.0);
+
+    // Vectors have the same layout in both orders
+    writeNumpy(filename, "{'descr': '<f8', 'fortran_order': False, 'shape': (4,), }", {1, 2, 3, 4});
+    MappedMatrix<Matrix<Dense, double>, NumpyFile> v(filename);
+    CHECK(v.getNbRows() == 4);
+    CHECK(v.getNbColumns() == 1);
+    CHECK(v(3, 0) == 4.0);
+
+    writeNumpy(filename, "{'descr': '<f8', 'fortran_order': False, 'shape': (2, 3, 4), }", {});
+    CHECK_THROWS_AS(openNumpy<double>(filename), std::runtime_error);
+}
+
+TEST_CASE("NumPy file with overflowing shape", "[numpy]")
+{
+    if (std::endian::native != std::endian::little) return;
+    auto filename = getTemporaryFilename("overflow.npy");
+
+    // 2^33 x 2^33 elements wrap around to zero
+    writeNumpy(filename, "{'descr': '<f8', 'fortran_order': True, 'shape': (8589934592, 8589934592), }", {});
+    CHECK_THROWS_AS(openNumpy<double>(filename), std::runtime_error);
+    CHECK_THROWS_AS((MappedMatrix<Matrix<Dense, double>, NumpyFile>(filename)), std::runtime_error);
+    CHECK_THROWS_AS((NumpyFile<Matrix<Dense, double>>::getFileSize(size_t(1) << 33, size_t(1) << 33)), std::runtime_error);
+
+    std::filesystem::remove(filename);
+}
+
+TEST_CASE("NumPy file round trip", "[numpy]")
+{
+    auto filename = getTemporaryFilename("round_trip.npy");
+
+    Matrix<Dense, float, Parameter<size_t, RowMajor>> A(5, 7);
+    for (size_t i = 0; i != 5; ++i)
+        for (size_t j = 0; j != 7; ++j) A(i, j) = i + 10.0f * j;
+    saveNumpy(A, filename);
+
+    MappedMatrix<Matrix<Dense, float, Parameter<size_t, RowMajor>>, NumpyFile> B(filename);
+    CHECK(B.getNbRows() == 5);
+    CHECK(B.getNbColumns() == 7);
+    CHECK(B(4, 6) == 64.0f);
+    CHECK(B(2, 3) == 32.0f);
+
+    // Created file in shared mapping
+    {
+        MappedMatrix<Matrix<Dense, double>, NumpyFile> C(filename, 3, 2);
+        for (size_t j = 0; j != 2; ++j)
+            for (size_t i = 0; i != 3; ++i) C(i, j) = i - 1.0 * j;
+        C.sync();
+    }
+    auto matrix = openNumpy<double>(filename);
+    REQUIRE(matrix.index() == 0);
+    CHECK(std::get<0>(matrix)(2, 1) == 1.0);
+}
+
+TEST_CASE("NumPy archive round trip", "[numpy]")
+{
+    auto filename = getTemporaryFilename("archive.npz");
+
+    Matrix<Dense, double> A(9, 4);
+    for (size_t j = 0; j != 4; ++j)
+        for (size_t i = 0; i != 9; ++i) A(i, j) = i + 100.0 * j;
+    Matrix<Dense, int32_t, Parameter<size_t, RowMajor>> B(2, 3);
+    for (size_t i = 0; i != 2; ++i)
+        for (size_t j = 0; j != 3; ++j) B(i, j) = i * 3 + j;
+
+    {
+        NumpyArchiveWriter writer(filename);
+        writer.add("A", A);
+        writer.add("B", B);
+    }
+
+    NumpyArchive archive(filename);
+    CHECK(archive.getNames() == std::vector<std::string>{"A", "B"});
+    CHECK(archive.contains("A"));
+    CHECK(!archive.contains("C"));
+
+    auto a = archive.get<double>("A");
+    REQUIRE(a.index() == 0);
+    CHECK(std::get<0>(a).equal(A));
+
+    auto b = archive.get<int32_t>("B");
+    REQUIRE(b.index() == 1);
+    CHECK(std::get<1>(b)(1, 2) == 5);
+
+    CHECK_THROWS_AS(archive.get<double>("B"), std::runtime_error);
+    CHECK_THROWS_AS(archive.get<double>("C"), std::runtime_error);
+}
+
+TEST_CASE("CRC-32", "[numpy]")
+{
+    CHECK(crc32(0, "123456789", 9) == 0xCBF43926);
+    CHECK(crc32(crc32(0, "1234", 4), "56789", 5) == 0xCBF43926);
+}
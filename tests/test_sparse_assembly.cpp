@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include "DenseMatrix.h"
+#include "SparseAssembly.h"
+#include "SparseMatrix.h"
+#include <random>
+
+using namespace BlasBooster;
+
+namespace {
+
+/// Assemble random triplets with many duplicates from several buffers and compare with the dense sum
+template <class P>
+void checkAssembly(size_t nbRows, size_t nbColumns, size_t nbTriplets, size_t nbBuffers, size_t nbThreads)
+{
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<size_t> row(0, nbRows - 1), column(0, nbColumns - 1);
+    std::uniform_int_distribution<int> value(-5, 5);
+
+    std::vector<TripletBuffer<double>> buffers(nbBuffers);
+    Matrix<Dense,double> expected(nbRows, nbColumns);
+    expected.fill(0.0);
+    for (size_t t = 0; t != nbTriplets; ++t) {
+        Triplet<double> triplet{row(generator), column(generator), double(value(generator))};
+        buffers[t % nbBuffers].push_back(triplet);
+        expected(triplet.row, triplet.column) += triplet.value;
+    }
+
+    auto A = assembleSparse<Matrix<Sparse,double,P>>(nbRows, nbColumns, buffers, WorkStealingScheduler(nbThreads));
+    REQUIRE(A.getNbRows() == nbRows);
+    REQUIRE(A.getNbColumns() == nbColumns);
+    CHECK(A.nnz() <= nbTriplets);
+
+    Matrix<Dense,double> result(A);
+    size_t nbMismatches = 0;
+    for (size_t i = 0; i != nbRows; ++i)
+        for (size_t j = 0; j != nbColumns; ++j) nbMismatches += result(i, j) != expected(i, j);
+    CHECK(nbMismatches == 0);
+
+    const size_t nbOuter = A.getMinorDimension();
+    for (size_t outer = 0; outer != nbOuter; ++outer)
+        CHECK(std::adjacent_find(A.beginKey() + A.beginOffset()[outer], A.beginKey() + A.beginOffset()[outer + 1],
+            [](size_t a, size_t b){ return a >= b; }) == A.beginKey() + A.beginOffset()[outer + 1]);
+}
+
+} // namespace
+
+TEST_CASE("SparseAssembly of triplets with duplicates", "[sparse_assembly]")
+{
+    typedef Parameter<size_t, ColumnMajor> CM;
+    typedef Parameter<size_t, RowMajor> RM;
+
+    for (size_t nbThreads : {1, 4}) {
+        checkAssembly<RM>(37, 23, 2000, 3, nbThreads);
+        checkAssembly<CM>(37, 23, 2000, 3, nbThreads);
+        checkAssembly<RM>(300, 200, 200000, 4, nbThreads);
+        checkAssembly<CM>(300, 200, 200000, 4, nbThreads);
+
+        // More lines than buckets of the first pass
+        checkAssembly<RM>(5000, 30, 50000, 2, nbThreads);
+        checkAssembly<CM>(30, 4096, 50000, 2, nbThreads);
+    }
+}
+
+TEST_CASE("SparseAssembly without duplicates and of empty buffers", "[sparse_assembly]")
+{
+    typedef Matrix<Sparse,float,Parameter<unsigned int, ColumnMajor>> CSC;
+
+    std::vector<TripletBuffer<float,unsigned int>> buffers(2);
+    buffers[0] = {{2, 1, 3.0f}, {0, 1, 1.0f}};
+    buffers[1] = {{1, 3, 4.0f}, {1, 1, 2.0f}};
+    auto A = assembleSparse<CSC>(3, 4, buffers);
+    CHECK(A.nnz() == 4);
+    CHECK(std::vector<unsigned int>(A.beginOffset(), A.endOffset()) == std::vector<unsigned int>{0, 0, 3, 3, 4});
+    CHECK(std::vector<unsigned int>(A.beginKey(), A.endKey()) == std::vector<unsigned int>{0, 1, 2, 1});
+    CHECK(std::vector<float>(A.begin(), A.end()) == std::vector<float>{1.0f, 2.0f, 3.0f, 4.0f});
+
+    // Duplicates cancelling to zero are kept as explicit zeros
+    buffers[1].push_back({2, 1, -3.0f});
+    A = assembleSparse<CSC>(3, 4, buffers);
+    CHECK(A.nnz() == 4);
+    CHECK(A.begin()[2] == 0.0f);
+
+    auto B = assembleSparse<CSC>(3, 4, std::vector<TripletBuffer<float,unsigned int>>(3));
+    CHECK(B.nnz() == 0);
+    CHECK(B.sizeOffset() == 5);
+
+    buffers[0].push_back({3, 0, 1.0f});
+    CHECK_THROWS(assembleSparse<CSC>(3, 4, buffers));
+}
@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include "DenseMatrix.h"
+#include "MatrixGenerator.h"
+#include "SparseBuilder.h"
+#include "SparseMatrix.h"
+
+using namespace BlasBooster;
+
+typedef Matrix<Sparse, double, Parameter<size_t, RowMajor>> CSR;
+typedef Matrix<Sparse, float, Parameter<size_t, ColumnMajor>> CSC;
+
+TEST_CASE("Sparse sizing constructor allocates only the given elements", "[sparse_builder]")
+{
+    CSR A(100000, 100000);
+    CHECK(A.nnz() == 0);
+    CHECK(A.sizeOffset() == 100001);
+    CHECK(std::all_of(A.beginOffset(), A.endOffset(), [](size_t offset){ return offset == 0; }));
+
+    A.resize(3, 4);
+    CHECK(A.nnz() == 0);
+    CHECK(A.sizeOffset() == 4);
+
+    Matrix<Dense, double> B(A);
+    CHECK(B.getNbRows() == 3);
+    CHECK(std::all_of(B.begin(), B.end(), [](double x){ return x == 0.0; }));
+}
+
+TEST_CASE("SparseAppendBuilder", "[sparse_builder]")
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = 77;
+    settings.nbColumns = 53;
+    settings.occupation = 0.2;
+    MatrixGenerator generator(settings);
+    auto expected = generator.createSparse<double, Parameter<size_t, RowMajor>>();
+
+    SparseAppendBuilder<CSR> builder(77, 53);
+    for (size_t i = 0; i != 60; ++i) {
+        for (size_t j = 0; j != 53; ++j)
+            if (generator(i, j) != 0.0) builder.push(j, generator(i, j));
+        builder.endLine();
+    }
+    CHECK(builder.getNbFinishedLines() == 60);
+
+    // Rows 60 to 76 are filled only up to row 65, the others are empty
+    for (size_t i = 60; i != 66; ++i) {
+        for (size_t j = 0; j != 53; ++j)
+            if (generator(i, j) != 0.0) builder.push(j, generator(i, j));
+        builder.endLine();
+    }
+    auto A = builder.finalize();
+
+    REQUIRE(A.getNbRows() == 77);
+    REQUIRE(A.nnz() == expected.beginOffset()[66]);
+    CHECK(std::equal(A.beginOffset(), A.beginOffset() + 67, expected.beginOffset()));
+    CHECK(std::all_of(A.beginOffset() + 67, A.endOffset(), [&](size_t offset){ return offset == A.nnz(); }));
+    CHECK(std::equal(A.beginKey(), A.endKey(), expected.beginKey()));
+    CHECK(std::equal(A.begin(), A.end(), expected.begin()));
+
+    SparseAppendBuilder<CSR> full(2, 2);
+    full.endLine();
+    full.endLine();
+    CHECK_THROWS(full.push(0, 1.0));
+    CHECK(full.finalize().nnz() == 0);
+}
+
+TEST_CASE("SparseCountedBuilder", "[sparse_builder]")
+{
+    // Column-major 4 x 3 matrix, inserted in reverse order
+    SparseCountedBuilder<CSC> builder(4, 3);
+    std::vector<std::tuple<size_t, size_t, float>> elements{{0, 0, 1.0f}, {3, 0, 2.0f}, {1, 1, 3.0f}, {2, 2, 4.0f}, {0, 2, 5.0f}};
+    for (auto [i, j, x] : elements) builder.count(j);
+    builder.count(1, 2); // upper bound for column 1
+    builder.allocate();
+    for (auto iter = elements.rbegin(); iter != elements.rend(); ++iter) builder.insert(std::get<1>(*iter), std::get<0>(*iter), std::get<2>(*iter));
+    CHECK_THROWS(builder.count(0));
+
+    auto A = builder.finalize();
+    REQUIRE(A.nnz() == 5);
+    CHECK(std::vector<size_t>(A.beginOffset(), A.endOffset()) == std::vector<size_t>{0, 2, 3, 5});
+    CHECK(std::vector<size_t>(A.beginKey(), A.endKey()) == std::vector<size_t>{0, 3, 1, 0, 2});
+    CHECK(std::vector<float>(A.begin(), A.end()) == std::vector<float>{1.0f, 2.0f, 3.0f, 5.0f, 4.0f});
+
+    SparseCountedBuilder<CSR> overflow(2, 2);
+    overflow.count(0);
+    overflow.allocate();
+    overflow.insert(0, 1, 1.0);
+    CHECK_THROWS(overflow.insert(0, 0, 1.0));
+}
@@ -0,0 +1,232 @@
+#include <catch2/catch_test_macros.hpp>
+#include "DenseMatrix.h"
+#include "MatrixGenerator.h"
+#include "MultiplicationFunctor.h"
+#include "SparseMatrix.h"
+#include "SparseMultiplication.h"
+#include <cmath>
+
+using namespace BlasBooster;
+
+namespace {
+
+template <class T, class P>
+Matrix<Dense,T,P> createMatrix(size_t nbRows, size_t nbColumns, double occupation, uint64_t seed)
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = nbRows;
+    settings.nbColumns = nbColumns;
+    settings.occupation = occupation;
+    settings.seed = seed;
+    return MatrixGenerator(settings).createDense<T,P>();
+}
+
+template <class T, class P1, class P2>
+double maxDifference(Matrix<Dense,T,P1> const& A, Matrix<Dense,T,P2> const& B)
+{
+    double result = 0.0;
+    for (size_t i = 0; i != A.getNbRows(); ++i)
+        for (size_t j = 0; j != A.getNbColumns(); ++j) result = std::max(result, std::abs(double(A(i, j)) - double(B(i, j))));
+    return result;
+}
+
+/// Compare multiplySparseDense with the dense product for all layouts of B and C
+template <class T, class PA, class PB, class PC>
+void checkProduct(size_t m, size_t n, size_t k, size_t nbThreads)
+{
+    auto denseA = createMatrix<T,Parameter<>>(m, n, 0.1, 1);
+    Matrix<Sparse,T,PA> A(denseA, [](T x){ return x != T(0); });
+    auto B = createMatrix<T,PB>(n, k, 1.0, 2);
+    auto C = createMatrix<T,PC>(m, k, 1.0, 3);
+
+    Matrix<Dense,T> expected(C, [](T){ return true; });
+    MultiplicationFunctor<Dense,T,Parameter<>,Dense,T,PB,Dense,T,Parameter<>,Native>()(denseA, B, expected, T(2), T(-0.5));
+
+    multiplySparseDense(A, B, C, T(2), T(-0.5), WorkStealingScheduler(nbThreads));
+    CHECK(maxDifference(C, expected) < (std::is_same<T,float>::value ? 1e-3 : 1e-10));
+}
+
+/// All combinations of CSR and CSC with ColumnMajor and RowMajor right-hand sides
+template <class T>
+void checkLayouts()
+{
+    typedef Parameter<size_t, ColumnMajor> CM;
+    typedef Parameter<size_t, RowMajor> RM;
+
+    for (size_t nbThreads : {1, 4}) {
+        for (size_t k : {1, 3, 8, 21, 64}) {
+            checkProduct<T, RM, RM, RM>(301, 257, k, nbThreads);
+            checkProduct<T, RM, CM, CM>(301, 257, k, nbThreads);
+            checkProduct<T, RM, RM, CM>(301, 257, k, nbThreads);
+            checkProduct<T, CM, RM, RM>(301, 257, k, nbThreads);
+            checkProduct<T, CM, CM, CM>(301, 257, k, nbThreads);
+            checkProduct<T, CM, CM, RM>(301, 257, k, nbThreads);
+        }
+    }
+
+    // Large enough to split the columns of a CSC matrix into private buffers
+    for (size_t k : {1, 3}) {
+        checkProduct<T, RM, CM, CM>(1500, 1200, k, 4);
+        checkProduct<T, CM, CM, CM>(1500, 1200, k, 4);
+        checkProduct<T, CM, RM, RM>(1500, 1200, k, 4);
+    }
+}
+
+} // namespace
+
+TEST_CASE("SparseKernel CSR and CSC times vectors and multiple right-hand sides", "[sparse_kernel]")
+{
+    checkLayouts<double>();
+    checkLayouts<float>();
+}
+
+TEST_CASE("SparseKernel with mixed precision and beta = 0", "[sparse_kernel]")
+{
+    auto denseA = createMatrix<float,Parameter<>>(100, 80, 0.2, 1);
+    Matrix<Sparse,float,Parameter<size_t,RowMajor>> A(denseA, [](float x){ return x != 0.0f; });
+    auto B = createMatrix<double,Parameter<size_t,RowMajor>>(80, 16, 1.0, 2);
+
+    // beta = 0 must overwrite NaN in C
+    Matrix<Dense,double,Parameter<size_t,RowMajor>> C(100, 16);
+    C.fill(std::nan(""));
+    multiplySparseDense(A, B, C, 1.0, 0.0, WorkStealingScheduler(3));
+
+    Matrix<Dense,double> expected(100, 16);
+    MultiplicationFunctor<Dense,float,Parameter<>,Dense,double,Parameter<size_t,RowMajor>,Dense,double,Parameter<>,Native>()(denseA, B, expected);
+    CHECK(maxDifference(C, expected) < 1e-10);
+}
+
+TEST_CASE("SparseKernel widens float operands into a tall double C", "[sparse_kernel]")
+{
+    // One nonzero per column, so that the private CSC buffers are limited by the size of A and C
+    const size_t m = 200000, n = 200000;
+    Matrix<Sparse,float,Parameter<size_t,ColumnMajor>> A(m, n, n);
+    for (size_t l = 0; l != n; ++l) {
+        A.beginOffset()[l + 1] = l + 1;
+        A.beginKey()[l] = l * 7919 % m;
+        A.begin()[l] = 1.0f + l % 5;
+    }
+
+    for (size_t k : {1, 5}) {
+        Matrix<Dense,float,Parameter<size_t,RowMajor>> B(n, k);
+        for (size_t l = 0; l != n; ++l)
+            for (size_t j = 0; j != k; ++j) B(l, j) = 0.25f * ((l + j) % 7);
+
+        Matrix<Dense,double,Parameter<size_t,RowMajor>> C(m, k), expected(m, k);
+        C.fill(1.0);
+        expected.fill(-0.5);
+        for (size_t l = 0; l != n; ++l)
+            for (size_t j = 0; j != k; ++j) expected(l * 7919 % m, j) += 2.0 * (1.0 + l % 5) * B(l, j);
+
+        multiplySparseDense(A, B, C, 2.0, -0.5, WorkStealingScheduler(8));
+        CHECK(maxDifference(C, expected) == 0.0);
+    }
+}
+
+TEST_CASE("SparseKernel nnz-balanced partitioning", "[sparse_kernel]")
+{
+    // One heavy row and many empty rows
+    std::vector<size_t> offset{0, 1000, 1000, 1000, 1000, 1001, 1002, 1003, 1004};
+    auto bounds = SparseKernel<double>::partition(offset.data(), 8, 4);
+    REQUIRE(bounds.front() == 0);
+    REQUIRE(bounds.back() == 8);
+    CHECK(bounds[1] == 1);
+    for (size_t p = 1; p != bounds.size(); ++p) CHECK(bounds[p] > bounds[p - 1]);
+
+    bounds = SparseKernel<double>::partition(static_cast<size_t const*>(nullptr), 10, 3);
+    CHECK(bounds == std::vector<size_t>{0, 3, 6, 10});
+
+    bounds = SparseKernel<double>::partition(offset.data(), 8, 100);
+    CHECK(bounds.size() <= 9);
+}
+
+namespace {
+
+/// Compare multiplySparseSparse with the dense product, the number of nonzeros with the structural product
+template <class P>
+void checkSparseProduct(size_t m, size_t k, size_t n, double occupationA, double occupationB, size_t nbThreads)
+{
+    auto denseA = createMatrix<double,Parameter<>>(m, k, occupationA, 1);
+    auto denseB = createMatrix<double,Parameter<>>(k, n, occupationB, 2);
+    auto isNonZero = [](double x){ return x != 0.0; };
+    Matrix<Sparse,double,P> A(denseA, isNonZero), B(denseB, isNonZero), C;
+
+    multiplySparseSparse(A, B, C, 2.0, WorkStealingScheduler(nbThreads));
+
+    Matrix<Dense,double> expected(m, n);
+    MultiplicationFunctor<Dense,double,Parameter<>,Dense,double,Parameter<>,Dense,double,Parameter<>,Native>()(denseA, denseB, expected, 2.0);
+    REQUIRE(C.getNbRows() == m);
+    REQUIRE(C.getNbColumns() == n);
+    CHECK(maxDifference(Matrix<Dense,double>(C), expected) < 1e-10);
+
+    size_t nnz = 0;
+    for (size_t i = 0; i != m; ++i)
+        for (size_t j = 0; j != n; ++j) {
+            bool structural = false;
+            for (size_t l = 0; l != k and !structural; ++l) structural = denseA(i, l) != 0.0 and denseB(l, j) != 0.0;
+            nnz += structural;
+        }
+    CHECK(C.nnz() == nnz);
+
+    const size_t nbOuter = C.getMinorDimension();
+    for (size_t outer = 0; outer != nbOuter; ++outer)
+        CHECK(std::is_sorted(C.beginKey() + C.beginOffset()[outer], C.beginKey() + C.beginOffset()[outer + 1]));
+}
+
+} // namespace
+
+TEST_CASE("SparseKernel sparse times sparse with hash and dense accumulators", "[sparse_kernel]")
+{
+    typedef Parameter<size_t, ColumnMajor> CM;
+    typedef Parameter<size_t, RowMajor> RM;
+
+    for (size_t nbThreads : {1, 4}) {
+        // Hash tables for very sparse rows, dense accumulators for the denser ones
+        checkSparseProduct<RM>(200, 150, 180, 0.01, 0.01, nbThreads);
+        checkSparseProduct<RM>(200, 150, 180, 0.1, 0.2, nbThreads);
+        checkSparseProduct<CM>(200, 150, 180, 0.01, 0.01, nbThreads);
+        checkSparseProduct<CM>(200, 150, 180, 0.1, 0.2, nbThreads);
+        checkSparseProduct<RM>(400, 400, 400, 0.02, 0.02, nbThreads);
+    }
+
+    // Many multiply-adds into few columns, dense accumulator with sorted keys
+    auto denseA = createMatrix<double,Parameter<>>(50, 40, 0.5, 1);
+    auto denseB = createMatrix<double,Parameter<>>(40, 1000, 1.0, 2);
+    for (size_t i = 0; i != 40; ++i)
+        for (size_t j = 0; j != 1000; ++j) if (j % 50 != 7) denseB(i, j) = 0.0;
+    Matrix<Sparse,double,RM> sparseA(denseA, [](double x){ return x != 0.0; });
+    Matrix<Sparse,double,RM> sparseB(denseB, [](double x){ return x != 0.0; }), sparseC;
+    multiplySparseSparse(sparseA, sparseB, sparseC);
+    Matrix<Dense,double> expected(50, 1000);
+    MultiplicationFunctor<Dense,double,Parameter<>,Dense,double,Parameter<>,Dense,double,Parameter<>,Native>()(denseA, denseB, expected);
+    CHECK(maxDifference(Matrix<Dense,double>(sparseC), expected) < 1e-10);
+    CHECK(sparseC.nnz() == 50 * 20);
+
+    // Empty product
+    Matrix<Sparse,double,RM> A(createMatrix<double,Parameter<>>(5, 4, 0.0, 1), [](double x){ return x != 0.0; }), C;
+    Matrix<Sparse,float,RM> B(createMatrix<float,Parameter<>>(4, 3, 1.0, 2), [](float x){ return x != 0.0f; });
+    MultiplicationFunctor<Sparse,double,RM,Sparse,float,RM,Sparse,double,RM,Native>()(A, B, C);
+    CHECK(C.nnz() == 0);
+    CHECK(C.sizeOffset() == 6);
+    CHECK(std::all_of(C.beginOffset(), C.endOffset(), [](size_t offset){ return offset == 0; }));
+
+    CHECK_THROWS(MultiplicationFunctor<Sparse,double,RM,Sparse,float,RM,Sparse,double,RM,Native>()(A, B, C, 1.0, 1.0));
+}
+
+TEST_CASE("SparseKernel sparse times sparse into an operand", "[sparse_kernel]")
+{
+    typedef Parameter<size_t, RowMajor> RM;
+
+    auto denseA = createMatrix<double,Parameter<>>(120, 120, 0.05, 1);
+    Matrix<Dense,double> expected(120, 120);
+    MultiplicationFunctor<Dense,double,Parameter<>,Dense,double,Parameter<>,Dense,double,Parameter<>,Native>()(denseA, denseA, expected);
+
+    // A = A x A reallocates A only after the product is complete
+    Matrix<Sparse,double,RM> A(denseA, [](double x){ return x != 0.0; });
+    multiplySparseSparse(A, A, A, 1.0, WorkStealingScheduler(4));
+    CHECK(maxDifference(Matrix<Dense,double>(A), expected) < 1e-10);
+
+    Matrix<Sparse,double,RM> B(denseA, [](double x){ return x != 0.0; }), C(B);
+    multiplySparseSparse(C, B, B);
+    CHECK(maxDifference(Matrix<Dense,double>(B), expected) < 1e-10);
+}
@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include "SparsityEstimator.h"
+#include <algorithm>
+#include <vector>
+
+using namespace BlasBooster;
+
+TEST_CASE("Wilson interval", "[estimator]")
+{
+    auto interval = SparsityEstimator::getWilsonInterval(0.5, 100, 1.96);
+    CHECK(interval.value == 0.5);
+    CHECK(std::abs(interval.lower - 0.4038) < 1e-4);
+    CHECK(std::abs(interval.upper - 0.5962) < 1e-4);
+
+    interval = SparsityEstimator::getWilsonInterval(0.0, 32, 1.96);
+    CHECK(interval.lower == 0.0);
+    CHECK(interval.upper > 0.0);
+    CHECK(interval.upper < 0.15);
+}
+
+TEST_CASE("Quantiles of order statistics", "[estimator]")
+{
+    std::vector<double> values(101);
+    for (size_t i = 0; i != values.size(); ++i) values[i] = static_cast<double>(i);
+
+    auto median = SparsityEstimator::getQuantile(values, 0.5, 1.96);
+    CHECK(median.value == 50.0);
+    CHECK(median.lower < 50.0);
+    CHECK(median.upper > 50.0);
+    CHECK(median.upper - median.lower < 25.0);
+
+    CHECK(SparsityEstimator::getQuantile(values, 1.0, 1.96).value == 100.0);
+    CHECK(SparsityEstimator::getQuantile({}, 0.5, 1.96).value == 0.0);
+}
+
+TEST_CASE("Sparsity estimation of a blocked pattern", "[estimator]")
+{
+    // Left half: every 4th element with magnitude 1e-3, right half: dense with magnitude 2
+    const size_t size = 512;
+    Matrix<Dense, double> A(size, size);
+    for (size_t j = 0; j != size; ++j)
+        for (size_t i = 0; i != size; ++i) A(i, j) = j < size / 2 ? ((i + j) % 4 == 0 ? 1e-3 : 0.0) : 2.0;
+
+    EstimatorSettings settings;
+    settings.blockSize = 128;
+    settings.quantiles = {0.1, 0.9};
+    auto estimate = SparsityEstimator(settings, WorkStealingScheduler(4))(A);
+
+    REQUIRE(estimate.nbBlockRows == 4);
+    REQUIRE(estimate.nbBlockColumns == 4);
+    CHECK(estimate.nbSamples < size * size / 10);
+
+    for (size_t bj = 0; bj != 4; ++bj) {
+        for (size_t bi = 0; bi != 4; ++bi) {
+            auto const& occupation = estimate.getBlockOccupation(bi, bj);
+            double exact = bj < 2 ? 0.25 : 1.0;
+            CHECK(occupation.lower <= exact);
+            CHECK(occupation.upper >= exact);
+        }
+    }
+
+    CHECK(estimate.occupation.lower <= 0.625);
+    CHECK(estimate.occupation.upper >= 0.625);
+    CHECK(estimate.occupation.upper - estimate.occupation.lower < 0.1);
+
+    CHECK(estimate.magnitudeQuantiles[0].value == 1e-3);
+    CHECK(estimate.magnitudeQuantiles[1].value == 2.0);
+
+    // Same result for raw pointer in row major view of the transposed matrix
+    auto transposed = SparsityEstimator(settings).estimate(A.getDataPointer(), size, 1, size, size);
+    CHECK(transposed.occupation.lower <= 0.625);
+    CHECK(transposed.occupation.upper >= 0.625);
+}
+
+TEST_CASE("Sparsity estimation with sample limit", "[estimator]")
+{
+    Matrix<Dense, float> A(300, 200);
+    A = 0.0f;
+
+    EstimatorSettings settings;
+    settings.blockSize = 64;
+    settings.maxSamples = 100;
+    auto estimate = SparsityEstimator(settings)(A);
+
+    CHECK(estimate.blockOccupations.size() == 5 * 4);
+    CHECK(estimate.nbSamples <= settings.maxSamples);
+    CHECK(estimate.nbSamples >= settings.maxSamples - settings.tileSize);
+    CHECK(estimate.occupation.value == 0.0);
+    CHECK(estimate.magnitudeQuantiles.size() == settings.quantiles.size());
+
+    // Blocks without tiles are not informative
+    size_t nbUnsampled = std::count_if(estimate.blockOccupations.begin(), estimate.blockOccupations.end(),
+        [](ConfidenceInterval const& interval){ return interval.lower == 0.0 and interval.upper == 1.0; });
+    CHECK(nbUnsampled == 20 - 12);
+}
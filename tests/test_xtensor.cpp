@@ -1,6 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
+#include "XtensorAdaptor.h"
 #include <xtensor/xarray.hpp>
+#include <xtensor/xtensor.hpp>
 #include <xtensor/xio.hpp>
+#include <xtensor/xmath.hpp>
 #include <xtensor/xview.hpp>
 
 TEST_CASE("xtensor", "[double]")
@@ -23,3 +26,60 @@ TEST_CASE("xtensor", "[double]")
        {4, 25, 49}}    
     );
 }
+
+using namespace BlasBooster;
+
+TEST_CASE("Dense matrix as xtensor expression", "[xtensor]")
+{
+    Matrix<Dense, double> A{{1.0, 2.0, 3.0},
+                            {4.0, 5.0, 6.0}};
+    Matrix<Dense, double, Parameter<size_t, RowMajor>> B{{1.0, 1.0, 1.0},
+                                                         {2.0, 2.0, 2.0}};
+    Matrix<Dense, double> C(2, 3);
+
+    auto c = adaptMatrix(C);
+    c = 2.0 * adaptMatrix(A) + adaptMatrix(B);
+    CHECK(C(0, 0) == 3.0);
+    CHECK(C(1, 2) == 14.0);
+
+    // Sub-matrix with leading dimension
+    Matrix<Dense, double, Parameter<size_t, ColumnMajor, VariableSize, LeadingDimension>> S(A, 2, 2, 0, 1);
+    auto s = adaptMatrix(S);
+    CHECK(s.shape()[0] == 2);
+    CHECK(s.shape()[1] == 2);
+    CHECK(s(1, 1) == 6.0);
+    s(0, 0) = -2.0;
+    CHECK(A(0, 1) == -2.0);
+
+    Matrix<Dense, double> const& D = A;
+    CHECK(xt::sum(adaptMatrix(D))() == 17.0);
+}
+
+TEST_CASE("Dense matrix borrowing xtensor memory", "[xtensor]")
+{
+    xt::xtensor<double, 2> a = {{1.0, 2.0, 3.0, 4.0},
+                                {5.0, 6.0, 7.0, 8.0},
+                                {9.0, 10.0, 11.0, 12.0}};
+
+    auto A = borrowMatrix<Matrix<Dense, double, Parameter<size_t, RowMajor>>>(a);
+    CHECK(A.getNbRows() == 3);
+    CHECK(A.getNbColumns() == 4);
+    CHECK(A.getDataPointer() == a.data());
+    A(2, 3) = -12.0;
+    CHECK(a(2, 3) == -12.0);
+
+    CHECK_THROWS_AS((borrowMatrix<Matrix<Dense, double>>(a)), std::runtime_error);
+
+    auto v = xt::view(a, xt::range(1, 3), xt::range(1, 4));
+    auto V = borrowMatrix<Matrix<Dense, double, Parameter<size_t, RowMajor, VariableSize, LeadingDimension>>>(v);
+    CHECK(V.getNbRows() == 2);
+    CHECK(V.getNbColumns() == 3);
+    CHECK(V(0, 0) == 6.0);
+    CHECK(V(1, 2) == -12.0);
+    CHECK_THROWS_AS((borrowMatrix<Matrix<Dense, double, Parameter<size_t, RowMajor>>>(v)), std::runtime_error);
+
+    xt::xtensor<double, 2, xt::layout_type::column_major> b = a;
+    auto B = borrowMatrix<Matrix<Dense, double>>(b);
+    CHECK(B(1, 2) == 7.0);
+    CHECK(B.getDataPointer() == b.data());
+}
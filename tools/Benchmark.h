@@ -0,0 +1,304 @@
+#pragma once
+
+#include "CostModel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BlasBooster {
+
+/**
+ * \brief Escape value from the optimizer, like benchmark::DoNotOptimize of Google Benchmark.
+ *
+ * The value must be computed and is assumed to be read, so that e.g. a matrix
+ * constructed in the timed loop, whose data pointer is passed, is not elided.
+ */
+template <class T>
+inline void doNotOptimize(T const& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static char const volatile* sink;
+    sink = reinterpret_cast<char const volatile*>(&value);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/// All pending stores must be completed, like benchmark::ClobberMemory of Google Benchmark
+inline void clobberMemory()
+{
+#if defined(__GNUC__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ * \brief Timing loop of a benchmark in the style of Google Benchmark.
+ *
+ *   for (auto _ : state) kernel();
+ *
+ * Only the loop is timed, the setup before the loop is not. The work of one
+ * iteration is given by setFlops and setBytes to report GFLOP/s and GB/s.
+ * Results, which are not used after the loop, must be passed to doNotOptimize
+ * and clobberMemory.
+ */
+class BenchmarkState
+{
+public:
+
+    /// Loop variable, unused by design
+    struct [[maybe_unused]] Value {};
+
+    class Iterator
+    {
+    public:
+
+        Iterator(BenchmarkState* state, size_t remaining) : state_(state), remaining_(remaining) {}
+
+        Value operator * () const { return Value(); }
+        Iterator& operator ++ () { --remaining_; return *this; }
+
+        bool operator != (Iterator const&)
+        {
+            if (remaining_ != 0) return true;
+            state_->stop();
+            return false;
+        }
+
+    private:
+
+        BenchmarkState* state_;
+        size_t remaining_;
+
+    };
+
+    BenchmarkState(std::vector<size_t> const& arguments, size_t nbIterations)
+     : arguments_(arguments), nbIterations_(nbIterations)
+    {}
+
+    Iterator begin()
+    {
+        startCpu_ = std::clock();
+        start_ = std::chrono::steady_clock::now();
+        return Iterator(this, nbIterations_);
+    }
+
+    Iterator end() { return Iterator(this, 0); }
+
+    /// Argument i of the parameterized benchmark
+    size_t range(size_t i) const { return arguments_.at(i); }
+
+    size_t getNbIterations() const { return nbIterations_; }
+
+    /// Floating point operations of one iteration
+    void setFlops(double flops) { flops_ = flops; }
+    double getFlops() const { return flops_; }
+
+    /// Bytes read and written by one iteration
+    void setBytes(double bytes) { bytes_ = bytes; }
+    double getBytes() const { return bytes_; }
+
+    /// Wall time of all iterations in seconds
+    double getRealTime() const { return realTime_; }
+
+    /// Process CPU time of all iterations in seconds, includes all threads
+    double getCpuTime() const { return cpuTime_; }
+
+    /// Mark the benchmark as not applicable, e.g. for a missing kernel
+    void skip(std::string const& message) { skipMessage_ = message; }
+    std::string const& getSkipMessage() const { return skipMessage_; }
+
+private:
+
+    void stop()
+    {
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_;
+        realTime_ = duration.count();
+        cpuTime_ = static_cast<double>(std::clock() - startCpu_) / CLOCKS_PER_SEC;
+    }
+
+    std::vector<size_t> arguments_;
+    size_t nbIterations_;
+
+    double flops_ = 0.0;
+    double bytes_ = 0.0;
+
+    std::chrono::steady_clock::time_point start_;
+    std::clock_t startCpu_ = 0;
+    double realTime_ = 0.0;
+    double cpuTime_ = 0.0;
+
+    std::string skipMessage_;
+
+};
+
+/// Measured run of one benchmark instance, times per iteration in nanoseconds
+struct BenchmarkResult
+{
+    std::string name;
+    size_t iterations = 0;
+    double realTime = 0.0;
+    double cpuTime = 0.0;
+    double gflops = 0.0;
+    double gbytes = 0.0;
+    std::string skipMessage;
+};
+
+/**
+ * \brief Registry and runner of parameterized benchmarks.
+ *
+ * Each registered benchmark is run for all argument sets with the name
+ * name/arg0/arg1/... The number of iterations is increased until the loop
+ * takes at least minTime seconds. The JSON output follows the format of
+ * Google Benchmark, so that its tools (e.g. compare.py) can be used to find
+ * regressions between two builds.
+ */
+class BenchmarkRunner
+{
+public:
+
+    typedef std::function<void(BenchmarkState&)> Function;
+
+    /// Minimum time of the timed loop in seconds
+    double minTime = 0.5;
+
+    /// Only benchmarks whose names match the regular expression are run
+    std::string filter = ".";
+
+    void add(std::string const& name, Function const& function, std::vector<std::vector<size_t>> const& arguments = {{}})
+    {
+        for (auto const& args : arguments) {
+            std::string fullName = name;
+            for (auto arg : args) fullName += "/" + std::to_string(arg);
+            benchmarks_.push_back({fullName, function, args});
+        }
+    }
+
+    /// Run all benchmarks matching the filter and print a table to out
+    std::vector<BenchmarkResult> run(std::ostream& out = std::cout) const
+    {
+        std::regex regex(filter);
+        std::vector<BenchmarkResult> results;
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-50s %14s %14s %12s %10s %10s\n", "Benchmark", "Time [ns]", "CPU [ns]", "Iterations", "GFLOP/s", "GB/s");
+        out << line << std::string(115, '-') << std::endl;
+
+        for (auto const& benchmark : benchmarks_) {
+            if (!std::regex_search(benchmark.name, regex)) continue;
+            auto result = run(benchmark);
+            if (result.skipMessage.empty())
+                std::snprintf(line, sizeof(line), "%-50s %14.0f %14.0f %12zu %10.3f %10.3f", result.name.c_str(),
+                    result.realTime, result.cpuTime, result.iterations, result.gflops, result.gbytes);
+            else
+                std::snprintf(line, sizeof(line), "%-50s skipped: %s", result.name.c_str(), result.skipMessage.c_str());
+            out << line << std::endl;
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    /// Results in the JSON format of Google Benchmark
+    static void writeJson(std::vector<BenchmarkResult> const& results, std::ostream& out)
+    {
+        char date[64];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+        out << "{\n  \"context\": {\n"
+            << "    \"date\": \"" << date << "\",\n"
+            << "    \"cpu_name\": \"" << escape(CostModel::getHostCpuName()) << "\",\n"
+            << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+            << "    \"library_build_type\": \"release\"\n"
+#else
+            << "    \"library_build_type\": \"debug\"\n"
+#endif
+            << "  },\n  \"benchmarks\": [";
+
+        bool first = true;
+        for (auto const& result : results) {
+            if (!result.skipMessage.empty()) continue;
+            out << (first ? "\n" : ",\n") << "    {\n"
+                << "      \"name\": \"" << escape(result.name) << "\",\n"
+                << "      \"run_name\": \"" << escape(result.name) << "\",\n"
+                << "      \"run_type\": \"iteration\",\n"
+                << "      \"iterations\": " << result.iterations << ",\n"
+                << "      \"real_time\": " << result.realTime << ",\n"
+                << "      \"cpu_time\": " << result.cpuTime << ",\n"
+                << "      \"time_unit\": \"ns\",\n"
+                << "      \"GFLOP/s\": " << result.gflops << ",\n"
+                << "      \"GB/s\": " << result.gbytes << "\n"
+                << "    }";
+            first = false;
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+
+    struct Benchmark
+    {
+        std::string name;
+        Function function;
+        std::vector<size_t> arguments;
+    };
+
+    BenchmarkResult run(Benchmark const& benchmark) const
+    {
+        BenchmarkResult result;
+        result.name = benchmark.name;
+
+        for (size_t nbIterations = 1;; ) {
+            BenchmarkState state(benchmark.arguments, nbIterations);
+            benchmark.function(state);
+            if (!state.getSkipMessage().empty()) {
+                result.skipMessage = state.getSkipMessage();
+                return result;
+            }
+
+            if (state.getRealTime() >= minTime or nbIterations >= maxIterations) {
+                result.iterations = nbIterations;
+                result.realTime = state.getRealTime() / nbIterations * 1e9;
+                result.cpuTime = state.getCpuTime() / nbIterations * 1e9;
+                result.gflops = state.getFlops() * nbIterations / state.getRealTime() * 1e-9;
+                result.gbytes = state.getBytes() * nbIterations / state.getRealTime() * 1e-9;
+                return result;
+            }
+
+            // Estimate the iterations for minTime with a margin, at most 10 times more per step
+            double factor = state.getRealTime() > 0.0 ? 1.4 * minTime / state.getRealTime() : 10.0;
+            nbIterations = std::min(maxIterations, static_cast<size_t>(nbIterations * std::clamp(factor, 2.0, 10.0)));
+        }
+    }
+
+    static std::string escape(std::string const& s)
+    {
+        std::string result;
+        for (char c : s) {
+            if (c == '"' or c == '\\') result += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) result += c;
+        }
+        return result;
+    }
+
+    static constexpr size_t maxIterations = 1000000000;
+
+    std::vector<Benchmark> benchmarks_;
+
+};
+
+} // namespace BlasBooster
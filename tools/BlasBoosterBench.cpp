@@ -0,0 +1,370 @@
+#include "Benchmark.h"
+#include "BlockSparseMultiplication.h"
+#include "DenseMatrix.h"
+#include "DynamicMultiplication.h"
+#include "MatrixConverter.h"
+#include "MatrixGenerator.h"
+#include "MultiplicationFunctor.h"
+#include "SparseAssembly.h"
+#include "SparseMatrix.h"
+#include "SparseMultiplication.h"
+#include "TypeName.h"
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace BlasBooster;
+
+namespace {
+
+/// Random nbRows x nbColumns matrix with the given fraction of nonzero elements
+template <class T, class P = Parameter<>>
+Matrix<Dense,T,P> createRandomMatrix(size_t nbRows, size_t nbColumns, double occupation, uint64_t seed = 42)
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = nbRows;
+    settings.nbColumns = nbColumns;
+    settings.occupation = occupation;
+    settings.seed = seed;
+    return MatrixGenerator(settings).createDense<T,P>();
+}
+
+template <class T, class P = Parameter<>>
+Matrix<Sparse,T,P> createRandomSparseMatrix(size_t nbRows, size_t nbColumns, double occupation)
+{
+    MatrixGeneratorSettings settings;
+    settings.nbRows = nbRows;
+    settings.nbColumns = nbColumns;
+    settings.occupation = occupation;
+    return MatrixGenerator(settings).createSparse<T,P>();
+}
+
+/// Bytes of the value, key and offset arrays
+template <class T, class P>
+double getBytes(Matrix<Sparse,T,P> const& A)
+{
+    const size_t nbOuter = std::is_same<typename P::orientation, ColumnMajor>::value ? A.getNbColumns() : A.getNbRows();
+    return A.nnz() * (sizeof(T) + sizeof(typename P::IndexType)) + (nbOuter + 1) * sizeof(typename P::IndexType);
+}
+
+/// C = A x B of dense square matrices
+template <class T>
+void benchmarkGemm(BenchmarkState& state)
+{
+    const size_t n = state.range(0);
+    auto A = createRandomMatrix<T>(n, n, 1.0, 1);
+    auto B = createRandomMatrix<T>(n, n, 1.0, 2);
+    Matrix<Dense,T> C(n, n);
+    MultiplicationFunctor<Dense,T,Parameter<>,Dense,T,Parameter<>,Dense,T,Parameter<>,Native> multiply;
+
+    for (auto _ : state) {
+        multiply(A, B, C);
+        clobberMemory();
+    }
+
+    state.setFlops(2.0 * n * n * n);
+    state.setBytes(4.0 * n * n * sizeof(T));
+}
+
+/**
+ * C = A x B of a sparse n x n matrix with nbRightHandSides dense columns, occupation in per mille.
+ * P: orientation of A, CSR or CSC. B and C are RowMajor, the multiplication uses all hardware threads.
+ */
+template <class T, class P>
+void benchmarkSparseDense(BenchmarkState& state)
+{
+    const size_t n = state.range(0), nbRightHandSides = state.range(2);
+    auto A = createRandomSparseMatrix<T,P>(n, n, state.range(1) * 1e-3);
+    auto B = createRandomMatrix<T,Parameter<size_t,RowMajor>>(n, nbRightHandSides, 1.0);
+    Matrix<Dense,T,Parameter<size_t,RowMajor>> C(n, nbRightHandSides);
+
+    for (auto _ : state) {
+        multiplySparseDense(A, B, C);
+        clobberMemory();
+    }
+
+    state.setFlops(2.0 * A.nnz() * nbRightHandSides);
+    state.setBytes(getBytes(A) + 2.0 * n * nbRightHandSides * sizeof(T));
+}
+
+/// C = A x A of a sparse n x n matrix into a sparse matrix, occupation in per mille
+template <class T, class P>
+void benchmarkSparseSparse(BenchmarkState& state)
+{
+    const size_t n = state.range(0);
+    auto A = createRandomSparseMatrix<T,P>(n, n, state.range(1) * 1e-3);
+    Matrix<Sparse,T,P> C;
+
+    for (auto _ : state) {
+        multiplySparseSparse(A, A, C);
+        clobberMemory();
+    }
+
+    // Multiply-adds of the product
+    double flops = 0.0;
+    for (size_t outer = 0; outer != n; ++outer)
+        for (auto e = A.beginOffset()[outer]; e != A.beginOffset()[outer + 1]; ++e)
+            flops += A.beginOffset()[A.beginKey()[e] + 1] - A.beginOffset()[A.beginKey()[e]];
+    state.setFlops(2.0 * flops);
+    state.setBytes(2.0 * getBytes(A) + getBytes(C));
+}
+
+/// Assembly of an n x n sparse matrix from random triplets in 8 buffers, triplets per row in range(1), about 1/4 duplicates
+template <class T, class P>
+void benchmarkSparseAssembly(BenchmarkState& state)
+{
+    const size_t n = state.range(0), nbTriplets = n * state.range(1);
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<size_t> index(0, n - 1);
+    std::vector<TripletBuffer<T>> buffers(8);
+    for (size_t t = 0; t != nbTriplets; ++t) {
+        const size_t i = index(generator);
+        buffers[t % 8].push_back({i, (i + index(generator) % (4 * state.range(1))) % n, T(1)});
+    }
+    Matrix<Sparse,T,P> A;
+
+    for (auto _ : state) {
+        A = assembleSparse<Matrix<Sparse,T,P>>(n, n, buffers);
+        clobberMemory();
+    }
+
+    state.setBytes(nbTriplets * sizeof(Triplet<T>) + getBytes(A));
+}
+
+/**
+ * C = A x B of a block-sparse n x n matrix with full 4 x 4 tiles and nbRightHandSides dense columns,
+ * fraction of stored tiles in per mille. Single-threaded, A, B and C are ColumnMajor.
+ */
+template <class T>
+void benchmarkBlockSparseDense(BenchmarkState& state)
+{
+    const size_t n = state.range(0), nbRightHandSides = state.range(2);
+    std::mt19937_64 generator(42);
+    std::bernoulli_distribution tile(state.range(1) * 1e-3);
+    Matrix<Dense,T> dense(n, n);
+    dense.fill(T(0));
+    for (size_t tj = 0; tj < n; tj += 4)
+        for (size_t ti = 0; ti < n; ti += 4)
+            if (tile(generator))
+                for (size_t j = tj; j < std::min(n, tj + 4); ++j)
+                    for (size_t i = ti; i < std::min(n, ti + 4); ++i) dense(i, j) = T(1);
+    Matrix<BlockSparse<4>,T> A(dense, [](T x){ return x != T(0); });
+    auto B = createRandomMatrix<T>(n, nbRightHandSides, 1.0);
+    Matrix<Dense,T> C(n, nbRightHandSides);
+    MultiplicationFunctor<BlockSparse<4>,T,Parameter<>,Dense,T,Parameter<>,Dense,T,Parameter<>,Native> multiply;
+
+    for (auto _ : state) {
+        multiply(A, B, C);
+        clobberMemory();
+    }
+
+    state.setFlops(2.0 * A.nnz() * nbRightHandSides);
+    state.setBytes(A.nnz() * sizeof(T) + A.getNbTiles() * sizeof(size_t) + 2.0 * n * nbRightHandSides * sizeof(T));
+}
+
+template <class T>
+void benchmarkDenseToSparse(BenchmarkState& state)
+{
+    const size_t n = state.range(0);
+    auto A = createRandomMatrix<T>(n, n, state.range(1) * 1e-3);
+    double bytes = 0.0;
+
+    for (auto _ : state) {
+        Matrix<Sparse,T> B(A, [](T x){ return x != T(0); });
+        doNotOptimize(&*B.begin());
+        clobberMemory();
+        bytes = getBytes(B);
+    }
+
+    state.setBytes(n * n * sizeof(T) + bytes);
+}
+
+template <class T>
+void benchmarkSparseToDense(BenchmarkState& state)
+{
+    const size_t n = state.range(0);
+    auto A = createRandomSparseMatrix<T>(n, n, state.range(1) * 1e-3);
+
+    for (auto _ : state) {
+        Matrix<Dense,T> B(A);
+        doNotOptimize(B.getDataPointer());
+        clobberMemory();
+    }
+
+    state.setBytes(getBytes(A) + n * n * sizeof(T));
+}
+
+/// Conversion of a ColumnMajor into a RowMajor matrix
+template <class T>
+void benchmarkTranspose(BenchmarkState& state)
+{
+    const size_t n = state.range(0);
+    auto A = createRandomMatrix<T>(n, n, 1.0);
+
+    for (auto _ : state) {
+        Matrix<Dense,T,Parameter<size_t,RowMajor>> B(A, [](T){ return true; });
+        doNotOptimize(B.getDataPointer());
+        clobberMemory();
+    }
+
+    state.setBytes(2.0 * n * n * sizeof(T));
+}
+
+/// Sum of a sub-matrix with leading dimension using the StripedIterator
+template <class T>
+void benchmarkStripedIterator(BenchmarkState& state)
+{
+    const size_t n = state.range(0);
+    auto A = createRandomMatrix<T>(n + 16, n, 1.0);
+    Matrix<Dense,T,Parameter<size_t,ColumnMajor,VariableSize,LeadingDimension>> S(A, n, n, 8, 0);
+    for (auto _ : state) {
+        T sum = 0;
+        for (auto iter = S.begin(), end = S.end(); iter != end; ++iter) sum += *iter;
+        doNotOptimize(sum);
+    }
+
+    state.setFlops(1.0 * n * n);
+    state.setBytes(1.0 * n * n * sizeof(T));
+}
+
+/// Conversion into blocks of all types of DynamicMatrixTypeList
+void benchmarkConverter(BenchmarkState& state)
+{
+    const size_t n = state.range(0), blockSize = state.range(1);
+    MatrixGeneratorSettings settings;
+    settings.nbRows = n;
+    settings.nbColumns = n;
+    settings.tileSize = blockSize;
+    settings.tileClasses = {TileClass::Zero, TileClass::SparseSingle, TileClass::DenseSingle,
+        TileClass::SparseDouble, TileClass::DenseMixed, TileClass::DenseDouble, TileClass::DenseDouble};
+    auto A = MatrixGenerator(settings).createDense<double>();
+
+    ConverterSettings converterSettings;
+    converterSettings.blockSize = blockSize;
+    converterSettings.threshold = settings.threshold;
+    MatrixConverter converter(converterSettings);
+    Matrix<Dense,DynamicMatrix,Parameter<size_t,ColumnMajor,VariableSize,NoLeadingDimension,UnblockedDimension>> B;
+
+    for (auto _ : state) {
+        converter(A, B);
+        clobberMemory();
+    }
+
+    state.setBytes(n * n * sizeof(double));
+}
+
+/// Matrix type of the dispatch benchmark
+DynamicMatrix createBlock(size_t type, size_t n, double occupation)
+{
+    auto A = createRandomMatrix<double>(n, n, occupation);
+    auto isNonZero = [](double x){ return x != 0.0; };
+    switch (type) {
+        case 0: return make_dynamic<Matrix<Dense,double>>(A, isNonZero);
+        case 1: return make_dynamic<Matrix<Dense,float>>(A, isNonZero);
+        case 2: return make_dynamic<Matrix<Sparse,double>>(A, isNonZero);
+        case 3: return make_dynamic<Matrix<Sparse,float>>(A, isNonZero);
+        default: throw std::runtime_error("BlasBoosterBench: unknown block type.");
+    }
+}
+
+/// C += A x B of DynamicMatrix blocks through the dispatch table, small blocks show the dispatch overhead
+void benchmarkDynamicDispatch(BenchmarkState& state)
+{
+    const size_t typeA = state.range(0), typeB = state.range(1), n = state.range(2);
+    DynamicMatrix A = createBlock(typeA, n, typeA < 2 ? 1.0 : 0.1);
+    DynamicMatrix B = createBlock(typeB, n, typeB < 2 ? 1.0 : 0.1);
+    Matrix<Dense,double> C(n, n);
+    C.fill(0.0);
+
+    try {
+        multiply(A, B, C);
+    } catch (std::runtime_error const& e) {
+        state.skip(e.what());
+        return;
+    }
+
+    for (auto _ : state) {
+        multiply(A, B, C);
+        clobberMemory();
+    }
+
+    state.setFlops(2.0 * n * n * n * A.getOccupation() * B.getOccupation());
+}
+
+template <class T>
+void addBenchmarks(BenchmarkRunner& runner)
+{
+    const std::string type = "<" + TypeName<T>::value() + ">";
+    runner.add("gemm" + type, benchmarkGemm<T>, {{64}, {128}, {256}, {512}, {1024}});
+    typedef Parameter<size_t,RowMajor> CSR;
+    typedef Parameter<size_t,ColumnMajor> CSC;
+    runner.add("spmv_csr" + type, benchmarkSparseDense<T,CSR>, {{4096, 1, 1}, {4096, 10, 1}, {4096, 100, 1}});
+    runner.add("spmv_csc" + type, benchmarkSparseDense<T,CSC>, {{4096, 1, 1}, {4096, 10, 1}, {4096, 100, 1}});
+    runner.add("spmm_csr" + type, benchmarkSparseDense<T,CSR>, {{4096, 1, 16}, {4096, 10, 16}, {4096, 100, 16}, {4096, 10, 8}, {4096, 10, 64}});
+    runner.add("spmm_csc" + type, benchmarkSparseDense<T,CSC>, {{4096, 1, 16}, {4096, 10, 16}, {4096, 100, 16}, {4096, 10, 8}, {4096, 10, 64}});
+    runner.add("spgemm_csr" + type, benchmarkSparseSparse<T,CSR>, {{4096, 1}, {4096, 10}, {4096, 50}});
+    runner.add("spgemm_csc" + type, benchmarkSparseSparse<T,CSC>, {{4096, 1}, {4096, 10}});
+    runner.add("bsr_spmm" + type, benchmarkBlockSparseDense<T>, {{4096, 10, 16}, {4096, 100, 16}, {4096, 10, 64}});
+    runner.add("coo_assembly_csr" + type, benchmarkSparseAssembly<T,CSR>, {{100000, 8}, {100000, 64}});
+    runner.add("coo_assembly_csc" + type, benchmarkSparseAssembly<T,CSC>, {{100000, 8}});
+    runner.add("dense_to_sparse" + type, benchmarkDenseToSparse<T>, {{1024, 10}, {1024, 100}, {1024, 300}});
+    runner.add("sparse_to_dense" + type, benchmarkSparseToDense<T>, {{1024, 10}, {1024, 100}, {1024, 300}});
+    runner.add("transpose" + type, benchmarkTranspose<T>, {{256}, {1024}, {4096}});
+    runner.add("striped_iterator" + type, benchmarkStripedIterator<T>, {{256}, {1024}});
+}
+
+} // namespace
+
+/**
+ * Performance suite of the kernels, conversions and the dynamic dispatch.
+ * The inputs are created by the MatrixGenerator.
+ *
+ * Usage: BlasBoosterBench [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>] [--benchmark_out=<file>]
+ *
+ * The names are <kernel><type>/<arguments>, e.g. spmm_csr<double>/4096/10/16 for
+ * n = 4096, occupation 10 per mille and 16 right-hand sides. The results are
+ * written as table to stdout and in the JSON format of Google Benchmark to
+ * the output file.
+ */
+int main(int argc, char* argv[])
+{
+    BenchmarkRunner runner;
+    std::string output;
+
+    for (int i = 1; i != argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](std::string const& option) { return arg.substr(option.size()); };
+        if (arg.starts_with("--benchmark_filter=")) runner.filter = value("--benchmark_filter=");
+        else if (arg.starts_with("--benchmark_min_time=")) runner.minTime = std::stod(value("--benchmark_min_time="));
+        else if (arg.starts_with("--benchmark_out=")) output = value("--benchmark_out=");
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>] [--benchmark_out=<file>]" << std::endl;
+            return 1;
+        }
+    }
+
+    addBenchmarks<double>(runner);
+    addBenchmarks<float>(runner);
+
+    // Block types: 0 Dense<double>, 1 Dense<float>, 2 Sparse<double>, 3 Sparse<float>
+    std::vector<std::vector<size_t>> dispatchArguments;
+    for (size_t n : {16, 64, 256})
+        for (size_t typeA = 0; typeA != 4; ++typeA)
+            for (size_t typeB = 0; typeB != 4; ++typeB) dispatchArguments.push_back({typeA, typeB, n});
+    runner.add("dynamic_dispatch", benchmarkDynamicDispatch, dispatchArguments);
+    runner.add("converter", benchmarkConverter, {{2048, 64}, {2048, 256}});
+
+    try {
+        auto results = runner.run();
+        if (!output.empty()) {
+            std::ofstream out(output);
+            BenchmarkRunner::writeJson(results, out);
+            if (!out) throw std::runtime_error("BlasBoosterBench: writing " + output + " failed.");
+        }
+    } catch (std::exception const& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
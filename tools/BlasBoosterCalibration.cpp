@@ -0,0 +1,46 @@
+#include "Calibration.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace BlasBooster;
+
+/**
+ * Measure the block kernels of the host and store the cost model into the database.
+ *
+ * Usage: BlasBoosterCalibration [database]
+ *
+ * The default database is given by the environment variable BLASBOOSTER_COST_MODEL.
+ * The models of other CPUs within the database are kept.
+ */
+int main(int argc, char* argv[])
+{
+    const char* env = std::getenv("BLASBOOSTER_COST_MODEL");
+    std::string filename = argc > 1 ? argv[1] : env ? env : "";
+    if (filename.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [database], or set BLASBOOSTER_COST_MODEL" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::cout << "Calibrating BlasBooster kernels on " << CostModel::getHostCpuName() << std::endl;
+        CostModel model = Calibration()();
+
+        ConverterSettings settings;
+        for (auto blockSize : {64, 128, 256}) {
+            settings.blockSize = blockSize;
+            settings.costModel = std::make_shared<CostModel>(model);
+            std::cout << "Sparse crossover occupation for block size " << blockSize << ": "
+                << settings.getSparseOccupation(GetIndex<Matrix<Sparse,double>, DynamicMatrixTypeList>::value,
+                                                GetIndex<Matrix<Dense,double>, DynamicMatrixTypeList>::value)
+                << std::endl;
+        }
+
+        model.save(filename);
+        std::cout << "Cost model written to " << filename << std::endl;
+    } catch (std::exception const& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}